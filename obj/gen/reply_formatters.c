@@ -0,0 +1,3308 @@
+/* Generated by genreplies from src/include/replies.h. Do not edit. */
+
+#include "gen/reply_formatters.h"
+
+#include <string.h>
+
+void msgbuf_add_RPL_WELCOME(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "001 " - 1 + n0 + sizeof " :Welcome to the Internet Relay Network " - 1 + n1);
+	p = msgbuf_put_bytes(p, "001 ", sizeof "001 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Welcome to the Internet Relay Network ", sizeof " :Welcome to the Internet Relay Network " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WELCOME(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WELCOME(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_YOURHOST(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "002 " - 1 + n0 + sizeof " :Your host is " - 1 + n1);
+	p = msgbuf_put_bytes(p, "002 ", sizeof "002 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Your host is ", sizeof " :Your host is " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_YOURHOST(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_YOURHOST(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_CREATED(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "003 " - 1 + n0 + sizeof " :This server has been started " - 1 + n1);
+	p = msgbuf_put_bytes(p, "003 ", sizeof "003 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :This server has been started ", sizeof " :This server has been started " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_CREATED(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_CREATED(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_MYINFO(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "004 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3);
+	p = msgbuf_put_bytes(p, "004 ", sizeof "004 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_MYINFO(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_MYINFO(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ISUPPORTNET(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "005 " - 1 + n0 + sizeof " NETWORK=" - 1 + n1 + sizeof " :is my network name" - 1);
+	p = msgbuf_put_bytes(p, "005 ", sizeof "005 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " NETWORK=", sizeof " NETWORK=" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is my network name", sizeof " :is my network name" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ISUPPORTNET(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ISUPPORTNET(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ISUPPORT1(MsgBuf *buf, const char *a0, const char *a1, const char *a2, int a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "005 " - 1 + n0 + sizeof " RFC2812 CHARSET=UTF-8 CASEMAPPING=ascii PREFIX=(qaohv)~&@%+ CHANTYPES=" - 1 + n1 + sizeof " CHANMODES=beI,k,l,imMnOPQRstVz CHANLIMIT=" - 1 + n2 + sizeof ":" - 1 + 21 + sizeof " :are supported on this server" - 1);
+	p = msgbuf_put_bytes(p, "005 ", sizeof "005 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " RFC2812 CHARSET=UTF-8 CASEMAPPING=ascii PREFIX=(qaohv)~&@%+ CHANTYPES=", sizeof " RFC2812 CHARSET=UTF-8 CASEMAPPING=ascii PREFIX=(qaohv)~&@%+ CHANTYPES=" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " CHANMODES=beI,k,l,imMnOPQRstVz CHANLIMIT=", sizeof " CHANMODES=beI,k,l,imMnOPQRstVz CHANLIMIT=" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, ":", sizeof ":" - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :are supported on this server", sizeof " :are supported on this server" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ISUPPORT1(const char *prefix, const char *a0, const char *a1, const char *a2, int a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ISUPPORT1(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ISUPPORT2(MsgBuf *buf, const char *a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "005 " - 1 + n0 + sizeof " CHANNELLEN=" - 1 + 21 + sizeof " NICKLEN=" - 1 + 21 + sizeof " TOPICLEN=" - 1 + 21 + sizeof " AWAYLEN=" - 1 + 21 + sizeof " KICKLEN=" - 1 + 21 + sizeof " MODES=" - 1 + 21 + sizeof " MAXLIST=beI:" - 1 + 21 + sizeof " EXCEPTS=e INVEX=I PENALTY FNC :are supported on this server" - 1);
+	p = msgbuf_put_bytes(p, "005 ", sizeof "005 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " CHANNELLEN=", sizeof " CHANNELLEN=" - 1);
+	p = msgbuf_put_long(p, a1, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " NICKLEN=", sizeof " NICKLEN=" - 1);
+	p = msgbuf_put_long(p, a2, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " TOPICLEN=", sizeof " TOPICLEN=" - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " AWAYLEN=", sizeof " AWAYLEN=" - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " KICKLEN=", sizeof " KICKLEN=" - 1);
+	p = msgbuf_put_long(p, a5, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " MODES=", sizeof " MODES=" - 1);
+	p = msgbuf_put_long(p, a6, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " MAXLIST=beI:", sizeof " MAXLIST=beI:" - 1);
+	p = msgbuf_put_long(p, a7, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " EXCEPTS=e INVEX=I PENALTY FNC :are supported on this server", sizeof " EXCEPTS=e INVEX=I PENALTY FNC :are supported on this server" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ISUPPORT2(const char *prefix, const char *a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ISUPPORT2(buf, a0, a1, a2, a3, a4, a5, a6, a7);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TRACELINK(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, long a6, int a7, int a8)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	a5 = a5 ? a5 : "(null)";
+	size_t n5 = strlen(a5);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "200 " - 1 + n0 + sizeof " Link " - 1 + n1 + sizeof "-" - 1 + n2 + sizeof " " - 1 + n3 + sizeof " " - 1 + n4 + sizeof " V" - 1 + n5 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "200 ", sizeof "200 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " Link ", sizeof " Link " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, "-", sizeof "-" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	p = msgbuf_put_bytes(p, " V", sizeof " V" - 1);
+	p = msgbuf_put_bytes(p, a5, n5);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a6, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a7, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a8, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TRACELINK(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, long a6, int a7, int a8)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TRACELINK(buf, a0, a1, a2, a3, a4, a5, a6, a7, a8);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TRACEOPERATOR(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "204 " - 1 + n0 + sizeof " Oper 2 :" - 1 + n1);
+	p = msgbuf_put_bytes(p, "204 ", sizeof "204 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " Oper 2 :", sizeof " Oper 2 :" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TRACEOPERATOR(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TRACEOPERATOR(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TRACESERVER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	a5 = a5 ? a5 : "(null)";
+	size_t n5 = strlen(a5);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "206 " - 1 + n0 + sizeof " Serv 1 0S 0C " - 1 + n1 + sizeof "[" - 1 + n2 + sizeof "@" - 1 + n3 + sizeof "] *!*@" - 1 + n4 + sizeof " :V" - 1 + n5);
+	p = msgbuf_put_bytes(p, "206 ", sizeof "206 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " Serv 1 0S 0C ", sizeof " Serv 1 0S 0C " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, "[", sizeof "[" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, "@", sizeof "@" - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, "] *!*@", sizeof "] *!*@" - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	p = msgbuf_put_bytes(p, " :V", sizeof " :V" - 1);
+	p = msgbuf_put_bytes(p, a5, n5);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TRACESERVER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TRACESERVER(buf, a0, a1, a2, a3, a4, a5);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_STATSLINKINFO(MsgBuf *buf, const char *a0, const char *a1, int a2, long a3, long a4, long a5, long a6, long a7)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "211 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " :" - 1 + 21);
+	p = msgbuf_put_bytes(p, "211 ", sizeof "211 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a2, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a5, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a6, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_long(p, a7, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_STATSLINKINFO(const char *prefix, const char *a0, const char *a1, int a2, long a3, long a4, long a5, long a6, long a7)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_STATSLINKINFO(buf, a0, a1, a2, a3, a4, a5, a6, a7);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_STATSCOMMANDS(MsgBuf *buf, const char *a0, const char *a1, long a2, long a3, long a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "212 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "212 ", sizeof "212 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a2, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_STATSCOMMANDS(const char *prefix, const char *a0, const char *a1, long a2, long a3, long a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_STATSCOMMANDS(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_STATSXLINE(MsgBuf *buf, const char *a0, char a1, const char *a2, long a3, const char *a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "216 " - 1 + n0 + sizeof " " - 1 + 1 + sizeof " " - 1 + n2 + sizeof " " - 1 + 21 + sizeof " :" - 1 + n4);
+	p = msgbuf_put_bytes(p, "216 ", sizeof "216 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	*p++ = a1;
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_STATSXLINE(const char *prefix, const char *a0, char a1, const char *a2, long a3, const char *a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_STATSXLINE(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFSTATS(MsgBuf *buf, const char *a0, char a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "219 " - 1 + n0 + sizeof " " - 1 + 1 + sizeof " :End of STATS report" - 1);
+	p = msgbuf_put_bytes(p, "219 ", sizeof "219 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	*p++ = a1;
+	p = msgbuf_put_bytes(p, " :End of STATS report", sizeof " :End of STATS report" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFSTATS(const char *prefix, const char *a0, char a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFSTATS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_UMODEIS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "221 " - 1 + n0 + sizeof " +" - 1 + n1);
+	p = msgbuf_put_bytes(p, "221 ", sizeof "221 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " +", sizeof " +" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_UMODEIS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_UMODEIS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_SERVLIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4, int a5, const char *a6)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a6 = a6 ? a6 : "(null)";
+	size_t n6 = strlen(a6);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "234 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " :" - 1 + n6);
+	p = msgbuf_put_bytes(p, "234 ", sizeof "234 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a5, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a6, n6);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_SERVLIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4, int a5, const char *a6)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_SERVLIST(buf, a0, a1, a2, a3, a4, a5, a6);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_SERVLISTEND(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "235 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :End of service listing" - 1);
+	p = msgbuf_put_bytes(p, "235 ", sizeof "235 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :End of service listing", sizeof " :End of service listing" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_SERVLISTEND(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_SERVLISTEND(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_STATSUPTIME(MsgBuf *buf, const char *a0, unsigned a1, unsigned a2, unsigned a3, unsigned a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "242 " - 1 + n0 + sizeof " :Server Up " - 1 + 21 + sizeof " days " - 1 + 21 + sizeof ":" - 1 + 23 + sizeof ":" - 1 + 23);
+	p = msgbuf_put_bytes(p, "242 ", sizeof "242 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Server Up ", sizeof " :Server Up " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " days ", sizeof " days " - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, ":", sizeof ":" - 1);
+	p = msgbuf_put_ulong(p, a3, 10, 2, '0', false);
+	p = msgbuf_put_bytes(p, ":", sizeof ":" - 1);
+	p = msgbuf_put_ulong(p, a4, 10, 2, '0', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_STATSUPTIME(const char *prefix, const char *a0, unsigned a1, unsigned a2, unsigned a3, unsigned a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_STATSUPTIME(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_STATSDEBUG(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "249 " - 1 + n0 + sizeof " :" - 1 + n1);
+	p = msgbuf_put_bytes(p, "249 ", sizeof "249 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_STATSDEBUG(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_STATSDEBUG(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LUSERCLIENT(MsgBuf *buf, const char *a0, long a1, long a2, long a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "251 " - 1 + n0 + sizeof " :There are " - 1 + 21 + sizeof " users and " - 1 + 21 + sizeof " services on " - 1 + 21 + sizeof " servers" - 1);
+	p = msgbuf_put_bytes(p, "251 ", sizeof "251 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :There are ", sizeof " :There are " - 1);
+	p = msgbuf_put_long(p, a1, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " users and ", sizeof " users and " - 1);
+	p = msgbuf_put_long(p, a2, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " services on ", sizeof " services on " - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " servers", sizeof " servers" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LUSERCLIENT(const char *prefix, const char *a0, long a1, long a2, long a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LUSERCLIENT(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LUSEROP(MsgBuf *buf, const char *a0, unsigned long a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "252 " - 1 + n0 + sizeof " " - 1 + 21 + sizeof " :operator(s) online" - 1);
+	p = msgbuf_put_bytes(p, "252 ", sizeof "252 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :operator(s) online", sizeof " :operator(s) online" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LUSEROP(const char *prefix, const char *a0, unsigned long a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LUSEROP(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LUSERUNKNOWN(MsgBuf *buf, const char *a0, unsigned long a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "253 " - 1 + n0 + sizeof " " - 1 + 21 + sizeof " :unknown connection(s)" - 1);
+	p = msgbuf_put_bytes(p, "253 ", sizeof "253 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :unknown connection(s)", sizeof " :unknown connection(s)" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LUSERUNKNOWN(const char *prefix, const char *a0, unsigned long a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LUSERUNKNOWN(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LUSERCHANNELS(MsgBuf *buf, const char *a0, unsigned long a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "254 " - 1 + n0 + sizeof " " - 1 + 21 + sizeof " :channels formed" - 1);
+	p = msgbuf_put_bytes(p, "254 ", sizeof "254 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :channels formed", sizeof " :channels formed" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LUSERCHANNELS(const char *prefix, const char *a0, unsigned long a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LUSERCHANNELS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LUSERME(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "255 " - 1 + n0 + sizeof " :I have " - 1 + 21 + sizeof " users, " - 1 + 21 + sizeof " services and " - 1 + 21 + sizeof " servers" - 1);
+	p = msgbuf_put_bytes(p, "255 ", sizeof "255 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :I have ", sizeof " :I have " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " users, ", sizeof " users, " - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " services and ", sizeof " services and " - 1);
+	p = msgbuf_put_ulong(p, a3, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " servers", sizeof " servers" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LUSERME(const char *prefix, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LUSERME(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ADMINME(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "256 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Administrative info" - 1);
+	p = msgbuf_put_bytes(p, "256 ", sizeof "256 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Administrative info", sizeof " :Administrative info" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ADMINME(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ADMINME(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ADMINLOC1(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "257 " - 1 + n0 + sizeof " :" - 1 + n1);
+	p = msgbuf_put_bytes(p, "257 ", sizeof "257 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ADMINLOC1(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ADMINLOC1(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ADMINLOC2(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "258 " - 1 + n0 + sizeof " :" - 1 + n1);
+	p = msgbuf_put_bytes(p, "258 ", sizeof "258 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ADMINLOC2(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ADMINLOC2(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ADMINEMAIL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "259 " - 1 + n0 + sizeof " :" - 1 + n1);
+	p = msgbuf_put_bytes(p, "259 ", sizeof "259 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ADMINEMAIL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ADMINEMAIL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TRACEEND(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "262 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof "-" - 1 + n3 + sizeof "." - 1 + n4 + sizeof " :End of TRACE" - 1);
+	p = msgbuf_put_bytes(p, "262 ", sizeof "262 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, "-", sizeof "-" - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, ".", sizeof "." - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	p = msgbuf_put_bytes(p, " :End of TRACE", sizeof " :End of TRACE" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TRACEEND(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TRACEEND(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TRYAGAIN(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "263 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Server load is temporarily too heavy. Please wait a while and try again." - 1);
+	p = msgbuf_put_bytes(p, "263 ", sizeof "263 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Server load is temporarily too heavy. Please wait a while and try again.", sizeof " :Server load is temporarily too heavy. Please wait a while and try again." - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TRYAGAIN(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TRYAGAIN(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LOCALUSERS(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "265 " - 1 + n0 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " :Current local users: " - 1 + 21 + sizeof ", Max: " - 1 + 21);
+	p = msgbuf_put_bytes(p, "265 ", sizeof "265 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :Current local users: ", sizeof " :Current local users: " - 1);
+	p = msgbuf_put_ulong(p, a3, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, ", Max: ", sizeof ", Max: " - 1);
+	p = msgbuf_put_ulong(p, a4, 10, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LOCALUSERS(const char *prefix, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LOCALUSERS(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_NETUSERS(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "266 " - 1 + n0 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " :Current global users: " - 1 + 21 + sizeof ", Max: " - 1 + 21);
+	p = msgbuf_put_bytes(p, "266 ", sizeof "266 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :Current global users: ", sizeof " :Current global users: " - 1);
+	p = msgbuf_put_ulong(p, a3, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, ", Max: ", sizeof ", Max: " - 1);
+	p = msgbuf_put_ulong(p, a4, 10, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_NETUSERS(const char *prefix, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_NETUSERS(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_STATSCONN(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "250 " - 1 + n0 + sizeof " :Highest connection count: " - 1 + 21 + sizeof " (" - 1 + 21 + sizeof " connections received)" - 1);
+	p = msgbuf_put_bytes(p, "250 ", sizeof "250 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Highest connection count: ", sizeof " :Highest connection count: " - 1);
+	p = msgbuf_put_ulong(p, a1, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " (", sizeof " (" - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " connections received)", sizeof " connections received)" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_STATSCONN(const char *prefix, const char *a0, unsigned long a1, unsigned long a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_STATSCONN(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISSSL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "275 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is connected via SSL (secure link)" - 1);
+	p = msgbuf_put_bytes(p, "275 ", sizeof "275 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is connected via SSL (secure link)", sizeof " :is connected via SSL (secure link)" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISSSL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISSSL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISCERTFP(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "276 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :has client certificate fingerprint " - 1 + n2);
+	p = msgbuf_put_bytes(p, "276 ", sizeof "276 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :has client certificate fingerprint ", sizeof " :has client certificate fingerprint " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISCERTFP(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISCERTFP(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_AWAY(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "301 " - 1 + n0 + sizeof " " - 1 + n1);
+	p = msgbuf_put_bytes(p, "301 ", sizeof "301 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_AWAY(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_AWAY(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_USERHOST(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "302 " - 1 + n0 + sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, "302 ", sizeof "302 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_USERHOST(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_USERHOST(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ISON(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "303 " - 1 + n0 + sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, "303 ", sizeof "303 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ISON(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ISON(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_UNAWAY(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "305 " - 1 + n0 + sizeof " :You are no longer marked as being away" - 1);
+	p = msgbuf_put_bytes(p, "305 ", sizeof "305 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :You are no longer marked as being away", sizeof " :You are no longer marked as being away" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_UNAWAY(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_UNAWAY(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_NOWAWAY(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "306 " - 1 + n0 + sizeof " :You have been marked as being away" - 1);
+	p = msgbuf_put_bytes(p, "306 ", sizeof "306 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :You have been marked as being away", sizeof " :You have been marked as being away" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_NOWAWAY(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_NOWAWAY(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISREGNICK(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "307 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is a registered nick" - 1);
+	p = msgbuf_put_bytes(p, "307 ", sizeof "307 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is a registered nick", sizeof " :is a registered nick" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISREGNICK(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISREGNICK(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISSERVICE(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "310 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is an IRC service" - 1);
+	p = msgbuf_put_bytes(p, "310 ", sizeof "310 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is an IRC service", sizeof " :is an IRC service" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISSERVICE(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISSERVICE(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISUSER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "311 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " * :" - 1 + n4);
+	p = msgbuf_put_bytes(p, "311 ", sizeof "311 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " * :", sizeof " * :" - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISUSER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISUSER(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISSERVER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "312 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :" - 1 + n3);
+	p = msgbuf_put_bytes(p, "312 ", sizeof "312 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISSERVER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISSERVER(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISOPERATOR(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "313 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is an IRC operator" - 1);
+	p = msgbuf_put_bytes(p, "313 ", sizeof "313 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is an IRC operator", sizeof " :is an IRC operator" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISOPERATOR(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISOPERATOR(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOWASUSER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "314 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " * :" - 1 + n4);
+	p = msgbuf_put_bytes(p, "314 ", sizeof "314 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " * :", sizeof " * :" - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOWASUSER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOWASUSER(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFWHO(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "315 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of WHO list" - 1);
+	p = msgbuf_put_bytes(p, "315 ", sizeof "315 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of WHO list", sizeof " :End of WHO list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFWHO(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFWHO(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISIDLE(MsgBuf *buf, const char *a0, const char *a1, unsigned long a2, unsigned long a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "317 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + 21 + sizeof " " - 1 + 21 + sizeof " :seconds idle, signon time" - 1);
+	p = msgbuf_put_bytes(p, "317 ", sizeof "317 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a3, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :seconds idle, signon time", sizeof " :seconds idle, signon time" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISIDLE(const char *prefix, const char *a0, const char *a1, unsigned long a2, unsigned long a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISIDLE(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFWHOIS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "318 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of WHOIS list" - 1);
+	p = msgbuf_put_bytes(p, "318 ", sizeof "318 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of WHOIS list", sizeof " :End of WHOIS list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFWHOIS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFWHOIS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISCHANNELS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "319 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, "319 ", sizeof "319 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISCHANNELS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISCHANNELS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LISTSTART(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "321 " - 1 + n0 + sizeof " Channel :Users  Name" - 1);
+	p = msgbuf_put_bytes(p, "321 ", sizeof "321 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " Channel :Users  Name", sizeof " Channel :Users  Name" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LISTSTART(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LISTSTART(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LIST(MsgBuf *buf, const char *a0, const char *a1, long a2, const char *a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "322 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + 21 + sizeof " :" - 1 + n3);
+	p = msgbuf_put_bytes(p, "322 ", sizeof "322 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a2, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LIST(const char *prefix, const char *a0, const char *a1, long a2, const char *a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LIST(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LISTEND(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "323 " - 1 + n0 + sizeof " :End of LIST" - 1);
+	p = msgbuf_put_bytes(p, "323 ", sizeof "323 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :End of LIST", sizeof " :End of LIST" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LISTEND(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LISTEND(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_CHANNELMODEIS(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "324 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " +" - 1 + n2);
+	p = msgbuf_put_bytes(p, "324 ", sizeof "324 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " +", sizeof " +" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_CHANNELMODEIS(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_CHANNELMODEIS(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_CREATIONTIME(MsgBuf *buf, const char *a0, const char *a1, long a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "329 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "329 ", sizeof "329 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a2, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_CREATIONTIME(const char *prefix, const char *a0, const char *a1, long a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_CREATIONTIME(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISLOGGEDIN(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "330 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :is logged in as" - 1);
+	p = msgbuf_put_bytes(p, "330 ", sizeof "330 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :is logged in as", sizeof " :is logged in as" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISLOGGEDIN(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISLOGGEDIN(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_NOTOPIC(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "331 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :No topic is set" - 1);
+	p = msgbuf_put_bytes(p, "331 ", sizeof "331 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :No topic is set", sizeof " :No topic is set" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_NOTOPIC(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_NOTOPIC(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TOPIC(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "332 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :" - 1 + n2);
+	p = msgbuf_put_bytes(p, "332 ", sizeof "332 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TOPIC(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TOPIC(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TOPICSETBY(MsgBuf *buf, const char *a0, const char *a1, const char *a2, unsigned a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "333 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "333 ", sizeof "333 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_ulong(p, a3, 10, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TOPICSETBY(const char *prefix, const char *a0, const char *a1, const char *a2, unsigned a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TOPICSETBY(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISBOT(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "335 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is an IRC Bot" - 1);
+	p = msgbuf_put_bytes(p, "335 ", sizeof "335 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is an IRC Bot", sizeof " :is an IRC Bot" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISBOT(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISBOT(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_INVITING(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "341 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + n3);
+	p = msgbuf_put_bytes(p, "341 ", sizeof "341 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, a3, n3);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_INVITING(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_INVITING(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_INVITELIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "346 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "346 ", sizeof "346 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_INVITELIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_INVITELIST(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFINVITELIST(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "347 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of channel invite list" - 1);
+	p = msgbuf_put_bytes(p, "347 ", sizeof "347 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of channel invite list", sizeof " :End of channel invite list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFINVITELIST(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFINVITELIST(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_EXCEPTLIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "348 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "348 ", sizeof "348 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_EXCEPTLIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_EXCEPTLIST(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFEXCEPTLIST(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "349 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of channel exception list" - 1);
+	p = msgbuf_put_bytes(p, "349 ", sizeof "349 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of channel exception list", sizeof " :End of channel exception list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFEXCEPTLIST(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFEXCEPTLIST(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_VERSION(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	a5 = a5 ? a5 : "(null)";
+	size_t n5 = strlen(a5);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "351 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof "-" - 1 + n2 + sizeof "." - 1 + n3 + sizeof " " - 1 + n4 + sizeof " :" - 1 + n5);
+	p = msgbuf_put_bytes(p, "351 ", sizeof "351 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, "-", sizeof "-" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, ".", sizeof "." - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a5, n5);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_VERSION(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_VERSION(buf, a0, a1, a2, a3, a4, a5);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOREPLY(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, const char *a6, int a7, const char *a8)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	a5 = a5 ? a5 : "(null)";
+	size_t n5 = strlen(a5);
+	a6 = a6 ? a6 : "(null)";
+	size_t n6 = strlen(a6);
+	a8 = a8 ? a8 : "(null)";
+	size_t n8 = strlen(a8);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "352 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " " - 1 + n4 + sizeof " " - 1 + n5 + sizeof " " - 1 + n6 + sizeof " :" - 1 + 21 + sizeof " " - 1 + n8);
+	p = msgbuf_put_bytes(p, "352 ", sizeof "352 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a5, n5);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a6, n6);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_long(p, a7, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a8, n8);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOREPLY(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, const char *a6, int a7, const char *a8)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOREPLY(buf, a0, a1, a2, a3, a4, a5, a6, a7, a8);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_NAMREPLY(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "353 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, "353 ", sizeof "353 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_NAMREPLY(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_NAMREPLY(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_LINKS(MsgBuf *buf, const char *a0, const char *a1, const char *a2, int a3, const char *a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a4 = a4 ? a4 : "(null)";
+	size_t n4 = strlen(a4);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "364 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :" - 1 + 21 + sizeof " " - 1 + n4);
+	p = msgbuf_put_bytes(p, "364 ", sizeof "364 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a4, n4);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_LINKS(const char *prefix, const char *a0, const char *a1, const char *a2, int a3, const char *a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_LINKS(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFLINKS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "365 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of LINKS list" - 1);
+	p = msgbuf_put_bytes(p, "365 ", sizeof "365 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of LINKS list", sizeof " :End of LINKS list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFLINKS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFLINKS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFNAMES(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "366 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of NAMES list" - 1);
+	p = msgbuf_put_bytes(p, "366 ", sizeof "366 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of NAMES list", sizeof " :End of NAMES list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFNAMES(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFNAMES(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_BANLIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "367 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " " - 1 + n3 + sizeof " " - 1 + 21);
+	p = msgbuf_put_bytes(p, "367 ", sizeof "367 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_long(p, a4, 0, ' ', false);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_BANLIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_BANLIST(buf, a0, a1, a2, a3, a4);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFBANLIST(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "368 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of channel ban list" - 1);
+	p = msgbuf_put_bytes(p, "368 ", sizeof "368 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of channel ban list", sizeof " :End of channel ban list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFBANLIST(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFBANLIST(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFWHOWAS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "369 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :End of WHOWAS list" - 1);
+	p = msgbuf_put_bytes(p, "369 ", sizeof "369 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :End of WHOWAS list", sizeof " :End of WHOWAS list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFWHOWAS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFWHOWAS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_INFO(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "371 " - 1 + n0 + sizeof " :" - 1 + n1);
+	p = msgbuf_put_bytes(p, "371 ", sizeof "371 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_INFO(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_INFO(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFINFO(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "374 " - 1 + n0 + sizeof " :End of INFO list" - 1);
+	p = msgbuf_put_bytes(p, "374 ", sizeof "374 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :End of INFO list", sizeof " :End of INFO list" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFINFO(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFINFO(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_MOTD(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "372 " - 1 + n0 + sizeof " :- " - 1 + n1);
+	p = msgbuf_put_bytes(p, "372 ", sizeof "372 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :- ", sizeof " :- " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_MOTD(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_MOTD(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_MOTDSTART(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "375 " - 1 + n0 + sizeof " :- " - 1 + n1 + sizeof " message of the day" - 1);
+	p = msgbuf_put_bytes(p, "375 ", sizeof "375 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :- ", sizeof " :- " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " message of the day", sizeof " message of the day" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_MOTDSTART(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_MOTDSTART(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_ENDOFMOTD(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "376 " - 1 + n0 + sizeof " :End of MOTD command" - 1);
+	p = msgbuf_put_bytes(p, "376 ", sizeof "376 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :End of MOTD command", sizeof " :End of MOTD command" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_ENDOFMOTD(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_ENDOFMOTD(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISHOST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	a3 = a3 ? a3 : "(null)";
+	size_t n3 = strlen(a3);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "378 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is connecting from *@" - 1 + n2 + sizeof " " - 1 + n3);
+	p = msgbuf_put_bytes(p, "378 ", sizeof "378 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is connecting from *@", sizeof " :is connecting from *@" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a3, n3);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISHOST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISHOST(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_WHOISMODES(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "379 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is using modes +" - 1 + n2);
+	p = msgbuf_put_bytes(p, "379 ", sizeof "379 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is using modes +", sizeof " :is using modes +" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_WHOISMODES(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_WHOISMODES(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_YOUREOPER(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "381 " - 1 + n0 + sizeof " :You are now an IRC Operator" - 1);
+	p = msgbuf_put_bytes(p, "381 ", sizeof "381 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :You are now an IRC Operator", sizeof " :You are now an IRC Operator" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_YOUREOPER(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_YOUREOPER(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_REHASHING(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "382 " - 1 + n0 + sizeof " :Rehashing" - 1);
+	p = msgbuf_put_bytes(p, "382 ", sizeof "382 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Rehashing", sizeof " :Rehashing" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_REHASHING(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_REHASHING(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_YOURESERVICE(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "383 " - 1 + n0 + sizeof " :You are service " - 1 + n1);
+	p = msgbuf_put_bytes(p, "383 ", sizeof "383 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :You are service ", sizeof " :You are service " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_YOURESERVICE(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_YOURESERVICE(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_TIME(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "391 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :" - 1 + n2);
+	p = msgbuf_put_bytes(p, "391 ", sizeof "391 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :", sizeof " :" - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_TIME(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_TIME(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_RPL_HOSTHIDDEN(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "396 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :is your displayed hostname now" - 1);
+	p = msgbuf_put_bytes(p, "396 ", sizeof "396 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :is your displayed hostname now", sizeof " :is your displayed hostname now" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_RPL_HOSTHIDDEN(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_RPL_HOSTHIDDEN(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOSUCHNICK(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "401 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :No such nick or channel name" - 1);
+	p = msgbuf_put_bytes(p, "401 ", sizeof "401 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :No such nick or channel name", sizeof " :No such nick or channel name" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOSUCHNICK(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOSUCHNICK(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOSUCHSERVER(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "402 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :No such server" - 1);
+	p = msgbuf_put_bytes(p, "402 ", sizeof "402 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :No such server", sizeof " :No such server" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOSUCHSERVER(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOSUCHSERVER(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOSUCHCHANNEL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "403 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :No such channel" - 1);
+	p = msgbuf_put_bytes(p, "403 ", sizeof "403 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :No such channel", sizeof " :No such channel" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOSUCHCHANNEL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOSUCHCHANNEL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_CANNOTSENDTOCHAN(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "404 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot send to channel" - 1);
+	p = msgbuf_put_bytes(p, "404 ", sizeof "404 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot send to channel", sizeof " :Cannot send to channel" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_CANNOTSENDTOCHAN(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_CANNOTSENDTOCHAN(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_TOOMANYCHANNELS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "405 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :You have joined too many channels" - 1);
+	p = msgbuf_put_bytes(p, "405 ", sizeof "405 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :You have joined too many channels", sizeof " :You have joined too many channels" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_TOOMANYCHANNELS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_TOOMANYCHANNELS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_WASNOSUCHNICK(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "406 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :There was no such nickname" - 1);
+	p = msgbuf_put_bytes(p, "406 ", sizeof "406 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :There was no such nickname", sizeof " :There was no such nickname" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_WASNOSUCHNICK(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_WASNOSUCHNICK(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_TOOMANYTARGETS(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "407 " - 1 + n0 + sizeof " :Too many recipients" - 1);
+	p = msgbuf_put_bytes(p, "407 ", sizeof "407 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Too many recipients", sizeof " :Too many recipients" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_TOOMANYTARGETS(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_TOOMANYTARGETS(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOORIGIN(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "409 " - 1 + n0 + sizeof " :No origin specified" - 1);
+	p = msgbuf_put_bytes(p, "409 ", sizeof "409 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :No origin specified", sizeof " :No origin specified" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOORIGIN(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOORIGIN(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_INVALIDCAP(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "410 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Invalid CAP subcommand" - 1);
+	p = msgbuf_put_bytes(p, "410 ", sizeof "410 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Invalid CAP subcommand", sizeof " :Invalid CAP subcommand" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_INVALIDCAP(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_INVALIDCAP(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NORECIPIENT(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "411 " - 1 + n0 + sizeof " :No recipient given" - 1);
+	p = msgbuf_put_bytes(p, "411 ", sizeof "411 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :No recipient given", sizeof " :No recipient given" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NORECIPIENT(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NORECIPIENT(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOTEXTTOSEND(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "412 " - 1 + n0 + sizeof " :No text to send" - 1);
+	p = msgbuf_put_bytes(p, "412 ", sizeof "412 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :No text to send", sizeof " :No text to send" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOTEXTTOSEND(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOTEXTTOSEND(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_WILDTOPLEVEL(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "414 " - 1 + n0 + sizeof " :Wildcard in toplevel domain" - 1);
+	p = msgbuf_put_bytes(p, "414 ", sizeof "414 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Wildcard in toplevel domain", sizeof " :Wildcard in toplevel domain" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_WILDTOPLEVEL(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_WILDTOPLEVEL(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_UNKNOWNCOMMAND(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "421 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Unknown command" - 1);
+	p = msgbuf_put_bytes(p, "421 ", sizeof "421 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Unknown command", sizeof " :Unknown command" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_UNKNOWNCOMMAND(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_UNKNOWNCOMMAND(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOMOTD(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "422 " - 1 + n0 + sizeof " :MOTD file is missing" - 1);
+	p = msgbuf_put_bytes(p, "422 ", sizeof "422 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :MOTD file is missing", sizeof " :MOTD file is missing" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOMOTD(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOMOTD(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NONICKNAMEGIVEN(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "431 " - 1 + n0 + sizeof " :No nickname given" - 1);
+	p = msgbuf_put_bytes(p, "431 ", sizeof "431 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :No nickname given", sizeof " :No nickname given" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NONICKNAMEGIVEN(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NONICKNAMEGIVEN(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_ERRONEUSNICKNAME(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "432 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Erroneous nickname" - 1);
+	p = msgbuf_put_bytes(p, "432 ", sizeof "432 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Erroneous nickname", sizeof " :Erroneous nickname" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_ERRONEUSNICKNAME(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_ERRONEUSNICKNAME(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NICKNAMETOOLONG(MsgBuf *buf, const char *a0, const char *a1, unsigned a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "432 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Nickname too long, max. " - 1 + 21 + sizeof " characters" - 1);
+	p = msgbuf_put_bytes(p, "432 ", sizeof "432 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Nickname too long, max. ", sizeof " :Nickname too long, max. " - 1);
+	p = msgbuf_put_ulong(p, a2, 10, 0, ' ', false);
+	p = msgbuf_put_bytes(p, " characters", sizeof " characters" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NICKNAMETOOLONG(const char *prefix, const char *a0, const char *a1, unsigned a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NICKNAMETOOLONG(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_FORBIDDENNICKNAME(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "432 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Nickname is forbidden/blocked" - 1);
+	p = msgbuf_put_bytes(p, "432 ", sizeof "432 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Nickname is forbidden/blocked", sizeof " :Nickname is forbidden/blocked" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_FORBIDDENNICKNAME(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_FORBIDDENNICKNAME(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NICKNAMEINUSE(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "433 " - 1 + n0 + sizeof " :Nickname already in use" - 1);
+	p = msgbuf_put_bytes(p, "433 ", sizeof "433 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Nickname already in use", sizeof " :Nickname already in use" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NICKNAMEINUSE(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NICKNAMEINUSE(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_USERNOTINCHANNEL(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "441 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :They aren't on that channel" - 1);
+	p = msgbuf_put_bytes(p, "441 ", sizeof "441 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :They aren't on that channel", sizeof " :They aren't on that channel" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_USERNOTINCHANNEL(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_USERNOTINCHANNEL(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOTONCHANNEL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "442 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :You are not on that channel" - 1);
+	p = msgbuf_put_bytes(p, "442 ", sizeof "442 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :You are not on that channel", sizeof " :You are not on that channel" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOTONCHANNEL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOTONCHANNEL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_USERONCHANNEL(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "443 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :is already on channel" - 1);
+	p = msgbuf_put_bytes(p, "443 ", sizeof "443 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :is already on channel", sizeof " :is already on channel" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_USERONCHANNEL(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_USERONCHANNEL(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_SUMMONDISABLED(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "445 " - 1 + n0 + sizeof " :SUMMON has been disabled" - 1);
+	p = msgbuf_put_bytes(p, "445 ", sizeof "445 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :SUMMON has been disabled", sizeof " :SUMMON has been disabled" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_SUMMONDISABLED(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_SUMMONDISABLED(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_USERSDISABLED(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "446 " - 1 + n0 + sizeof " :USERS has been disabled" - 1);
+	p = msgbuf_put_bytes(p, "446 ", sizeof "446 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :USERS has been disabled", sizeof " :USERS has been disabled" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_USERSDISABLED(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_USERSDISABLED(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NONICKCHANGE(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "447 " - 1 + n0 + sizeof " :Cannot change nickname while on " - 1 + n1 + sizeof "(+N)" - 1);
+	p = msgbuf_put_bytes(p, "447 ", sizeof "447 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Cannot change nickname while on ", sizeof " :Cannot change nickname while on " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, "(+N)", sizeof "(+N)" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NONICKCHANGE(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NONICKCHANGE(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOTREGISTERED(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "451 " - 1 + n0 + sizeof " :Connection not registered" - 1);
+	p = msgbuf_put_bytes(p, "451 ", sizeof "451 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Connection not registered", sizeof " :Connection not registered" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOTREGISTERED(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOTREGISTERED(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOTREGISTEREDSERVER(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "451 " - 1 + n0 + sizeof " :Connection not registered as server link" - 1);
+	p = msgbuf_put_bytes(p, "451 ", sizeof "451 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Connection not registered as server link", sizeof " :Connection not registered as server link" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOTREGISTEREDSERVER(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOTREGISTEREDSERVER(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NEEDMOREPARAMS(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "461 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Syntax error" - 1);
+	p = msgbuf_put_bytes(p, "461 ", sizeof "461 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Syntax error", sizeof " :Syntax error" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NEEDMOREPARAMS(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NEEDMOREPARAMS(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_ALREADYREGISTRED(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "462 " - 1 + n0 + sizeof " :Connection already registered" - 1);
+	p = msgbuf_put_bytes(p, "462 ", sizeof "462 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Connection already registered", sizeof " :Connection already registered" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_ALREADYREGISTRED(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_ALREADYREGISTRED(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_PASSWDMISMATCH(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "464 " - 1 + n0 + sizeof " :Invalid password" - 1);
+	p = msgbuf_put_bytes(p, "464 ", sizeof "464 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Invalid password", sizeof " :Invalid password" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_PASSWDMISMATCH(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_PASSWDMISMATCH(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_CHANNELISFULL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "471 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+l) -- Channel is full, try later" - 1);
+	p = msgbuf_put_bytes(p, "471 ", sizeof "471 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+l) -- Channel is full, try later", sizeof " :Cannot join channel (+l) -- Channel is full, try later" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_CHANNELISFULL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_CHANNELISFULL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_SECURECHANNEL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "471 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+z) -- SSL connections only" - 1);
+	p = msgbuf_put_bytes(p, "471 ", sizeof "471 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+z) -- SSL connections only", sizeof " :Cannot join channel (+z) -- SSL connections only" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_SECURECHANNEL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_SECURECHANNEL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_OPONLYCHANNEL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "471 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+O) -- IRC opers only" - 1);
+	p = msgbuf_put_bytes(p, "471 ", sizeof "471 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+O) -- IRC opers only", sizeof " :Cannot join channel (+O) -- IRC opers only" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_OPONLYCHANNEL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_OPONLYCHANNEL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_REGONLYCHANNEL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "471 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+R) -- Registered users only" - 1);
+	p = msgbuf_put_bytes(p, "471 ", sizeof "471 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+R) -- Registered users only", sizeof " :Cannot join channel (+R) -- Registered users only" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_REGONLYCHANNEL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_REGONLYCHANNEL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_UNKNOWNMODE(MsgBuf *buf, const char *a0, char a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "472 " - 1 + n0 + sizeof " " - 1 + 1 + sizeof " :is unknown mode char for " - 1 + n2);
+	p = msgbuf_put_bytes(p, "472 ", sizeof "472 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	*p++ = a1;
+	p = msgbuf_put_bytes(p, " :is unknown mode char for ", sizeof " :is unknown mode char for " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_UNKNOWNMODE(const char *prefix, const char *a0, char a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_UNKNOWNMODE(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_INVITEONLYCHAN(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "473 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+i) -- Invited users only" - 1);
+	p = msgbuf_put_bytes(p, "473 ", sizeof "473 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+i) -- Invited users only", sizeof " :Cannot join channel (+i) -- Invited users only" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_INVITEONLYCHAN(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_INVITEONLYCHAN(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_BANNEDFROMCHAN(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "474 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+b) -- You are banned" - 1);
+	p = msgbuf_put_bytes(p, "474 ", sizeof "474 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+b) -- You are banned", sizeof " :Cannot join channel (+b) -- You are banned" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_BANNEDFROMCHAN(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_BANNEDFROMCHAN(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_BADCHANNELKEY(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "475 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot join channel (+k) -- Wrong channel key" - 1);
+	p = msgbuf_put_bytes(p, "475 ", sizeof "475 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot join channel (+k) -- Wrong channel key", sizeof " :Cannot join channel (+k) -- Wrong channel key" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_BADCHANNELKEY(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_BADCHANNELKEY(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOCHANMODES(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "477 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Channel doesn't support modes" - 1);
+	p = msgbuf_put_bytes(p, "477 ", sizeof "477 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Channel doesn't support modes", sizeof " :Channel doesn't support modes" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOCHANMODES(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOCHANMODES(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NEEDREGGEDNICK(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "477 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot send to channel (+M) -- You need to be identified to a registered account to message this channel" - 1);
+	p = msgbuf_put_bytes(p, "477 ", sizeof "477 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot send to channel (+M) -- You need to be identified to a registered account to message this channel", sizeof " :Cannot send to channel (+M) -- You need to be identified to a registered account to message this channel" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NEEDREGGEDNICK(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NEEDREGGEDNICK(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_LISTFULL(MsgBuf *buf, const char *a0, const char *a1, const char *a2, int a3)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "478 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + n2 + sizeof " :Channel list is full (" - 1 + 21 + sizeof ")" - 1);
+	p = msgbuf_put_bytes(p, "478 ", sizeof "478 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " :Channel list is full (", sizeof " :Channel list is full (" - 1);
+	p = msgbuf_put_long(p, a3, 0, ' ', false);
+	p = msgbuf_put_bytes(p, ")", sizeof ")" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_LISTFULL(const char *prefix, const char *a0, const char *a1, const char *a2, int a3)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_LISTFULL(buf, a0, a1, a2, a3);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOPRIVILEGES(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "481 " - 1 + n0 + sizeof " :Permission denied" - 1);
+	p = msgbuf_put_bytes(p, "481 ", sizeof "481 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Permission denied", sizeof " :Permission denied" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOPRIVILEGES(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOPRIVILEGES(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_CHANOPRIVSNEEDED(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "482 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :You are not channel operator" - 1);
+	p = msgbuf_put_bytes(p, "482 ", sizeof "482 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :You are not channel operator", sizeof " :You are not channel operator" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_CHANOPRIVSNEEDED(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_CHANOPRIVSNEEDED(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_CHANOPPRIVTOOLOW(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "482 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Your privileges are too low" - 1);
+	p = msgbuf_put_bytes(p, "482 ", sizeof "482 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Your privileges are too low", sizeof " :Your privileges are too low" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_CHANOPPRIVTOOLOW(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_CHANOPPRIVTOOLOW(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_KICKDENY(MsgBuf *buf, const char *a0, const char *a1, const char *a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	a2 = a2 ? a2 : "(null)";
+	size_t n2 = strlen(a2);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "482 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :Cannot kick, " - 1 + n2 + sizeof " is protected" - 1);
+	p = msgbuf_put_bytes(p, "482 ", sizeof "482 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :Cannot kick, ", sizeof " :Cannot kick, " - 1);
+	p = msgbuf_put_bytes(p, a2, n2);
+	p = msgbuf_put_bytes(p, " is protected", sizeof " is protected" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_KICKDENY(const char *prefix, const char *a0, const char *a1, const char *a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_KICKDENY(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_CANTKILLSERVER(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "483 " - 1 + n0 + sizeof " :You can't kill a server!" - 1);
+	p = msgbuf_put_bytes(p, "483 ", sizeof "483 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :You can't kill a server!", sizeof " :You can't kill a server!" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_CANTKILLSERVER(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_CANTKILLSERVER(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_RESTRICTED(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "484 " - 1 + n0 + sizeof " :Your connection is restricted" - 1);
+	p = msgbuf_put_bytes(p, "484 ", sizeof "484 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Your connection is restricted", sizeof " :Your connection is restricted" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_RESTRICTED(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_RESTRICTED(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NICKREGISTER(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "484 " - 1 + n0 + sizeof " :Cannot modify user mode (+R) -- Use IRC services" - 1);
+	p = msgbuf_put_bytes(p, "484 ", sizeof "484 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Cannot modify user mode (+R) -- Use IRC services", sizeof " :Cannot modify user mode (+R) -- Use IRC services" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NICKREGISTER(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NICKREGISTER(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NONONREG(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "486 " - 1 + n0 + sizeof " :Cannot send to user (+b) -- You must identify to a registered nick to private message " - 1 + n1);
+	p = msgbuf_put_bytes(p, "486 ", sizeof "486 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Cannot send to user (+b) -- You must identify to a registered nick to private message ", sizeof " :Cannot send to user (+b) -- You must identify to a registered nick to private message " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NONONREG(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NONONREG(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOOPERHOST(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "491 " - 1 + n0 + sizeof " :Not configured for your host" - 1);
+	p = msgbuf_put_bytes(p, "491 ", sizeof "491 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Not configured for your host", sizeof " :Not configured for your host" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOOPERHOST(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOOPERHOST(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOTONSAMECHANNEL(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "493 " - 1 + n0 + sizeof " :You must share a common channel with " - 1 + n1);
+	p = msgbuf_put_bytes(p, "493 ", sizeof "493 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :You must share a common channel with ", sizeof " :You must share a common channel with " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOTONSAMECHANNEL(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOTONSAMECHANNEL(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_UMODEUNKNOWNFLAG(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "501 " - 1 + n0 + sizeof " :Unknown mode" - 1);
+	p = msgbuf_put_bytes(p, "501 ", sizeof "501 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Unknown mode", sizeof " :Unknown mode" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_UMODEUNKNOWNFLAG(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_UMODEUNKNOWNFLAG(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_UMODEUNKNOWNFLAG2(MsgBuf *buf, const char *a0, char a1, char a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "501 " - 1 + n0 + sizeof " :Unknown mode \"" - 1 + 1 + 1 + sizeof "\"" - 1);
+	p = msgbuf_put_bytes(p, "501 ", sizeof "501 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Unknown mode \"", sizeof " :Unknown mode \"" - 1);
+	*p++ = a1;
+	*p++ = a2;
+	p = msgbuf_put_bytes(p, "\"", sizeof "\"" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_UMODEUNKNOWNFLAG2(const char *prefix, const char *a0, char a1, char a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_UMODEUNKNOWNFLAG2(buf, a0, a1, a2);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_USERSDONTMATCH(MsgBuf *buf, const char *a0)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "502 " - 1 + n0 + sizeof " :Can't set/get mode for other users" - 1);
+	p = msgbuf_put_bytes(p, "502 ", sizeof "502 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Can't set/get mode for other users", sizeof " :Can't set/get mode for other users" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_USERSDONTMATCH(const char *prefix, const char *a0)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_USERSDONTMATCH(buf, a0);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_USERNOTONSERV(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "504 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " :User is not on this server" - 1);
+	p = msgbuf_put_bytes(p, "504 ", sizeof "504 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " :User is not on this server", sizeof " :User is not on this server" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_USERNOTONSERV(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_USERNOTONSERV(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_NOINVITE(MsgBuf *buf, const char *a0, const char *a1)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "518 " - 1 + n0 + sizeof " :Cannot invite to " - 1 + n1 + sizeof " (+V)" - 1);
+	p = msgbuf_put_bytes(p, "518 ", sizeof "518 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " :Cannot invite to ", sizeof " :Cannot invite to " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " (+V)", sizeof " (+V)" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_NOINVITE(const char *prefix, const char *a0, const char *a1)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_NOINVITE(buf, a0, a1);
+	return reply_end(buf);
+}
+
+void msgbuf_add_ERR_INVALIDMODEPARAM(MsgBuf *buf, const char *a0, const char *a1, char a2)
+{
+	a0 = a0 ? a0 : "(null)";
+	size_t n0 = strlen(a0);
+	a1 = a1 ? a1 : "(null)";
+	size_t n1 = strlen(a1);
+	char *p = msgbuf_reserve(buf, 0 + sizeof "696 " - 1 + n0 + sizeof " " - 1 + n1 + sizeof " " - 1 + 1 + sizeof " * :Invalid mode parameter" - 1);
+	p = msgbuf_put_bytes(p, "696 ", sizeof "696 " - 1);
+	p = msgbuf_put_bytes(p, a0, n0);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	p = msgbuf_put_bytes(p, a1, n1);
+	p = msgbuf_put_bytes(p, " ", sizeof " " - 1);
+	*p++ = a2;
+	p = msgbuf_put_bytes(p, " * :Invalid mode parameter", sizeof " * :Invalid mode parameter" - 1);
+	msgbuf_commit(buf, p);
+}
+
+char *reply_ERR_INVALIDMODEPARAM(const char *prefix, const char *a0, const char *a1, char a2)
+{
+	MsgBuf *buf = reply_begin(prefix);
+	msgbuf_add_ERR_INVALIDMODEPARAM(buf, a0, a1, a2);
+	return reply_end(buf);
+}
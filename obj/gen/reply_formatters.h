@@ -0,0 +1,577 @@
+/* Generated by genreplies from src/include/replies.h. Do not edit. */
+
+#pragma once
+
+#include "include/msgbuf.h"
+
+/* "001 %s :Welcome to the Internet Relay Network %s" */
+void msgbuf_add_RPL_WELCOME(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WELCOME(const char *prefix, const char *a0, const char *a1);
+
+/* "002 %s :Your host is %s" */
+void msgbuf_add_RPL_YOURHOST(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_YOURHOST(const char *prefix, const char *a0, const char *a1);
+
+/* "003 %s :This server has been started %s" */
+void msgbuf_add_RPL_CREATED(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_CREATED(const char *prefix, const char *a0, const char *a1);
+
+/* "004 %s %s %s %s" */
+void msgbuf_add_RPL_MYINFO(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3);
+char *reply_RPL_MYINFO(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3);
+
+/* "005 %s NETWORK=%s :is my network name" */
+void msgbuf_add_RPL_ISUPPORTNET(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ISUPPORTNET(const char *prefix, const char *a0, const char *a1);
+
+/* "005 %s RFC2812 CHARSET=UTF-8 CASEMAPPING=ascii PREFIX=(qaohv)~&@%%+ CHANTYPES=%s CHANMODES=beI,k,l,imMnOPQRstVz CHANLIMIT=%s:%d :are supported on this server" */
+void msgbuf_add_RPL_ISUPPORT1(MsgBuf *buf, const char *a0, const char *a1, const char *a2, int a3);
+char *reply_RPL_ISUPPORT1(const char *prefix, const char *a0, const char *a1, const char *a2, int a3);
+
+/* "005 %s CHANNELLEN=%d NICKLEN=%d TOPICLEN=%d AWAYLEN=%d KICKLEN=%d MODES=%d MAXLIST=beI:%d EXCEPTS=e INVEX=I PENALTY FNC :are supported on this server" */
+void msgbuf_add_RPL_ISUPPORT2(MsgBuf *buf, const char *a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7);
+char *reply_RPL_ISUPPORT2(const char *prefix, const char *a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7);
+
+/* "200 %s Link %s-%s %s %s V%s %ld %d %d" */
+void msgbuf_add_RPL_TRACELINK(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, long a6, int a7, int a8);
+char *reply_RPL_TRACELINK(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, long a6, int a7, int a8);
+
+/* "204 %s Oper 2 :%s" */
+void msgbuf_add_RPL_TRACEOPERATOR(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_TRACEOPERATOR(const char *prefix, const char *a0, const char *a1);
+
+/* "206 %s Serv 1 0S 0C %s[%s@%s] *!*@%s :V%s" */
+void msgbuf_add_RPL_TRACESERVER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5);
+char *reply_RPL_TRACESERVER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5);
+
+/* "211 %s %s %d %ld %ld %ld %ld :%ld" */
+void msgbuf_add_RPL_STATSLINKINFO(MsgBuf *buf, const char *a0, const char *a1, int a2, long a3, long a4, long a5, long a6, long a7);
+char *reply_RPL_STATSLINKINFO(const char *prefix, const char *a0, const char *a1, int a2, long a3, long a4, long a5, long a6, long a7);
+
+/* "212 %s %s %ld %ld %ld" */
+void msgbuf_add_RPL_STATSCOMMANDS(MsgBuf *buf, const char *a0, const char *a1, long a2, long a3, long a4);
+char *reply_RPL_STATSCOMMANDS(const char *prefix, const char *a0, const char *a1, long a2, long a3, long a4);
+
+/* "216 %s %c %s %ld :%s" */
+void msgbuf_add_RPL_STATSXLINE(MsgBuf *buf, const char *a0, char a1, const char *a2, long a3, const char *a4);
+char *reply_RPL_STATSXLINE(const char *prefix, const char *a0, char a1, const char *a2, long a3, const char *a4);
+
+/* "219 %s %c :End of STATS report" */
+void msgbuf_add_RPL_ENDOFSTATS(MsgBuf *buf, const char *a0, char a1);
+char *reply_RPL_ENDOFSTATS(const char *prefix, const char *a0, char a1);
+
+/* "221 %s +%s" */
+void msgbuf_add_RPL_UMODEIS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_UMODEIS(const char *prefix, const char *a0, const char *a1);
+
+/* "234 %s %s %s %s %d %d :%s" */
+void msgbuf_add_RPL_SERVLIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4, int a5, const char *a6);
+char *reply_RPL_SERVLIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4, int a5, const char *a6);
+
+/* "235 %s %s %s :End of service listing" */
+void msgbuf_add_RPL_SERVLISTEND(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_SERVLISTEND(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "242 %s :Server Up %u days %u:%02u:%02u" */
+void msgbuf_add_RPL_STATSUPTIME(MsgBuf *buf, const char *a0, unsigned a1, unsigned a2, unsigned a3, unsigned a4);
+char *reply_RPL_STATSUPTIME(const char *prefix, const char *a0, unsigned a1, unsigned a2, unsigned a3, unsigned a4);
+
+/* "249 %s :%s" */
+void msgbuf_add_RPL_STATSDEBUG(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_STATSDEBUG(const char *prefix, const char *a0, const char *a1);
+
+/* "251 %s :There are %ld users and %ld services on %ld servers" */
+void msgbuf_add_RPL_LUSERCLIENT(MsgBuf *buf, const char *a0, long a1, long a2, long a3);
+char *reply_RPL_LUSERCLIENT(const char *prefix, const char *a0, long a1, long a2, long a3);
+
+/* "252 %s %lu :operator(s) online" */
+void msgbuf_add_RPL_LUSEROP(MsgBuf *buf, const char *a0, unsigned long a1);
+char *reply_RPL_LUSEROP(const char *prefix, const char *a0, unsigned long a1);
+
+/* "253 %s %lu :unknown connection(s)" */
+void msgbuf_add_RPL_LUSERUNKNOWN(MsgBuf *buf, const char *a0, unsigned long a1);
+char *reply_RPL_LUSERUNKNOWN(const char *prefix, const char *a0, unsigned long a1);
+
+/* "254 %s %lu :channels formed" */
+void msgbuf_add_RPL_LUSERCHANNELS(MsgBuf *buf, const char *a0, unsigned long a1);
+char *reply_RPL_LUSERCHANNELS(const char *prefix, const char *a0, unsigned long a1);
+
+/* "255 %s :I have %lu users, %lu services and %lu servers" */
+void msgbuf_add_RPL_LUSERME(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3);
+char *reply_RPL_LUSERME(const char *prefix, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3);
+
+/* "256 %s %s :Administrative info" */
+void msgbuf_add_RPL_ADMINME(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ADMINME(const char *prefix, const char *a0, const char *a1);
+
+/* "257 %s :%s" */
+void msgbuf_add_RPL_ADMINLOC1(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ADMINLOC1(const char *prefix, const char *a0, const char *a1);
+
+/* "258 %s :%s" */
+void msgbuf_add_RPL_ADMINLOC2(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ADMINLOC2(const char *prefix, const char *a0, const char *a1);
+
+/* "259 %s :%s" */
+void msgbuf_add_RPL_ADMINEMAIL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ADMINEMAIL(const char *prefix, const char *a0, const char *a1);
+
+/* "262 %s %s %s-%s.%s :End of TRACE" */
+void msgbuf_add_RPL_TRACEEND(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4);
+char *reply_RPL_TRACEEND(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4);
+
+/* "263 %s %s :Server load is temporarily too heavy. Please wait a while and try again." */
+void msgbuf_add_RPL_TRYAGAIN(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_TRYAGAIN(const char *prefix, const char *a0, const char *a1);
+
+/* "265 %s %lu %lu :Current local users: %lu, Max: %lu" */
+void msgbuf_add_RPL_LOCALUSERS(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4);
+char *reply_RPL_LOCALUSERS(const char *prefix, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4);
+
+/* "266 %s %lu %lu :Current global users: %lu, Max: %lu" */
+void msgbuf_add_RPL_NETUSERS(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4);
+char *reply_RPL_NETUSERS(const char *prefix, const char *a0, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4);
+
+/* "250 %s :Highest connection count: %lu (%lu connections received)" */
+void msgbuf_add_RPL_STATSCONN(MsgBuf *buf, const char *a0, unsigned long a1, unsigned long a2);
+char *reply_RPL_STATSCONN(const char *prefix, const char *a0, unsigned long a1, unsigned long a2);
+
+/* "275 %s %s :is connected via SSL (secure link)" */
+void msgbuf_add_RPL_WHOISSSL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WHOISSSL(const char *prefix, const char *a0, const char *a1);
+
+/* "276 %s %s :has client certificate fingerprint %s" */
+void msgbuf_add_RPL_WHOISCERTFP(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_WHOISCERTFP(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "301 %s %s" */
+void msgbuf_add_RPL_AWAY(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_AWAY(const char *prefix, const char *a0, const char *a1);
+
+/* "302 %s :" */
+void msgbuf_add_RPL_USERHOST(MsgBuf *buf, const char *a0);
+char *reply_RPL_USERHOST(const char *prefix, const char *a0);
+
+/* "303 %s :" */
+void msgbuf_add_RPL_ISON(MsgBuf *buf, const char *a0);
+char *reply_RPL_ISON(const char *prefix, const char *a0);
+
+/* "305 %s :You are no longer marked as being away" */
+void msgbuf_add_RPL_UNAWAY(MsgBuf *buf, const char *a0);
+char *reply_RPL_UNAWAY(const char *prefix, const char *a0);
+
+/* "306 %s :You have been marked as being away" */
+void msgbuf_add_RPL_NOWAWAY(MsgBuf *buf, const char *a0);
+char *reply_RPL_NOWAWAY(const char *prefix, const char *a0);
+
+/* "307 %s %s :is a registered nick" */
+void msgbuf_add_RPL_WHOISREGNICK(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WHOISREGNICK(const char *prefix, const char *a0, const char *a1);
+
+/* "310 %s %s :is an IRC service" */
+void msgbuf_add_RPL_WHOISSERVICE(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WHOISSERVICE(const char *prefix, const char *a0, const char *a1);
+
+/* "311 %s %s %s %s * :%s" */
+void msgbuf_add_RPL_WHOISUSER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4);
+char *reply_RPL_WHOISUSER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4);
+
+/* "312 %s %s %s :%s" */
+void msgbuf_add_RPL_WHOISSERVER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3);
+char *reply_RPL_WHOISSERVER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3);
+
+/* "313 %s %s :is an IRC operator" */
+void msgbuf_add_RPL_WHOISOPERATOR(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WHOISOPERATOR(const char *prefix, const char *a0, const char *a1);
+
+/* "314 %s %s %s %s * :%s" */
+void msgbuf_add_RPL_WHOWASUSER(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4);
+char *reply_RPL_WHOWASUSER(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4);
+
+/* "315 %s %s :End of WHO list" */
+void msgbuf_add_RPL_ENDOFWHO(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFWHO(const char *prefix, const char *a0, const char *a1);
+
+/* "317 %s %s %lu %lu :seconds idle, signon time" */
+void msgbuf_add_RPL_WHOISIDLE(MsgBuf *buf, const char *a0, const char *a1, unsigned long a2, unsigned long a3);
+char *reply_RPL_WHOISIDLE(const char *prefix, const char *a0, const char *a1, unsigned long a2, unsigned long a3);
+
+/* "318 %s %s :End of WHOIS list" */
+void msgbuf_add_RPL_ENDOFWHOIS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFWHOIS(const char *prefix, const char *a0, const char *a1);
+
+/* "319 %s %s :" */
+void msgbuf_add_RPL_WHOISCHANNELS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WHOISCHANNELS(const char *prefix, const char *a0, const char *a1);
+
+/* "321 %s Channel :Users  Name" */
+void msgbuf_add_RPL_LISTSTART(MsgBuf *buf, const char *a0);
+char *reply_RPL_LISTSTART(const char *prefix, const char *a0);
+
+/* "322 %s %s %ld :%s" */
+void msgbuf_add_RPL_LIST(MsgBuf *buf, const char *a0, const char *a1, long a2, const char *a3);
+char *reply_RPL_LIST(const char *prefix, const char *a0, const char *a1, long a2, const char *a3);
+
+/* "323 %s :End of LIST" */
+void msgbuf_add_RPL_LISTEND(MsgBuf *buf, const char *a0);
+char *reply_RPL_LISTEND(const char *prefix, const char *a0);
+
+/* "324 %s %s +%s" */
+void msgbuf_add_RPL_CHANNELMODEIS(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_CHANNELMODEIS(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "329 %s %s %ld" */
+void msgbuf_add_RPL_CREATIONTIME(MsgBuf *buf, const char *a0, const char *a1, long a2);
+char *reply_RPL_CREATIONTIME(const char *prefix, const char *a0, const char *a1, long a2);
+
+/* "330 %s %s %s :is logged in as" */
+void msgbuf_add_RPL_WHOISLOGGEDIN(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_WHOISLOGGEDIN(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "331 %s %s :No topic is set" */
+void msgbuf_add_RPL_NOTOPIC(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_NOTOPIC(const char *prefix, const char *a0, const char *a1);
+
+/* "332 %s %s :%s" */
+void msgbuf_add_RPL_TOPIC(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_TOPIC(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "333 %s %s %s %u" */
+void msgbuf_add_RPL_TOPICSETBY(MsgBuf *buf, const char *a0, const char *a1, const char *a2, unsigned a3);
+char *reply_RPL_TOPICSETBY(const char *prefix, const char *a0, const char *a1, const char *a2, unsigned a3);
+
+/* "335 %s %s :is an IRC Bot" */
+void msgbuf_add_RPL_WHOISBOT(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_WHOISBOT(const char *prefix, const char *a0, const char *a1);
+
+/* "341 %s %s %s%s" */
+void msgbuf_add_RPL_INVITING(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3);
+char *reply_RPL_INVITING(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3);
+
+/* "346 %s %s %s %s %d" */
+void msgbuf_add_RPL_INVITELIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4);
+char *reply_RPL_INVITELIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4);
+
+/* "347 %s %s :End of channel invite list" */
+void msgbuf_add_RPL_ENDOFINVITELIST(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFINVITELIST(const char *prefix, const char *a0, const char *a1);
+
+/* "348 %s %s %s %s %d" */
+void msgbuf_add_RPL_EXCEPTLIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4);
+char *reply_RPL_EXCEPTLIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4);
+
+/* "349 %s %s :End of channel exception list" */
+void msgbuf_add_RPL_ENDOFEXCEPTLIST(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFEXCEPTLIST(const char *prefix, const char *a0, const char *a1);
+
+/* "351 %s %s-%s.%s %s :%s" */
+void msgbuf_add_RPL_VERSION(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5);
+char *reply_RPL_VERSION(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5);
+
+/* "352 %s %s %s %s %s %s %s :%d %s" */
+void msgbuf_add_RPL_WHOREPLY(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, const char *a6, int a7, const char *a8);
+char *reply_RPL_WHOREPLY(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, const char *a4, const char *a5, const char *a6, int a7, const char *a8);
+
+/* "353 %s %s %s :" */
+void msgbuf_add_RPL_NAMREPLY(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_NAMREPLY(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "364 %s %s %s :%d %s" */
+void msgbuf_add_RPL_LINKS(MsgBuf *buf, const char *a0, const char *a1, const char *a2, int a3, const char *a4);
+char *reply_RPL_LINKS(const char *prefix, const char *a0, const char *a1, const char *a2, int a3, const char *a4);
+
+/* "365 %s %s :End of LINKS list" */
+void msgbuf_add_RPL_ENDOFLINKS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFLINKS(const char *prefix, const char *a0, const char *a1);
+
+/* "366 %s %s :End of NAMES list" */
+void msgbuf_add_RPL_ENDOFNAMES(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFNAMES(const char *prefix, const char *a0, const char *a1);
+
+/* "367 %s %s %s %s %d" */
+void msgbuf_add_RPL_BANLIST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3, int a4);
+char *reply_RPL_BANLIST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3, int a4);
+
+/* "368 %s %s :End of channel ban list" */
+void msgbuf_add_RPL_ENDOFBANLIST(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFBANLIST(const char *prefix, const char *a0, const char *a1);
+
+/* "369 %s %s :End of WHOWAS list" */
+void msgbuf_add_RPL_ENDOFWHOWAS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_ENDOFWHOWAS(const char *prefix, const char *a0, const char *a1);
+
+/* "371 %s :%s" */
+void msgbuf_add_RPL_INFO(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_INFO(const char *prefix, const char *a0, const char *a1);
+
+/* "374 %s :End of INFO list" */
+void msgbuf_add_RPL_ENDOFINFO(MsgBuf *buf, const char *a0);
+char *reply_RPL_ENDOFINFO(const char *prefix, const char *a0);
+
+/* "372 %s :- %s" */
+void msgbuf_add_RPL_MOTD(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_MOTD(const char *prefix, const char *a0, const char *a1);
+
+/* "375 %s :- %s message of the day" */
+void msgbuf_add_RPL_MOTDSTART(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_MOTDSTART(const char *prefix, const char *a0, const char *a1);
+
+/* "376 %s :End of MOTD command" */
+void msgbuf_add_RPL_ENDOFMOTD(MsgBuf *buf, const char *a0);
+char *reply_RPL_ENDOFMOTD(const char *prefix, const char *a0);
+
+/* "378 %s %s :is connecting from *@%s %s" */
+void msgbuf_add_RPL_WHOISHOST(MsgBuf *buf, const char *a0, const char *a1, const char *a2, const char *a3);
+char *reply_RPL_WHOISHOST(const char *prefix, const char *a0, const char *a1, const char *a2, const char *a3);
+
+/* "379 %s %s :is using modes +%s" */
+void msgbuf_add_RPL_WHOISMODES(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_WHOISMODES(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "381 %s :You are now an IRC Operator" */
+void msgbuf_add_RPL_YOUREOPER(MsgBuf *buf, const char *a0);
+char *reply_RPL_YOUREOPER(const char *prefix, const char *a0);
+
+/* "382 %s :Rehashing" */
+void msgbuf_add_RPL_REHASHING(MsgBuf *buf, const char *a0);
+char *reply_RPL_REHASHING(const char *prefix, const char *a0);
+
+/* "383 %s :You are service %s" */
+void msgbuf_add_RPL_YOURESERVICE(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_YOURESERVICE(const char *prefix, const char *a0, const char *a1);
+
+/* "391 %s %s :%s" */
+void msgbuf_add_RPL_TIME(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_RPL_TIME(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "396 %s %s :is your displayed hostname now" */
+void msgbuf_add_RPL_HOSTHIDDEN(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_RPL_HOSTHIDDEN(const char *prefix, const char *a0, const char *a1);
+
+/* "401 %s %s :No such nick or channel name" */
+void msgbuf_add_ERR_NOSUCHNICK(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOSUCHNICK(const char *prefix, const char *a0, const char *a1);
+
+/* "402 %s %s :No such server" */
+void msgbuf_add_ERR_NOSUCHSERVER(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOSUCHSERVER(const char *prefix, const char *a0, const char *a1);
+
+/* "403 %s %s :No such channel" */
+void msgbuf_add_ERR_NOSUCHCHANNEL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOSUCHCHANNEL(const char *prefix, const char *a0, const char *a1);
+
+/* "404 %s %s :Cannot send to channel" */
+void msgbuf_add_ERR_CANNOTSENDTOCHAN(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_CANNOTSENDTOCHAN(const char *prefix, const char *a0, const char *a1);
+
+/* "405 %s %s :You have joined too many channels" */
+void msgbuf_add_ERR_TOOMANYCHANNELS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_TOOMANYCHANNELS(const char *prefix, const char *a0, const char *a1);
+
+/* "406 %s %s :There was no such nickname" */
+void msgbuf_add_ERR_WASNOSUCHNICK(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_WASNOSUCHNICK(const char *prefix, const char *a0, const char *a1);
+
+/* "407 %s :Too many recipients" */
+void msgbuf_add_ERR_TOOMANYTARGETS(MsgBuf *buf, const char *a0);
+char *reply_ERR_TOOMANYTARGETS(const char *prefix, const char *a0);
+
+/* "409 %s :No origin specified" */
+void msgbuf_add_ERR_NOORIGIN(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOORIGIN(const char *prefix, const char *a0);
+
+/* "410 %s %s :Invalid CAP subcommand" */
+void msgbuf_add_ERR_INVALIDCAP(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_INVALIDCAP(const char *prefix, const char *a0, const char *a1);
+
+/* "411 %s :No recipient given" */
+void msgbuf_add_ERR_NORECIPIENT(MsgBuf *buf, const char *a0);
+char *reply_ERR_NORECIPIENT(const char *prefix, const char *a0);
+
+/* "412 %s :No text to send" */
+void msgbuf_add_ERR_NOTEXTTOSEND(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOTEXTTOSEND(const char *prefix, const char *a0);
+
+/* "414 %s :Wildcard in toplevel domain" */
+void msgbuf_add_ERR_WILDTOPLEVEL(MsgBuf *buf, const char *a0);
+char *reply_ERR_WILDTOPLEVEL(const char *prefix, const char *a0);
+
+/* "421 %s %s :Unknown command" */
+void msgbuf_add_ERR_UNKNOWNCOMMAND(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_UNKNOWNCOMMAND(const char *prefix, const char *a0, const char *a1);
+
+/* "422 %s :MOTD file is missing" */
+void msgbuf_add_ERR_NOMOTD(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOMOTD(const char *prefix, const char *a0);
+
+/* "431 %s :No nickname given" */
+void msgbuf_add_ERR_NONICKNAMEGIVEN(MsgBuf *buf, const char *a0);
+char *reply_ERR_NONICKNAMEGIVEN(const char *prefix, const char *a0);
+
+/* "432 %s %s :Erroneous nickname" */
+void msgbuf_add_ERR_ERRONEUSNICKNAME(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_ERRONEUSNICKNAME(const char *prefix, const char *a0, const char *a1);
+
+/* "432 %s %s :Nickname too long, max. %u characters" */
+void msgbuf_add_ERR_NICKNAMETOOLONG(MsgBuf *buf, const char *a0, const char *a1, unsigned a2);
+char *reply_ERR_NICKNAMETOOLONG(const char *prefix, const char *a0, const char *a1, unsigned a2);
+
+/* "432 %s %s :Nickname is forbidden/blocked" */
+void msgbuf_add_ERR_FORBIDDENNICKNAME(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_FORBIDDENNICKNAME(const char *prefix, const char *a0, const char *a1);
+
+/* "433 %s :Nickname already in use" */
+void msgbuf_add_ERR_NICKNAMEINUSE(MsgBuf *buf, const char *a0);
+char *reply_ERR_NICKNAMEINUSE(const char *prefix, const char *a0);
+
+/* "441 %s %s %s :They aren't on that channel" */
+void msgbuf_add_ERR_USERNOTINCHANNEL(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_ERR_USERNOTINCHANNEL(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "442 %s %s :You are not on that channel" */
+void msgbuf_add_ERR_NOTONCHANNEL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOTONCHANNEL(const char *prefix, const char *a0, const char *a1);
+
+/* "443 %s %s %s :is already on channel" */
+void msgbuf_add_ERR_USERONCHANNEL(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_ERR_USERONCHANNEL(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "445 %s :SUMMON has been disabled" */
+void msgbuf_add_ERR_SUMMONDISABLED(MsgBuf *buf, const char *a0);
+char *reply_ERR_SUMMONDISABLED(const char *prefix, const char *a0);
+
+/* "446 %s :USERS has been disabled" */
+void msgbuf_add_ERR_USERSDISABLED(MsgBuf *buf, const char *a0);
+char *reply_ERR_USERSDISABLED(const char *prefix, const char *a0);
+
+/* "447 %s :Cannot change nickname while on %s(+N)" */
+void msgbuf_add_ERR_NONICKCHANGE(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NONICKCHANGE(const char *prefix, const char *a0, const char *a1);
+
+/* "451 %s :Connection not registered" */
+void msgbuf_add_ERR_NOTREGISTERED(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOTREGISTERED(const char *prefix, const char *a0);
+
+/* "451 %s :Connection not registered as server link" */
+void msgbuf_add_ERR_NOTREGISTEREDSERVER(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOTREGISTEREDSERVER(const char *prefix, const char *a0);
+
+/* "461 %s %s :Syntax error" */
+void msgbuf_add_ERR_NEEDMOREPARAMS(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NEEDMOREPARAMS(const char *prefix, const char *a0, const char *a1);
+
+/* "462 %s :Connection already registered" */
+void msgbuf_add_ERR_ALREADYREGISTRED(MsgBuf *buf, const char *a0);
+char *reply_ERR_ALREADYREGISTRED(const char *prefix, const char *a0);
+
+/* "464 %s :Invalid password" */
+void msgbuf_add_ERR_PASSWDMISMATCH(MsgBuf *buf, const char *a0);
+char *reply_ERR_PASSWDMISMATCH(const char *prefix, const char *a0);
+
+/* "471 %s %s :Cannot join channel (+l) -- Channel is full, try later" */
+void msgbuf_add_ERR_CHANNELISFULL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_CHANNELISFULL(const char *prefix, const char *a0, const char *a1);
+
+/* "471 %s %s :Cannot join channel (+z) -- SSL connections only" */
+void msgbuf_add_ERR_SECURECHANNEL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_SECURECHANNEL(const char *prefix, const char *a0, const char *a1);
+
+/* "471 %s %s :Cannot join channel (+O) -- IRC opers only" */
+void msgbuf_add_ERR_OPONLYCHANNEL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_OPONLYCHANNEL(const char *prefix, const char *a0, const char *a1);
+
+/* "471 %s %s :Cannot join channel (+R) -- Registered users only" */
+void msgbuf_add_ERR_REGONLYCHANNEL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_REGONLYCHANNEL(const char *prefix, const char *a0, const char *a1);
+
+/* "472 %s %c :is unknown mode char for %s" */
+void msgbuf_add_ERR_UNKNOWNMODE(MsgBuf *buf, const char *a0, char a1, const char *a2);
+char *reply_ERR_UNKNOWNMODE(const char *prefix, const char *a0, char a1, const char *a2);
+
+/* "473 %s %s :Cannot join channel (+i) -- Invited users only" */
+void msgbuf_add_ERR_INVITEONLYCHAN(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_INVITEONLYCHAN(const char *prefix, const char *a0, const char *a1);
+
+/* "474 %s %s :Cannot join channel (+b) -- You are banned" */
+void msgbuf_add_ERR_BANNEDFROMCHAN(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_BANNEDFROMCHAN(const char *prefix, const char *a0, const char *a1);
+
+/* "475 %s %s :Cannot join channel (+k) -- Wrong channel key" */
+void msgbuf_add_ERR_BADCHANNELKEY(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_BADCHANNELKEY(const char *prefix, const char *a0, const char *a1);
+
+/* "477 %s %s :Channel doesn't support modes" */
+void msgbuf_add_ERR_NOCHANMODES(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOCHANMODES(const char *prefix, const char *a0, const char *a1);
+
+/* "477 %s %s :Cannot send to channel (+M) -- You need to be identified to a registered account to message this channel" */
+void msgbuf_add_ERR_NEEDREGGEDNICK(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NEEDREGGEDNICK(const char *prefix, const char *a0, const char *a1);
+
+/* "478 %s %s %s :Channel list is full (%d)" */
+void msgbuf_add_ERR_LISTFULL(MsgBuf *buf, const char *a0, const char *a1, const char *a2, int a3);
+char *reply_ERR_LISTFULL(const char *prefix, const char *a0, const char *a1, const char *a2, int a3);
+
+/* "481 %s :Permission denied" */
+void msgbuf_add_ERR_NOPRIVILEGES(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOPRIVILEGES(const char *prefix, const char *a0);
+
+/* "482 %s %s :You are not channel operator" */
+void msgbuf_add_ERR_CHANOPRIVSNEEDED(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_CHANOPRIVSNEEDED(const char *prefix, const char *a0, const char *a1);
+
+/* "482 %s %s :Your privileges are too low" */
+void msgbuf_add_ERR_CHANOPPRIVTOOLOW(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_CHANOPPRIVTOOLOW(const char *prefix, const char *a0, const char *a1);
+
+/* "482 %s %s :Cannot kick, %s is protected" */
+void msgbuf_add_ERR_KICKDENY(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+char *reply_ERR_KICKDENY(const char *prefix, const char *a0, const char *a1, const char *a2);
+
+/* "483 %s :You can't kill a server!" */
+void msgbuf_add_ERR_CANTKILLSERVER(MsgBuf *buf, const char *a0);
+char *reply_ERR_CANTKILLSERVER(const char *prefix, const char *a0);
+
+/* "484 %s :Your connection is restricted" */
+void msgbuf_add_ERR_RESTRICTED(MsgBuf *buf, const char *a0);
+char *reply_ERR_RESTRICTED(const char *prefix, const char *a0);
+
+/* "484 %s :Cannot modify user mode (+R) -- Use IRC services" */
+void msgbuf_add_ERR_NICKREGISTER(MsgBuf *buf, const char *a0);
+char *reply_ERR_NICKREGISTER(const char *prefix, const char *a0);
+
+/* "486 %s :Cannot send to user (+b) -- You must identify to a registered nick to private message %s" */
+void msgbuf_add_ERR_NONONREG(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NONONREG(const char *prefix, const char *a0, const char *a1);
+
+/* "491 %s :Not configured for your host" */
+void msgbuf_add_ERR_NOOPERHOST(MsgBuf *buf, const char *a0);
+char *reply_ERR_NOOPERHOST(const char *prefix, const char *a0);
+
+/* "493 %s :You must share a common channel with %s" */
+void msgbuf_add_ERR_NOTONSAMECHANNEL(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOTONSAMECHANNEL(const char *prefix, const char *a0, const char *a1);
+
+/* "501 %s :Unknown mode" */
+void msgbuf_add_ERR_UMODEUNKNOWNFLAG(MsgBuf *buf, const char *a0);
+char *reply_ERR_UMODEUNKNOWNFLAG(const char *prefix, const char *a0);
+
+/* "501 %s :Unknown mode \"%c%c\"" */
+void msgbuf_add_ERR_UMODEUNKNOWNFLAG2(MsgBuf *buf, const char *a0, char a1, char a2);
+char *reply_ERR_UMODEUNKNOWNFLAG2(const char *prefix, const char *a0, char a1, char a2);
+
+/* "502 %s :Can't set/get mode for other users" */
+void msgbuf_add_ERR_USERSDONTMATCH(MsgBuf *buf, const char *a0);
+char *reply_ERR_USERSDONTMATCH(const char *prefix, const char *a0);
+
+/* "504 %s %s :User is not on this server" */
+void msgbuf_add_ERR_USERNOTONSERV(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_USERNOTONSERV(const char *prefix, const char *a0, const char *a1);
+
+/* "518 %s :Cannot invite to %s (+V)" */
+void msgbuf_add_ERR_NOINVITE(MsgBuf *buf, const char *a0, const char *a1);
+char *reply_ERR_NOINVITE(const char *prefix, const char *a0, const char *a1);
+
+/* "696 %s %s %c * :Invalid mode parameter" */
+void msgbuf_add_ERR_INVALIDMODEPARAM(MsgBuf *buf, const char *a0, const char *a1, char a2);
+char *reply_ERR_INVALIDMODEPARAM(const char *prefix, const char *a0, const char *a1, char a2);
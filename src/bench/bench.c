@@ -0,0 +1,817 @@
+#include <math.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "include/bench.h"
+
+/*
+ * Load generator which runs many users from a single thread. All sockets are
+ * non-blocking and driven by one epoll loop.
+ *
+ * The users register, join channels whose popularity follows a Zipf
+ * distribution (uniform for exponent 0) and then send a mix of PRIVMSG, JOIN,
+ * PART and NICK at a fixed total rate. Every PRIVMSG carries the time it was
+ * sent and the server of its sender, so the delivery latency of each copy
+ * received by another user is measured on the same clock and by the number
+ * of links it crossed.
+ */
+
+static const char *op_names[N_OPS] = {"privmsg", "join", "part", "nick"};
+
+volatile bool g_alive = true;
+
+static void handle_sigint(int sig) {
+	(void)sig;
+	g_alive = false;
+}
+
+/**
+ * xorshift64* generator, seeded by the user so runs can be repeated.
+ */
+static uint64_t next_random(Bench *bench) {
+	bench->rng ^= bench->rng >> 12;
+	bench->rng ^= bench->rng << 25;
+	bench->rng ^= bench->rng >> 27;
+	return bench->rng * 2685821657736338717ULL;
+}
+
+static double random_unit(Bench *bench) {
+	return (next_random(bench) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static size_t random_below(Bench *bench, size_t n) {
+	return next_random(bench) % n;
+}
+
+static void build_channel_cdf(Bench *bench) {
+	double total = 0;
+
+	for (size_t i = 0; i < bench->n_channels; i++) {
+		total += 1 / pow(i + 1, bench->zipf_exponent);
+		bench->channel_cdf[i] = total;
+	}
+
+	for (size_t i = 0; i < bench->n_channels; i++) {
+		bench->channel_cdf[i] /= total;
+	}
+}
+
+static int random_channel(Bench *bench) {
+	double u = random_unit(bench);
+	size_t lo = 0, hi = bench->n_channels - 1;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (bench->channel_cdf[mid] < u) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+void Bench_close_user(Bench *bench, BenchUser *user) {
+	if (user->fd == -1) {
+		return;
+	}
+
+	epoll_ctl(bench->epollfd, EPOLL_CTL_DEL, user->fd, NULL);
+	close(user->fd);
+	user->fd = -1;
+	bench->closed++;
+
+	for (int i = 0; i < user->n_channels; i++) {
+		bench->members[user->channels[i]]--;
+	}
+
+	user->n_channels = 0;
+}
+
+/**
+ * Write queued bytes of user until the socket is full, and watch for
+ * EPOLLOUT while bytes are left.
+ */
+static void flush_user(Bench *bench, BenchUser *user) {
+	while (user->fd != -1 && user->out_off < user->out.len) {
+		ssize_t n = write(user->fd, user->out.data + user->out_off,
+						  user->out.len - user->out_off);
+
+		if (n > 0) {
+			user->out_off += n;
+		} else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		} else {
+			Bench_close_user(bench, user);
+			return;
+		}
+	}
+
+	if (user->fd == -1) {
+		return;
+	}
+
+	if (user->out_off == user->out.len) {
+		msgbuf_clear(&user->out);
+		user->out_off = 0;
+	}
+
+	bool writing = user->out.len > 0;
+
+	if (writing != user->writing) {
+		struct epoll_event ev = {.events = EPOLLIN | (writing ? EPOLLOUT : 0),
+								 .data.ptr = user};
+		epoll_ctl(bench->epollfd, EPOLL_CTL_MOD, user->fd, &ev);
+		user->writing = writing;
+	}
+}
+
+void Bench_send_line(Bench *bench, BenchUser *user, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	msgbuf_add_vformat(&user->out, format, args);
+	va_end(args);
+	msgbuf_add_crlf(&user->out);
+	flush_user(bench, user);
+}
+
+static bool is_member(BenchUser *user, int channel) {
+	for (int i = 0; i < user->n_channels; i++) {
+		if (user->channels[i] == channel) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Join a channel the user is not on yet. Returns false if there is none.
+ */
+static bool join_channel(Bench *bench, BenchUser *user) {
+	if (user->n_channels == BENCH_MAX_CHANNELS ||
+		(size_t)user->n_channels == bench->n_channels) {
+		return false;
+	}
+
+	int channel;
+
+	// Popular channels are drawn again and again, so fall back to a scan
+	for (int tries = 0;; tries++) {
+		channel = tries < 16 ? random_channel(bench)
+							 : (int)random_below(bench, bench->n_channels);
+
+		if (!is_member(user, channel)) {
+			break;
+		}
+	}
+
+	user->channels[user->n_channels++] = channel;
+	bench->members[channel]++;
+	Bench_send_line(bench, user, "JOIN #bench%d", channel);
+	return true;
+}
+
+static bool part_channel(Bench *bench, BenchUser *user) {
+	if (user->n_channels == 0) {
+		return false;
+	}
+
+	int i = random_below(bench, user->n_channels);
+	int channel = user->channels[i];
+	user->channels[i] = user->channels[--user->n_channels];
+	bench->members[channel]--;
+	Bench_send_line(bench, user, "PART #bench%d", channel);
+	return true;
+}
+
+static void send_privmsg(Bench *bench, BenchUser *user) {
+	unsigned long now = get_time_ns();
+
+	if (user->n_channels > 0) {
+		int channel = user->channels[random_below(bench, user->n_channels)];
+		bench->expected += bench->members[channel] - 1;
+		Bench_send_line(bench, user, "PRIVMSG #bench%d :bench %lu %d %s",
+						channel, now, user->server, bench->payload);
+		return;
+	}
+
+	BenchUser *other = &bench->users[random_below(bench, bench->n_users)];
+
+	if (other->fd != -1 && other != user) {
+		bench->expected++;
+	}
+
+	Bench_send_line(bench, user, "PRIVMSG %c%d :bench %lu %d %s",
+					other->renamed ? 'v' : 'u', other->id, now, user->server,
+					bench->payload);
+}
+
+/**
+ * Send one operation chosen by the weights of the mix from a random user.
+ */
+static void run_operation(Bench *bench) {
+	BenchUser *user = &bench->users[random_below(bench, bench->n_users)];
+
+	if (user->fd == -1 || !user->registered ||
+		user->out.len - user->out_off > BENCH_MAX_PENDING) {
+		bench->skipped++;
+		return;
+	}
+
+	unsigned total = 0;
+
+	for (int i = 0; i < N_OPS; i++) {
+		total += bench->weights[i];
+	}
+
+	unsigned pick = random_below(bench, total);
+	int op = 0;
+
+	while (pick >= bench->weights[op]) {
+		pick -= bench->weights[op++];
+	}
+
+	if (op == OP_JOIN && !join_channel(bench, user)) {
+		op = OP_PART;
+		part_channel(bench, user);
+	} else if (op == OP_PART && !part_channel(bench, user)) {
+		op = OP_JOIN;
+		join_channel(bench, user);
+	} else if (op == OP_NICK) {
+		user->renamed = !user->renamed;
+		Bench_send_line(bench, user, "NICK %c%d", user->renamed ? 'v' : 'u',
+				  user->id);
+	} else if (op == OP_PRIVMSG) {
+		send_privmsg(bench, user);
+	}
+
+	bench->ops[op]++;
+}
+
+static void handle_line(Bench *bench, BenchUser *user, char *line) {
+	if (!strncmp(line, "PING ", 5)) {
+		Bench_send_line(bench, user, "PONG %s", line + 5);
+		return;
+	}
+
+	if (!strncmp(line, "ERROR", 5)) {
+		Bench_close_user(bench, user);
+		return;
+	}
+
+	char *body = strstr(line, " :bench ");
+
+	if (body && strstr(line, " PRIVMSG ")) {
+		char *end = NULL;
+		uint64_t sent_at = strtoull(body + 8, &end, 10);
+		int from = strtol(end, NULL, 10);
+		uint64_t now = get_time_ns();
+		uint64_t latency = now > sent_at ? now - sent_at : 0;
+		Histogram_add(&bench->latency, latency);
+		bench->delivered++;
+
+		if (from >= 0 && (size_t)from < bench->n_servers &&
+			bench->hops[from][user->server] >= 0) {
+			Histogram_add(&bench->hop_latency[bench->hops[from][user->server]],
+						  latency);
+		}
+
+		return;
+	}
+
+	body = strstr(line, " :probe ");
+
+	if (body && strstr(line, " PRIVMSG ")) {
+		Bench_handle_probe(bench, user, body + 8);
+		return;
+	}
+
+	// Numeric replies look like ":<server> <code> <nick> ..."
+	char *code = strchr(line, ' ');
+
+	if (!code || !isdigit(code[1]) || !isdigit(code[2]) || !isdigit(code[3]) ||
+		code[4] != ' ') {
+		return;
+	}
+
+	int numeric = atoi(code + 1);
+
+	if (numeric == 1 && !user->registered && user->probe) {
+		user->registered = true;
+		bench->n_probes_ready++;
+		bench->pending_joins++;
+		Bench_send_line(bench, user, "JOIN %s", BENCH_PROBE_CHANNEL);
+	} else if (numeric == 1 && !user->registered) {
+		user->registered = true;
+		bench->n_registered++;
+
+		for (int i = 0; i < bench->joins_per_user; i++) {
+			if (join_channel(bench, user)) {
+				bench->pending_joins++;
+			}
+		}
+	} else if (numeric == 366 || numeric >= 400) {
+		// End of NAMES follows a JOIN; an error may be the answer to a JOIN
+		if (bench->setup && numeric == 366 && bench->pending_joins > 0) {
+			bench->pending_joins--;
+		}
+
+		if (numeric >= 400) {
+			bench->errors++;
+			log_debug("user %d: %s", user->id, line);
+		}
+	}
+}
+
+static void read_user(Bench *bench, BenchUser *user) {
+	for (;;) {
+		ssize_t n = read(user->fd, user->in + user->in_len,
+						 BENCH_IN_BUF_SIZE - user->in_len);
+
+		if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return;
+		}
+
+		if (n <= 0) {
+			Bench_close_user(bench, user);
+			return;
+		}
+
+		user->in_len += n;
+		user->in[user->in_len] = 0;
+
+		char *start = user->in;
+		char *end;
+
+		while ((end = strstr(start, "\r\n")) != NULL) {
+			*end = 0;
+			handle_line(bench, user, start);
+
+			if (user->fd == -1) {
+				return;
+			}
+
+			start = end + 2;
+		}
+
+		user->in_len -= start - user->in;
+		memmove(user->in, start, user->in_len + 1);
+
+		// A line longer than the buffer is dropped
+		if (user->in_len == BENCH_IN_BUF_SIZE) {
+			user->in_len = 0;
+		}
+	}
+}
+
+void Bench_poll(Bench *bench, int timeout_ms) {
+	struct epoll_event events[256];
+	int n = epoll_wait(bench->epollfd, events, 256, timeout_ms);
+
+	for (int i = 0; i < n; i++) {
+		BenchUser *user = events[i].data.ptr;
+
+		if (events[i].events & EPOLLIN) {
+			read_user(bench, user);
+		}
+
+		if (user->fd != -1 && (events[i].events & EPOLLOUT)) {
+			flush_user(bench, user);
+		}
+
+		if (user->fd != -1 && (events[i].events & (EPOLLERR | EPOLLHUP))) {
+			Bench_close_user(bench, user);
+		}
+	}
+}
+
+/**
+ * Connect user to its server and watch the socket for input.
+ */
+bool Bench_open_user(Bench *bench, BenchUser *user) {
+	BenchServer *server = &bench->servers[user->server];
+	user->fd = connect_to_host(server->host, server->port);
+
+	if (user->fd == -1) {
+		log_error("failed to connect user %d to %s", user->id, server->name);
+		return false;
+	}
+
+	fcntl(user->fd, F_SETFL, fcntl(user->fd, F_GETFL) | O_NONBLOCK);
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = user};
+	CHECK(epoll_ctl(bench->epollfd, EPOLL_CTL_ADD, user->fd, &ev),
+		  "epoll_ctl");
+
+	return true;
+}
+
+/**
+ * Open the connections of all users and probes and send their registration.
+ * Users are spread over the servers in turn.
+ */
+static bool connect_users(Bench *bench) {
+	size_t n_total = bench->n_users + bench->n_probes;
+
+	for (size_t i = 0; i < n_total && g_alive; i++) {
+		BenchUser *user = &bench->users[i];
+		user->id = i;
+		user->probe = i >= bench->n_users;
+		user->server = user->probe ? i - bench->n_users : i % bench->n_servers;
+		user->probe_from = -1;
+		msgbuf_init(&user->out);
+
+		if (!Bench_open_user(bench, user)) {
+			return false;
+		}
+
+		if (user->probe) {
+			Bench_send_line(bench, user, "NICK p%d", user->server);
+			Bench_send_line(bench, user, "USER p%d * * :bench probe",
+							user->server);
+		} else {
+			Bench_send_line(bench, user, "NICK u%zu", i);
+			Bench_send_line(bench, user, "USER u%zu * * :bench user", i);
+		}
+
+		if ((i + 1) % BENCH_CONNECT_BATCH == 0) {
+			Bench_poll(bench, 0);
+		}
+	}
+
+	return g_alive;
+}
+
+/**
+ * Raise the limit of open files to allow a socket for each user.
+ */
+static void raise_file_limit(size_t n_users) {
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+		return;
+	}
+
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	if (limit.rlim_cur < n_users + 16) {
+		log_warn("open file limit %lu is too low for %zu users",
+				 (unsigned long)limit.rlim_cur, n_users);
+	}
+}
+
+/**
+ * Parse mix of the form "privmsg=90,join=4,part=4,nick=2". Operations which
+ * are not listed get no weight.
+ */
+static bool parse_mix(Bench *bench, const char *mix) {
+	char *copy = strdup(mix);
+	char *saveptr = NULL;
+	bool valid = true;
+	unsigned total = 0;
+
+	memset(bench->weights, 0, sizeof bench->weights);
+
+	for (char *tok = strtok_r(copy, ",", &saveptr); tok && valid;
+		 tok = strtok_r(NULL, ",", &saveptr)) {
+		char *eq = strchr(tok, '=');
+		valid = false;
+
+		for (int i = 0; eq && i < N_OPS; i++) {
+			if (!strncasecmp(tok, op_names[i], eq - tok) &&
+				strlen(op_names[i]) == (size_t)(eq - tok)) {
+				bench->weights[i] = atoi(eq + 1);
+				total += bench->weights[i];
+				valid = true;
+			}
+		}
+	}
+
+	free(copy);
+	return valid && total > 0;
+}
+
+/**
+ * Wait for messages in flight until nothing arrives for a while.
+ */
+void Bench_drain(Bench *bench) {
+	uint64_t last_delivered = bench->delivered;
+	uint64_t quiet_since = get_time_ms();
+	uint64_t drain_end = quiet_since + BENCH_DRAIN_MS;
+
+	while (g_alive && get_time_ms() - quiet_since < BENCH_DRAIN_MS / 4 &&
+		   get_time_ms() < drain_end) {
+		if (bench->killed && !bench->recovered_ns) {
+			Bench_check_recovery(bench);
+		}
+
+		Bench_poll(bench, BENCH_TICK_MS);
+
+		if (bench->delivered != last_delivered) {
+			last_delivered = bench->delivered;
+			quiet_since = get_time_ms();
+		}
+	}
+}
+
+void Bench_report_latency(Bench *bench) {
+	printf("delivery latency ms: p50 %.3f p99 %.3f p99.9 %.3f max %.3f\n",
+		   Histogram_percentile(&bench->latency, 50) / 1e6,
+		   Histogram_percentile(&bench->latency, 99) / 1e6,
+		   Histogram_percentile(&bench->latency, 99.9) / 1e6,
+		   bench->latency.max / 1e6);
+}
+
+static void report(Bench *bench, double setup_s, double load_s) {
+	printf("users %zu, channels %zu, joins %d, zipf %.2f: %zu registered in "
+		   "%.2f s\n",
+		   bench->n_users, bench->n_channels, bench->joins_per_user,
+		   bench->zipf_exponent, bench->n_registered, setup_s);
+
+	uint64_t total = 0;
+
+	for (int i = 0; i < N_OPS; i++) {
+		total += bench->ops[i];
+	}
+
+	printf("sent %lu ops in %.2f s (%.0f ops/s):", (unsigned long)total,
+		   load_s, load_s > 0 ? total / load_s : 0);
+
+	for (int i = 0; i < N_OPS; i++) {
+		printf(" %s %lu", op_names[i], (unsigned long)bench->ops[i]);
+	}
+
+	printf(", %lu skipped\n", (unsigned long)bench->skipped);
+	printf("delivered %lu of about %lu messages (%.0f msgs/s), %lu errors, "
+		   "%lu closed\n",
+		   (unsigned long)bench->delivered, (unsigned long)bench->expected,
+		   load_s > 0 ? bench->delivered / load_s : 0,
+		   (unsigned long)bench->errors, (unsigned long)bench->closed);
+	Bench_report_latency(bench);
+}
+
+static void free_bench(Bench *bench) {
+	for (size_t i = 0; i < bench->n_users + bench->n_probes; i++) {
+		if (bench->users[i].fd != -1) {
+			close(bench->users[i].fd);
+		}
+
+		msgbuf_destroy(&bench->users[i].out);
+	}
+
+	Bench_stop_servers(bench);
+
+	for (size_t i = 0; i < bench->n_servers; i++) {
+		free(bench->servers[i].name);
+		free(bench->servers[i].host);
+		free(bench->servers[i].port);
+	}
+
+	close(bench->epollfd);
+	free(bench->users);
+	free(bench->links);
+	free(bench->channel_cdf);
+	free(bench->members);
+	free(bench->payload);
+	free(bench);
+}
+
+static void usage(const char *program) {
+	fprintf(stderr, "Usage: %s [options] <server>\n", program);
+	fprintf(stderr, "       %s -T <topology> [options] <server> <server>...\n", program);
+	fprintf(stderr, "       %s -R <capture> [-x <speed>] <server>\n", program);
+	fprintf(stderr, "  -u <users>    users to connect (default 1000)\n");
+	fprintf(stderr, "  -c <channels> channels to use (default 100)\n");
+	fprintf(stderr, "  -j <count>    channels each user joins at first (default 1)\n");
+	fprintf(stderr, "  -z <s>        Zipf exponent of channel popularity, 0 for uniform (default 1)\n");
+	fprintf(stderr, "  -r <rate>     operations per second (default 1000)\n");
+	fprintf(stderr, "  -t <seconds>  duration of the load (default 10)\n");
+	fprintf(stderr, "  -m <mix>      weights of operations (default privmsg=90,join=4,part=4,nick=2)\n");
+	fprintf(stderr, "  -p <bytes>    padding added to each message (default 32)\n");
+	fprintf(stderr, "  -s <seed>     seed of the random generator (default 1)\n");
+	fprintf(stderr, "  -T <topology> start the servers and link them as a chain, star or mesh\n");
+	fprintf(stderr, "  -k <seconds>  time into the load when a link is killed, 0 for none (default half)\n");
+	fprintf(stderr, "  -R <capture>  replay the users of a capture made by build/server -c\n");
+	fprintf(stderr, "  -x <speed>    times faster than captured to replay (default 1)\n");
+}
+
+int main(int argc, char *argv[]) {
+	Bench *bench = calloc(1, sizeof *bench);
+	bench->n_users = 1000;
+	bench->n_channels = 100;
+	bench->joins_per_user = 1;
+	bench->zipf_exponent = 1;
+	bench->rate = 1000;
+	bench->duration_s = 10;
+	bench->payload_len = 32;
+	bench->seed = 1;
+	bench->kill_at_s = -1;
+	bench->replay_speed = 1;
+	parse_mix(bench, "privmsg=90,join=4,part=4,nick=2");
+
+	int opt;
+
+	while ((opt = getopt(argc, argv, "u:c:j:z:r:t:m:p:s:T:k:R:x:")) != -1) {
+		switch (opt) {
+		case 'u':
+			bench->n_users = atol(optarg);
+			break;
+		case 'c':
+			bench->n_channels = atol(optarg);
+			break;
+		case 'j':
+			bench->joins_per_user = atoi(optarg);
+			break;
+		case 'z':
+			bench->zipf_exponent = atof(optarg);
+			break;
+		case 'r':
+			bench->rate = atof(optarg);
+			break;
+		case 't':
+			bench->duration_s = atof(optarg);
+			break;
+		case 'm':
+			if (!parse_mix(bench, optarg)) {
+				usage(*argv);
+				return 1;
+			}
+			break;
+		case 'p':
+			bench->payload_len = atol(optarg);
+			break;
+		case 's':
+			bench->seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'T':
+			bench->topology = optarg;
+			break;
+		case 'k':
+			bench->kill_at_s = atof(optarg);
+			break;
+		case 'R':
+			bench->replay_path = optarg;
+			break;
+		case 'x':
+			bench->replay_speed = atof(optarg);
+			break;
+		default:
+			usage(*argv);
+			return 1;
+		}
+	}
+
+	if (optind >= argc || bench->n_users == 0 || bench->n_channels == 0 ||
+		bench->joins_per_user < 0 ||
+		bench->joins_per_user > BENCH_MAX_CHANNELS || bench->rate <= 0 ||
+		bench->payload_len > MAX_MSG_LEN / 2 ||
+		argc - optind > BENCH_MAX_SERVERS || bench->replay_speed <= 0 ||
+		(bench->replay_path && bench->topology)) {
+		usage(*argv);
+		return 1;
+	}
+
+	if (bench->kill_at_s < 0) {
+		bench->kill_at_s = bench->duration_s / 2;
+	}
+
+	for (int i = optind; i < argc; i++) {
+		struct peer_info_t info;
+		memset(&info, 0, sizeof info);
+
+		if (!get_peer_info(CONFIG_FILENAME, argv[i], &info)) {
+			log_error("server %s not found in %s", argv[i], CONFIG_FILENAME);
+			return 1;
+		}
+
+		BenchServer *server = &bench->servers[bench->n_servers++];
+		server->name = info.peer_name;
+		server->host = info.peer_host;
+		server->port = info.peer_port;
+		free(info.peer_passwd);
+	}
+
+	if (bench->topology ? !Bench_build_topology(bench, bench->topology)
+						: bench->n_servers != 1) {
+		usage(*argv);
+		return 1;
+	}
+
+	// Every connection would log a line
+	logger_set_level(LOG_WARN);
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, handle_sigint);
+
+	if (bench->topology) {
+		bench->n_probes = bench->n_servers;
+	}
+
+	// A replay has a user for each connection of the capture
+	if (bench->replay_path && !Bench_load_capture(bench)) {
+		return 1;
+	}
+
+	raise_file_limit(bench->n_users + bench->n_probes);
+
+	bench->rng = bench->seed ? bench->seed : 1;
+	bench->users = calloc(bench->n_users + bench->n_probes, sizeof *bench->users);
+	bench->channel_cdf = calloc(bench->n_channels, sizeof *bench->channel_cdf);
+	bench->members = calloc(bench->n_channels, sizeof *bench->members);
+	bench->payload = malloc(bench->payload_len + 1);
+	memset(bench->payload, 'x', bench->payload_len);
+	bench->payload[bench->payload_len] = 0;
+	build_channel_cdf(bench);
+
+	bench->epollfd = epoll_create1(0);
+	CHECK(bench->epollfd, "epoll_create1");
+
+	if (bench->replay_path) {
+		bool replayed = Bench_replay(bench);
+		free_bench(bench);
+		return replayed ? 0 : 1;
+	}
+
+	if (bench->topology && !Bench_start_servers(bench)) {
+		Bench_stop_servers(bench);
+		return 1;
+	}
+
+	// Register users and join channels
+	uint64_t start = get_time_ms();
+	bench->setup = true;
+
+	if (!connect_users(bench)) {
+		Bench_stop_servers(bench);
+		return 1;
+	}
+
+	while (g_alive &&
+		   (bench->n_registered + bench->n_probes_ready + bench->closed <
+				bench->n_users + bench->n_probes ||
+			bench->pending_joins > 0)) {
+		if (get_time_ms() - start > BENCH_SETUP_TIMEOUT_MS) {
+			log_warn("setup timed out: %zu users registered, %zu joins pending",
+					 bench->n_registered, bench->pending_joins);
+			break;
+		}
+
+		Bench_poll(bench, BENCH_TICK_MS);
+	}
+
+	bench->setup = false;
+	double setup_s = (get_time_ms() - start) / 1e3;
+
+	// Servers are linked once their users are registered, so each link
+	// carries a burst of all users behind it
+	if (bench->topology && g_alive && !Bench_link_servers(bench)) {
+		Bench_stop_servers(bench);
+		return 1;
+	}
+
+	// Send operations at the target rate
+	uint64_t load_start = get_time_ns();
+	uint64_t load_ns = bench->duration_s * 1e9;
+	uint64_t kill_ns = bench->kill_at_s * 1e9;
+	uint64_t issued = 0;
+
+	while (g_alive) {
+		uint64_t elapsed = get_time_ns() - load_start;
+
+		if (elapsed >= load_ns) {
+			break;
+		}
+
+		if (bench->n_links > 0 && kill_ns > 0 && elapsed >= kill_ns &&
+			!bench->killed_at) {
+			Bench_kill_link(bench);
+		}
+
+		if (bench->killed && !bench->recovered_ns) {
+			Bench_check_recovery(bench);
+		}
+
+		uint64_t due = elapsed / 1e9 * bench->rate;
+
+		for (; issued < due; issued++) {
+			run_operation(bench);
+		}
+
+		Bench_poll(bench, BENCH_TICK_MS);
+	}
+
+	double load_s = (get_time_ns() - load_start) / 1e9;
+
+	Bench_drain(bench);
+	report(bench, setup_s, load_s);
+
+	if (bench->topology) {
+		Bench_report_topology(bench);
+	}
+
+	free_bench(bench);
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+#include "include/bench.h"
+#include "include/capture.h"
+
+/*
+ * Replay of a capture made by "build/server -c <file>". Every connection of
+ * the capture is opened at the time of its first line, sends its lines at the
+ * times they were read, divided by the speed, and is closed where it was
+ * closed in the capture. The text of a PRIVMSG is prefixed with the time it
+ * was sent, so the delivery latency is measured as for generated load.
+ *
+ * PINGs of the server are answered as they arrive, so the PONGs of the
+ * capture are not sent.
+ */
+
+/**
+ * Count the connections and records of the capture. The bench gets one user
+ * for each connection.
+ */
+bool Bench_load_capture(Bench *bench) {
+	CaptureReader *reader = CaptureReader_open(bench->replay_path);
+
+	if (!reader) {
+		return false;
+	}
+
+	CaptureRecord *record = malloc(sizeof *record);
+	size_t n_users = 0;
+
+	while (CaptureReader_next(reader, record)) {
+		n_users = MAX(n_users, record->conn_id);
+		bench->replay_records++;
+		bench->replay_us = record->at_us;
+	}
+
+	free(record);
+	CaptureReader_close(reader);
+
+	if (n_users == 0) {
+		log_error("capture %s has no lines", bench->replay_path);
+		return false;
+	}
+
+	bench->n_users = n_users;
+	bench->joins_per_user = 0;
+
+	return true;
+}
+
+static void replay_record(Bench *bench, CaptureRecord *record) {
+	BenchUser *user = &bench->users[record->conn_id - 1];
+
+	if (record->len == 0) {
+		Bench_close_user(bench, user);
+		return;
+	}
+
+	if (!user->opened) {
+		user->opened = true;
+
+		if (!Bench_open_user(bench, user)) {
+			bench->replay_failed++;
+		}
+	}
+
+	if (user->fd == -1) {
+		bench->replay_dropped++;
+		return;
+	}
+
+	if (!strncmp(record->line, "PONG", 4)) {
+		return;
+	}
+
+	char *text = strstr(record->line, " :");
+
+	if (text && !strncmp(record->line, "PRIVMSG ", 8)) {
+		*text = 0;
+		Bench_send_line(bench, user, "%s :bench %lu %d %s", record->line,
+						get_time_ns(), user->server, text + 2);
+		bench->ops[OP_PRIVMSG]++;
+	} else {
+		Bench_send_line(bench, user, "%s", record->line);
+	}
+
+	bench->replayed++;
+}
+
+static void report_replay(Bench *bench, double load_s) {
+	double capture_s = bench->replay_us / 1e6;
+
+	printf("replayed %lu of %lu lines from %zu connections in %.2f s "
+		   "(%.0f lines/s), captured in %.2f s, speed %gx\n",
+		   (unsigned long)bench->replayed,
+		   (unsigned long)bench->replay_records, bench->n_users, load_s,
+		   load_s > 0 ? bench->replayed / load_s : 0, capture_s,
+		   bench->replay_speed);
+	printf("%lu privmsg, %lu dropped, %lu connects failed, %lu registered, "
+		   "%lu errors, %lu closed\n",
+		   (unsigned long)bench->ops[OP_PRIVMSG],
+		   (unsigned long)bench->replay_dropped,
+		   (unsigned long)bench->replay_failed,
+		   (unsigned long)bench->n_registered, (unsigned long)bench->errors,
+		   (unsigned long)bench->closed);
+	printf("delivered %lu messages (%.0f msgs/s)\n",
+		   (unsigned long)bench->delivered,
+		   load_s > 0 ? bench->delivered / load_s : 0);
+	Bench_report_latency(bench);
+	printf("send lag ms: p50 %.3f p99 %.3f max %.3f\n",
+		   Histogram_percentile(&bench->replay_lag, 50) / 1e6,
+		   Histogram_percentile(&bench->replay_lag, 99) / 1e6,
+		   bench->replay_lag.max / 1e6);
+}
+
+/**
+ * Send the lines of the capture on schedule. The time by which a line is
+ * sent late shows whether the server or the bench kept up with the speed.
+ */
+bool Bench_replay(Bench *bench) {
+	CaptureReader *reader = CaptureReader_open(bench->replay_path);
+
+	if (!reader) {
+		return false;
+	}
+
+	for (size_t i = 0; i < bench->n_users; i++) {
+		bench->users[i].fd = -1;
+		bench->users[i].id = i;
+		bench->users[i].probe_from = -1;
+	}
+
+	CaptureRecord *record = malloc(sizeof *record);
+	bool more = CaptureReader_next(reader, record);
+	uint64_t start = get_time_ns();
+
+	while (g_alive && more) {
+		uint64_t elapsed = get_time_ns() - start;
+		uint64_t due = record->at_us * 1e3 / bench->replay_speed;
+
+		if (elapsed < due) {
+			Bench_poll(bench, due - elapsed < 1000000 ? 0 : BENCH_TICK_MS);
+			continue;
+		}
+
+		// Lines which are due are sent in a batch before the next poll
+		for (int sent = 0; more && due <= elapsed && sent < BENCH_CONNECT_BATCH;
+			 sent++) {
+			Histogram_add(&bench->replay_lag, elapsed - due);
+			replay_record(bench, record);
+			more = CaptureReader_next(reader, record);
+			due = record->at_us * 1e3 / bench->replay_speed;
+		}
+
+		Bench_poll(bench, 0);
+	}
+
+	double load_s = (get_time_ns() - start) / 1e9;
+
+	Bench_drain(bench);
+	report_replay(bench, load_s);
+
+	free(record);
+	CaptureReader_close(reader);
+
+	return true;
+}
@@ -0,0 +1,609 @@
+#include <ftw.h>
+#include <libgen.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "include/bench.h"
+
+/*
+ * Topologies of local servers for the bench. Each server is started in a
+ * directory of its own, so the servers do not share channel stores and logs,
+ * and with an admin socket which is used to kill links.
+ *
+ * Every server has a probe user which joins BENCH_PROBE_CHANNEL. A link is
+ * brought up by a CONNECT from the probe user of one end, after which that
+ * user sends a probe to the channel every BENCH_PROBE_INTERVAL_MS. The link
+ * is up once the probe user at the other end receives a probe sent after the
+ * CONNECT: the probe is queued behind the handshake and the burst of users,
+ * so this is the time for the whole link to come up. Recovery after a killed
+ * link is measured the same way from the time of the kill.
+ *
+ * The servers keep their links a spanning tree and ignore a CONNECT to a
+ * server they can already reach, so the extra links of a mesh are marked
+ * redundant.
+ */
+
+static BenchUser *probe_user(Bench *bench, int server) {
+	return &bench->users[bench->n_users + server];
+}
+
+static void add_link(Bench *bench, int from, int to) {
+	BenchLink *link = &bench->links[bench->n_links++];
+	link->from = from;
+	link->to = to;
+}
+
+/**
+ * Compute the hops between all servers over the links which are up.
+ */
+static void compute_hops(Bench *bench) {
+	size_t n = bench->n_servers;
+
+	for (size_t src = 0; src < n; src++) {
+		int queue[BENCH_MAX_SERVERS];
+		size_t head = 0, tail = 0;
+
+		for (size_t i = 0; i < n; i++) {
+			bench->hops[src][i] = -1;
+		}
+
+		bench->hops[src][src] = 0;
+		queue[tail++] = src;
+
+		while (head < tail) {
+			int server = queue[head++];
+
+			for (size_t i = 0; i < bench->n_links; i++) {
+				BenchLink *link = &bench->links[i];
+				int other = link->from == server ? link->to
+						  : link->to == server	 ? link->from
+												 : -1;
+
+				if (!link->up || other == -1 || bench->hops[src][other] >= 0) {
+					continue;
+				}
+
+				bench->hops[src][other] = bench->hops[src][server] + 1;
+				queue[tail++] = other;
+			}
+		}
+	}
+}
+
+/**
+ * Make the links of a chain, star or mesh of the servers. The first server
+ * is the center of a star.
+ */
+bool Bench_build_topology(Bench *bench, const char *topology) {
+	size_t n = bench->n_servers;
+
+	if (n < 2) {
+		log_error("a topology needs at least 2 servers");
+		return false;
+	}
+
+	bench->links = calloc(n * (n - 1) / 2, sizeof *bench->links);
+	bench->n_links = 0;
+
+	if (!strcmp(topology, "chain")) {
+		for (size_t i = 1; i < n; i++) {
+			add_link(bench, i - 1, i);
+		}
+	} else if (!strcmp(topology, "star")) {
+		for (size_t i = 1; i < n; i++) {
+			add_link(bench, 0, i);
+		}
+	} else if (!strcmp(topology, "mesh")) {
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = i + 1; j < n; j++) {
+				add_link(bench, i, j);
+			}
+		}
+	} else {
+		log_error("unknown topology %s", topology);
+		return false;
+	}
+
+	compute_hops(bench);
+	return true;
+}
+
+/**
+ * Connect to the admin socket of server. Returns -1 if it is not listening.
+ */
+static int connect_admin(BenchServer *server) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof addr.sun_path, "%s", server->admin_path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd == -1) {
+		return -1;
+	}
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof addr) == -1) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * Send request to the admin socket of server and return the reply up to and
+ * including the line starting with OK or ERR, or NULL on error.
+ */
+static char *admin_request(BenchServer *server, const char *request) {
+	int fd = connect_admin(server);
+
+	if (fd == -1) {
+		log_warn("failed to connect to admin socket of %s", server->name);
+		return NULL;
+	}
+
+	MsgBuf reply;
+	msgbuf_init(&reply);
+	msgbuf_add_format(&reply, "%s\r\n", request);
+	bool ok = write_all(fd, reply.data, reply.len) != -1;
+	msgbuf_clear(&reply);
+
+	char buf[4096];
+	size_t line_start = 0;
+
+	while (ok) {
+		ssize_t n = read(fd, buf, sizeof buf);
+
+		if (n <= 0) {
+			ok = false;
+			break;
+		}
+
+		msgbuf_add_bytes(&reply, buf, n);
+
+		// Look for the last line among the complete lines read so far
+		char *end;
+		bool done = false;
+
+		while (!done &&
+			   (end = memchr(reply.data + line_start, '\n',
+							 reply.len - line_start)) != NULL) {
+			char *line = reply.data + line_start;
+			done = !strncmp(line, "OK", 2) || !strncmp(line, "ERR", 3);
+			line_start = end - reply.data + 1;
+		}
+
+		if (done) {
+			break;
+		}
+	}
+
+	close(fd);
+
+	if (!ok) {
+		msgbuf_destroy(&reply);
+		return NULL;
+	}
+
+	char *text = msgbuf_to_string(&reply);
+	msgbuf_destroy(&reply);
+	return text;
+}
+
+/**
+ * Returns true if server from has a link to server to, whether it is
+ * registered or not.
+ */
+static bool has_link(Bench *bench, int from, int to) {
+	char *dump = admin_request(&bench->servers[from], "DUMP");
+
+	if (!dump) {
+		return false;
+	}
+
+	char *prefix = make_string("peer %s ", bench->servers[to].name);
+	bool found = !strncmp(dump, prefix, strlen(prefix));
+
+	for (char *line = strchr(dump, '\n'); line && !found;
+		 line = strchr(line + 1, '\n')) {
+		found = !strncmp(line + 1, prefix, strlen(prefix));
+	}
+
+	free(prefix);
+	free(dump);
+	return found;
+}
+
+static void send_connect(Bench *bench, BenchLink *link) {
+	Bench_send_line(bench, probe_user(bench, link->from), "CONNECT %s",
+					bench->servers[link->to].name);
+	bench->next_check_at = get_time_ns() + BENCH_CONNECT_RETRY_MS * 1000000ULL;
+}
+
+/**
+ * Send a probe across link if one is due and CONNECT again if the link is
+ * gone. Returns true once a probe sent after since has crossed the link.
+ */
+static bool probe_link(Bench *bench, BenchLink *link, uint64_t since,
+					   int *connects) {
+	BenchUser *receiver = probe_user(bench, link->to);
+
+	if (receiver->probe_from == link->from && receiver->probe_sent_at >= since) {
+		return true;
+	}
+
+	uint64_t now = get_time_ns();
+
+	if (now >= bench->next_probe_at) {
+		Bench_send_line(bench, probe_user(bench, link->from),
+						"PRIVMSG %s :probe %lu %d", BENCH_PROBE_CHANNEL,
+						(unsigned long)now, link->from);
+		bench->next_probe_at = now + BENCH_PROBE_INTERVAL_MS * 1000000ULL;
+	}
+
+	// A CONNECT fails if the other end still has the old link
+	if (now >= bench->next_check_at) {
+		if (has_link(bench, link->from, link->to)) {
+			bench->next_check_at = now + BENCH_CONNECT_RETRY_MS * 1000000ULL;
+		} else {
+			send_connect(bench, link);
+			(*connects)++;
+		}
+	}
+
+	return false;
+}
+
+void Bench_handle_probe(Bench *bench, BenchUser *user, const char *body) {
+	(void)bench;
+
+	if (!user->probe) {
+		return;
+	}
+
+	char *end = NULL;
+	user->probe_sent_at = strtoull(body, &end, 10);
+	user->probe_from = strtol(end, NULL, 10);
+	user->probe_received_at = get_time_ns();
+}
+
+/**
+ * Bring up the links one at a time and measure the time each takes to carry
+ * a probe. Returns false if the bench was interrupted.
+ */
+bool Bench_link_servers(Bench *bench) {
+	for (size_t i = 0; i < bench->n_links && g_alive; i++) {
+		BenchLink *link = &bench->links[i];
+		link->redundant = bench->hops[link->from][link->to] >= 0;
+		uint64_t start = get_time_ns();
+		send_connect(bench, link);
+		link->connects++;
+
+		if (link->redundant) {
+			continue;
+		}
+
+		while (g_alive && !probe_link(bench, link, start, &link->connects)) {
+			if (get_time_ns() - start > BENCH_LINK_TIMEOUT_MS * 1000000ULL) {
+				log_warn("link %s-%s is not up after %d ms",
+						 bench->servers[link->from].name,
+						 bench->servers[link->to].name, BENCH_LINK_TIMEOUT_MS);
+				break;
+			}
+
+			Bench_poll(bench, BENCH_TICK_MS);
+		}
+
+		BenchUser *receiver = probe_user(bench, link->to);
+
+		if (receiver->probe_from == link->from &&
+			receiver->probe_sent_at >= start) {
+			link->up = true;
+			link->up_ns = receiver->probe_received_at - start;
+			compute_hops(bench);
+		}
+	}
+
+	return g_alive;
+}
+
+/**
+ * Drop the middle link which is up from its CONNECT end, as if the network
+ * failed, and CONNECT again at once.
+ */
+void Bench_kill_link(Bench *bench) {
+	BenchLink *up[BENCH_MAX_SERVERS];
+	size_t n_up = 0;
+
+	for (size_t i = 0; i < bench->n_links && n_up < BENCH_MAX_SERVERS; i++) {
+		if (bench->links[i].up) {
+			up[n_up++] = &bench->links[i];
+		}
+	}
+
+	bench->killed_at = get_time_ns();
+
+	if (n_up == 0) {
+		return;
+	}
+
+	BenchLink *link = up[n_up / 2];
+	char *request = make_string("DROP %s", bench->servers[link->to].name);
+	char *reply = admin_request(&bench->servers[link->from], request);
+
+	if (reply && !strncmp(reply, "OK", 2)) {
+		bench->killed = link;
+		bench->next_probe_at = 0;
+		send_connect(bench, link);
+		link->reconnects++;
+	} else {
+		log_warn("failed to drop link %s-%s: %s",
+				 bench->servers[link->from].name, bench->servers[link->to].name,
+				 reply ? reply : "no reply");
+	}
+
+	free(request);
+	free(reply);
+}
+
+void Bench_check_recovery(Bench *bench) {
+	BenchLink *link = bench->killed;
+
+	if (probe_link(bench, link, bench->killed_at, &link->reconnects)) {
+		bench->recovered_ns =
+			probe_user(bench, link->to)->probe_received_at - bench->killed_at;
+	}
+}
+
+/**
+ * Prepare the working directory of server: the config, MOTD and channels
+ * of the current directory are linked into it.
+ */
+static bool make_server_dir(Bench *bench, BenchServer *server) {
+	server->dir = make_string("%s/%s", bench->run_dir, server->name);
+	server->admin_path = make_string("%s/admin.sock", server->dir);
+	char *data_dir = make_string("%s/data", server->dir);
+	char *config = realpath(CONFIG_FILENAME, NULL);
+	char *motd = realpath("./data/motd.txt", NULL);
+	char *channels = realpath("./data/channels.txt", NULL);
+	bool ok = mkdir(server->dir, 0755) == 0 && mkdir(data_dir, 0755) == 0;
+
+	if (ok && config) {
+		char *path = make_string("%s/config.csv", server->dir);
+		ok = symlink(config, path) == 0;
+		free(path);
+	}
+
+	if (ok && motd) {
+		char *path = make_string("%s/motd.txt", data_dir);
+		ok = symlink(motd, path) == 0;
+		free(path);
+	}
+
+	if (ok && channels) {
+		char *path = make_string("%s/channels.txt", data_dir);
+		ok = symlink(channels, path) == 0;
+		free(path);
+	}
+
+	if (!ok) {
+		log_error("failed to prepare %s: %s", server->dir, strerror(errno));
+	}
+
+	free(data_dir);
+	free(config);
+	free(motd);
+	free(channels);
+	return ok;
+}
+
+/**
+ * Start each server from the build directory of the bench and wait until all
+ * of them accept admin connections.
+ */
+bool Bench_start_servers(Bench *bench) {
+	char exe[PATH_MAX];
+	ssize_t len = readlink("/proc/self/exe", exe, sizeof exe - 1);
+
+	if (len == -1) {
+		perror("readlink");
+		return false;
+	}
+
+	exe[len] = 0;
+	char *server_exe = make_string("%s/server", dirname(exe));
+	bench->run_dir = strdup("/tmp/irc-bench-XXXXXX");
+
+	if (!mkdtemp(bench->run_dir)) {
+		perror("mkdtemp");
+		free(bench->run_dir);
+		bench->run_dir = NULL;
+		free(server_exe);
+		return false;
+	}
+
+	for (size_t i = 0; i < bench->n_servers; i++) {
+		BenchServer *server = &bench->servers[i];
+
+		if (!make_server_dir(bench, server)) {
+			free(server_exe);
+			return false;
+		}
+
+		char *log_path = make_string("%s/server.log", server->dir);
+		server->pid = fork();
+
+		if (server->pid == 0) {
+			int log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			int null_fd = open("/dev/null", O_RDWR);
+
+			if (chdir(server->dir) == -1 || log_fd == -1 || null_fd == -1) {
+				_exit(127);
+			}
+
+			dup2(null_fd, STDIN_FILENO);
+			dup2(null_fd, STDOUT_FILENO);
+			dup2(log_fd, STDERR_FILENO);
+			execl(server_exe, server_exe, "-l", "warn", "-a",
+				  server->admin_path, server->name, (char *)NULL);
+			_exit(127);
+		}
+
+		free(log_path);
+
+		if (server->pid == -1) {
+			perror("fork");
+			server->pid = 0;
+			free(server_exe);
+			return false;
+		}
+	}
+
+	free(server_exe);
+
+	uint64_t start = get_time_ms();
+
+	for (size_t i = 0; i < bench->n_servers; i++) {
+		BenchServer *server = &bench->servers[i];
+		int fd;
+
+		while ((fd = connect_admin(server)) == -1) {
+			int status;
+
+			if (waitpid(server->pid, &status, WNOHANG) == server->pid) {
+				log_error("server %s exited, see %s/server.log", server->name,
+						  server->dir);
+				server->pid = 0;
+				return false;
+			}
+
+			if (get_time_ms() - start > BENCH_START_TIMEOUT_MS || !g_alive) {
+				log_error("server %s is not listening", server->name);
+				return false;
+			}
+
+			usleep(10000);
+		}
+
+		close(fd);
+	}
+
+	return true;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+						struct FTW *ftw) {
+	(void)st;
+	(void)flag;
+	(void)ftw;
+	return remove(path);
+}
+
+/**
+ * Stop the started servers and remove their directories, which are kept if
+ * a server did not exit cleanly.
+ */
+void Bench_stop_servers(Bench *bench) {
+	bool clean = true;
+
+	for (size_t i = 0; i < bench->n_servers; i++) {
+		if (bench->servers[i].pid > 0) {
+			kill(bench->servers[i].pid, SIGINT);
+		}
+	}
+
+	for (size_t i = 0; i < bench->n_servers; i++) {
+		BenchServer *server = &bench->servers[i];
+		uint64_t start = get_time_ms();
+		int status = 0;
+
+		while (server->pid > 0 &&
+			   waitpid(server->pid, &status, WNOHANG) != server->pid) {
+			if (get_time_ms() - start > BENCH_START_TIMEOUT_MS) {
+				kill(server->pid, SIGKILL);
+				waitpid(server->pid, &status, 0);
+				break;
+			}
+
+			usleep(10000);
+		}
+
+		if (server->pid > 0 && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+			log_warn("server %s exited with status %d, see %s/server.log",
+					 server->name, status, server->dir);
+			clean = false;
+		}
+
+		server->pid = 0;
+		free(server->dir);
+		free(server->admin_path);
+		server->dir = server->admin_path = NULL;
+	}
+
+	if (bench->run_dir && clean) {
+		nftw(bench->run_dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	}
+
+	free(bench->run_dir);
+	bench->run_dir = NULL;
+}
+
+void Bench_report_topology(Bench *bench) {
+	printf("topology %s of %zu servers:", bench->topology, bench->n_servers);
+
+	for (size_t i = 0; i < bench->n_links; i++) {
+		printf(" %s-%s", bench->servers[bench->links[i].from].name,
+			   bench->servers[bench->links[i].to].name);
+	}
+
+	printf("\n");
+
+	for (size_t i = 0; i < bench->n_links; i++) {
+		BenchLink *link = &bench->links[i];
+		printf("link %s-%s: ", bench->servers[link->from].name,
+			   bench->servers[link->to].name);
+
+		if (link->redundant) {
+			printf("redundant, servers were already connected\n");
+		} else if (link->up) {
+			printf("up in %.3f ms after %d CONNECT\n", link->up_ns / 1e6,
+				   link->connects);
+		} else {
+			printf("not up\n");
+		}
+	}
+
+	for (size_t hops = 0; hops < bench->n_servers; hops++) {
+		const Histogram *latency = &bench->hop_latency[hops];
+
+		if (latency->total == 0) {
+			continue;
+		}
+
+		printf("%zu hops: %lu messages, latency ms p50 %.3f p99 %.3f max %.3f\n",
+			   hops, (unsigned long)latency->total,
+			   Histogram_percentile(latency, 50) / 1e6,
+			   Histogram_percentile(latency, 99) / 1e6, latency->max / 1e6);
+	}
+
+	BenchLink *link = bench->killed;
+
+	if (!link) {
+		return;
+	}
+
+	printf("link %s-%s killed: ", bench->servers[link->from].name,
+		   bench->servers[link->to].name);
+
+	if (bench->recovered_ns) {
+		printf("recovered in %.3f ms after %d CONNECT\n",
+			   bench->recovered_ns / 1e6, link->reconnects);
+	} else {
+		printf("not recovered\n");
+	}
+}
@@ -152,15 +152,15 @@ int main(int argc, char *argv[]) {
 	client.port = info.peer_port;
 
 	// establish connection with the server
-	int client_sock = connect_to_host(client.hostname, client.port);
-	fcntl(client_sock, F_SETFL, fcntl(client_sock, F_GETFL) | O_NONBLOCK);
+	client.conn = Connection_create_and_connect(client.hostname, client.port);
 
-	// init client
-	client.conn = calloc(1, sizeof *client.conn);
-	client.conn->fd = client_sock;
+	if (!client.conn) {
+		die("Failed to connect to server");
+	}
+
+	fcntl(client.conn->fd, F_SETFL,
+		  fcntl(client.conn->fd, F_GETFL) | O_NONBLOCK);
 	client.conn->conn_type = CLIENT_CONNECTION;
-	client.conn->incoming_messages = List_alloc(NULL, free);
-	client.conn->outgoing_messages = List_alloc(NULL, free);
 
 	pthread_mutex_init(&client.mutex, NULL);
 
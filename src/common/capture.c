@@ -0,0 +1,348 @@
+#include "include/capture.h"
+
+#include <ctype.h>
+
+static uint64_t capture_now_us(void)
+{
+	return get_time_ns() / 1000;
+}
+
+static void write_varint(FILE *file, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		putc((value & 0x7f) | 0x80, file);
+		value >>= 7;
+	}
+
+	putc(value, file);
+}
+
+static bool read_varint(FILE *file, uint64_t *value)
+{
+	*value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int c = getc(file);
+
+		if (c == EOF)
+		{
+			return false;
+		}
+
+		*value |= (uint64_t)(c & 0x7f) << shift;
+
+		if (!(c & 0x80))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Create a capture file. The salt is random so names cannot be recovered by
+ * hashing guesses.
+ */
+Capture *Capture_open(const char *filename)
+{
+	FILE *file = fopen(filename, "wb");
+
+	if (!file)
+	{
+		log_error("failed to open capture %s: %s", filename, strerror(errno));
+		return NULL;
+	}
+
+	Capture *capture = calloc(1, sizeof *capture);
+	capture->file = file;
+	capture->last_us = capture_now_us();
+	capture->next_id = 1;
+	capture->salt = get_time_ns() ^ ((uint64_t)getpid() << 32);
+
+	FILE *urandom = fopen("/dev/urandom", "rb");
+
+	if (urandom)
+	{
+		if (fread(&capture->salt, sizeof capture->salt, 1, urandom) != 1)
+		{
+			log_warn("failed to read /dev/urandom");
+		}
+
+		fclose(urandom);
+	}
+
+	fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_LEN, file);
+	log_info("Capturing user traffic to %s", filename);
+
+	return capture;
+}
+
+void Capture_close(Capture *capture)
+{
+	if (!capture)
+	{
+		return;
+	}
+
+	fclose(capture->file);
+	log_info("Captured %lu lines, %lu bytes", (unsigned long)capture->records,
+			 (unsigned long)capture->bytes);
+	free(capture);
+}
+
+static void Capture_write(Capture *capture, uint32_t conn_id, const char *data,
+						  size_t len)
+{
+	uint64_t now = capture_now_us();
+	uint64_t delta = now > capture->last_us ? now - capture->last_us : 0;
+	capture->last_us += delta;
+
+	write_varint(capture->file, conn_id);
+	write_varint(capture->file, delta);
+	write_varint(capture->file, len);
+	fwrite(data, 1, len, capture->file);
+
+	capture->records++;
+	capture->bytes += len;
+}
+
+/**
+ * Record a line read from conn. The connection gets an id at its first line,
+ * unless that line starts a server link, which stops the capture of conn.
+ */
+void Capture_record(Capture *capture, Connection *conn, const char *line,
+					size_t len)
+{
+	if (len == 0)
+	{
+		return;
+	}
+
+	if (conn->capture_id == 0)
+	{
+		if (!strncmp(line, "PASS", 4) || !strncmp(line, "SERVER", 6))
+		{
+			conn->capture = NULL;
+			return;
+		}
+
+		conn->capture_id = capture->next_id++;
+	}
+
+	char out[MAX_MSG_LEN + 1];
+	size_t out_len = Capture_anonymize(capture->salt, line, len, out, sizeof out);
+
+	if (out_len > 0)
+	{
+		Capture_write(capture, conn->capture_id, out, out_len);
+	}
+}
+
+void Capture_record_close(Capture *capture, Connection *conn)
+{
+	if (conn->capture_id != 0)
+	{
+		Capture_write(capture, conn->capture_id, NULL, 0);
+	}
+}
+
+/**
+ * Salted 64 bit FNV-1a hash of a name without case, so that names which the
+ * server treats as equal get the same replacement.
+ */
+static uint32_t capture_hash(uint64_t salt, const char *str, size_t len)
+{
+	uint64_t hash = 14695981039346656037ULL ^ salt;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)tolower(str[i]);
+		hash *= 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	return hash & 0xfffffff;
+}
+
+static bool capture_keep(const char *item, size_t len)
+{
+	if (len == 0 || (len == 1 && *item == '*') || *item == '+' || *item == '-')
+	{
+		return true;
+	}
+
+	for (size_t i = 0; i < len; i++)
+	{
+		if (!isdigit(item[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t Capture_anonymize(uint64_t salt, const char *line, size_t len, char *out,
+						 size_t size)
+{
+	const char *end = line + len;
+	size_t n = 0;
+
+	// A prefix sent by a user is ignored by the server
+	if (line < end && *line == ':')
+	{
+		while (line < end && *line != ' ')
+		{
+			line++;
+		}
+
+		while (line < end && *line == ' ')
+		{
+			line++;
+		}
+	}
+
+	// Command
+	while (line < end && *line != ' ' && n + 1 < size)
+	{
+		out[n++] = *line++;
+	}
+
+	while (line < end && n + 1 < size)
+	{
+		if (*line == ' ')
+		{
+			out[n++] = *line++;
+			continue;
+		}
+
+		// Trailing parameter
+		if (*line == ':')
+		{
+			out[n++] = ':';
+
+			for (line++; line < end && n + 1 < size; line++)
+			{
+				out[n++] = 'x';
+			}
+
+			break;
+		}
+
+		// Middle parameter as a list of items separated by commas
+		const char *param_end = line;
+
+		while (param_end < end && *param_end != ' ')
+		{
+			param_end++;
+		}
+
+		while (line < param_end && n + 1 < size)
+		{
+			const char *item_end = memchr(line, ',', param_end - line);
+
+			if (!item_end)
+			{
+				item_end = param_end;
+			}
+
+			size_t item_len = item_end - line;
+			char item[16];
+
+			if (capture_keep(line, item_len))
+			{
+				size_t copy = MIN(item_len, size - 1 - n);
+				memcpy(out + n, line, copy);
+				n += copy;
+			}
+			else
+			{
+				bool channel = *line == '#' || *line == '&';
+				int item_out =
+					snprintf(item, sizeof item, channel ? "#c%07x" : "a%07x",
+							 capture_hash(salt, line, item_len));
+				size_t copy = MIN((size_t)item_out, size - 1 - n);
+				memcpy(out + n, item, copy);
+				n += copy;
+			}
+
+			line = item_end;
+
+			if (line < param_end && n + 1 < size)
+			{
+				out[n++] = *line++;
+			}
+		}
+	}
+
+	out[n] = 0;
+	return n;
+}
+
+CaptureReader *CaptureReader_open(const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+
+	if (!file)
+	{
+		log_error("failed to open capture %s: %s", filename, strerror(errno));
+		return NULL;
+	}
+
+	char magic[CAPTURE_MAGIC_LEN];
+
+	if (fread(magic, 1, sizeof magic, file) != sizeof magic ||
+		memcmp(magic, CAPTURE_MAGIC, sizeof magic))
+	{
+		log_error("%s is not a capture file", filename);
+		fclose(file);
+		return NULL;
+	}
+
+	CaptureReader *reader = calloc(1, sizeof *reader);
+	reader->file = file;
+	return reader;
+}
+
+/**
+ * Read the next record. Returns false at the end of the file, or if the
+ * rest of the file is not a valid record.
+ */
+bool CaptureReader_next(CaptureReader *reader, CaptureRecord *record)
+{
+	uint64_t conn_id, delta, len;
+
+	if (!read_varint(reader->file, &conn_id) ||
+		!read_varint(reader->file, &delta) ||
+		!read_varint(reader->file, &len) || conn_id == 0 ||
+		conn_id > UINT32_MAX || len > MAX_MSG_LEN ||
+		fread(record->line, 1, len, reader->file) != len)
+	{
+		return false;
+	}
+
+	reader->at_us += delta;
+	record->conn_id = conn_id;
+	record->at_us = reader->at_us;
+	record->len = len;
+	record->line[len] = 0;
+
+	return true;
+}
+
+void CaptureReader_close(CaptureReader *reader)
+{
+	if (!reader)
+	{
+		return;
+	}
+
+	fclose(reader->file);
+	free(reader);
+}
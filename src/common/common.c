@@ -1,6 +1,8 @@
 #include "include/common.h"
 #include "include/server.h"
 
+#include <time.h>
+
 /**
  * Use this utility function to allocate a string with given format and args.
  * The purpose of this function is to check the size of the resultant string
@@ -79,6 +81,64 @@ char *rstrstr(char *string, char *pattern)
 	return prev;
 }
 
+static uint64_t (*clock_now_ns)(void *) = NULL;
+static void *clock_arg = NULL;
+
+/**
+ * Replace the monotonic clock of get_time_ms() and get_time_ns() with the
+ * function now_ns called with arg, such as the virtual clock of a simulation.
+ * Pass NULL to use the monotonic clock again.
+ */
+void set_clock(uint64_t (*now_ns)(void *), void *arg)
+{
+	clock_now_ns = now_ns;
+	clock_arg = arg;
+}
+
+/**
+ * Returns the current time of the monotonic clock in milliseconds.
+ * Use this to measure intervals and deadlines as it is not affected by
+ * changes to the system time.
+ */
+uint64_t get_time_ms()
+{
+	if (clock_now_ns)
+	{
+		return clock_now_ns(clock_arg) / 1000000;
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Returns the time of the monotonic clock in nanoseconds. Use this to measure
+ * short durations.
+ */
+uint64_t get_time_ns()
+{
+	if (clock_now_ns)
+	{
+		return clock_now_ns(clock_arg);
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Returns the current wall clock time in milliseconds since the epoch.
+ * Use this for times which are shown to users.
+ */
+uint64_t get_realtime_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 Vector *readlines(const char *filename)
 {
 	FILE *file = fopen(filename, "r");
@@ -366,6 +426,22 @@ ssize_t write_all(int fd, char *buf, size_t len)
 	return bytes_written;
 }
 
+/**
+ * Start a thread with all signals blocked, so that signals are only handled by
+ * the thread which calls this function. Returns 0 or an error number like
+ * pthread_create.
+ */
+int start_thread(pthread_t *thread, void *(*start)(void *), void *arg)
+{
+	sigset_t mask, old_mask;
+	sigfillset(&mask);
+	pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+	int error = pthread_create(thread, NULL, start, arg);
+	pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+	return error;
+}
+
 bool get_peer_info(const char *filename, const char *name, struct peer_info_t *info)
 {
 	FILE *file = fopen(filename, "r");
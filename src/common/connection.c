@@ -1,21 +1,56 @@
 /**
- * Functions to read/write from a socket byte stream
+ * Functions to read/write from a socket byte stream, or from any other
+ * stream with a Transport
  */
 
 #include "include/connection.h"
 
+#include "include/capture.h"
 #include "include/server.h"
 
-Connection *Connection_alloc(int fd, struct sockaddr *addr, socklen_t addrlen) {
+static ssize_t socket_read(Connection *this, char *buf, size_t len) {
+	return read_all(this->fd, buf, len);
+}
+
+static ssize_t socket_write(Connection *this, char *buf, size_t len) {
+	return write_all(this->fd, buf, len);
+}
+
+static void socket_close(Connection *this) {
+	if (this->fd != -1) {
+		shutdown(this->fd, SHUT_RDWR);
+		close(this->fd);
+	}
+}
+
+const Transport socket_transport = {socket_read, socket_write, socket_close};
+
+/**
+ * Every connection is created here, so none is left without a transport.
+ */
+static Connection *Connection_new(int fd, const char *hostname, int port) {
 	Connection *this = calloc(1, sizeof *this);
 	this->fd = fd;
-	this->hostname = strdup(addr_to_string(addr, addrlen));
-	this->port = get_port(addr);
+	this->transport = &socket_transport;
+	this->hostname = strdup(hostname);
+	this->port = port;
 	this->incoming_messages = List_alloc(NULL, free);
 	this->outgoing_messages = List_alloc(NULL, free);
 	return this;
 }
 
+Connection *Connection_alloc(int fd, struct sockaddr *addr, socklen_t addrlen) {
+	return Connection_new(fd, addr_to_string(addr, addrlen), get_port(addr));
+}
+
+/**
+ * Create connection for a socket which has no network address, such as a
+ * Unix domain socket. The name is used as its hostname.
+ */
+Connection *Connection_alloc_local(int fd, const char *name) {
+	return Connection_new(fd, name, 0);
+}
+
 Connection *Connection_create_and_connect(const char *hostname,
 										  const char *port) {
 	int fd = connect_to_host(hostname, port);
@@ -24,20 +59,15 @@ Connection *Connection_create_and_connect(const char *hostname,
 		return NULL;
 	}
 
-	Connection *this = calloc(1, sizeof *this);
-	this->fd = fd;
-	this->hostname = strdup(hostname);
-	this->port = atoi(port);
-	this->incoming_messages = List_alloc(NULL, free);
-	this->outgoing_messages = List_alloc(NULL, free);
-	return this;
+	return Connection_new(fd, hostname, atoi(port));
 }
 
 void Connection_free(Connection *this) {
-	if (this->fd != -1) {
-		shutdown(this->fd, SHUT_RDWR);
-		close(this->fd);
+	if (this->capture) {
+		Capture_record_close(this->capture, this);
 	}
+
+	this->transport->close(this);
 	List_free(this->incoming_messages);
 	List_free(this->outgoing_messages);
 	free(this->hostname);
@@ -55,8 +85,8 @@ ssize_t Connection_read(Connection *this) {
 		return -1;
 	}
 	// Read available bytes into request buffer
-	ssize_t nread = read_all(this->fd, this->req_buf + this->req_len,
-							 MAX_MSG_LEN - this->req_len);
+	ssize_t nread = this->transport->read(
+		this, this->req_buf + this->req_len, MAX_MSG_LEN - this->req_len);
 
 	if (nread <= 0) {
 		log_error("read_all(): %s", strerror(errno));
@@ -64,6 +94,7 @@ ssize_t Connection_read(Connection *this) {
 	}
 
 	this->req_len += nread;
+	this->bytes_received += nread;
 	this->req_buf[this->req_len] = 0;
 
 	char *start_msg = this->req_buf;
@@ -73,7 +104,13 @@ ssize_t Connection_read(Connection *this) {
 	while ((end_msg = strstr(start_msg, "\r\n")) != NULL) {
 		char *message = strndup(start_msg, end_msg - start_msg);
 		// log_debug("Message: %s", message);
+
+		if (this->capture) {
+			Capture_record(this->capture, this, message, end_msg - start_msg);
+		}
+
 		List_push_back(this->incoming_messages, message);
+		this->messages_received++;
 		start_msg = end_msg + 2;
 	}
 
@@ -81,7 +118,7 @@ ssize_t Connection_read(Connection *this) {
 	if (start_msg > this->req_buf &&
 		start_msg < this->req_buf + this->req_len) {
 		size_t new_len = strlen(start_msg);
-		memmove(start_msg, this->req_buf, new_len);
+		memmove(this->req_buf, start_msg, new_len);
 		this->req_buf[new_len] = 0;
 		this->req_len = new_len;
 	} else {
@@ -100,8 +137,9 @@ ssize_t Connection_write(Connection *this) {
 
 	// Send all available bytes from response buffer
 	if (this->res_len > 0 && this->res_off < this->res_len) {
-		ssize_t nsent = write_all(this->fd, this->res_buf + this->res_off,
-								  this->res_len - this->res_off);
+		ssize_t nsent =
+			this->transport->write(this, this->res_buf + this->res_off,
+								   this->res_len - this->res_off);
 		// log_debug("Sent %zd bytes to fd %d", nsent, this->fd);
 
 		if (nsent <= 0) {
@@ -110,11 +148,13 @@ ssize_t Connection_write(Connection *this) {
 		}
 
 		this->res_off += nsent;
+		this->bytes_sent += nsent;
 
 		// Entire message was sent
 		if (this->res_off >= this->res_len) {
 			// Mark response buffer as empty
 			this->res_off = this->res_len = 0;
+			this->messages_sent++;
 		}
 
 		return nsent;
@@ -135,7 +175,7 @@ ssize_t Connection_write(Connection *this) {
 		char *msg = List_peek_front(queue);
 
 		// Add next message to response buffer
-		strncpy(this->res_buf, msg, strlen(msg));
+		memcpy(this->res_buf, msg, strlen(msg));
 
 		this->res_len = strlen(msg);
 		this->res_off = 0;
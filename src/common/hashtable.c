@@ -35,7 +35,7 @@ size_t djb2hash(const void *key, int len, uint32_t seed);
 
 size_t ht_size(Hashtable *this)
 {
-	return this->size;
+	return this ? this->size : 0;
 }
 
 size_t ht_capacity(Hashtable *this)
@@ -85,7 +85,7 @@ void ht_print(Hashtable *this, char *(*key_to_string)(void *),
 		itr = this->table[i];
 		while (itr)
 		{
-			log_info("bucket: %d, key: %s, value: %s", i,
+			log_info("bucket: %zu, key: %s, value: %s", i,
 					 key_to_string(itr->key),
 					 value_to_string(itr->value));
 			itr = itr->next;
@@ -290,36 +290,31 @@ bool ht_contains(Hashtable *this, const void *key)
  */
 bool ht_remove(Hashtable *this, const void *key, void **key_out, void **value_out)
 {
-	for (size_t i = 0; i < this->capacity; i++)
+	size_t hash = ht_hash(key, this->key_len, this->seed) % this->capacity;
+	HTNode *curr = this->table[hash];
+	HTNode *prev = NULL;
+
+	while (curr)
 	{
-		if (this->table[i])
+		if (this->key_compare(curr->key, key) == 0)
 		{
-			HTNode *curr = this->table[i];
-			HTNode *prev = NULL;
-
-			while (curr)
+			if (!prev)
 			{
-				if (this->key_compare(curr->key, key) == 0)
-				{
-					if (!prev)
-					{
-						this->table[i] = curr->next;
-					}
-					else
-					{
-						prev->next = curr->next;
-					}
-
-					ht_node_free(this, curr, key_out, value_out);
-					this->size--;
-
-					return true;
-				}
-
-				prev = curr;
-				curr = curr->next;
+				this->table[hash] = curr->next;
+			}
+			else
+			{
+				prev->next = curr->next;
 			}
+
+			ht_node_free(this, curr, key_out, value_out);
+			this->size--;
+
+			return true;
 		}
+
+		prev = curr;
+		curr = curr->next;
 	}
 
 	return false;
@@ -335,8 +330,8 @@ void ht_iter_init(HashtableIter *itr, Hashtable *ht)
 
 bool ht_iter_next(HashtableIter *itr, void **key_out, void **value_out)
 {
-	// End of table
-	if (itr->index >= itr->hashtable->capacity)
+	// End of table; a NULL table is empty
+	if (!itr->hashtable || itr->index >= itr->hashtable->capacity)
 	{
 		return false;
 	}
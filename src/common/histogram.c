@@ -0,0 +1,102 @@
+#include "include/histogram.h"
+
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+
+static size_t bucket_index(uint64_t value)
+{
+	if (value < HISTOGRAM_SUB_COUNT)
+	{
+		return value;
+	}
+
+	int bits = 64 - __builtin_clzll(value); /* value < 2^bits */
+
+	if (bits > HISTOGRAM_MAX_BITS)
+	{
+		return HISTOGRAM_BUCKETS - 1;
+	}
+
+	int shift = bits - 1 - HISTOGRAM_SUB_BITS;
+	return ((size_t)(shift + 1) << HISTOGRAM_SUB_BITS) + (value >> shift) - HISTOGRAM_SUB_COUNT;
+}
+
+/**
+ * Returns the largest value which is counted in bucket.
+ */
+static uint64_t bucket_max(size_t index)
+{
+	if (index < HISTOGRAM_SUB_COUNT)
+	{
+		return index;
+	}
+
+	int shift = (index >> HISTOGRAM_SUB_BITS) - 1;
+	uint64_t sub = (index & (HISTOGRAM_SUB_COUNT - 1)) + HISTOGRAM_SUB_COUNT;
+	return (sub << shift) + ((uint64_t)1 << shift) - 1;
+}
+
+void Histogram_add(Histogram *histogram, uint64_t value)
+{
+	histogram->counts[bucket_index(value)]++;
+	histogram->total++;
+	histogram->sum += value;
+
+	if (value > histogram->max)
+	{
+		histogram->max = value;
+	}
+}
+
+/**
+ * Returns the smallest value which is greater than or equal to percentile
+ * percent of the values added, rounded up to the end of its bucket.
+ */
+uint64_t Histogram_percentile(const Histogram *histogram, double percentile)
+{
+	if (histogram->total == 0)
+	{
+		return 0;
+	}
+
+	double exact_rank = percentile / 100 * histogram->total;
+	uint64_t rank = (uint64_t)exact_rank;
+	uint64_t seen = 0;
+
+	if (rank < exact_rank || rank == 0)
+	{
+		rank++;
+	}
+
+	size_t i = 0;
+
+	for (; i < HISTOGRAM_BUCKETS - 1; i++)
+	{
+		seen += histogram->counts[i];
+
+		if (seen >= rank)
+		{
+			break;
+		}
+	}
+
+	/* The last bucket has no upper bound */
+	uint64_t value = i < HISTOGRAM_BUCKETS - 1 ? bucket_max(i) : UINT64_MAX;
+	return value < histogram->max ? value : histogram->max;
+}
+
+/**
+ * Returns number of values added which are less than value. The count is exact
+ * if value is the start of a bucket, such as a power of two.
+ */
+uint64_t Histogram_count_below(const Histogram *histogram, uint64_t value)
+{
+	size_t end = bucket_index(value);
+	uint64_t count = 0;
+
+	for (size_t i = 0; i < end; i++)
+	{
+		count += histogram->counts[i];
+	}
+
+	return count;
+}
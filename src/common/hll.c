@@ -0,0 +1,126 @@
+#include "include/hll.h"
+
+#include <math.h>
+#include <string.h>
+
+static const char hll_alphabet[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * 64 bit FNV-1a hash followed by the murmur3 finalizer to spread the bits.
+ */
+static uint64_t hll_hash(const char *str)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (; *str; str++)
+	{
+		hash ^= (unsigned char)*str;
+		hash *= 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+void hll_init(HyperLogLog *this)
+{
+	memset(this, 0, sizeof *this);
+}
+
+void hll_add(HyperLogLog *this, const char *str)
+{
+	uint64_t hash = hll_hash(str);
+	size_t index = hash >> (64 - HLL_PRECISION);
+	uint64_t rest = hash << HLL_PRECISION;
+
+	// position of the first set bit in the remaining bits
+	uint8_t rank = 1;
+	while (rank <= 64 - HLL_PRECISION && !(rest & (1ULL << 63)))
+	{
+		rest <<= 1;
+		rank++;
+	}
+
+	if (rank > this->registers[index])
+	{
+		this->registers[index] = rank;
+	}
+}
+
+void hll_merge(HyperLogLog *this, const HyperLogLog *other)
+{
+	for (size_t i = 0; i < HLL_REGISTERS; i++)
+	{
+		if (other->registers[i] > this->registers[i])
+		{
+			this->registers[i] = other->registers[i];
+		}
+	}
+}
+
+double hll_estimate(const HyperLogLog *this)
+{
+	const double m = HLL_REGISTERS;
+	const double alpha = 0.7213 / (1 + 1.079 / m);
+
+	double sum = 0;
+	size_t zeros = 0;
+
+	for (size_t i = 0; i < HLL_REGISTERS; i++)
+	{
+		sum += ldexp(1.0, -this->registers[i]);
+
+		if (this->registers[i] == 0)
+		{
+			zeros++;
+		}
+	}
+
+	double estimate = alpha * m * m / sum;
+
+	// Use linear counting for small cardinalities
+	if (estimate <= 2.5 * m && zeros > 0)
+	{
+		estimate = m * log(m / zeros);
+	}
+
+	return estimate;
+}
+
+void hll_encode(const HyperLogLog *this, char *out)
+{
+	for (size_t i = 0; i < HLL_REGISTERS; i++)
+	{
+		out[i] = hll_alphabet[this->registers[i] & 63];
+	}
+
+	out[HLL_REGISTERS] = 0;
+}
+
+bool hll_decode(HyperLogLog *this, const char *str)
+{
+	if (strlen(str) != HLL_REGISTERS)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < HLL_REGISTERS; i++)
+	{
+		const char *found = strchr(hll_alphabet, str[i]);
+
+		if (!found || !*found)
+		{
+			return false;
+		}
+
+		this->registers[i] = found - hll_alphabet;
+	}
+
+	return true;
+}
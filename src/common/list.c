@@ -148,6 +148,25 @@ void List_pop_front(List *this)
 	this->size--;
 }
 
+/* Remove the front element without freeing it and return it to the caller */
+void *List_take_front(List *this)
+{
+	if (this->size == 0)
+	{
+		return NULL;
+	}
+
+	void *elem = this->head->elem;
+	this->head->elem = NULL;
+
+	void (*elem_free)(void *) = this->elem_free;
+	this->elem_free = NULL;
+	List_pop_front(this);
+	this->elem_free = elem_free;
+
+	return elem;
+}
+
 void List_pop_back(List *this)
 {
 	if (this->size == 0)
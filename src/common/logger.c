@@ -0,0 +1,374 @@
+#include <strings.h>
+#include <time.h>
+
+#include "include/common.h"
+#include "include/msgbuf.h"
+
+/*
+ * The ring is a bounded multi producer, single consumer queue. Each slot has
+ * a sequence number: a producer claims position pos by moving head from pos
+ * to pos + 1 if the slot of pos has sequence pos, fills the slot and sets its
+ * sequence to pos + 1. The writer reads position tail once the sequence of its
+ * slot is tail + 1 and hands the slot to the next round by setting it to
+ * tail + LOG_RING_SIZE. Producers never wait for each other or the writer.
+ */
+
+typedef struct _LogRecord
+{
+	uint64_t seq;
+	int level;
+	int line;
+	const char *file;
+	time_t time;
+	char message[LOG_RECORD_LEN];
+} LogRecord;
+
+static const char *level_strings[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+static const char *level_colors[] = {"\x1b[94m", "\x1b[36m", "\x1b[32m", "\x1b[33m", "\x1b[31m", "\x1b[35m"};
+
+static LogRecord *ring = NULL;
+static uint64_t head = 0;		  /* next position to claim */
+static uint64_t tail = 0;		  /* next position to write */
+static bool running = false;	  /* flag set while the writer thread runs */
+static unsigned long dropped = 0; /* records dropped because ring was full */
+static pthread_t writer;
+
+/* Module 0 is used for source files once all modules are taken */
+static char module_names[LOG_MAX_MODULES][32] = {"*"};
+static int module_levels[LOG_MAX_MODULES] = {LOG_TRACE};
+static int n_modules = 1;
+static int default_level = LOG_TRACE;
+static pthread_mutex_t modules_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Copy name of source file without directory and extension to name.
+ */
+static void module_name(const char *file, char *name, size_t size)
+{
+	const char *base = strrchr(file, '/');
+	base = base ? base + 1 : file;
+	size_t len = strcspn(base, ".");
+
+	if (len >= size)
+	{
+		len = size - 1;
+	}
+
+	memcpy(name, base, len);
+	name[len] = 0;
+}
+
+/**
+ * Returns id of module with name, adding it if it is new. Caller must hold
+ * modules_lock.
+ */
+static int find_module(const char *name)
+{
+	for (int i = 1; i < n_modules; i++)
+	{
+		if (!strcmp(module_names[i], name))
+		{
+			return i;
+		}
+	}
+
+	if (n_modules == LOG_MAX_MODULES)
+	{
+		return 0;
+	}
+
+	snprintf(module_names[n_modules], sizeof module_names[n_modules], "%s", name);
+	__atomic_store_n(&module_levels[n_modules], default_level, __ATOMIC_RELAXED);
+
+	return n_modules++;
+}
+
+int logger_module(const char *file)
+{
+	char name[sizeof module_names[0]];
+	module_name(file, name, sizeof name);
+
+	pthread_mutex_lock(&modules_lock);
+	int module = find_module(name);
+	pthread_mutex_unlock(&modules_lock);
+
+	return module;
+}
+
+int logger_level(int module)
+{
+	return __atomic_load_n(&module_levels[module], __ATOMIC_RELAXED);
+}
+
+void logger_set_level(int level)
+{
+	pthread_mutex_lock(&modules_lock);
+	default_level = level;
+
+	for (int i = 0; i < n_modules; i++)
+	{
+		__atomic_store_n(&module_levels[i], level, __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_unlock(&modules_lock);
+}
+
+static int parse_level(const char *str)
+{
+	for (int i = LOG_TRACE; i <= LOG_FATAL; i++)
+	{
+		if (!strcasecmp(str, level_strings[i]))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Set levels from a comma separated list of "<level>" for all modules and
+ * "<module>=<level>" for one module, which are applied from left to right.
+ */
+bool logger_set_levels(const char *levels)
+{
+	char *copy = strdup(levels);
+	char *saveptr = NULL;
+	bool valid = true;
+
+	// Check the whole list before any level is changed
+	for (int pass = 0; pass < 2 && valid; pass++)
+	{
+		strcpy(copy, levels);
+
+		for (char *tok = strtok_r(copy, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr))
+		{
+			char *eq = strchr(tok, '=');
+			int level = parse_level(eq ? eq + 1 : tok);
+
+			if (level == -1 || (eq && eq == tok))
+			{
+				valid = false;
+				break;
+			}
+
+			if (pass == 0)
+			{
+				continue;
+			}
+
+			if (!eq)
+			{
+				logger_set_level(level);
+				continue;
+			}
+
+			*eq = 0;
+			pthread_mutex_lock(&modules_lock);
+			__atomic_store_n(&module_levels[find_module(tok)], level, __ATOMIC_RELAXED);
+			pthread_mutex_unlock(&modules_lock);
+		}
+	}
+
+	free(copy);
+	return valid;
+}
+
+unsigned long logger_dropped()
+{
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+static void format_record(MsgBuf *buf, int level, const char *file, int line, time_t time, const char *message)
+{
+	struct tm tm;
+	char time_str[16];
+	localtime_r(&time, &tm);
+	strftime(time_str, sizeof time_str, "%H:%M:%S", &tm);
+
+	msgbuf_add_format(buf, "%s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m %s\n", time_str, level_colors[level],
+					  level_strings[level], file, line, message);
+}
+
+/**
+ * Returns record at tail or NULL if the ring is empty.
+ */
+static LogRecord *ring_peek()
+{
+	LogRecord *record = &ring[tail & (LOG_RING_SIZE - 1)];
+
+	if (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != tail + 1)
+	{
+		return NULL;
+	}
+
+	return record;
+}
+
+static void ring_release(LogRecord *record)
+{
+	__atomic_store_n(&record->seq, tail + LOG_RING_SIZE, __ATOMIC_RELEASE);
+	tail++;
+}
+
+/**
+ * Write records in batches until the logger is stopped and the ring is empty.
+ */
+static void *logger_writer(void *arg)
+{
+	(void)arg;
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	unsigned long reported = 0;
+
+	for (;;)
+	{
+		bool stopping = !__atomic_load_n(&running, __ATOMIC_ACQUIRE);
+		LogRecord *record;
+		size_t n_records = 0;
+
+		while ((record = ring_peek()) != NULL)
+		{
+			format_record(&buf, record->level, record->file, record->line, record->time, record->message);
+			ring_release(record);
+			n_records++;
+
+			if (buf.len >= 64 * 1024)
+			{
+				write_all(STDERR_FILENO, buf.data, buf.len);
+				msgbuf_clear(&buf);
+			}
+		}
+
+		unsigned long n_dropped = logger_dropped();
+
+		if (n_dropped != reported)
+		{
+			char *message = make_string("%lu log records dropped", n_dropped - reported);
+			format_record(&buf, LOG_WARN, __FILE__, __LINE__, time(NULL), message);
+			free(message);
+			reported = n_dropped;
+		}
+
+		if (buf.len > 0)
+		{
+			write_all(STDERR_FILENO, buf.data, buf.len);
+			msgbuf_clear(&buf);
+		}
+
+		if (stopping)
+		{
+			break;
+		}
+
+		if (n_records == 0)
+		{
+			struct timespec ts = {.tv_sec = 0, .tv_nsec = LOG_WRITER_SLEEP_MS * 1000000L};
+			nanosleep(&ts, NULL);
+		}
+	}
+
+	msgbuf_destroy(&buf);
+	return NULL;
+}
+
+bool logger_start()
+{
+	if (__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	{
+		return true;
+	}
+
+	// Records which are still in the ring are written when the process exits
+	if (!ring)
+	{
+		ring = calloc(LOG_RING_SIZE, sizeof *ring);
+		atexit(logger_stop);
+	}
+
+	for (uint64_t i = 0; i < LOG_RING_SIZE; i++)
+	{
+		ring[i].seq = i;
+	}
+
+	head = tail = 0;
+	__atomic_store_n(&running, true, __ATOMIC_RELEASE);
+
+	if (start_thread(&writer, logger_writer, NULL) != 0)
+	{
+		__atomic_store_n(&running, false, __ATOMIC_RELEASE);
+		return false;
+	}
+
+	return true;
+}
+
+void logger_stop()
+{
+	if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	{
+		return;
+	}
+
+	__atomic_store_n(&running, false, __ATOMIC_RELEASE);
+	pthread_join(writer, NULL);
+}
+
+void logger_write(int level, const char *file, int line, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+
+	if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	{
+		char message[LOG_RECORD_LEN];
+		vsnprintf(message, sizeof message, fmt, args);
+		va_end(args);
+
+		MsgBuf buf;
+		msgbuf_init(&buf);
+		format_record(&buf, level, file, line, time(NULL), message);
+		write_all(STDERR_FILENO, buf.data, buf.len);
+		msgbuf_destroy(&buf);
+		return;
+	}
+
+	// Claim a slot
+	uint64_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+	LogRecord *record;
+
+	for (;;)
+	{
+		record = &ring[pos & (LOG_RING_SIZE - 1)];
+		int64_t diff = (int64_t)(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) - pos);
+
+		if (diff == 0)
+		{
+			if (__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// Ring is full
+			__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+			va_end(args);
+			return;
+		}
+		else
+		{
+			pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+		}
+	}
+
+	record->level = level;
+	record->file = file;
+	record->line = line;
+	record->time = time(NULL);
+	vsnprintf(record->message, sizeof record->message, fmt, args);
+	va_end(args);
+
+	__atomic_store_n(&record->seq, pos + 1, __ATOMIC_RELEASE);
+}
@@ -61,6 +61,54 @@ Vector *parse_message_list(List *list)
 	return array;
 }
 
+/**
+ * Like parse_message_list() but only the head of each message is parsed
+ * (see parse_message_head()). Messages whose command needs every field are
+ * fully parsed instead.
+ */
+Vector *parse_message_list_lazy(List *list, bool (*needs_full_parse)(const char *command))
+{
+	Vector *array = Vector_alloc(4, NULL, message_free_callback);
+
+	while (List_size(list) > 0)
+	{
+		char *message = List_take_front(list);
+
+		Message *msg = calloc(1, sizeof *msg);
+		message_init(msg);
+
+		if (parse_message_head(message, msg) == -1)
+		{
+			log_warn("Invalid message");
+			message_destroy(msg);
+			free(msg);
+			continue;
+		}
+
+		if (needs_full_parse(msg->command))
+		{
+			char *copy = strdup(msg->message);
+			message_destroy(msg);
+			message_init(msg);
+
+			if (parse_message(copy, msg) == -1)
+			{
+				log_warn("Invalid message");
+				message_destroy(msg);
+				free(msg);
+				free(copy);
+				continue;
+			}
+
+			free(copy);
+		}
+
+		Vector_push(array, msg);
+	}
+
+	return array;
+}
+
 Vector *parse_all_messages(char *str)
 {
 	assert(str);
@@ -101,16 +149,12 @@ int parse_message(char *str, Message *msg)
 
 	msg->message = strdup(str);
 
-	char *ptr = strstr(str, ":");
-
-	if (ptr == str)
-	{
-		ptr = strstr(ptr + 1, ":");
-	}
+	// The body starts at the first " :", so params may contain ':'
+	char *ptr = strstr(str, " :");
 
 	if (ptr)
 	{
-		msg->body = strdup(ptr + 1);
+		msg->body = strdup(ptr + 2);
 		*ptr = 0;
 	}
 
@@ -155,3 +199,68 @@ int parse_message(char *str, Message *msg)
 
 	return 0;
 }
+
+/* Copy the next space separated word at *ptr and advance *ptr past it */
+static char *next_word(const char **ptr)
+{
+	const char *start = *ptr;
+
+	while (*start == ' ')
+	{
+		start++;
+	}
+
+	const char *end = start;
+
+	while (*end && *end != ' ')
+	{
+		end++;
+	}
+
+	*ptr = end;
+
+	return end > start ? strndup(start, end - start) : NULL;
+}
+
+/**
+ * Parse only the origin, command and first parameter of a message. The
+ * message takes ownership of str, which is left untouched in msg->message so
+ * that it can be relayed as is. The body and other params are not parsed.
+ */
+int parse_message_head(char *str, Message *msg)
+{
+	assert(str);
+
+	msg->message = str;
+	msg->lazy = true;
+
+	const char *ptr = str;
+
+	if (*ptr == ':')
+	{
+		ptr++;
+
+		if (*ptr != ' ' && *ptr != '\0')
+		{
+			msg->origin = next_word(&ptr);
+		}
+	}
+
+	if (!(msg->command = next_word(&ptr)))
+	{
+		return -1;
+	}
+
+	while (*ptr == ' ')
+	{
+		ptr++;
+	}
+
+	if (*ptr && *ptr != ':')
+	{
+		msg->params[0] = next_word(&ptr);
+		msg->n_params = 1;
+	}
+
+	return 0;
+}
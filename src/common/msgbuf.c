@@ -0,0 +1,382 @@
+#include "include/msgbuf.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSGBUF_INITIAL_CAPACITY 512
+
+void msgbuf_init(MsgBuf *this)
+{
+	memset(this, 0, sizeof *this);
+}
+
+void msgbuf_destroy(MsgBuf *this)
+{
+	free(this->data);
+	memset(this, 0, sizeof *this);
+}
+
+void msgbuf_clear(MsgBuf *this)
+{
+	msgbuf_truncate(this, 0);
+}
+
+void msgbuf_truncate(MsgBuf *this, size_t len)
+{
+	if (len < this->len)
+	{
+		this->len = len;
+		this->data[len] = 0;
+	}
+}
+
+char *msgbuf_reserve(MsgBuf *this, size_t n)
+{
+	if (this->len + n + 1 <= this->capacity)
+	{
+		return this->data + this->len;
+	}
+
+	size_t capacity = this->capacity ? this->capacity : MSGBUF_INITIAL_CAPACITY;
+
+	while (capacity < this->len + n + 1)
+	{
+		capacity *= 2;
+	}
+
+	this->data = realloc(this->data, capacity);
+	assert(this->data);
+	this->capacity = capacity;
+
+	return this->data + this->len;
+}
+
+void msgbuf_commit(MsgBuf *this, char *end)
+{
+	assert(end >= this->data + this->len && end < this->data + this->capacity);
+	this->len = end - this->data;
+	*end = 0;
+}
+
+void msgbuf_add_bytes(MsgBuf *this, const char *bytes, size_t n)
+{
+	msgbuf_reserve(this, n);
+	memcpy(this->data + this->len, bytes, n);
+	this->len += n;
+	this->data[this->len] = 0;
+}
+
+void msgbuf_add_char(MsgBuf *this, char c)
+{
+	msgbuf_reserve(this, 1);
+	this->data[this->len++] = c;
+	this->data[this->len] = 0;
+}
+
+void msgbuf_add_string(MsgBuf *this, const char *str)
+{
+	if (!str)
+	{
+		str = "(null)";
+	}
+
+	msgbuf_add_bytes(this, str, strlen(str));
+}
+
+char *msgbuf_put_bytes(char *out, const char *bytes, size_t n)
+{
+	memcpy(out, bytes, n);
+	return out + n;
+}
+
+/*
+ * Write digits of value in given base, padded to width with pad character.
+ * Padding goes to the right if left is set.
+ */
+static char *msgbuf_put_digits(char *out, unsigned long long value, bool negative, unsigned base,
+							   size_t width, char pad, bool left)
+{
+	char digits[24];
+	size_t n = 0;
+
+	do
+	{
+		digits[n++] = "0123456789abcdef"[value % base];
+		value /= base;
+	} while (value);
+
+	size_t len = n + negative;
+	size_t fill = width > len ? width - len : 0;
+
+	if (!left && pad == ' ')
+	{
+		memset(out, ' ', fill);
+		out += fill;
+	}
+
+	if (negative)
+	{
+		*out++ = '-';
+	}
+
+	if (!left && pad == '0')
+	{
+		memset(out, '0', fill);
+		out += fill;
+	}
+
+	while (n > 0)
+	{
+		*out++ = digits[--n];
+	}
+
+	if (left)
+	{
+		memset(out, ' ', fill);
+		out += fill;
+	}
+
+	return out;
+}
+
+char *msgbuf_put_long(char *out, long long value, size_t width, char pad, bool left)
+{
+	unsigned long long magnitude = value < 0 ? -(unsigned long long)value : (unsigned long long)value;
+	return msgbuf_put_digits(out, magnitude, value < 0, 10, width, pad, left);
+}
+
+char *msgbuf_put_ulong(char *out, unsigned long long value, unsigned base, size_t width, char pad, bool left)
+{
+	return msgbuf_put_digits(out, value, false, base, width, pad, left);
+}
+
+void msgbuf_add_long(MsgBuf *this, long value)
+{
+	char *out = msgbuf_reserve(this, MSGBUF_INT_MAX_LEN);
+	msgbuf_commit(this, msgbuf_put_long(out, value, 0, ' ', false));
+}
+
+void msgbuf_add_ulong(MsgBuf *this, unsigned long value)
+{
+	char *out = msgbuf_reserve(this, MSGBUF_INT_MAX_LEN);
+	msgbuf_commit(this, msgbuf_put_ulong(out, value, 10, 0, ' ', false));
+}
+
+void msgbuf_add_numeric(MsgBuf *this, int code)
+{
+	assert(code >= 0 && code < 1000);
+	char *out = msgbuf_reserve(this, 3);
+	msgbuf_commit(this, msgbuf_put_ulong(out, code, 10, 3, '0', false));
+}
+
+void msgbuf_add_crlf(MsgBuf *this)
+{
+	if (this->len < 2 || strcmp(this->data + this->len - 2, "\r\n") != 0)
+	{
+		msgbuf_add_bytes(this, "\r\n", 2);
+	}
+}
+
+/* Append the output of vsnprintf for the conversions the fast path lacks */
+static void add_vsnprintf(MsgBuf *this, const char *format, va_list args)
+{
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+
+	if (len < 0)
+	{
+		return;
+	}
+
+	char *out = msgbuf_reserve(this, len + 1);
+	vsnprintf(out, len + 1, format, args);
+	msgbuf_commit(this, out + len);
+}
+
+void msgbuf_add_vformat(MsgBuf *this, const char *format, va_list args)
+{
+	const char *ptr = format;
+
+	while (*ptr)
+	{
+		// Copy literal text up to the next conversion
+		const char *end = strchr(ptr, '%');
+
+		if (!end)
+		{
+			msgbuf_add_bytes(this, ptr, strlen(ptr));
+			return;
+		}
+
+		msgbuf_add_bytes(this, ptr, end - ptr);
+		const char *conversion = end;
+		ptr = end + 1;
+
+		bool left = false;
+		char pad = ' ';
+
+		for (; *ptr == '-' || *ptr == '0'; ptr++)
+		{
+			if (*ptr == '-')
+			{
+				left = true;
+			}
+			else
+			{
+				pad = '0';
+			}
+		}
+
+		size_t width = 0;
+
+		for (; *ptr >= '0' && *ptr <= '9'; ptr++)
+		{
+			width = width * 10 + (*ptr - '0');
+		}
+
+		int longs = 0;
+		bool size = false;
+
+		for (;; ptr++)
+		{
+			if (*ptr == 'l')
+			{
+				longs++;
+			}
+			else if (*ptr == 'z')
+			{
+				size = true;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		switch (*ptr)
+		{
+		case 's':
+		{
+			const char *str = va_arg(args, const char *);
+			size_t len = strlen(str ? str : "(null)");
+			size_t fill = width > len ? width - len : 0;
+
+			for (size_t i = 0; !left && i < fill; i++)
+			{
+				msgbuf_add_char(this, ' ');
+			}
+
+			msgbuf_add_string(this, str);
+
+			for (size_t i = 0; left && i < fill; i++)
+			{
+				msgbuf_add_char(this, ' ');
+			}
+			break;
+		}
+		case 'c':
+			msgbuf_add_char(this, (char)va_arg(args, int));
+			break;
+		case 'd':
+		case 'i':
+		{
+			long long value = size		  ? (long long)va_arg(args, ssize_t)
+							  : longs > 1 ? va_arg(args, long long)
+							  : longs	  ? va_arg(args, long)
+										  : va_arg(args, int);
+			char *out = msgbuf_reserve(this, MSGBUF_INT_MAX_LEN + width);
+			msgbuf_commit(this, msgbuf_put_long(out, value, width, pad, left));
+			break;
+		}
+		case 'u':
+		case 'x':
+		{
+			unsigned long long value = size		   ? va_arg(args, size_t)
+									   : longs > 1 ? va_arg(args, unsigned long long)
+									   : longs	   ? va_arg(args, unsigned long)
+												   : va_arg(args, unsigned);
+			char *out = msgbuf_reserve(this, MSGBUF_INT_MAX_LEN + width);
+			msgbuf_commit(this, msgbuf_put_ulong(out, value, *ptr == 'x' ? 16 : 10, width, pad, left));
+			break;
+		}
+		case '%':
+			msgbuf_add_char(this, '%');
+			break;
+		default:
+			// The arguments of the conversions before were taken, so the rest
+			// of the format can be handed over as is
+			add_vsnprintf(this, conversion, args);
+			return;
+		}
+
+		ptr++;
+	}
+}
+
+void msgbuf_add_format(MsgBuf *this, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	msgbuf_add_vformat(this, format, args);
+	va_end(args);
+}
+
+char *msgbuf_to_string(const MsgBuf *this)
+{
+	char *str = malloc(this->len + 1);
+	assert(str);
+	memcpy(str, this->data ? this->data : "", this->len + 1);
+	return str;
+}
+
+/* Buffer shared by replies built on the calling thread */
+static __thread MsgBuf reply_buf;
+
+MsgBuf *reply_begin(const char *prefix)
+{
+	msgbuf_clear(&reply_buf);
+
+	if (prefix)
+	{
+		msgbuf_add_char(&reply_buf, ':');
+		msgbuf_add_string(&reply_buf, prefix);
+		msgbuf_add_char(&reply_buf, ' ');
+	}
+
+	return &reply_buf;
+}
+
+char *reply_end(MsgBuf *buf)
+{
+	msgbuf_add_crlf(buf);
+	return msgbuf_to_string(buf);
+}
+
+char *make_prefixed_reply(const char *prefix, size_t prefix_len, const char *format, ...)
+{
+	MsgBuf *buf = reply_begin(NULL);
+	msgbuf_add_bytes(buf, prefix, prefix_len);
+
+	va_list args;
+	va_start(args, format);
+	msgbuf_add_vformat(buf, format, args);
+	va_end(args);
+
+	return msgbuf_to_string(buf);
+}
+
+char *make_reply(const char *format, ...)
+{
+	MsgBuf *buf = reply_begin(NULL);
+
+	va_list args;
+	va_start(args, format);
+	msgbuf_add_vformat(buf, format, args);
+	va_end(args);
+
+	return msgbuf_to_string(buf);
+}
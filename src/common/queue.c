@@ -62,3 +62,17 @@ void *queue_dequeue(queue_t *q)
 	pthread_mutex_unlock(&q->m);
 	return data;
 }
+
+void *queue_try_dequeue(queue_t *q)
+{
+	pthread_mutex_lock(&q->m);
+	void *data = NULL;
+	if (List_size(q->l) > 0)
+	{
+		data = List_peek_front(q->l);
+		List_pop_front(q->l);
+		pthread_cond_signal(&q->cv);
+	}
+	pthread_mutex_unlock(&q->m);
+	return data;
+}
@@ -0,0 +1,511 @@
+#include "include/simnet.h"
+
+typedef struct _SimSegment
+{
+	uint64_t deliver_at; /* virtual time at which the segment arrives */
+	size_t len;			 /* 0 for the end of the stream */
+	char data[];
+} SimSegment;
+
+typedef struct _SimEndpoint
+{
+	SimNet *net;
+	Connection *conn;			/* connection of this end */
+	SimNode *node;				/* node of this end */
+	SimNode *remote;			/* node of the other end */
+	struct _SimEndpoint *other; /* other end, NULL once it is closed */
+	List *incoming;				/* segments from the other end in order */
+	size_t offset;				/* bytes of the first segment already read */
+	uint64_t last_deliver_at;	/* arrival of the last segment sent */
+	bool ready;					/* fd is in the ready fds of the node */
+} SimEndpoint;
+
+static uint64_t SimNet_random(SimNet *net)
+{
+	// xorshift64*
+	net->rng ^= net->rng >> 12;
+	net->rng ^= net->rng << 25;
+	net->rng ^= net->rng >> 27;
+	return net->rng * 2685821657736338717ULL;
+}
+
+static uint64_t SimNet_now_ns(void *arg)
+{
+	return ((SimNet *)arg)->now_ms * 1000000;
+}
+
+static void SimNode_free(SimNode *node)
+{
+	Vector_free(node->ready);
+	free(node->name);
+	free(node);
+}
+
+/**
+ * Returns the node with given name, which is created in group 0 if it does
+ * not exist.
+ */
+static SimNode *SimNet_node(SimNet *net, const char *name)
+{
+	SimNode *node = ht_get(net->nodes, name);
+
+	if (!node)
+	{
+		node = calloc(1, sizeof *node);
+		node->name = strdup(name);
+		node->ready = Vector_alloc(4, NULL, NULL);
+		ht_set(net->nodes, node->name, node);
+	}
+
+	return node;
+}
+
+/**
+ * Add the connection with fd to the ready fds of its node, or hold it until
+ * the partition between its nodes heals. Connections which were closed are
+ * skipped.
+ */
+static void SimNet_mark_ready(SimNet *net, int fd)
+{
+	SimEndpoint *endpoint = ht_get(net->endpoints, &fd);
+
+	if (!endpoint || endpoint->ready)
+	{
+		return;
+	}
+
+	if (endpoint->node->group != endpoint->remote->group)
+	{
+		Vector_push(net->held, (void *)(intptr_t)fd);
+		return;
+	}
+
+	endpoint->ready = true;
+	Vector_push(endpoint->node->ready, (void *)(intptr_t)fd);
+}
+
+/**
+ * Add the arrival of a segment at fd to the heap of arrivals.
+ */
+static void SimNet_push_arrival(SimNet *net, uint64_t at, int fd)
+{
+	if (net->n_arrivals == net->arrivals_capacity)
+	{
+		net->arrivals_capacity =
+			net->arrivals_capacity ? net->arrivals_capacity * 2 : 64;
+		net->arrivals = realloc(net->arrivals, net->arrivals_capacity *
+												   sizeof *net->arrivals);
+	}
+
+	size_t i = net->n_arrivals++;
+
+	for (; i > 0 && net->arrivals[(i - 1) / 2].at > at; i = (i - 1) / 2)
+	{
+		net->arrivals[i] = net->arrivals[(i - 1) / 2];
+	}
+
+	net->arrivals[i] = (SimArrival){at, fd};
+}
+
+/**
+ * Remove the earliest arrival from the heap of arrivals.
+ */
+static void SimNet_pop_arrival(SimNet *net)
+{
+	SimArrival last = net->arrivals[--net->n_arrivals];
+	size_t i = 0;
+
+	while (2 * i + 1 < net->n_arrivals)
+	{
+		size_t child = 2 * i + 1;
+
+		if (child + 1 < net->n_arrivals &&
+			net->arrivals[child + 1].at < net->arrivals[child].at)
+		{
+			child++;
+		}
+
+		if (last.at <= net->arrivals[child].at)
+		{
+			break;
+		}
+
+		net->arrivals[i] = net->arrivals[child];
+		i = child;
+	}
+
+	net->arrivals[i] = last;
+}
+
+/**
+ * Queue a segment from endpoint to its other end. Each loss adds a
+ * retransmission timeout which doubles, and a segment never arrives before
+ * one sent earlier on the same stream.
+ */
+static void SimNet_send(SimEndpoint *from, const char *data, size_t len)
+{
+	SimNet *net = from->net;
+	uint64_t delay = net->latency_min_ms;
+
+	if (net->latency_max_ms > net->latency_min_ms)
+	{
+		delay += SimNet_random(net) %
+				 (net->latency_max_ms - net->latency_min_ms + 1);
+	}
+
+	bool lost = false;
+
+	for (uint64_t rto = SIMNET_RTO_MS;
+		 SimNet_random(net) < net->loss * (double)UINT64_MAX; rto *= 2)
+	{
+		delay += rto;
+		lost = true;
+	}
+
+	SimSegment *segment = malloc(sizeof *segment + len);
+	segment->deliver_at = net->now_ms + delay;
+	segment->len = len;
+	memcpy(segment->data, data, len);
+
+	if (segment->deliver_at < from->last_deliver_at)
+	{
+		segment->deliver_at = from->last_deliver_at;
+	}
+
+	from->last_deliver_at = segment->deliver_at;
+	List_push_back(from->other->incoming, segment);
+
+	if (segment->deliver_at <= net->now_ms)
+	{
+		SimNet_mark_ready(net, from->other->conn->fd);
+	}
+	else
+	{
+		SimNet_push_arrival(net, segment->deliver_at, from->other->conn->fd);
+	}
+
+	net->segments_sent++;
+	net->segments_lost += lost;
+	net->bytes_sent += len;
+}
+
+/**
+ * Returns the first segment of endpoint if it has arrived and the other end
+ * can be reached.
+ */
+static SimSegment *SimNet_arrived(SimEndpoint *endpoint)
+{
+	SimSegment *segment = List_peek_front(endpoint->incoming);
+
+	if (!segment || segment->deliver_at > endpoint->net->now_ms ||
+		endpoint->node->group != endpoint->remote->group)
+	{
+		return NULL;
+	}
+
+	return segment;
+}
+
+static ssize_t sim_read(Connection *conn, char *buf, size_t len)
+{
+	SimEndpoint *endpoint = conn->transport_data;
+	SimSegment *segment = NULL;
+	size_t nread = 0;
+
+	while (nread < len && (segment = SimNet_arrived(endpoint)) &&
+		   segment->len > 0)
+	{
+		size_t n = segment->len - endpoint->offset;
+
+		if (n > len - nread)
+		{
+			n = len - nread;
+		}
+
+		memcpy(buf + nread, segment->data + endpoint->offset, n);
+		nread += n;
+		endpoint->offset += n;
+
+		if (endpoint->offset == segment->len)
+		{
+			List_pop_front(endpoint->incoming);
+			endpoint->offset = 0;
+		}
+	}
+
+	if (nread > 0)
+	{
+		return nread;
+	}
+
+	if (segment && segment->len == 0)
+	{
+		return 0;
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+static ssize_t sim_write(Connection *conn, char *buf, size_t len)
+{
+	SimEndpoint *endpoint = conn->transport_data;
+
+	if (!endpoint->other)
+	{
+		errno = EPIPE;
+		return -1;
+	}
+
+	SimNet_send(endpoint, buf, len);
+	return len;
+}
+
+/**
+ * Send the end of the stream to the other end and free this end.
+ */
+static void sim_close(Connection *conn)
+{
+	SimEndpoint *endpoint = conn->transport_data;
+
+	if (endpoint->other)
+	{
+		SimNet_send(endpoint, NULL, 0);
+		endpoint->other->other = NULL;
+	}
+
+	ht_remove(endpoint->net->endpoints, &conn->fd, NULL, NULL);
+	List_free(endpoint->incoming);
+	free(endpoint);
+}
+
+static const Transport sim_transport = {sim_read, sim_write, sim_close};
+
+static Connection *SimNet_endpoint(SimNet *net, const char *node,
+								   const char *remote)
+{
+	SimEndpoint *endpoint = calloc(1, sizeof *endpoint);
+	endpoint->net = net;
+	endpoint->node = SimNet_node(net, node);
+	endpoint->remote = SimNet_node(net, remote);
+	endpoint->incoming = List_alloc(NULL, free);
+
+	Connection *conn = Connection_alloc_local(net->next_fd++, remote);
+	conn->transport = &sim_transport;
+	conn->transport_data = endpoint;
+	endpoint->conn = conn;
+
+	ht_set(net->endpoints, &conn->fd, endpoint);
+	return conn;
+}
+
+/**
+ * Create a network whose random choices follow from seed. Its virtual clock
+ * replaces the monotonic clock until it is freed. rand() is seeded as well,
+ * since it seeds hashtables, whose order of iteration decides the order in
+ * which servers handle connections and send messages.
+ */
+SimNet *SimNet_alloc(uint64_t seed)
+{
+	SimNet *net = calloc(1, sizeof *net);
+	net->now_ms = SIMNET_START_MS;
+	net->rng = seed ? seed : 1;
+	net->next_fd = SIMNET_FIRST_FD;
+	net->nodes = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	net->nodes->value_free = (elem_free_type)SimNode_free;
+	net->endpoints = ht_alloc_type(INT_TYPE, SHALLOW_TYPE);
+	net->listeners = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	net->listeners->value_free = (elem_free_type)List_free;
+	net->held = Vector_alloc(4, NULL, NULL);
+
+	srand(seed);
+	set_clock(SimNet_now_ns, net);
+	return net;
+}
+
+/**
+ * Free the network and the connections which were not accepted. Other
+ * connections must be freed before.
+ */
+void SimNet_free(SimNet *net)
+{
+	set_clock(NULL, NULL);
+	ht_free(net->listeners);
+	ht_free(net->endpoints);
+	ht_free(net->nodes);
+	Vector_free(net->held);
+	free(net->arrivals);
+	free(net);
+}
+
+void SimNet_set_latency(SimNet *net, unsigned min_ms, unsigned max_ms)
+{
+	assert(min_ms <= max_ms);
+	net->latency_min_ms = min_ms;
+	net->latency_max_ms = max_ms;
+}
+
+void SimNet_set_loss(SimNet *net, double loss)
+{
+	assert(loss >= 0 && loss < 1);
+	net->loss = loss;
+}
+
+/**
+ * Move node to partition group. Segments between nodes of different groups
+ * are held until the nodes are in the same group again.
+ */
+void SimNet_partition(SimNet *net, const char *node, int group)
+{
+	SimNet_node(net, node)->group = group;
+}
+
+/**
+ * Move every node back to group 0. Connections at which segments arrived
+ * across the partition are ready.
+ */
+void SimNet_heal(SimNet *net)
+{
+	HashtableIter itr;
+	ht_iter_init(&itr, net->nodes);
+	SimNode *node = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&node))
+	{
+		node->group = 0;
+	}
+
+	Vector *held = net->held;
+	net->held = Vector_alloc(4, NULL, NULL);
+
+	for (size_t i = 0; i < Vector_size(held); i++)
+	{
+		SimNet_mark_ready(net, (intptr_t)Vector_get_at(held, i));
+	}
+
+	Vector_free(held);
+}
+
+/**
+ * Move the virtual clock forward. Connections at which segments arrived in
+ * the meantime are ready.
+ */
+void SimNet_advance(SimNet *net, uint64_t ms)
+{
+	net->now_ms += ms;
+
+	while (net->n_arrivals > 0 && net->arrivals[0].at <= net->now_ms)
+	{
+		int fd = net->arrivals[0].fd;
+		SimNet_pop_arrival(net);
+		SimNet_mark_ready(net, fd);
+	}
+}
+
+/**
+ * Accept connections to node from now on.
+ */
+void SimNet_listen(SimNet *net, const char *node)
+{
+	if (!ht_contains(net->listeners, node))
+	{
+		ht_set(net->listeners, (void *)node,
+			   List_alloc(NULL, (void (*)(void *))Connection_free));
+	}
+}
+
+/**
+ * Open a connection from node to a listening node. Returns the end of from,
+ * or NULL if the node does not listen or cannot be reached. The other end is
+ * ready at once and returned by SimNet_accept().
+ */
+Connection *SimNet_connect(SimNet *net, const char *from, const char *to)
+{
+	List *pending = ht_get(net->listeners, to);
+
+	if (!pending ||
+		SimNet_node(net, from)->group != SimNet_node(net, to)->group)
+	{
+		errno = ECONNREFUSED;
+		return NULL;
+	}
+
+	Connection *conn = SimNet_endpoint(net, from, to);
+	Connection *accepted = SimNet_endpoint(net, to, from);
+
+	SimEndpoint *endpoint = conn->transport_data;
+	endpoint->other = accepted->transport_data;
+	endpoint->other->other = endpoint;
+
+	List_push_back(pending, accepted);
+	SimNet_mark_ready(net, accepted->fd);
+	return conn;
+}
+
+/**
+ * Returns the next connection to node, or NULL if there is none.
+ */
+Connection *SimNet_accept(SimNet *net, const char *node)
+{
+	List *pending = ht_get(net->listeners, node);
+
+	if (!pending || List_size(pending) == 0)
+	{
+		return NULL;
+	}
+
+	return List_take_front(pending);
+}
+
+/**
+ * Returns true if data or the end of the stream has arrived at the
+ * connection.
+ */
+bool SimNet_readable(Connection *conn)
+{
+	return SimNet_arrived(conn->transport_data) != NULL;
+}
+
+/**
+ * Returns the next connection of node at which something arrived since it
+ * was last returned, or NULL if there is none. Like an edge triggered
+ * epoll_wait, a connection is only returned again once more arrives, so it
+ * should be read until it is no longer readable.
+ */
+Connection *SimNet_next_ready(SimNet *net, const char *node)
+{
+	SimNode *sim_node = ht_get(net->nodes, node);
+
+	while (sim_node && Vector_size(sim_node->ready) > 0)
+	{
+		size_t last = Vector_size(sim_node->ready) - 1;
+		int fd = (intptr_t)Vector_get_at(sim_node->ready, last);
+		Vector_remove(sim_node->ready, last, NULL);
+
+		SimEndpoint *endpoint = ht_get(net->endpoints, &fd);
+
+		if (endpoint)
+		{
+			endpoint->ready = false;
+			return endpoint->conn;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns true if something arrived at any connection of node, and forgets
+ * which connections these were.
+ */
+bool SimNet_take_ready(SimNet *net, const char *node)
+{
+	bool ready = false;
+
+	while (SimNet_next_ready(net, node))
+	{
+		ready = true;
+	}
+
+	return ready;
+}
@@ -0,0 +1,171 @@
+#include "include/skiplist.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static SkipListNode *SkipList_node_alloc(int level, uint64_t key, void *elem)
+{
+	SkipListNode *node =
+		calloc(1, sizeof *node + level * sizeof(SkipListNode *));
+	node->key = key;
+	node->elem = elem;
+	return node;
+}
+
+SkipList *SkipList_alloc(void)
+{
+	SkipList *this = calloc(1, sizeof *this);
+	this->head = SkipList_node_alloc(SKIPLIST_MAX_LEVEL, 0, NULL);
+	this->level = 1;
+	this->seed = 0x9e3779b97f4a7c15ULL;
+	return this;
+}
+
+void SkipList_free(SkipList *this)
+{
+	if (!this)
+	{
+		return;
+	}
+
+	SkipListNode *node = this->head;
+
+	while (node)
+	{
+		SkipListNode *next = node->next[0];
+		free(node);
+		node = next;
+	}
+
+	free(this);
+}
+
+/**
+ * Each level has a quarter of the nodes of the level below, which takes fewer
+ * pointers per node than halves for about the same number of steps.
+ */
+static int SkipList_random_level(SkipList *this)
+{
+	// xorshift64
+	this->seed ^= this->seed << 13;
+	this->seed ^= this->seed >> 7;
+	this->seed ^= this->seed << 17;
+
+	uint64_t bits = this->seed;
+	int level = 1;
+
+	while (level < SKIPLIST_MAX_LEVEL && (bits & 3) == 0)
+	{
+		level++;
+		bits >>= 2;
+	}
+
+	return level;
+}
+
+/* Order of nodes: by key, then by address of the element */
+static bool SkipList_before(SkipListNode *node, uint64_t key, void *elem)
+{
+	return node->key < key ||
+		   (node->key == key && (uintptr_t)node->elem < (uintptr_t)elem);
+}
+
+/**
+ * Find the last node before key and elem on each level.
+ */
+static void SkipList_find(SkipList *this, uint64_t key, void *elem,
+						  SkipListNode **update)
+{
+	SkipListNode *node = this->head;
+
+	for (int i = this->level - 1; i >= 0; i--)
+	{
+		while (node->next[i] && SkipList_before(node->next[i], key, elem))
+		{
+			node = node->next[i];
+		}
+
+		update[i] = node;
+	}
+}
+
+void SkipList_insert(SkipList *this, uint64_t key, void *elem)
+{
+	SkipListNode *update[SKIPLIST_MAX_LEVEL];
+	SkipList_find(this, key, elem, update);
+
+	int level = SkipList_random_level(this);
+
+	for (; this->level < level; this->level++)
+	{
+		update[this->level] = this->head;
+	}
+
+	SkipListNode *node = SkipList_node_alloc(level, key, elem);
+
+	for (int i = 0; i < level; i++)
+	{
+		node->next[i] = update[i]->next[i];
+		update[i]->next[i] = node;
+	}
+
+	this->size++;
+}
+
+/**
+ * Remove elem which was inserted with key.
+ * Returns true on success, false if it was not found.
+ */
+bool SkipList_remove(SkipList *this, uint64_t key, void *elem)
+{
+	SkipListNode *update[SKIPLIST_MAX_LEVEL];
+	SkipList_find(this, key, elem, update);
+
+	SkipListNode *node = update[0]->next[0];
+
+	if (!node || node->key != key || node->elem != elem)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < this->level && update[i]->next[i] == node; i++)
+	{
+		update[i]->next[i] = node->next[i];
+	}
+
+	while (this->level > 1 && !this->head->next[this->level - 1])
+	{
+		this->level--;
+	}
+
+	free(node);
+	assert(this->size > 0);
+	this->size--;
+
+	return true;
+}
+
+SkipListNode *SkipList_seek(SkipList *this, uint64_t key)
+{
+	SkipListNode *node = this->head;
+
+	for (int i = this->level - 1; i >= 0; i--)
+	{
+		while (node->next[i] && node->next[i]->key < key)
+		{
+			node = node->next[i];
+		}
+	}
+
+	return node->next[0];
+}
+
+SkipListNode *SkipList_next(SkipListNode *node)
+{
+	return node->next[0];
+}
+
+size_t SkipList_size(SkipList *this)
+{
+	return this->size;
+}
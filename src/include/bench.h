@@ -0,0 +1,152 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include "common.h"
+#include "histogram.h"
+#include "msgbuf.h"
+
+/*
+ * Load generator which runs many users against one server, or against a
+ * topology of local servers which it starts and links itself. It can also
+ * replay the traffic of a capture made by the server.
+ */
+
+#define BENCH_MAX_CHANNELS 8		   // channels a user can be on
+#define BENCH_IN_BUF_SIZE 8192		   // bytes of partial lines kept per user
+#define BENCH_MAX_PENDING (64 * 1024) // bytes queued for a user before ops are skipped
+#define BENCH_TICK_MS 1				   // time between batches of operations
+#define BENCH_SETUP_TIMEOUT_MS 60000   // time to register users and join channels
+#define BENCH_DRAIN_MS 2000			   // max time to wait for messages in flight
+#define BENCH_CONNECT_BATCH 64		   // connections opened between polls
+#define BENCH_MAX_SERVERS 16		   // servers of a topology
+#define BENCH_START_TIMEOUT_MS 5000	   // time for a started server to listen
+#define BENCH_PROBE_INTERVAL_MS 5	   // time between probes while a link comes up
+#define BENCH_CONNECT_RETRY_MS 100	   // time between checks that a CONNECT failed
+#define BENCH_LINK_TIMEOUT_MS 30000	   // time for a link to carry a probe
+#define BENCH_PROBE_CHANNEL "#probe"   // channel of the probe users
+
+extern volatile bool g_alive; // cleared by SIGINT
+
+enum { OP_PRIVMSG, OP_JOIN, OP_PART, OP_NICK, N_OPS };
+
+typedef struct BenchUser {
+	int fd;							// socket, -1 once closed
+	int id;							// index of user
+	int server;						// index of server the user is on
+	bool probe;						// user sends and receives probes only
+	bool registered;				// RPL_WELCOME was received
+	bool renamed;					// nick is v<id> instead of u<id>
+	bool writing;					// EPOLLOUT is set
+	bool opened;					// connection of a replayed user was opened
+	int channels[BENCH_MAX_CHANNELS]; // channels the user has joined
+	int n_channels;
+	MsgBuf out;						// bytes not written yet
+	size_t out_off;					// bytes of out which were written
+	char in[BENCH_IN_BUF_SIZE + 1]; // partial line read from server
+	size_t in_len;
+	int probe_from;					// server of the last probe received
+	uint64_t probe_sent_at;			// time the last probe was sent
+	uint64_t probe_received_at;		// time the last probe was received
+} BenchUser;
+
+typedef struct BenchServer {
+	char *name;
+	char *host;
+	char *port;
+	char *dir;		  // working directory of a started server
+	char *admin_path; // admin socket of a started server
+	pid_t pid;		  // pid of a started server, 0 otherwise
+} BenchServer;
+
+typedef struct BenchLink {
+	int from; // server which sends CONNECT
+	int to;
+	bool redundant;	  // servers were already connected through others
+	bool up;		  // a probe crossed the link
+	uint64_t up_ns;	  // time from CONNECT to the first probe across the link
+	int connects;	  // CONNECT messages sent to bring the link up
+	int reconnects;	  // CONNECT messages sent after the link was killed
+} BenchLink;
+
+typedef struct Bench {
+	// options
+	size_t n_users;
+	size_t n_channels;
+	int joins_per_user;
+	double zipf_exponent;
+	double rate;
+	double duration_s;
+	unsigned weights[N_OPS];
+	size_t payload_len;
+	uint64_t seed;
+	const char *topology; // NULL to load one running server
+	double kill_at_s;	  // time into the load when a link is killed, 0 for none
+	const char *replay_path; // capture to replay instead of generating load
+	double replay_speed;	 // factor by which the replay is faster than the capture
+
+	// state
+	int epollfd;
+	BenchUser *users;	 // users followed by one probe user per server
+	size_t n_probes;
+	double *channel_cdf; // cumulative probability of choosing each channel
+	long *members;		 // members of each channel as far as the bench knows
+	char *payload;
+	uint64_t rng;
+	bool setup;			 // users are still registering and joining
+	size_t n_registered;
+	size_t n_probes_ready;
+	size_t pending_joins;
+
+	// servers
+	BenchServer servers[BENCH_MAX_SERVERS];
+	size_t n_servers;
+	char *run_dir;		 // directory of started servers
+	BenchLink *links;
+	size_t n_links;
+	int hops[BENCH_MAX_SERVERS][BENCH_MAX_SERVERS]; // -1 if not connected
+	BenchLink *killed;	 // link which was killed during the load
+	uint64_t killed_at;	 // time the link was killed
+	uint64_t recovered_ns; // time from kill to the first probe across the link
+	uint64_t next_probe_at;	 // time the next probe is sent
+	uint64_t next_check_at;	 // time to check whether a CONNECT failed
+
+	// results
+	uint64_t ops[N_OPS];
+	uint64_t skipped;
+	uint64_t expected;
+	uint64_t delivered;
+	uint64_t errors;
+	uint64_t closed;
+	Histogram latency;						// delivery latency in ns
+	Histogram hop_latency[BENCH_MAX_SERVERS]; // delivery latency by hop count
+	uint64_t replay_records;  // records in the capture
+	uint64_t replay_us;		  // time from first to last record of the capture
+	uint64_t replayed;		  // lines sent by replayed users
+	uint64_t replay_dropped;  // lines of users which were not connected
+	uint64_t replay_failed;	  // connections which could not be opened
+	Histogram replay_lag;	  // time by which lines were sent late in ns
+} Bench;
+
+/* bench.c */
+void Bench_send_line(Bench *bench, BenchUser *user, const char *format, ...)
+	__attribute__((format(printf, 3, 4)));
+void Bench_poll(Bench *bench, int timeout_ms);
+bool Bench_open_user(Bench *bench, BenchUser *user);
+void Bench_close_user(Bench *bench, BenchUser *user);
+void Bench_drain(Bench *bench);
+void Bench_report_latency(Bench *bench);
+
+/* topology.c */
+bool Bench_build_topology(Bench *bench, const char *topology);
+bool Bench_start_servers(Bench *bench);
+void Bench_stop_servers(Bench *bench);
+bool Bench_link_servers(Bench *bench);
+void Bench_handle_probe(Bench *bench, BenchUser *user, const char *body);
+void Bench_kill_link(Bench *bench);
+void Bench_check_recovery(Bench *bench);
+void Bench_report_topology(Bench *bench);
+
+/* replay.c */
+bool Bench_load_capture(Bench *bench);
+bool Bench_replay(Bench *bench);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "common.h"
+#include "connection.h"
+
+/*
+ * Capture of the lines which users send to a server, to replay the traffic of
+ * a real network against a test server.
+ *
+ * A capture file starts with CAPTURE_MAGIC, followed by one record per line:
+ * the id of its connection, the microseconds since the previous record and
+ * the length of the line, each as a varint, and then the bytes of the line. A
+ * record of length 0 marks that the connection was closed.
+ *
+ * Lines are anonymized before they are written. Commands, numbers, modes and
+ * "*" are kept. Every other parameter is replaced by a salted hash which is
+ * the same for the same name within one capture, so a nick or channel still
+ * matches its later uses, and trailing text is replaced by as many 'x'.
+ * Connections of server links are not recorded.
+ */
+
+#define CAPTURE_MAGIC "IRCCAP01"
+#define CAPTURE_MAGIC_LEN 8
+
+typedef struct _Capture
+{
+	FILE *file;
+	uint64_t salt;	  /* key of the hash which replaces names */
+	uint64_t last_us; /* time of the last record */
+	uint32_t next_id; /* id of the next connection recorded */
+	uint64_t records;
+	uint64_t bytes;
+} Capture;
+
+typedef struct _CaptureRecord
+{
+	uint32_t conn_id;
+	uint64_t at_us; /* time since the capture started */
+	size_t len;		/* length of line, 0 when the connection was closed */
+	char line[MAX_MSG_LEN + 1];
+} CaptureRecord;
+
+typedef struct _CaptureReader
+{
+	FILE *file;
+	uint64_t at_us; /* time of the last record read */
+} CaptureReader;
+
+Capture *Capture_open(const char *filename);
+void Capture_close(Capture *capture);
+void Capture_record(Capture *capture, Connection *conn, const char *line,
+					size_t len);
+void Capture_record_close(Capture *capture, Connection *conn);
+
+/**
+ * Write the anonymized form of line to out, which has space for size bytes.
+ * Returns the length written.
+ */
+size_t Capture_anonymize(uint64_t salt, const char *line, size_t len, char *out,
+						 size_t size);
+
+CaptureReader *CaptureReader_open(const char *filename);
+bool CaptureReader_next(CaptureReader *reader, CaptureRecord *record);
+void CaptureReader_close(CaptureReader *reader);
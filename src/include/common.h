@@ -7,6 +7,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -29,6 +30,7 @@
 #include "hashtable.h"
 #include "list.h"
 #include "log.h"
+#include "logger.h"
 #include "vector.h"
 
 #define MAX_EVENTS 10
@@ -71,6 +73,10 @@
 char *trimwhitespace(char *str); /* erase leading and trailing whitesapce from string and return pointer to first non whitespace character. */
 char *make_string(char *format, ...); /* allocates a string from format string and args with exact size */
 char *rstrstr(char *string, char *pattern); /* reverse strstr: returns pointer to last occurrence of pattern in string */
+uint64_t get_time_ms(); /* returns time of monotonic clock in milliseconds */
+uint64_t get_time_ns(); /* returns time of monotonic clock in nanoseconds */
+uint64_t get_realtime_ms(); /* returns wall clock time in milliseconds since the epoch */
+void set_clock(uint64_t (*now_ns)(void *), void *arg); /* replace monotonic clock, NULL to restore */
 
 Vector *readlines(const char *filename); /* Returns a vector of lines in given file */
 size_t word_len(const char *str);
@@ -87,6 +93,7 @@ char *addr_to_string(struct sockaddr *addr, socklen_t len); /* get ip address fr
 
 ssize_t read_all(int fd, char *buf, size_t len);  /* read all bytes from fd to buffer */
 ssize_t write_all(int fd, char *buf, size_t len); /* write all bytes from fd to buffer */
+int start_thread(pthread_t *thread, void *(*start)(void *), void *arg); /* start thread with all signals blocked */
 
 typedef struct peer_info_t
 {
@@ -7,12 +7,32 @@ typedef enum _conn_type_t
 	UNKNOWN_CONNECTION,
 	USER_CONNECTION,
 	PEER_CONNECTION,
-	CLIENT_CONNECTION
+	CLIENT_CONNECTION,
+	ADMIN_CONNECTION
 } conn_type_t;
 
+struct _Connection;
+struct _Capture;
+
+/**
+ * Operations on the byte stream beneath a connection. read and write return
+ * the number of bytes transferred, 0 for end of stream on read, or -1 with
+ * errno set. close releases the stream when the connection is freed.
+ */
+typedef struct _Transport
+{
+	ssize_t (*read)(struct _Connection *, char *buf, size_t len);
+	ssize_t (*write)(struct _Connection *, char *buf, size_t len);
+	void (*close)(struct _Connection *);
+} Transport;
+
+extern const Transport socket_transport; // read and write the socket fd
+
 typedef struct _Connection
 {
 	int fd;
+	const Transport *transport;	   // stream beneath the connection
+	void *transport_data;		   // state of a transport other than sockets
 	conn_type_t conn_type;
 	char *hostname;
 	int port;
@@ -25,9 +45,16 @@ typedef struct _Connection
 	List *incoming_messages;	   // queue of received messages
 	List *outgoing_messages;	   // queue of messages to deliver
 	void *data;					   // additional data for users and peers
+	uint64_t messages_received;	   // complete messages read
+	uint64_t bytes_received;	   // bytes read
+	uint64_t messages_sent;		   // complete messages written
+	uint64_t bytes_sent;		   // bytes written
+	struct _Capture *capture;	   // records lines read, NULL if not captured
+	uint32_t capture_id;		   // id of connection in capture, 0 until a line is recorded
 } Connection;
 
 Connection *Connection_alloc(int fd, struct sockaddr *addr, socklen_t addrlen);
+Connection *Connection_alloc_local(int fd, const char *name);
 Connection *Connection_create_and_connect(const char *hostname, const char *port);
 void Connection_free(Connection *);
 ssize_t Connection_read(Connection *);
@@ -51,7 +51,7 @@ void ht_print(Hashtable *this, char *(*key_to_string)(void *),
               char *(*value_to_string)(void *));
 Hashtable *ht_alloc();
 void ht_free(Hashtable *this);
-size_t ht_size(Hashtable *this);
+size_t ht_size(Hashtable *this); // 0 if this is NULL
 size_t ht_capacity(Hashtable *this);
 void ht_init(Hashtable *this);
 void ht_destroy(Hashtable *this);
@@ -62,7 +62,7 @@ bool ht_remove(Hashtable *this, const void *key, void **key_out,
 void ht_foreach(Hashtable *this, void (*callback)(void *key, void *value));
 bool ht_contains(Hashtable *this, const void *key);
 HTNode *ht_find(Hashtable *this, const void *key);
-void ht_iter_init(HashtableIter *itr, Hashtable *ht);
+void ht_iter_init(HashtableIter *itr, Hashtable *ht); // NULL is iterated as empty
 bool ht_iter_next(HashtableIter *itr, void **key_out, void **value_out);
 bool ht_remove_all_filter(Hashtable *this, filter_type filter, void *args);
 bool ht_remove_filter(Hashtable *this, filter_type filter, void *args,
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define HISTOGRAM_SUB_BITS 4  /* log2 of buckets per power of two */
+#define HISTOGRAM_MAX_BITS 40 /* values from 2^40 on share the last bucket */
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+/**
+ * Log-linear histogram like an HDR histogram: values below 2^HISTOGRAM_SUB_BITS
+ * have a bucket each, and every following power of two is split into
+ * 2^HISTOGRAM_SUB_BITS buckets of equal width, so percentiles have a relative
+ * error of at most 1 / 2^HISTOGRAM_SUB_BITS. A value is added with a bit scan
+ * and a shift. A zeroed histogram is empty.
+ */
+typedef struct Histogram
+{
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	uint64_t total; /* number of values added */
+	uint64_t sum;	/* sum of values added */
+	uint64_t max;	/* largest value added */
+} Histogram;
+
+void Histogram_add(Histogram *histogram, uint64_t value);
+uint64_t Histogram_percentile(const Histogram *histogram, double percentile);
+uint64_t Histogram_count_below(const Histogram *histogram, uint64_t value);
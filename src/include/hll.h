@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define HLL_PRECISION 8
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+/**
+ * HyperLogLog sketch to estimate the number of distinct strings in a set.
+ * Sketches of different sets can be merged to estimate the size of their
+ * union. With 256 registers the standard error is about 6.5%.
+ */
+typedef struct HyperLogLog
+{
+	uint8_t registers[HLL_REGISTERS];
+} HyperLogLog;
+
+void hll_init(HyperLogLog *this);
+void hll_add(HyperLogLog *this, const char *str);
+void hll_merge(HyperLogLog *this, const HyperLogLog *other); /* this = union of this and other */
+double hll_estimate(const HyperLogLog *this);
+
+/**
+ * Encode the registers as a string of HLL_REGISTERS printable characters.
+ * The output buffer must have space for HLL_REGISTERS + 1 bytes.
+ */
+void hll_encode(const HyperLogLog *this, char *out);
+
+/**
+ * Decode sketch from a string created by hll_encode().
+ * Returns false if the string is invalid.
+ */
+bool hll_decode(HyperLogLog *this, const char *str);
@@ -36,6 +36,7 @@ void List_destroy(List *this);
 void List_push_front(List *this, void *elem);
 void List_push_back(List *this, void *elem);
 void List_pop_front(List *this);
+void *List_take_front(List *this);
 void List_pop_back(List *this);
 void *List_peek_front(List *this);
 void *List_peek_back(List *this);
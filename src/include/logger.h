@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "log.h"
+
+/*
+ * Logging backend behind the log_trace() ... log_fatal() macros of log.h.
+ *
+ * Calls below LOG_COMPILE_LEVEL are removed at compile time; the arguments
+ * are still type checked but never evaluated. The remaining calls are
+ * filtered by the runtime level of their module, which is the name of the
+ * source file without directory and extension (e.g. "server").
+ *
+ * Until logger_start() is called records are written to stderr by the
+ * calling thread. After it, they are formatted into a lock-free ring and a
+ * writer thread writes them in batches. Records are dropped when the ring is
+ * full, so logging never blocks.
+ */
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_TRACE /* lowest level which is compiled in */
+#endif
+
+#define LOG_RING_SIZE 4096	 /* records in ring, must be a power of 2 */
+#define LOG_RECORD_LEN 600	 /* max length of a formatted message */
+#define LOG_MAX_MODULES 64	 /* modules with their own level */
+#define LOG_WRITER_SLEEP_MS 5 /* time the writer sleeps when ring is empty */
+
+bool logger_start();						/* start writer thread, which is stopped at exit */
+void logger_stop();							/* write remaining records and stop writer thread */
+bool logger_set_levels(const char *levels); /* e.g. "info,server=debug"; returns false if invalid */
+void logger_set_level(int level);			/* set level of all modules */
+int logger_module(const char *file);		/* returns id of module of source file */
+int logger_level(int module);				/* returns level of module */
+unsigned long logger_dropped();				/* records dropped because ring was full */
+
+void logger_write(int level, const char *file, int line, const char *fmt, ...)
+	__attribute__((format(printf, 4, 5)));
+
+static inline void logger_discard(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+static inline void logger_discard(const char *fmt, ...)
+{
+	(void)fmt;
+}
+
+/*
+ * The module of a call site is looked up once and kept in a static variable.
+ * Writer threads log too, so the variable is accessed atomically; threads
+ * which race on the first lookup store the same module.
+ */
+#define LOGGER_LOG(level, ...)                                              \
+	do                                                                      \
+	{                                                                       \
+		static int logger_module_ = -1;                                     \
+		int logger_module_id_ =                                             \
+			__atomic_load_n(&logger_module_, __ATOMIC_RELAXED);             \
+		if (logger_module_id_ < 0)                                          \
+		{                                                                   \
+			logger_module_id_ = logger_module(__FILE__);                    \
+			__atomic_store_n(&logger_module_, logger_module_id_,            \
+							 __ATOMIC_RELAXED);                             \
+		}                                                                   \
+		if ((level) >= logger_level(logger_module_id_))                     \
+			logger_write((level), __FILE__, __LINE__, __VA_ARGS__);         \
+	} while (0)
+
+#define LOGGER_DISCARD(...)                  \
+	do                                       \
+	{                                        \
+		if (0)                               \
+			logger_discard(__VA_ARGS__);     \
+	} while (0)
+
+#undef log_trace
+#undef log_debug
+#undef log_info
+#undef log_warn
+#undef log_error
+#undef log_fatal
+
+#if LOG_COMPILE_LEVEL <= LOG_TRACE
+#define log_trace(...) LOGGER_LOG(LOG_TRACE, __VA_ARGS__)
+#else
+#define log_trace(...) LOGGER_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_DEBUG
+#define log_debug(...) LOGGER_LOG(LOG_DEBUG, __VA_ARGS__)
+#else
+#define log_debug(...) LOGGER_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_INFO
+#define log_info(...) LOGGER_LOG(LOG_INFO, __VA_ARGS__)
+#else
+#define log_info(...) LOGGER_DISCARD(__VA_ARGS__)
+#endif
+
+#define log_warn(...) LOGGER_LOG(LOG_WARN, __VA_ARGS__)
+#define log_error(...) LOGGER_LOG(LOG_ERROR, __VA_ARGS__)
+#define log_fatal(...) LOGGER_LOG(LOG_FATAL, __VA_ARGS__)
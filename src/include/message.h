@@ -11,10 +11,13 @@ typedef struct _Message
 	char *params[MAX_MSG_PARAM];
 	char *body;
 	size_t n_params;
+	bool lazy; // Only origin, command and first param were parsed
 } Message;
 
 void message_init(Message *msg);
 void message_destroy(Message *msg);
 int parse_message(char *str, Message *msg);
+int parse_message_head(char *str, Message *msg);
 Vector *parse_all_messages(char *str);
 Vector *parse_message_list(List *list);
+Vector *parse_message_list_lazy(List *list, bool (*needs_full_parse)(const char *command));
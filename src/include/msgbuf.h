@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define MSGBUF_INT_MAX_LEN 21 /* digits and sign of a 64 bit integer */
+
+/**
+ * Growable buffer to build messages in one pass. The buffer is reused
+ * between messages, so building a message does not allocate unless the
+ * buffer has to grow. The data is always null terminated.
+ */
+typedef struct MsgBuf
+{
+	char *data;
+	size_t len;
+	size_t capacity;
+} MsgBuf;
+
+void msgbuf_init(MsgBuf *this);
+void msgbuf_destroy(MsgBuf *this);
+void msgbuf_clear(MsgBuf *this);				/* empty the buffer but keep its memory */
+void msgbuf_truncate(MsgBuf *this, size_t len); /* shorten the contents to len bytes */
+
+/**
+ * Ensure there is space for n more bytes and return a pointer to the end of
+ * the contents. Bytes written there are added by msgbuf_commit() with a
+ * pointer past the last byte written.
+ */
+char *msgbuf_reserve(MsgBuf *this, size_t n);
+void msgbuf_commit(MsgBuf *this, char *end);
+
+/* Write into reserved space and return a pointer past the written bytes */
+char *msgbuf_put_bytes(char *out, const char *bytes, size_t n);
+char *msgbuf_put_long(char *out, long long value, size_t width, char pad, bool left);
+char *msgbuf_put_ulong(char *out, unsigned long long value, unsigned base, size_t width, char pad, bool left);
+
+void msgbuf_add_char(MsgBuf *this, char c);
+void msgbuf_add_string(MsgBuf *this, const char *str); /* NULL is added as "(null)" like printf */
+void msgbuf_add_bytes(MsgBuf *this, const char *bytes, size_t n);
+void msgbuf_add_long(MsgBuf *this, long value);
+void msgbuf_add_ulong(MsgBuf *this, unsigned long value);
+void msgbuf_add_numeric(MsgBuf *this, int code); /* three digit reply code */
+void msgbuf_add_crlf(MsgBuf *this);              /* add \r\n unless present */
+
+/**
+ * Append formatted output in a single pass over the format string. The printf
+ * subset used by replies is formatted directly: %s %c %d %i %u %x %% with
+ * optional '-' and '0' flags, a width and the l, ll and z length modifiers.
+ * From the first other conversion on, the rest of the format is passed to
+ * vsnprintf, so any printf format gives the same output as snprintf.
+ */
+void msgbuf_add_format(MsgBuf *this, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+void msgbuf_add_vformat(MsgBuf *this, const char *format, va_list args);
+
+char *msgbuf_to_string(const MsgBuf *this); /* allocate a copy of the contents with exact size */
+
+/**
+ * Format a message into a buffer shared by the caller's thread and return an
+ * allocated copy. Like make_string() but the format is only parsed once.
+ */
+char *make_reply(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * Like make_reply() but starts with prefix, which is copied as is.
+ */
+char *make_prefixed_reply(const char *prefix, size_t prefix_len, const char *format, ...)
+	__attribute__((format(printf, 3, 4)));
+
+/**
+ * Start a reply in the shared buffer with ":<prefix> " (if prefix is not NULL)
+ * and finish it with reply_end(), which adds \r\n and returns a copy.
+ */
+MsgBuf *reply_begin(const char *prefix);
+char *reply_end(MsgBuf *buf);
@@ -18,3 +18,4 @@ void queue_init(queue_t *q);
 void queue_destroy(queue_t *q, void (*free_callback)(void *));
 void queue_enqueue(queue_t *q, void *data);
 void *queue_dequeue(queue_t *q);
+void *queue_try_dequeue(queue_t *q); /* returns NULL if queue is empty */
@@ -19,6 +19,7 @@
 #define RPL_SERVLIST_MSG "234 %s %s %s %s %d %d :%s"
 #define RPL_SERVLISTEND_MSG "235 %s %s %s :End of service listing"
 #define RPL_STATSUPTIME "242 %s :Server Up %u days %u:%02u:%02u"
+#define RPL_STATSDEBUG_MSG "249 %s :%s"
 #define RPL_LUSERCLIENT_MSG "251 %s :There are %ld users and %ld services on %ld servers"
 #define RPL_LUSEROP_MSG "252 %s %lu :operator(s) online"
 #define RPL_LUSERUNKNOWN_MSG "253 %s %lu :unknown connection(s)"
@@ -29,6 +30,7 @@
 #define RPL_ADMINLOC2_MSG "258 %s :%s"
 #define RPL_ADMINEMAIL_MSG "259 %s :%s"
 #define RPL_TRACEEND_MSG "262 %s %s %s-%s.%s :End of TRACE"
+#define RPL_TRYAGAIN_MSG "263 %s %s :Server load is temporarily too heavy. Please wait a while and try again."
 #define RPL_LOCALUSERS_MSG "265 %s %lu %lu :Current local users: %lu, Max: %lu"
 #define RPL_NETUSERS_MSG "266 %s %lu %lu :Current global users: %lu, Max: %lu"
 #define RPL_STATSCONN_MSG "250 %s :Highest connection count: %lu (%lu connections received)"
@@ -1,30 +1,76 @@
 #pragma once
 
+#include "capture.h"
 #include "common.h"
 #include "connection.h"
 #include "hashtable.h"
+#include "histogram.h"
+#include "hll.h"
 #include "list.h"
 #include "message.h"
+#include "msgbuf.h"
+#include "queue.h"
+#include "simnet.h"
+#include "skiplist.h"
 #include "vector.h"
 
+#include "gen/reply_formatters.h"
+
 #define MOTD_FILENAME "./data/motd.txt"
 #define MAX_CHANNEL_COUNT 8
 #define MAX_CHANNEL_USERS 8
 #define CHANNELS_FILENAME "./data/channels.txt"
+#define CHANNELS_DB_FILENAME "./data/channels.db"
+#define JOURNAL_FILENAME "./data/channels.journal"
 #define DEFAULT_INFO "development irc server"
+#define EPOLL_TIMEOUT_MS 250     // max time to block in epoll_wait
+#define QUERY_TIMEOUT_MS 5000    // deadline for network-wide queries
+#define QUERY_HOP_MARGIN_MS 250  // time reserved per hop to send results back
+#define SUMMARY_INTERVAL_MS 5000 // min time between summaries sent to peers
+#define PEER_PING_INTERVAL_MS 5000 // default time between PINGs to a peer
+#define PEER_MAX_MISSED_PINGS 3    // default PINGs missed before link is dead
+#define PEER_QUEUE_HIGH_WATERMARK 1024 // queued messages before reads pause
+#define PEER_QUEUE_LOW_WATERMARK 256   // queued messages before reads resume
+#define SIM_POLL_ROUNDS 1024 // max reads and writes of a simulated connection per poll
+#define JOURNAL_SNAPSHOT_RECORDS 10000 // journal records before a snapshot
+#define JOURNAL_SNAPSHOT_CHUNK 4096    // channels added to a snapshot per loop iteration
+#define HISTORY_BLOCK_SIZE 4096        // bytes of history kept per channel
+#define HISTORY_MAX_BYTES (8 << 20)    // bytes of history for all channels
+#define HISTORY_MAX_LIMIT 100          // max messages sent for CHATHISTORY
+#define CHANNEL_LOG_DIR "./data/logs"
+#define CHANNEL_LOG_SEGMENT_SIZE (16 << 20) // bytes of log before a new segment
+#define CHANNEL_LOG_INDEX_INTERVAL 4096     // bytes of log per index entry
+#define CHANNEL_LOG_MAX_AGE_MS (7 * 24 * 3600 * 1000ULL) // age of removed logs
+#define CHANNEL_LOG_MAX_OPEN_FILES 256      // segments kept open by the writer
+#define STATS_MAX_COMMANDS 64         // commands counted before the rest are merged
+#define STATS_OTHER_COMMAND "*"       // name used for unknown and merged commands
+#define LOAD_WINDOW_MS 1000           // time over which the busy share of the loop is measured
+#define OVERLOAD_LAG_MS 50            // smoothed loop iteration time at which the server is overloaded
+#define OVERLOAD_BUSY_PERCENT 90      // busy share of the loop at which the server is overloaded
+#define OVERLOAD_ACCEPT_BATCH 4       // connections accepted per loop iteration while overloaded
+#define OVERLOAD_WHO_MEMBERS 64       // members of a channel above which WHO is refused while overloaded
+#define STREAM_LOW_WATERMARK 32       // queued messages of a user below which a stream sends more
+#define STREAM_CHUNK 64               // channels sent by a stream at a time
+#define STREAM_MAX_WAITING 4          // streams of a user waiting for the one being sent
 
 /*
  * Add server prefix and \r\n suffix to messages
  */
 #define Server_create_message(serv, format, ...)                               \
-  make_string(":%s " format "\r\n", serv->name, __VA_ARGS__)
+  make_reply(":%s " format "\r\n", serv->name, __VA_ARGS__)
+
+/*
+ * Create numeric reply with server prefix and \r\n suffix using the typed
+ * formatter generated for the template <reply>_MSG in replies.h
+ */
+#define Server_create_reply(serv, reply, ...)                                  \
+  reply_##reply(serv->name, __VA_ARGS__)
 
 /*
  * Add user prefix and \r\n suffix to messages
  */
 #define User_create_message(usr, format, ...)                                  \
-  make_string(":%s!%s@%s " format "\r\n", usr->nick, usr->username,            \
-              usr->hostname, __VA_ARGS__)
+  make_prefixed_reply(usr->prefix, usr->prefix_len, format "\r\n", __VA_ARGS__)
 
 typedef struct _Peer {
   int fd;
@@ -34,10 +80,108 @@ typedef struct _Peer {
   bool registered;
   bool quit; // flag to indicate server leaving
   List *msg_queue;
+  time_t connected_at;    // time link was registered
+  uint64_t ping_sent_at;  // time last PING was sent
+  uint64_t last_seen_at;  // time last message was received from peer
+  long rtt_ms;            // round trip time of last PING, -1 if unknown
+  int missed_pings;       // number of PINGs sent without any reply
+  bool congested;         // msg_queue passed the high watermark
 
   enum { ACTIVE_SERVER, PASSIVE_SERVER } server_type;
 } Peer;
 
+struct _Channel;
+
+/*
+ * Ordered indexes over the channels of the server, so that LIST with
+ * conditions on the number of members or on times (ELIST) only looks at the
+ * channels in range instead of all of them.
+ */
+typedef struct _ChannelIndex {
+  SkipList *by_members; // channels keyed by number of local members
+  SkipList *by_created; // channels keyed by time_created
+  SkipList *by_topic;   // channels keyed by topic_changed_at, if known
+} ChannelIndex;
+
+typedef struct _HistoryBlock {
+  char *data;                       // HISTORY_BLOCK_SIZE bytes in the arena
+  size_t head;                      // offset of oldest entry
+  size_t tail;                      // offset to add next entry at
+  size_t n_entries;                 // number of entries in ring
+  struct _Channel *channel;         // channel using the block, NULL if free
+  struct _HistoryBlock *prev, *next; // LRU list or free list
+} HistoryBlock;
+
+typedef struct _History {
+  char *arena;              // memory of all blocks
+  HistoryBlock *blocks;     // array of blocks in arena
+  size_t n_blocks;          // number of blocks
+  HistoryBlock *free_list;  // blocks not used by a channel
+  HistoryBlock *lru_head;   // most recently used block
+  HistoryBlock *lru_tail;   // least recently used block
+  unsigned long batch_seq;  // counter used for CHATHISTORY batch ids
+} History;
+
+typedef struct _ChannelLog {
+  char *dir;         // directory with a directory for each channel
+  Hashtable *channels; // map channel name to segments of its log
+  Vector *pending;   // writes not handed to the writer yet
+  queue_t *batches;  // batches of writes for the writer thread
+  pthread_t writer;  // thread which writes the logs
+} ChannelLog;
+
+typedef struct _ChannelStoreWriter {
+  MsgBuf records;      // record of each channel added
+  MsgBuf strings;      // string table
+  uint32_t n_channels; // channels added
+} ChannelStoreWriter;
+
+typedef struct _Journal {
+  int fd;                  // journal file opened for appending
+  char *filename;          // journal file
+  char *snapshot_filename; // file the journal is compacted into
+  MsgBuf pending;          // records not handed to the writer yet
+  size_t n_records;        // records since the last snapshot
+  queue_t *batches;        // batches for the writer thread
+  pthread_t writer;        // thread which writes and syncs the journal
+  ChannelStoreWriter *snapshot;   // snapshot being built, NULL if none
+  struct _Channel *snapshot_next; // next channel added to the snapshot
+  MsgBuf snapshot_records;        // records since the snapshot was started
+} Journal;
+
+typedef struct _CommandStats {
+  uint64_t count;        // messages handled
+  uint64_t bytes;        // bytes of these messages
+  uint64_t remote_count; // messages which came from peers
+  Histogram latency;     // time to handle a message in nanoseconds
+} CommandStats;
+
+typedef struct _ConfigEntry {
+  char *name;
+  char *host;
+  char *port;
+  char *passwd;
+  Vector *autoconnect; // names of servers which connect to this server
+} ConfigEntry;
+
+#define CATALOG_MAX_SPLICES 2
+
+typedef struct _CatalogLine {
+  char *data;                          // reply without the nick
+  size_t len;                          // length of data
+  size_t splices[CATALOG_MAX_SPLICES]; // offsets in data to insert nick at
+  size_t n_splices;
+} CatalogLine;
+
+typedef struct _Catalog {
+  Vector *welcome;         // RPL_WELCOME to RPL_MYINFO
+  Vector *motd;            // RPL_MOTD for each line of motd file
+  CatalogLine *motd_start; // RPL_MOTDSTART
+  CatalogLine *no_motd;    // ERR_NOMOTD
+  Hashtable *help;         // Map subject to HELP reply lines
+  Vector *info;            // INFO reply lines
+} Catalog;
+
 typedef struct _Server {
   struct sockaddr_in servaddr; // address info for server
   int fd;                      // listen socket
@@ -51,6 +195,12 @@ typedef struct _Server {
       *config_file; // name of config file with irc server address and passwords
   char *passwd;
   char *info;
+  time_t started_at;         // time server was started
+  int peer_ping_interval_ms; // time between PINGs sent to peers
+  int peer_max_missed_pings; // PINGs missed before a peer link is closed
+  size_t peer_queue_high;    // peer queue size at which reads are paused
+  size_t peer_queue_low;     // peer queue size at which reads are resumed
+  size_t n_congested_peers;  // peers with queues above the high watermark
 
   Hashtable *connections;           // map sock to Connection struct
   Hashtable *nick_to_user_map;      // Map nick to user struct on this server
@@ -58,8 +208,55 @@ typedef struct _Server {
   Hashtable *name_to_channel_map;   // Map channel name to channel struct
   Hashtable *nick_to_serv_name_map; // Map nick to name of server which has user
 
-  Hashtable *test_list_server_map; // Map nick to ListCommand struct
+  struct _Channel *first_channel; // channels in order of creation
+  struct _Channel *last_channel;
+  Vector *streams;                 // ReplyStream structs being sent
+  ChannelIndex *channel_index;     // channels ordered for LIST filters
+
+  Hashtable *queries;       // Map request id to Query struct
+  unsigned long query_seq;  // counter used to create request ids
+
+  size_t n_unknown;        // connections which have not registered yet
+  size_t n_peers;          // registered peer links
+  size_t max_local_users;  // highest number of users on this server
+  size_t max_global_users; // highest number of users in the network
+
+  Hashtable *summaries;              // Map server name to Summary struct
+  unsigned long remote_users;        // sum of users in all summaries
+  HyperLogLog channel_sketch;        // sketch of local channel names
+  HyperLogLog remote_channel_sketch; // union of sketches in all summaries
+  bool channel_sketch_stale;         // flag to rebuild sketch of channels
+  unsigned long summary_seq;         // sequence number of last summary sent
+  char *summary;                     // last summary sent to peers
+  uint64_t summary_sent_at;          // time last summary was sent
+
+  Catalog *catalog; // replies built at startup
+
+  Hashtable *config; // Map server name to ConfigEntry struct
+  int signal_fd;     // signalfd for SIGHUP, -1 if not used
+
+  Journal *journal; // log of channel changes, NULL if not used
+  History *history; // recent messages of channels
+  ChannelLog *channel_log; // messages of channels on disk, NULL if not used
+
+  Hashtable *command_stats; // Map command to CommandStats struct
+  Histogram loop_latency;   // time to handle the events of a loop iteration
+  uint64_t loop_lag_ns;     // moving average of loop iteration time
+  uint64_t load_window_start; // time the current busy window started
+  uint64_t load_window_busy;  // time spent handling events in the window
+  unsigned loop_busy_percent; // busy share of the loop in the last window
+  bool overloaded;            // expensive commands and accepts are held back
+  unsigned long overloads;    // times the server became overloaded
+  unsigned long refused_commands; // commands answered with RPL_TRYAGAIN
+
+  int admin_fd;     // listen socket for admin connections, -1 if not used
+  char *admin_path; // path of admin socket
 
+  Capture *capture; // lines read from users, NULL if not captured
+
+  SimNet *net;            // simulated network, NULL if the server uses sockets
+  bool sim_busy;          // last simulated poll handled events
+  uint64_t sim_polled_at; // time of last simulated poll
 } Server;
 
 typedef struct _User {
@@ -68,6 +265,8 @@ typedef struct _User {
   char *nick; // display name
   char *username;
   char *realname;
+  char *prefix;      // ":nick!username@hostname " for messages from user
+  size_t prefix_len; // length of prefix
   Vector *channels;  // list of channels joined by user
   bool registered;   // flag to indicate user has registered with username,
                      // realname and nick
@@ -75,36 +274,103 @@ typedef struct _User {
   bool quit;         // flag to indicate user is leaving server
   char *quit_message;
   List *msg_queue;
+  struct _ReplyStream *stream; // bulk reply being sent, NULL if none
 } User;
 
+typedef struct _ChannelStore {
+  void *data;  // mapped channel store file
+  size_t size; // size of mapping
+  size_t refs; // channels which were loaded from the mapping
+} ChannelStore;
+
 typedef struct _Channel {
   char *name;          // name of channel
   char *topic;         // channel topic
   int mode;            // channel mode
   time_t time_created; // time channel was created
-  Hashtable *members;  // map username to User struct
+  Hashtable *members;  // map username to User struct, NULL if never joined
+  ChannelStore *store; // store which name and topic may point into
+  HistoryBlock *history; // recent messages, NULL if none
+  struct _Channel *prev; // neighbours in channel list of server
+  struct _Channel *next;
+  ChannelIndex *index; // index of server, NULL until the channel is added
 
-  // time_t topic_changed_at;
+  time_t topic_changed_at; // time topic was set, 0 if not known
   // char *topic_changed_by;
 } Channel;
 
+/*
+ * Counters gossiped by every server to the rest of the network, so that
+ * global statistics can be answered without asking other servers.
+ */
+typedef struct _Summary {
+  unsigned long seq;          // sequence number to discard old summaries
+  unsigned long users;        // number of users on server
+  unsigned long channels;     // number of channels on server
+  HyperLogLog channel_sketch; // sketch of channel names on server
+} Summary;
+
 struct help_t {
   const char *subject;
   const char *title;
   const char *body;
 };
 
-struct ListCommand {
-  Hashtable *pending; // set of server name
-  Connection *conn;
-};
+enum query_type_t { QUERY_SERVERS, QUERY_LIST, QUERY_WHO };
+
+enum stream_type_t { STREAM_LIST, STREAM_NAMES };
+
+/*
+ * Reply to LIST or NAMES for all channels, which is sent in chunks as the
+ * output of the user drains instead of all at once. The stream walks the
+ * channel list of the server, so channels created meanwhile are sent if the
+ * stream has not reached the end, and a removed channel is skipped. Replies
+ * to other commands of the user may come between the chunks. Another LIST or
+ * NAMES of the user waits until the stream before it is sent.
+ */
+typedef struct _ReplyStream {
+  int type;          // one of stream_type_t
+  User *usr;         // user the replies are sent to
+  Channel *next;     // next channel to send, NULL after the last
+  Hashtable *rows;   // LIST rows of other servers not sent yet, or NULL
+  HashtableIter row_itr; // position in rows once all channels are sent
+  bool rows_started;
+  struct _ReplyStream *after; // stream of the user waiting for this one
+} ReplyStream;
+
+/*
+ * A network-wide request which is fanned out to all peers. Every server adds
+ * its local rows, merges the rows sent back by its peers and returns the
+ * aggregate to the server it received the request from, or to the user who
+ * made the request. Results are sent at the deadline even if some peers have
+ * not answered yet.
+ */
+typedef struct _Query {
+  char *id;           // network unique request id: <server>.<seq>
+  int type;           // one of query_type_t
+  char *args;         // query arguments or NULL
+  char *reply_peer;   // name of peer to send results to, if any
+  char *reply_nick;   // nick of local user to send results to, if any
+  int reply_fd;       // fd of local user to send results to
+  Hashtable *pending; // set of peer names whose results are awaited
+  Hashtable *rows;    // Map row key to row
+  uint64_t deadline;  // monotonic time in ms to send results by
+  bool partial;       // flag to indicate some server did not respond
+} Query;
 
 Server *Server_create(const char *name);
+void Server_free(Server *serv);
 void Server_destroy(Server *serv);
 void Server_accept_all(Server *serv);
+int Server_poll(Server *serv, int timeout_ms);
+bool Server_handle_events(Server *serv, Connection *connection,
+                          uint32_t events);
+void Server_finish_poll(Server *serv);
+uint32_t Server_connection_events(Server *serv, Connection *conn);
 void Server_process_request(Server *serv, Connection *usr);
 
 void Server_flush_message_queues(Server *serv);
+void Server_check_timeouts(Server *serv);
 
 void Server_process_request_from_unknown(Server *serv, Connection *conn);
 void Server_process_request_from_user(Server *serv, Connection *conn);
@@ -117,8 +383,12 @@ void Server_message_user(Server *serv, const char *origin, const char *target,
 void Server_relay_message(Server *serv, const char *origin,
                           const char *message);
 void Server_broadcast_message(Server *serv, const char *message);
+void Server_add_history(Server *serv, Channel *channel, const char *message);
 bool Server_add_connection(Server *serv, Connection *connection);
 void Server_remove_connection(Server *serv, Connection *connection);
+void Server_remove_all_connections(Server *serv);
+void Server_update_peer_congestion(Server *serv, Peer *peer);
+void Server_queue_peer_message(Server *serv, Peer *peer, char *message);
 
 void Server_handle_NICK(Server *serv, User *usr, Message *msg);
 void Server_handle_USER(Server *serv, User *usr, Message *msg);
@@ -136,19 +406,59 @@ void Server_handle_LIST(Server *serv, User *usr, Message *msg);
 void Server_handle_NAMES(Server *serv, User *usr, Message *msg);
 void Server_handle_CONNECT(Server *serv, User *usr, Message *msg);
 void Server_handle_LUSERS(Server *serv, User *usr, Message *msg);
+void Server_handle_CHATHISTORY(Server *serv, User *usr, Message *msg);
 void Server_handle_HELP(Server *serv, User *usr, Message *msg);
+void Server_handle_STATS(Server *serv, User *usr, Message *msg);
 
 void Server_handle_TEST_LIST_SERVER(Server *serv, User *usr, Message *msg);
-void Server_handle_peer_TEST_LIST_SERVER(Server *serv, Peer *peer,
-                                         Message *msg);
+
+void send_names_reply(Server *serv, User *usr, Channel *channel);
+
+void Server_add_channel(Server *serv, Channel *channel);
+void Server_remove_channel(Server *serv, Channel *channel);
+void Server_link_channels(Server *serv);
+void Server_start_stream(Server *serv, User *usr, int type, Hashtable *rows);
+void Server_continue_stream(Server *serv, User *usr);
+void Server_stop_stream(Server *serv, User *usr);
+
+ChannelIndex *ChannelIndex_alloc(void);
+void ChannelIndex_free(ChannelIndex *index);
+void ChannelIndex_add(ChannelIndex *index, Channel *channel);
+void ChannelIndex_remove(ChannelIndex *index, Channel *channel);
+void ChannelIndex_update_members(Channel *channel, size_t old_count);
+void ChannelIndex_update_topic(Channel *channel, time_t old_time);
+Vector *Server_find_channels(Server *serv, const char *args);
+bool match_mask(const char *mask, const char *str);
+
+void Server_start_query(Server *serv, User *usr, int type, const char *args);
+long parse_list_row(const char *row, const char **topic);
+void Server_handle_peer_QUERY(Server *serv, Peer *peer, Message *msg);
+void Server_handle_peer_QREPLY(Server *serv, Peer *peer, Message *msg);
+void Server_handle_peer_QEND(Server *serv, Peer *peer, Message *msg);
+void Server_check_queries(Server *serv);
+void Server_remove_peer_from_queries(Server *serv, Peer *peer);
+void Query_free(Query *query);
+
+void Server_gossip_summary(Server *serv);
+void Server_send_summaries(Server *serv, Peer *peer);
+void Server_remove_summary(Server *serv, const char *name);
+void Server_rebuild_channel_sketch(Server *serv);
+unsigned long Server_count_global_users(Server *serv);
+unsigned long Server_estimate_global_channels(Server *serv);
+void Server_handle_peer_SUMMARY(Server *serv, Peer *peer, Message *msg);
 
 void Server_handle_SERVER(Server *serv, Peer *peer, Message *msg);
 void Server_handle_PASS(Server *serv, Peer *peer, Message *msg);
+void Server_handle_peer_PING(Server *serv, Peer *peer, Message *msg);
+void Server_handle_peer_PONG(Server *serv, Peer *peer, Message *msg);
+void Server_check_peer_heartbeats(Server *serv);
 
 bool check_user_registration(Server *serv, User *usr);
 void check_peer_registration(Server *serv, Peer *peer);
 
 User *User_alloc(int fd, const char *hostname);
+void User_update_prefix(User *usr);
+char *User_prefix_message(User *usr, const char *message);
 void User_free(User *this);
 bool User_is_member(User *usr, const char *channel_name);
 void User_add_channel(User *usr, const char *channel_name);
@@ -158,13 +468,90 @@ Peer *Peer_alloc(int type, int fd, const char *hostname);
 void Peer_free(Peer *);
 Hashtable *load_peers(const char *config_filename);
 
-Hashtable *load_channels(const char *filename);
+Hashtable *load_config(const char *filename);
+void ConfigEntry_free(ConfigEntry *entry);
+void Server_apply_config(Server *serv, Hashtable *old_config);
+bool Server_reload_config(Server *serv);
+bool Server_connect_peer(Server *serv, const char *name);
+
+Hashtable *load_channels(const char *filename, const char *journal_filename);
 void save_channels(Hashtable *hashtable, const char *filename);
+void write_channels(MsgBuf *buf, Hashtable *hashtable);
+bool save_snapshot(const char *filename, const char *data, size_t len);
+
+bool is_channel_store(const char *filename);
+bool ChannelStore_load(const char *filename, Hashtable *channels);
+bool ChannelStore_contains(ChannelStore *store, const char *str);
+void ChannelStore_release(ChannelStore *store);
+void write_channel_store(MsgBuf *buf, Hashtable *channels);
+void ChannelStoreWriter_init(ChannelStoreWriter *writer);
+void ChannelStoreWriter_add(ChannelStoreWriter *writer, Channel *channel);
+void ChannelStoreWriter_finish(ChannelStoreWriter *writer, MsgBuf *buf);
 Channel *Channel_alloc(const char *name);
 void Channel_free(Channel *this);
+void Channel_set_topic(Channel *this, const char *topic);
+void Channel_set_topic_time(Channel *this, time_t at);
 void Channel_add_member(Channel *this, User *);
 bool Channel_remove_member(Channel *this, User *);
 bool Channel_has_member(Channel *this, User *);
 
+extern const struct help_t help[];
+extern const size_t n_help;
 const struct help_t *get_help_text(const char *subject);
-char *get_motd(char *fname);
+
+Catalog *Catalog_alloc(Server *serv);
+void Catalog_free(Catalog *catalog);
+char *CatalogLine_render(const CatalogLine *line, const char *nick);
+void Catalog_send(Vector *lines, User *usr);
+void Catalog_send_motd(Catalog *catalog, User *usr);
+void Server_reload_catalog(Server *serv);
+
+Journal *Journal_open(const char *filename, const char *snapshot_filename);
+void Journal_close(Journal *journal, Hashtable *channels);
+void Journal_flush(Journal *journal);
+void Journal_snapshot(Journal *journal, Hashtable *channels);
+void Journal_start_snapshot(Journal *journal, Channel *first);
+bool Journal_continue_snapshot(Journal *journal, size_t n);
+void Journal_skip_channel(Journal *journal, Channel *channel);
+void Journal_add_channel(Journal *journal, Channel *channel);
+void Journal_set_topic(Journal *journal, Channel *channel);
+void Journal_set_mode(Journal *journal, Channel *channel);
+void Journal_remove_channel(Journal *journal, const char *name);
+size_t Journal_replay(Hashtable *channels, const char *filename);
+
+History *History_alloc(size_t max_bytes);
+void History_free(History *history);
+void History_add(History *history, Channel *channel, const char *message,
+                 uint64_t time_ms);
+void History_remove_channel(History *history, Channel *channel);
+uint64_t History_oldest(History *history, Channel *channel);
+size_t History_count(History *history, Channel *channel, uint64_t after_ms,
+                     uint64_t before_ms);
+size_t History_send(History *history, Channel *channel, List *queue,
+                    uint64_t after_ms, uint64_t before_ms, bool latest,
+                    size_t limit);
+
+ChannelLog *ChannelLog_open(const char *dir);
+void ChannelLog_close(ChannelLog *log);
+void ChannelLog_flush(ChannelLog *log);
+void ChannelLog_append(ChannelLog *log, const char *name, const char *message,
+                       uint64_t time_ms);
+size_t ChannelLog_send(ChannelLog *log, const char *name, List *queue,
+                       uint64_t after_ms, uint64_t before_ms, bool latest,
+                       size_t limit);
+
+void Server_count_command(Server *serv, const char *command, size_t bytes,
+                          uint64_t elapsed_ns, bool remote);
+void Server_send_command_stats(Server *serv, User *usr);
+void Server_send_link_stats(Server *serv, User *usr);
+void Server_update_load(Server *serv, uint64_t busy_ns);
+void Server_send_load_stats(Server *serv, User *usr);
+
+bool Server_listen_admin(Server *serv, const char *path);
+void Server_accept_admin(Server *serv);
+void Server_close_admin(Server *serv);
+void Server_process_request_from_admin(Server *serv, Connection *conn);
+
+Server *Server_create_simulated(const char *name, Hashtable *config,
+                                SimNet *net);
+void Server_poll_simulated(Server *serv);
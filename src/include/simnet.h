@@ -0,0 +1,70 @@
+#pragma once
+
+#include "common.h"
+#include "connection.h"
+
+/*
+ * In-memory network to simulate many servers and users in one process.
+ * Connections made through it have a simulated transport: bytes written to
+ * one end arrive at the other end after a random latency, a lost segment
+ * arrives after retransmission timeouts, and nothing crosses a partition
+ * until it heals. Time is a virtual clock which only moves in SimNet_advance(),
+ * and every random choice comes from the seed, so a run can be repeated
+ * exactly.
+ *
+ * Endpoints are named by nodes, such as server names. Nodes are in partition
+ * group 0 until they are moved to another group; only nodes in the same group
+ * can reach each other. Connections at which something arrived are kept per
+ * node, so a node with many idle connections need not look at them.
+ */
+
+#define SIMNET_START_MS 3600000	  /* virtual time at which a network starts */
+#define SIMNET_RTO_MS 200		  /* first retransmission timeout of a lost segment */
+#define SIMNET_FIRST_FD (1 << 20) /* fds of simulated connections count up from here */
+
+typedef struct _SimNode
+{
+	char *name;
+	int group;	   /* partition group */
+	Vector *ready; /* fds of connections at which something arrived */
+} SimNode;
+
+typedef struct _SimArrival
+{
+	uint64_t at; /* virtual time of arrival */
+	int fd;		 /* connection at which the segment arrives */
+} SimArrival;
+
+typedef struct _SimNet
+{
+	uint64_t now_ms;		 /* virtual clock */
+	uint64_t rng;			 /* state of the random number generator */
+	unsigned latency_min_ms; /* one way latency of a segment */
+	unsigned latency_max_ms;
+	double loss;			 /* probability that a segment is lost */
+	int next_fd;			 /* fd of the next connection */
+	Hashtable *nodes;		 /* Map node name to SimNode struct */
+	Hashtable *endpoints;	 /* Map fd to end of an open connection */
+	Hashtable *listeners;	 /* Map node name to List of Connections to accept */
+	SimArrival *arrivals;	 /* min-heap of segments in flight by arrival */
+	size_t n_arrivals;
+	size_t arrivals_capacity;
+	Vector *held;			 /* fds at which segments arrived across a partition */
+	uint64_t segments_sent;
+	uint64_t segments_lost; /* segments which were lost at least once */
+	uint64_t bytes_sent;
+} SimNet;
+
+SimNet *SimNet_alloc(uint64_t seed);
+void SimNet_free(SimNet *net);
+void SimNet_set_latency(SimNet *net, unsigned min_ms, unsigned max_ms);
+void SimNet_set_loss(SimNet *net, double loss);
+void SimNet_partition(SimNet *net, const char *node, int group);
+void SimNet_heal(SimNet *net);
+void SimNet_advance(SimNet *net, uint64_t ms);
+void SimNet_listen(SimNet *net, const char *node);
+Connection *SimNet_connect(SimNet *net, const char *from, const char *to);
+Connection *SimNet_accept(SimNet *net, const char *node);
+bool SimNet_readable(Connection *conn);
+Connection *SimNet_next_ready(SimNet *net, const char *node);
+bool SimNet_take_ready(SimNet *net, const char *node);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define SKIPLIST_MAX_LEVEL 24
+
+/**
+ * Skip list of elements ordered by an integer key, to find the elements with
+ * keys in a range without looking at the others. Elements with equal keys are
+ * ordered by address, so the same element may be added under different keys
+ * but a pair of key and element only once. Elements are not owned by the
+ * list.
+ */
+typedef struct SkipListNode
+{
+	uint64_t key;
+	void *elem;
+	struct SkipListNode *next[]; /* one per level of the node */
+} SkipListNode;
+
+typedef struct SkipList
+{
+	SkipListNode *head; /* node without element before the first */
+	int level;			/* levels in use */
+	size_t size;
+	uint64_t seed; /* state of the generator of node levels */
+} SkipList;
+
+SkipList *SkipList_alloc(void);
+void SkipList_free(SkipList *this);
+void SkipList_insert(SkipList *this, uint64_t key, void *elem);
+bool SkipList_remove(SkipList *this, uint64_t key, void *elem);
+
+/**
+ * Returns the first node with a key of at least key, or NULL if there is
+ * none. The following nodes are found with SkipList_next().
+ */
+SkipListNode *SkipList_seek(SkipList *this, uint64_t key);
+SkipListNode *SkipList_next(SkipListNode *node);
+size_t SkipList_size(SkipList *this);
@@ -0,0 +1,543 @@
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "include/server.h"
+
+/*
+ * Local admin socket for monitoring and operating the server. Admin
+ * connections are served by the event loop like users and peers, but speak a
+ * line based protocol of their own. Each request is a line ending with \r\n:
+ *
+ *   METRICS        counters and histograms in the Prometheus text format
+ *   DUMP           users, peers and channels of this server
+ *   SNAPSHOT       write the channels to the channel store
+ *   RELOAD         reload the config and MOTD files, like SIGHUP
+ *   DROP <server>  close the link to a peer, as if the network failed
+ *   QUIT           close the connection
+ *
+ * Replies are lines ending with \n. METRICS ends with "# EOF" and the other
+ * verbs with a line starting with "OK" or "ERR". A request of the form
+ * "GET /metrics HTTP/1.x" is answered with the metrics as an HTTP response
+ * once the request headers have been read, so the socket can be scraped with
+ * curl --unix-socket.
+ */
+
+// upper bounds of histogram buckets in ns: 2^10, 2^12, ..., 2^30
+#define ADMIN_BUCKET_MIN_BITS 10
+#define ADMIN_BUCKET_MAX_BITS 30
+
+/**
+ * Queue a reply line for admin connection. Lines longer than a message are
+ * truncated.
+ */
+static void admin_send(Connection *conn, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static void admin_send(Connection *conn, const char *format, ...) {
+	char line[MAX_MSG_LEN + 1];
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(line, sizeof line - 1, format, args);
+	va_end(args);
+
+	if (len < 0) {
+		return;
+	}
+
+	if ((size_t)len >= sizeof line - 1) {
+		len = sizeof line - 2;
+	}
+
+	line[len] = '\n';
+	line[len + 1] = 0;
+	List_push_back(conn->outgoing_messages, strdup(line));
+}
+
+/**
+ * Copy str to buf with the escapes of a Prometheus label value.
+ */
+static const char *escape_label(const char *str, char *buf, size_t size) {
+	size_t len = 0;
+
+	for (; *str && len + 2 < size; str++) {
+		if (*str == '"' || *str == '\\') {
+			buf[len++] = '\\';
+		}
+
+		buf[len++] = *str;
+	}
+
+	buf[len] = 0;
+	return buf;
+}
+
+static void send_metric_header(Connection *conn, const char *name,
+							   const char *type, const char *help) {
+	admin_send(conn, "# HELP %s %s", name, help);
+	admin_send(conn, "# TYPE %s %s", name, type);
+}
+
+/**
+ * Send histogram of values in ns as a Prometheus histogram in seconds. labels
+ * is empty or a list of labels followed by a comma.
+ */
+static void send_histogram(Connection *conn, const char *name,
+						   const char *labels, const Histogram *histogram) {
+	for (int bits = ADMIN_BUCKET_MIN_BITS; bits <= ADMIN_BUCKET_MAX_BITS;
+		 bits += 2) {
+		uint64_t bound = (uint64_t)1 << bits;
+		admin_send(conn, "%s_bucket{%sle=\"%.9g\"} %lu", name, labels,
+				   bound / 1e9,
+				   (unsigned long)Histogram_count_below(histogram, bound));
+	}
+
+	admin_send(conn, "%s_bucket{%sle=\"+Inf\"} %lu", name, labels,
+			   (unsigned long)histogram->total);
+
+	// The series without le have no trailing comma
+	char series[192] = "";
+	int len = strlen(labels);
+
+	if (len > 0) {
+		snprintf(series, sizeof series, "{%.*s}", len - 1, labels);
+	}
+
+	admin_send(conn, "%s_sum%s %.9g", name, series, histogram->sum / 1e9);
+	admin_send(conn, "%s_count%s %lu", name, series,
+			   (unsigned long)histogram->total);
+}
+
+static void send_connection_metrics(Server *serv, Connection *conn) {
+	static const char *types[] = {"unknown", "user", "peer", "client",
+								  "admin"};
+	size_t counts[sizeof types / sizeof *types] = {0};
+	size_t user_queued = 0;
+	size_t user_queue_max = 0;
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *other = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&other)) {
+		counts[other->conn_type]++;
+
+		if (other->conn_type == USER_CONNECTION) {
+			size_t size = List_size(((User *)other->data)->msg_queue);
+			user_queued += size;
+			user_queue_max = size > user_queue_max ? size : user_queue_max;
+		}
+	}
+
+	send_metric_header(conn, "irc_connections", "gauge",
+					   "Open connections by type.");
+
+	for (size_t i = 0; i < sizeof types / sizeof *types; i++) {
+		admin_send(conn, "irc_connections{type=\"%s\"} %zu", types[i],
+				   counts[i]);
+	}
+
+	send_metric_header(conn, "irc_user_queue_messages", "gauge",
+					   "Messages queued for all users.");
+	admin_send(conn, "irc_user_queue_messages %zu", user_queued);
+	send_metric_header(conn, "irc_user_queue_messages_max", "gauge",
+					   "Messages queued for the user with the longest queue.");
+	admin_send(conn, "irc_user_queue_messages_max %zu", user_queue_max);
+}
+
+static void send_peer_metrics(Server *serv, Connection *conn) {
+	// Metrics of a family are sent together, so collect the links first
+	Vector *links = Vector_alloc(8, NULL, NULL);
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *other = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&other)) {
+		if (other->conn_type == PEER_CONNECTION &&
+			((Peer *)other->data)->registered) {
+			Vector_push(links, other);
+		}
+	}
+
+	size_t n_links = Vector_size(links);
+	char (*labels)[128] = calloc(n_links + 1, sizeof *labels);
+
+	for (size_t i = 0; i < n_links; i++) {
+		Peer *peer = ((Connection *)Vector_get_at(links, i))->data;
+		escape_label(peer->name, labels[i], sizeof labels[i]);
+	}
+
+	send_metric_header(conn, "irc_peer_queue_messages", "gauge",
+					   "Messages queued for the peer.");
+
+	for (size_t i = 0; i < n_links; i++) {
+		Peer *peer = ((Connection *)Vector_get_at(links, i))->data;
+		admin_send(conn, "irc_peer_queue_messages{peer=\"%s\"} %zu", labels[i],
+				   List_size(peer->msg_queue));
+	}
+
+	send_metric_header(conn, "irc_peer_rtt_seconds", "gauge",
+					   "Round trip time of the last PING to the peer.");
+
+	for (size_t i = 0; i < n_links; i++) {
+		Peer *peer = ((Connection *)Vector_get_at(links, i))->data;
+
+		if (peer->rtt_ms >= 0) {
+			admin_send(conn, "irc_peer_rtt_seconds{peer=\"%s\"} %.3f",
+					   labels[i], peer->rtt_ms / 1e3);
+		}
+	}
+
+	send_metric_header(conn, "irc_peer_missed_pings", "gauge",
+					   "PINGs sent to the peer without a reply.");
+
+	for (size_t i = 0; i < n_links; i++) {
+		Peer *peer = ((Connection *)Vector_get_at(links, i))->data;
+		admin_send(conn, "irc_peer_missed_pings{peer=\"%s\"} %d", labels[i],
+				   peer->missed_pings);
+	}
+
+	send_metric_header(conn, "irc_peer_sent_bytes_total", "counter",
+					   "Bytes sent to the peer.");
+
+	for (size_t i = 0; i < n_links; i++) {
+		Connection *link = Vector_get_at(links, i);
+		admin_send(conn, "irc_peer_sent_bytes_total{peer=\"%s\"} %lu",
+				   labels[i], (unsigned long)link->bytes_sent);
+	}
+
+	send_metric_header(conn, "irc_peer_received_bytes_total", "counter",
+					   "Bytes received from the peer.");
+
+	for (size_t i = 0; i < n_links; i++) {
+		Connection *link = Vector_get_at(links, i);
+		admin_send(conn, "irc_peer_received_bytes_total{peer=\"%s\"} %lu",
+				   labels[i], (unsigned long)link->bytes_received);
+	}
+
+	free(labels);
+	Vector_free(links);
+}
+
+static void send_command_metrics(Server *serv, Connection *conn) {
+	static const struct {
+		const char *name, *help;
+	} counters[] = {
+		{"irc_commands_total", "Messages handled by command."},
+		{"irc_command_bytes_total", "Bytes of messages handled by command."},
+		{"irc_remote_commands_total", "Messages from peers by command."},
+	};
+
+	for (size_t i = 0; i < sizeof counters / sizeof *counters; i++) {
+		send_metric_header(conn, counters[i].name, "counter", counters[i].help);
+
+		HashtableIter itr;
+		ht_iter_init(&itr, serv->command_stats);
+		char *command = NULL;
+		CommandStats *stats = NULL;
+
+		while (ht_iter_next(&itr, (void **)&command, (void **)&stats)) {
+			uint64_t values[] = {stats->count, stats->bytes,
+								 stats->remote_count};
+			char label[128];
+			admin_send(conn, "%s{command=\"%s\"} %lu", counters[i].name,
+					   escape_label(command, label, sizeof label),
+					   (unsigned long)values[i]);
+		}
+	}
+
+	send_metric_header(conn, "irc_command_duration_seconds", "histogram",
+					   "Time to handle a message by command.");
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->command_stats);
+	char *command = NULL;
+	CommandStats *stats = NULL;
+
+	while (ht_iter_next(&itr, (void **)&command, (void **)&stats)) {
+		char label[128];
+		char labels[160];
+		snprintf(labels, sizeof labels, "command=\"%s\",",
+				 escape_label(command, label, sizeof label));
+		send_histogram(conn, "irc_command_duration_seconds", labels,
+					   &stats->latency);
+	}
+}
+
+/**
+ * Send all metrics of the server in the Prometheus text format.
+ */
+static void send_metrics(Server *serv, Connection *conn) {
+	send_metric_header(conn, "irc_uptime_seconds", "gauge",
+					   "Time since the server was started.");
+	admin_send(conn, "irc_uptime_seconds %ld",
+			   (long)(time(NULL) - serv->started_at));
+	send_metric_header(conn, "irc_users", "gauge", "Users on this server.");
+	admin_send(conn, "irc_users %zu", ht_size(serv->nick_to_user_map));
+	send_metric_header(conn, "irc_channels", "gauge",
+					   "Channels on this server.");
+	admin_send(conn, "irc_channels %zu", ht_size(serv->name_to_channel_map));
+	send_metric_header(conn, "irc_log_records_dropped_total", "counter",
+					   "Log records dropped because the log ring was full.");
+	admin_send(conn, "irc_log_records_dropped_total %lu", logger_dropped());
+
+	send_connection_metrics(serv, conn);
+	send_peer_metrics(serv, conn);
+
+	send_metric_header(conn, "irc_loop_duration_seconds", "histogram",
+					   "Time to handle the events of one event loop iteration.");
+	send_histogram(conn, "irc_loop_duration_seconds", "", &serv->loop_latency);
+	send_metric_header(conn, "irc_loop_lag_seconds", "gauge",
+					   "Moving average of event loop iteration time.");
+	admin_send(conn, "irc_loop_lag_seconds %.6f", serv->loop_lag_ns / 1e9);
+	send_metric_header(conn, "irc_loop_busy_ratio", "gauge",
+					   "Share of time the event loop was handling events.");
+	admin_send(conn, "irc_loop_busy_ratio %.2f", serv->loop_busy_percent / 100.0);
+	send_metric_header(conn, "irc_overloaded", "gauge",
+					   "1 while expensive commands and accepts are held back.");
+	admin_send(conn, "irc_overloaded %d", serv->overloaded);
+	send_metric_header(conn, "irc_overloads_total", "counter",
+					   "Times the server became overloaded.");
+	admin_send(conn, "irc_overloads_total %lu", serv->overloads);
+	send_metric_header(conn, "irc_commands_refused_total", "counter",
+					   "Commands answered with RPL_TRYAGAIN while overloaded.");
+	admin_send(conn, "irc_commands_refused_total %lu", serv->refused_commands);
+
+	send_command_metrics(serv, conn);
+}
+
+/**
+ * Send the users, peers and channels of this server.
+ */
+static void send_dump(Server *serv, Connection *conn) {
+	admin_send(conn, "server %s port %s uptime %ld users %zu peers %zu "
+					 "channels %zu congested %zu",
+			   serv->name, serv->port, (long)(time(NULL) - serv->started_at),
+			   ht_size(serv->nick_to_user_map), serv->n_peers,
+			   ht_size(serv->name_to_channel_map), serv->n_congested_peers);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *other = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&other)) {
+		if (other->conn_type == USER_CONNECTION) {
+			User *usr = other->data;
+			admin_send(conn, "user %s fd %d host %s queue %zu channels %zu",
+					   usr->nick, other->fd, other->hostname,
+					   List_size(usr->msg_queue), Vector_size(usr->channels));
+		} else if (other->conn_type == PEER_CONNECTION) {
+			Peer *peer = other->data;
+			admin_send(conn,
+					   "peer %s fd %d host %s registered %d queue %zu rtt %ld "
+					   "missed %d congested %d",
+					   peer->name ? peer->name : "*", other->fd,
+					   other->hostname, peer->registered,
+					   List_size(peer->msg_queue), peer->rtt_ms,
+					   peer->missed_pings, peer->congested);
+		}
+	}
+
+	ht_iter_init(&itr, serv->name_to_channel_map);
+	Channel *channel = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&channel)) {
+		admin_send(conn, "channel %s members %zu history %zu", channel->name,
+				   channel->members ? ht_size(channel->members) : 0,
+				   channel->history ? channel->history->n_entries : 0);
+	}
+
+	admin_send(conn, "OK");
+}
+
+/**
+ * Close the link to the peer with name without sending SQUIT, so both ends
+ * handle it like a link which died.
+ */
+static void drop_peer(Server *serv, Connection *conn, const char *name) {
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *other = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&other)) {
+		Peer *peer = other->data;
+
+		if (other->conn_type == PEER_CONNECTION && peer->name &&
+			!strcmp(peer->name, name)) {
+			log_warn("dropping link to %s", name);
+			Server_remove_connection(serv, other);
+			admin_send(conn, "OK dropped %s", name);
+			return;
+		}
+	}
+
+	admin_send(conn, "ERR no link to %s", name);
+}
+
+static void handle_admin_request(Server *serv, Connection *conn,
+								 const char *request) {
+	if (!strcasecmp(request, "METRICS")) {
+		send_metrics(serv, conn);
+		admin_send(conn, "# EOF");
+	} else if (!strcasecmp(request, "DUMP")) {
+		send_dump(serv, conn);
+	} else if (!strcasecmp(request, "SNAPSHOT")) {
+		if (serv->journal) {
+			Journal_snapshot(serv->journal, serv->name_to_channel_map);
+		} else {
+			save_channels(serv->name_to_channel_map, CHANNELS_DB_FILENAME);
+		}
+
+		admin_send(conn, "OK wrote %zu channels",
+				   ht_size(serv->name_to_channel_map));
+	} else if (!strcasecmp(request, "RELOAD")) {
+		if (Server_reload_config(serv)) {
+			admin_send(conn, "OK reloaded %s", serv->config_file);
+		} else {
+			admin_send(conn, "ERR failed to reload %s", serv->config_file);
+		}
+	} else if (!strncasecmp(request, "DROP ", 5)) {
+		drop_peer(serv, conn, request + 5);
+	} else if (!strcasecmp(request, "QUIT")) {
+		conn->quit = true;
+	} else {
+		admin_send(conn, "ERR unknown request");
+	}
+}
+
+/**
+ * Answer an HTTP request once its headers have been read. conn->data holds
+ * the requested path.
+ */
+static void handle_http_request(Server *serv, Connection *conn) {
+	const char *path = conn->data;
+
+	if (!strcmp(path, "/metrics")) {
+		List_push_back(conn->outgoing_messages,
+					   strdup("HTTP/1.0 200 OK\r\n"
+							  "Content-Type: text/plain; version=0.0.4\r\n"
+							  "Connection: close\r\n\r\n"));
+		send_metrics(serv, conn);
+	} else {
+		List_push_back(conn->outgoing_messages,
+					   strdup("HTTP/1.0 404 Not Found\r\n"
+							  "Connection: close\r\n\r\n"));
+	}
+
+	conn->quit = true;
+}
+
+void Server_process_request_from_admin(Server *serv, Connection *conn) {
+	assert(conn->conn_type == ADMIN_CONNECTION);
+
+	while (List_size(conn->incoming_messages) > 0 && !conn->quit) {
+		char *request = List_peek_front(conn->incoming_messages);
+
+		if (conn->data) {
+			// Headers of an HTTP request end with an empty line
+			if (*request == 0) {
+				handle_http_request(serv, conn);
+			}
+		} else if (!strncmp(request, "GET ", 4)) {
+			char *path = request + 4;
+			conn->data = strndup(path, strcspn(path, " "));
+		} else if (*request) {
+			handle_admin_request(serv, conn, request);
+		}
+
+		List_pop_front(conn->incoming_messages);
+	}
+}
+
+/**
+ * Listen for admin connections on Unix socket at path, replacing any socket
+ * which was left behind. Returns false on error.
+ */
+bool Server_listen_admin(Server *serv, const char *path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+
+	if (strlen(path) >= sizeof addr.sun_path) {
+		log_error("admin socket path %s is too long", path);
+		return false;
+	}
+
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (fd == -1) {
+		log_error("socket(): %s", strerror(errno));
+		return false;
+	}
+
+	unlink(path);
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof addr) == -1 ||
+		listen(fd, MAX_EVENTS) == -1) {
+		log_error("failed to listen on admin socket %s: %s", path,
+				  strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+
+	if (epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		log_error("epoll_ctl(): %s", strerror(errno));
+		close(fd);
+		unlink(path);
+		return false;
+	}
+
+	serv->admin_fd = fd;
+	serv->admin_path = strdup(path);
+	log_info("admin socket is listening at %s", path);
+
+	return true;
+}
+
+/**
+ * Accept pending admin connections. They are read from even while reads are
+ * paused for congested peers.
+ */
+void Server_accept_admin(Server *serv) {
+	int fd;
+
+	while ((fd = accept4(serv->admin_fd, NULL, NULL,
+						 SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+		Connection *conn = Connection_alloc_local(fd, "admin");
+		conn->conn_type = ADMIN_CONNECTION;
+		ht_set(serv->connections, &conn->fd, conn);
+
+		struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.fd = fd};
+
+		if (epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+			log_error("epoll_ctl(): %s", strerror(errno));
+			Server_remove_connection(serv, conn);
+			continue;
+		}
+
+		log_debug("Got admin connection %d", fd);
+	}
+
+	if (errno != EAGAIN && errno != EWOULDBLOCK) {
+		log_error("accept(): %s", strerror(errno));
+	}
+}
+
+/**
+ * Stop listening for admin connections and remove the socket file.
+ */
+void Server_close_admin(Server *serv) {
+	if (serv->admin_fd == -1) {
+		return;
+	}
+
+	close(serv->admin_fd);
+	unlink(serv->admin_path);
+	free(serv->admin_path);
+	serv->admin_fd = -1;
+	serv->admin_path = NULL;
+}
@@ -0,0 +1,224 @@
+#include "include/server.h"
+
+/*
+ * Replies which are the same for every user except for the nick are built
+ * once when the catalog is loaded. Each line is stored without the nick and
+ * with the offsets at which the nick is inserted, so sending a reply is a
+ * malloc and a few memcpy calls and does not touch the filesystem.
+ */
+
+#define NICK_MARK "\x1a"  // placeholder for the nick while building lines
+
+static void CatalogLine_free(CatalogLine *line) {
+	free(line->data);
+	free(line);
+}
+
+/**
+ * Create catalog line from a reply which has NICK_MARK in place of the nick.
+ * Takes ownership of reply.
+ */
+static CatalogLine *CatalogLine_alloc(char *reply) {
+	CatalogLine *line = calloc(1, sizeof *line);
+	char *mark = NULL;
+	char *end = reply;
+
+	while ((mark = strstr(end, NICK_MARK)) != NULL) {
+		assert(line->n_splices < CATALOG_MAX_SPLICES);
+		memmove(mark, mark + 1, strlen(mark + 1) + 1);
+		line->splices[line->n_splices++] = mark - reply;
+		end = mark;
+	}
+
+	line->data = reply;
+	line->len = strlen(reply);
+
+	return line;
+}
+
+static Vector *lines_alloc() {
+	return Vector_alloc(4, NULL, (elem_free_type)CatalogLine_free);
+}
+
+/**
+ * Add each line of the MOTD file as a RPL_MOTD line.
+ */
+static void load_motd(Server *serv, Catalog *catalog) {
+	FILE *file = serv->motd_file ? fopen(serv->motd_file, "r") : NULL;
+
+	if (!file) {
+		log_warn("failed to open %s", serv->motd_file);
+		return;
+	}
+
+	char *line = NULL;
+	size_t line_cap = 0;
+	ssize_t len;
+
+	while ((len = getline(&line, &line_cap, file)) != -1) {
+		if (len > 0 && line[len - 1] == '\n') {
+			line[len - 1] = 0;
+		}
+
+		Vector_push(catalog->motd,
+					CatalogLine_alloc(Server_create_reply(serv, RPL_MOTD,
+														  NICK_MARK, line)));
+	}
+
+	free(line);
+	fclose(file);
+}
+
+/**
+ * Add the HELP reply for entry under given subject.
+ */
+static void load_help(Server *serv, Catalog *catalog, const char *subject,
+					  const struct help_t *help) {
+	Vector *lines = lines_alloc();
+
+	Vector_push(lines, CatalogLine_alloc(Server_create_message(
+						   serv, "704 %s %s :%s", NICK_MARK, subject,
+						   help->title)));
+	Vector_push(lines, CatalogLine_alloc(Server_create_message(
+						   serv, "705 %s %s :", NICK_MARK, subject)));
+
+	// Break long lines into multiple messages
+	Vector *text = text_wrap(help->body, 200);
+
+	for (size_t i = 0; i < Vector_size(text); i++) {
+		Vector_push(lines, CatalogLine_alloc(Server_create_message(
+							   serv, "705 %s %s :%s", NICK_MARK, subject,
+							   (char *)Vector_get_at(text, i))));
+	}
+
+	Vector_free(text);
+
+	Vector_push(lines, CatalogLine_alloc(Server_create_message(
+						   serv, "706 %s %s :End of help", NICK_MARK,
+						   subject)));
+
+	ht_set(catalog->help, (char *)subject, lines);
+}
+
+/**
+ * Build all catalog replies for the current server configuration.
+ */
+Catalog *Catalog_alloc(Server *serv) {
+	Catalog *catalog = calloc(1, sizeof *catalog);
+
+	catalog->welcome = lines_alloc();
+	Vector_push(catalog->welcome,
+				CatalogLine_alloc(Server_create_reply(serv, RPL_WELCOME,
+													  NICK_MARK, NICK_MARK)));
+	Vector_push(catalog->welcome,
+				CatalogLine_alloc(Server_create_reply(
+					serv, RPL_YOURHOST, NICK_MARK, serv->hostname)));
+	Vector_push(catalog->welcome,
+				CatalogLine_alloc(Server_create_reply(
+					serv, RPL_CREATED, NICK_MARK, serv->created_at)));
+	Vector_push(catalog->welcome,
+				CatalogLine_alloc(Server_create_reply(
+					serv, RPL_MYINFO, NICK_MARK, serv->hostname, "*", "*")));
+
+	catalog->motd = lines_alloc();
+	load_motd(serv, catalog);
+	catalog->motd_start = CatalogLine_alloc(
+		Server_create_message(serv, "375 %s :- %s Message of the day - ",
+							  NICK_MARK, serv->name));
+	catalog->no_motd =
+		CatalogLine_alloc(Server_create_reply(serv, ERR_NOMOTD, NICK_MARK));
+
+	catalog->help = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	catalog->help->value_free = (elem_free_type)Vector_free;
+
+	for (size_t i = 0; i < n_help; i++) {
+		load_help(serv, catalog, help[i].subject, help + i);
+	}
+
+	// HELP without a subject
+	load_help(serv, catalog, "*", get_help_text("HELP"));
+
+	catalog->info = lines_alloc();
+	Vector_push(catalog->info,
+				CatalogLine_alloc(Server_create_message(
+					serv, "371 %s :%s", NICK_MARK, serv->info)));
+	Vector_push(catalog->info,
+				CatalogLine_alloc(Server_create_message(
+					serv, "374 %s :End of INFO list", NICK_MARK)));
+
+	return catalog;
+}
+
+void Catalog_free(Catalog *catalog) {
+	if (!catalog) {
+		return;
+	}
+
+	Vector_free(catalog->welcome);
+	Vector_free(catalog->motd);
+	CatalogLine_free(catalog->motd_start);
+	CatalogLine_free(catalog->no_motd);
+	ht_free(catalog->help);
+	Vector_free(catalog->info);
+	free(catalog);
+}
+
+/**
+ * Rebuild the catalog, e.g. after the MOTD file or server info has changed.
+ */
+void Server_reload_catalog(Server *serv) {
+	Catalog_free(serv->catalog);
+	serv->catalog = Catalog_alloc(serv);
+}
+
+/**
+ * Allocate a copy of line with nick inserted at each splice offset.
+ */
+char *CatalogLine_render(const CatalogLine *line, const char *nick) {
+	size_t nick_len = strlen(nick);
+	char *out = malloc(line->len + line->n_splices * nick_len + 1);
+	char *p = out;
+	size_t start = 0;
+
+	for (size_t i = 0; i < line->n_splices; i++) {
+		size_t end = line->splices[i];
+		memcpy(p, line->data + start, end - start);
+		p += end - start;
+		memcpy(p, nick, nick_len);
+		p += nick_len;
+		start = end;
+	}
+
+	memcpy(p, line->data + start, line->len - start + 1);
+
+	return out;
+}
+
+void Catalog_send(Vector *lines, User *usr) {
+	for (size_t i = 0; i < Vector_size(lines); i++) {
+		List_push_back(usr->msg_queue,
+					   CatalogLine_render(Vector_get_at(lines, i), usr->nick));
+	}
+}
+
+/**
+ * Send the message of the day for today, which is the line (day of year %
+ * number of lines) of the MOTD file.
+ */
+void Catalog_send_motd(Catalog *catalog, User *usr) {
+	size_t n = Vector_size(catalog->motd);
+
+	if (n == 0) {
+		List_push_back(usr->msg_queue,
+					   CatalogLine_render(catalog->no_motd, usr->nick));
+		return;
+	}
+
+	time_t t = time(NULL);
+	struct tm tm;
+	localtime_r(&t, &tm);
+
+	List_push_back(usr->msg_queue,
+				   CatalogLine_render(Vector_get_at(catalog->motd, tm.tm_yday % n),
+									  usr->nick));
+}
@@ -1,3 +1,5 @@
+#include <fcntl.h>
+#include <libgen.h>
 #include <time.h>
 
 #include "include/server.h"
@@ -21,17 +23,51 @@ Channel *Channel_alloc(const char *name)
 void Channel_free(Channel *this)
 {
 	ht_free(this->members);
-	free(this->topic);
-	free(this->name);
+
+	// Strings borrowed from a channel store are freed with the store
+	if (!ChannelStore_contains(this->store, this->topic))
+	{
+		free(this->topic);
+	}
+
+	if (!ChannelStore_contains(this->store, this->name))
+	{
+		free(this->name);
+	}
+
+	ChannelStore_release(this->store);
 	free(this);
 }
 
+/**
+ * Replace topic of channel with a copy of topic, or clear it if topic is NULL.
+ */
+void Channel_set_topic(Channel *this, const char *topic)
+{
+	if (!ChannelStore_contains(this->store, this->topic))
+	{
+		free(this->topic);
+	}
+
+	this->topic = topic ? strdup(topic) : NULL;
+}
+
+/**
+ * Record when the topic of channel was set.
+ */
+void Channel_set_topic_time(Channel *this, time_t at)
+{
+	time_t old_time = this->topic_changed_at;
+	this->topic_changed_at = at;
+	ChannelIndex_update_topic(this, old_time);
+}
+
 /**
  * Check if given user is part of channel.
  */
 bool Channel_has_member(Channel *this, User *user)
 {
-	return ht_contains(this->members, user->username);
+	return this->members && ht_contains(this->members, user->username);
 }
 
 /**
@@ -39,7 +75,14 @@ bool Channel_has_member(Channel *this, User *user)
  */
 void Channel_add_member(Channel *this, User *user)
 {
+	if (!this->members)
+	{
+		this->members = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	}
+
+	size_t count = ht_size(this->members);
 	ht_set(this->members, user->username, user);
+	ChannelIndex_update_members(this, count);
 }
 
 /**
@@ -48,84 +91,118 @@ void Channel_add_member(Channel *this, User *user)
  */
 bool Channel_remove_member(Channel *this, User *user)
 {
-	return ht_remove(this->members, user->username, NULL, NULL);
+	if (!this->members || !ht_remove(this->members, user->username, NULL, NULL))
+	{
+		return false;
+	}
+
+	ChannelIndex_update_members(this, ht_size(this->members) + 1);
+	return true;
 }
 
 /**
- * Loads channels from file into hashtable which maps channel name as string to Channel*.
+ * Loads channels from the snapshot file into hashtable which maps channel name
+ * as string to Channel*, then replays the journal written since the snapshot.
+ * The snapshot is either a channel store or a text file with a channel on
+ * each line. The journal is skipped if journal_filename is NULL.
+ *
+ * The keys of the hashtable are the names of the channels, so channels must be
+ * added with their own name as key.
  */
-Hashtable *load_channels(const char *filename)
+Hashtable *load_channels(const char *filename, const char *journal_filename)
 {
 	Hashtable *hashtable = ht_alloc();
+	hashtable->key_copy = NULL;
+	hashtable->key_free = NULL;
 	hashtable->value_copy = NULL;
 	hashtable->value_free = (elem_free_type)Channel_free;
 
+	if (is_channel_store(filename) && ChannelStore_load(filename, hashtable))
+	{
+		if (journal_filename)
+		{
+			Journal_replay(hashtable, journal_filename);
+		}
+
+		return hashtable;
+	}
+
 	FILE *file = fopen(filename, "r");
 
 	if (!file)
 	{
 		log_error("Failed to open file %s", filename);
-		return hashtable;
 	}
 
 	char *line = NULL;
 	size_t len = 0;
 	ssize_t nread = 0;
 
-	while ((nread = getline(&line, &len, file)) > 0)
+	while (file && (nread = getline(&line, &len, file)) > 0)
 	{
 		if (line[nread - 1] == '\n')
 		{
 			line[nread - 1] = 0;
 		}
 
-		char *saveptr = NULL;
-		char *saveptr1 = NULL;
+		// The topic is the rest of the line and may contain ':'
+		char *topic = strstr(line, " :");
+
+		if (topic)
+		{
+			*topic = 0;
+			topic += 2;
+		}
 
-		char *info = strtok_r(line, ":", &saveptr);
-		char *topic = strtok_r(NULL, ":", &saveptr);
+		char *saveptr = NULL;
+		char *name = strtok_r(line, " ", &saveptr);
+		char *time_created = strtok_r(NULL, " ", &saveptr);
+		char *mode = strtok_r(NULL, " ", &saveptr);
 
-		char *name = strtok_r(info, " ", &saveptr1);
-		time_t time_created = atol(strtok_r(NULL, " ", &saveptr1));
-		int mode = atoi(strtok_r(NULL, " ", &saveptr1));
+		if (!name || !time_created || !mode)
+		{
+			log_warn("Skipped bad line in file %s", filename);
+			continue;
+		}
 
 		Channel *this = Channel_alloc(name);
-		this->mode = mode;
-		this->time_created = time_created;
+		this->mode = atoi(mode);
+		this->time_created = atol(time_created);
 		this->topic = topic ? strdup(topic) : NULL;
 
-		if (!this->topic)
-		{
-			log_info("Added channel %s without topic", this->name);
-		}
-		else
+		Channel *old_channel = NULL;
+
+		if (ht_remove(hashtable, name, NULL, (void **)&old_channel))
 		{
-			log_info("Added channel %s with topic %s", this->name, this->topic);
+			Channel_free(old_channel);
 		}
 
-		ht_set(hashtable, name, this);
+		ht_set(hashtable, this->name, this);
 	}
 
 	free(line);
-	fclose(file);
+
+	if (file)
+	{
+		fclose(file);
+	}
 
 	log_info("Loaded %zu channels from file %s", ht_size(hashtable),
 			 filename);
+
+	if (journal_filename)
+	{
+		Journal_replay(hashtable, journal_filename);
+	}
+
 	return hashtable;
 }
 
 /**
- * Write channels to give file with each line containing the (name, time_created, mode, user_limit, topic) of the channel.
+ * Add channels as text to buf with each line containing the (name, time_created, mode, topic) of the channel.
  */
-void save_channels(Hashtable *hashtable, const char *filename)
+void write_channels(MsgBuf *buf, Hashtable *hashtable)
 {
-	FILE *file = fopen(filename, "w");
-	if (!file)
-	{
-		log_error("Failed to open file %s", filename);
-		return;
-	}
-
 	HashtableIter itr;
 	ht_iter_init(&itr, hashtable);
 
@@ -133,17 +210,75 @@ void save_channels(Hashtable *hashtable, const char *filename)
 
 	while (ht_iter_next(&itr, NULL, (void **)&channel))
 	{
-		fprintf(file, "%s %ld %d", channel->name,
-				(long)channel->time_created, channel->mode);
+		msgbuf_add_format(buf, "%s %ld %d", channel->name,
+						  (long)channel->time_created, channel->mode);
 
 		if (channel->topic)
 		{
-			fprintf(file, " :%s", channel->topic);
+			msgbuf_add_format(buf, " :%s", channel->topic);
 		}
 
-		fprintf(file, "\n");
+		msgbuf_add_char(buf, '\n');
+	}
+}
+
+/**
+ * Replace the contents of file with data. The data is written to a temporary
+ * file which is synced and renamed over the file, so the file always has
+ * either the old or the new contents.
+ */
+bool save_snapshot(const char *filename, const char *data, size_t len)
+{
+	char *tmp_filename = make_string("%s.tmp", filename);
+	int fd = open(tmp_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if (fd == -1)
+	{
+		log_error("Failed to open file %s", tmp_filename);
+		free(tmp_filename);
+		return false;
+	}
+
+	bool ok = write_all(fd, (char *)data, len) == (ssize_t)len && fdatasync(fd) == 0;
+	close(fd);
+
+	if (!ok || rename(tmp_filename, filename) == -1)
+	{
+		log_error("Failed to write file %s", filename);
+		unlink(tmp_filename);
+		free(tmp_filename);
+		return false;
+	}
+
+	free(tmp_filename);
+
+	// Sync the directory so the rename is durable
+	char *dir = strdup(filename);
+	int dir_fd = open(dirname(dir), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (dir_fd != -1)
+	{
+		fsync(dir_fd);
+		close(dir_fd);
+	}
+
+	free(dir);
+	return true;
+}
+
+/**
+ * Write channel store with given channels to file.
+ */
+void save_channels(Hashtable *hashtable, const char *filename)
+{
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	write_channel_store(&buf, hashtable);
+
+	if (save_snapshot(filename, buf.data ? buf.data : "", buf.len))
+	{
+		log_info("Saved %zu channels to file %s", ht_size(hashtable), filename);
 	}
 
-	fclose(file);
-	log_info("Saved %zu channels to file %s", ht_size(hashtable), filename);
+	msgbuf_destroy(&buf);
 }
@@ -0,0 +1,838 @@
+#include <dirent.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "include/queue.h"
+#include "include/server.h"
+
+/*
+ * Messages of channels are also appended to a log on disk, so history can be
+ * queried for longer than it is kept in memory. The log of a channel is a
+ * directory of segments which are named by the time of their first message:
+ *
+ *   <channel>/<time>.log   LogRecord | message | padding to 8 bytes
+ *   <channel>/<time>.idx   LogIndexEntry of the first record and of the next
+ *                          record after every CHANNEL_LOG_INDEX_INTERVAL bytes
+ *
+ * A query finds the segment by a binary search over the segment times and the
+ * record by a binary search over the mapped index, so it reads at most one
+ * interval of the log before the first message it sends.
+ *
+ * The event loop decides where each record goes and adds it to the pending
+ * write of its segment. Pending writes are handed to the writer thread once
+ * per loop iteration, so the loop never waits for the disk. The log is not
+ * synced; messages which were not written when the server crashed are lost,
+ * and a torn record or index entry they leave is cut off before appending.
+ * Times of records never decrease within a channel, even if the clock does.
+ *
+ * A new segment is started after CHANNEL_LOG_SEGMENT_SIZE bytes. Segments
+ * whose messages are all older than CHANNEL_LOG_MAX_AGE_MS are removed at
+ * that point.
+ */
+
+typedef struct _LogRecord {
+	uint32_t len; // length of message
+	uint32_t reserved;
+	uint64_t time_ms; // time message was added
+} LogRecord;
+
+typedef struct _LogIndexEntry {
+	uint64_t time_ms; // time of record
+	uint64_t offset;  // offset of record in log
+} LogIndexEntry;
+
+typedef struct _ChannelLogWrite {
+	enum { LOG_APPEND, LOG_REMOVE, LOG_STOP } type;
+	char *dir;						// directory of channel
+	uint64_t segment;				// segment to append to or remove
+	MsgBuf data;					// records to append to log
+	MsgBuf index;					// entries to append to index
+	struct _ChannelLogState *state; // owner, only used by the event loop
+} ChannelLogWrite;
+
+/*
+ * Segments of a channel as seen by the event loop, which includes writes the
+ * writer has not done yet.
+ */
+typedef struct _ChannelLogState {
+	char *dir;				  // directory of channel
+	uint64_t *segments;		  // time of each segment, oldest first
+	size_t n_segments;		  // number of segments
+	size_t capacity;		  // capacity of segments
+	uint64_t size;			  // bytes in last segment
+	uint64_t last_indexed;	  // offset of last indexed record in last segment
+	uint64_t last_time;		  // time of last record
+	ChannelLogWrite *pending; // write to last segment in this loop iteration
+} ChannelLogState;
+
+/*
+ * Mapped files of a segment.
+ */
+typedef struct _LogSegment {
+	char *data;			  // log
+	size_t size;		  // size of log
+	LogIndexEntry *index; // index
+	size_t n_index;		  // number of index entries
+	size_t index_size;	  // size of index file
+} LogSegment;
+
+/*
+ * Segment file which the writer has open.
+ */
+typedef struct _LogFile {
+	uint64_t segment;
+	int log_fd;
+	int index_fd;
+} LogFile;
+
+static size_t record_size(size_t len) {
+	return (sizeof(LogRecord) + len + 7) & ~(size_t)7;
+}
+
+static char *segment_path(const char *dir, uint64_t segment, const char *ext) {
+	return make_string("%s/%020" PRIu64 ".%s", dir, segment, ext);
+}
+
+/**
+ * Directory of channel in dir. Characters other than letters, digits, '-'
+ * and '_' are escaped as %XX, so every channel name is a valid file name.
+ */
+static char *channel_dir(const char *dir, const char *name) {
+	static const char hex[] = "0123456789ABCDEF";
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	msgbuf_add_format(&buf, "%s/", dir);
+
+	for (const char *s = name; *s; s++) {
+		if (isalnum((unsigned char)*s) || *s == '-' || *s == '_') {
+			msgbuf_add_char(&buf, *s);
+		} else {
+			unsigned char c = *s;
+			msgbuf_add_char(&buf, '%');
+			msgbuf_add_char(&buf, hex[c >> 4]);
+			msgbuf_add_char(&buf, hex[c & 15]);
+		}
+	}
+
+	char *path = msgbuf_to_string(&buf);
+	msgbuf_destroy(&buf);
+
+	return path;
+}
+
+static ChannelLogWrite *ChannelLogWrite_alloc(int type, const char *dir,
+											  uint64_t segment) {
+	ChannelLogWrite *write = calloc(1, sizeof *write);
+	write->type = type;
+	write->dir = dir ? strdup(dir) : NULL;
+	write->segment = segment;
+	msgbuf_init(&write->data);
+	msgbuf_init(&write->index);
+
+	return write;
+}
+
+static void ChannelLogWrite_free(ChannelLogWrite *write) {
+	if (write) {
+		free(write->dir);
+		msgbuf_destroy(&write->data);
+		msgbuf_destroy(&write->index);
+		free(write);
+	}
+}
+
+static void ChannelLogState_free(ChannelLogState *state) {
+	free(state->dir);
+	free(state->segments);
+	free(state);
+}
+
+static void LogFile_close(LogFile *file) {
+	close(file->log_fd);
+	close(file->index_fd);
+	free(file);
+}
+
+static void *map_file(const char *path, size_t *size) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	struct stat st;
+	void *data = NULL;
+	*size = 0;
+
+	if (fd == -1) {
+		return NULL;
+	}
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+		if (data == MAP_FAILED) {
+			log_error("Failed to map file %s", path);
+			data = NULL;
+		} else {
+			*size = st.st_size;
+		}
+	}
+
+	close(fd);
+	return data;
+}
+
+/**
+ * Map log and index of segment i. Missing files, e.g. of a segment the
+ * writer has not created yet, are mapped as empty.
+ */
+static void LogSegment_map(ChannelLogState *state, size_t i, LogSegment *seg) {
+	char *log_path = segment_path(state->dir, state->segments[i], "log");
+	char *index_path = segment_path(state->dir, state->segments[i], "idx");
+
+	seg->data = map_file(log_path, &seg->size);
+	seg->index = map_file(index_path, &seg->index_size);
+	seg->n_index = seg->index_size / sizeof(LogIndexEntry);
+
+	free(log_path);
+	free(index_path);
+}
+
+static void LogSegment_unmap(LogSegment *seg) {
+	if (seg->data) {
+		munmap(seg->data, seg->size);
+	}
+
+	if (seg->index) {
+		munmap(seg->index, seg->index_size);
+	}
+}
+
+/**
+ * Returns record at offset or NULL if there is no complete record.
+ */
+static const LogRecord *LogSegment_record(const LogSegment *seg,
+										  uint64_t offset) {
+	if (offset + sizeof(LogRecord) > seg->size) {
+		return NULL;
+	}
+
+	const LogRecord *record = (const LogRecord *)(seg->data + offset);
+
+	if (offset + record_size(record->len) > seg->size) {
+		return NULL;
+	}
+
+	return record;
+}
+
+/**
+ * Returns number of index entries with a time before time_ms.
+ */
+static size_t LogSegment_search(const LogSegment *seg, uint64_t time_ms) {
+	size_t lo = 0;
+	size_t hi = seg->n_index;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (seg->index[mid].time_ms < time_ms) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/**
+ * Returns number of segments of channel which start before time_ms.
+ */
+static size_t ChannelLogState_search(const ChannelLogState *state,
+									 uint64_t time_ms) {
+	size_t lo = 0;
+	size_t hi = state->n_segments;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (state->segments[mid] < time_ms) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static int compare_segments(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void ChannelLogState_push(ChannelLogState *state, uint64_t segment) {
+	if (state->n_segments == state->capacity) {
+		state->capacity = state->capacity ? state->capacity * 2 : 4;
+		state->segments = realloc(state->segments,
+								  state->capacity * sizeof *state->segments);
+	}
+
+	state->segments[state->n_segments++] = segment;
+}
+
+/**
+ * Cut the last segment of channel back to size bytes of log and n_index
+ * entries of index. A crash can leave a torn record or index entry at the end
+ * of the files, and records appended after it would be misplaced. If no index
+ * entry is left, one for the first record, which is at first_time, is added.
+ */
+static void LogSegment_repair(ChannelLogState *state, uint64_t size,
+							  size_t n_index, uint64_t first_time) {
+	uint64_t segment = state->segments[state->n_segments - 1];
+	char *log_path = segment_path(state->dir, segment, "log");
+	char *index_path = segment_path(state->dir, segment, "idx");
+
+	log_info("Repairing log segment %s", log_path);
+
+	if (truncate(log_path, size) == -1 ||
+		(truncate(index_path, n_index * sizeof(LogIndexEntry)) == -1 &&
+		 errno != ENOENT)) {
+		log_error("failed to truncate segment %s", log_path);
+	}
+
+	if (n_index == 0 && size > 0) {
+		LogIndexEntry entry = {.time_ms = first_time, .offset = 0};
+		int fd = open(index_path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+		if (fd == -1 ||
+			write_all(fd, (char *)&entry, sizeof entry) != sizeof entry) {
+			log_error("failed to write index of segment %s", log_path);
+		}
+
+		if (fd != -1) {
+			close(fd);
+		}
+	}
+
+	free(log_path);
+	free(index_path);
+}
+
+/**
+ * Read segments of channel from its directory.
+ */
+static void ChannelLogState_load(ChannelLogState *state) {
+	DIR *dir = opendir(state->dir);
+
+	if (!dir) {
+		return;
+	}
+
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != NULL) {
+		char *end = NULL;
+		uint64_t segment = strtoull(entry->d_name, &end, 10);
+
+		if (end != entry->d_name && !strcmp(end, ".log")) {
+			ChannelLogState_push(state, segment);
+		}
+	}
+
+	closedir(dir);
+
+	if (state->n_segments == 0) {
+		return;
+	}
+
+	qsort(state->segments, state->n_segments, sizeof *state->segments,
+		  compare_segments);
+
+	// Continue the last segment where it ends
+	LogSegment seg;
+	LogSegment_map(state, state->n_segments - 1, &seg);
+
+	// Entries of records which were not completely written are dropped
+	size_t n_index = seg.n_index;
+
+	while (n_index > 0 &&
+		   !LogSegment_record(&seg, seg.index[n_index - 1].offset)) {
+		n_index--;
+	}
+
+	uint64_t offset = 0;
+	state->last_time = state->segments[state->n_segments - 1];
+
+	if (n_index > 0) {
+		offset = seg.index[n_index - 1].offset;
+		state->last_indexed = offset;
+	}
+
+	const LogRecord *record;
+	uint64_t first_time = 0;
+
+	while ((record = LogSegment_record(&seg, offset)) != NULL) {
+		if (offset == 0) {
+			first_time = record->time_ms;
+		}
+
+		state->last_time = record->time_ms;
+		offset += record_size(record->len);
+	}
+
+	state->size = offset;
+
+	if (offset != seg.size || n_index * sizeof(LogIndexEntry) != seg.index_size ||
+		(n_index == 0 && offset > 0)) {
+		LogSegment_repair(state, offset, n_index, first_time);
+	}
+
+	LogSegment_unmap(&seg);
+}
+
+static ChannelLogState *ChannelLog_get_state(ChannelLog *log,
+											 const char *name) {
+	ChannelLogState *state = ht_get(log->channels, name);
+
+	if (!state) {
+		state = calloc(1, sizeof *state);
+		state->dir = channel_dir(log->dir, name);
+		ChannelLogState_load(state);
+		ht_set(log->channels, (char *)name, state);
+	}
+
+	return state;
+}
+
+/**
+ * Start a new segment of channel at time_ms and remove segments which only
+ * have messages older than CHANNEL_LOG_MAX_AGE_MS.
+ */
+static void ChannelLog_start_segment(ChannelLog *log, ChannelLogState *state,
+									 uint64_t time_ms) {
+	// Segment names must be unique and in order
+	if (state->n_segments > 0 &&
+		time_ms <= state->segments[state->n_segments - 1]) {
+		time_ms = state->segments[state->n_segments - 1] + 1;
+	}
+
+	ChannelLogState_push(state, time_ms);
+
+	size_t n_expired = 0;
+
+	while (n_expired + 1 < state->n_segments &&
+		   state->segments[n_expired + 1] + CHANNEL_LOG_MAX_AGE_MS < time_ms) {
+		Vector_push(log->pending,
+					ChannelLogWrite_alloc(LOG_REMOVE, state->dir,
+										  state->segments[n_expired]));
+		n_expired++;
+	}
+
+	state->n_segments -= n_expired;
+	memmove(state->segments, state->segments + n_expired,
+			state->n_segments * sizeof *state->segments);
+
+	state->size = 0;
+	state->last_indexed = 0;
+	state->pending = NULL;
+}
+
+/**
+ * Add message sent to channel at time_ms to the log of the channel. The
+ * \r\n of the message is not stored.
+ */
+void ChannelLog_append(ChannelLog *log, const char *name, const char *message,
+					   uint64_t time_ms) {
+	if (!log) {
+		return;
+	}
+
+	size_t len = strlen(message);
+
+	if (len >= 2 && !strcmp(message + len - 2, "\r\n")) {
+		len -= 2;
+	}
+
+	size_t size = record_size(len);
+	ChannelLogState *state = ChannelLog_get_state(log, name);
+
+	if (time_ms < state->last_time) {
+		time_ms = state->last_time;
+	}
+
+	state->last_time = time_ms;
+
+	if (state->n_segments == 0 ||
+		(state->size > 0 && state->size + size > CHANNEL_LOG_SEGMENT_SIZE)) {
+		ChannelLog_start_segment(log, state, time_ms);
+	}
+
+	if (!state->pending) {
+		state->pending = ChannelLogWrite_alloc(
+			LOG_APPEND, state->dir, state->segments[state->n_segments - 1]);
+		state->pending->state = state;
+		Vector_push(log->pending, state->pending);
+	}
+
+	if (state->size == 0 ||
+		state->size - state->last_indexed >= CHANNEL_LOG_INDEX_INTERVAL) {
+		LogIndexEntry entry = {.time_ms = time_ms, .offset = state->size};
+		msgbuf_add_bytes(&state->pending->index, (char *)&entry, sizeof entry);
+		state->last_indexed = state->size;
+	}
+
+	LogRecord record = {.len = len, .reserved = 0, .time_ms = time_ms};
+	char padding[8] = {0};
+	msgbuf_add_bytes(&state->pending->data, (char *)&record, sizeof record);
+	msgbuf_add_bytes(&state->pending->data, message, len);
+	msgbuf_add_bytes(&state->pending->data, padding,
+					 size - sizeof record - len);
+
+	state->size += size;
+}
+
+/**
+ * Hand writes added since the last call to the writer.
+ */
+void ChannelLog_flush(ChannelLog *log) {
+	if (!log || Vector_size(log->pending) == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < Vector_size(log->pending); i++) {
+		ChannelLogWrite *write = Vector_get_at(log->pending, i);
+
+		if (write->state) {
+			write->state->pending = NULL;
+			write->state = NULL;
+		}
+	}
+
+	queue_enqueue(log->batches, log->pending);
+	log->pending = Vector_alloc(16, NULL, (elem_free_type)ChannelLogWrite_free);
+}
+
+/**
+ * Returns open files of segment, closing the previous segment of the channel.
+ */
+static LogFile *open_segment(Hashtable *files, ChannelLogWrite *write) {
+	LogFile *file = ht_get(files, write->dir);
+
+	if (file && file->segment == write->segment) {
+		return file;
+	}
+
+	ht_remove(files, write->dir, NULL, NULL);
+
+	if (ht_size(files) >= CHANNEL_LOG_MAX_OPEN_FILES) {
+		HashtableIter itr;
+		char *dir = NULL;
+
+		// Close an arbitrary segment
+		ht_iter_init(&itr, files);
+
+		if (ht_iter_next(&itr, (void **)&dir, NULL)) {
+			ht_remove(files, dir, NULL, NULL);
+		}
+	}
+
+	if (mkdir(write->dir, 0755) == -1 && errno != EEXIST) {
+		log_error("failed to create directory %s", write->dir);
+		return NULL;
+	}
+
+	char *log_path = segment_path(write->dir, write->segment, "log");
+	char *index_path = segment_path(write->dir, write->segment, "idx");
+	int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+
+	file = calloc(1, sizeof *file);
+	file->segment = write->segment;
+	file->log_fd = open(log_path, flags, 0644);
+	file->index_fd = open(index_path, flags, 0644);
+
+	if (file->log_fd == -1 || file->index_fd == -1) {
+		log_error("failed to open segment %s", log_path);
+		LogFile_close(file);
+		file = NULL;
+	} else {
+		ht_set(files, write->dir, file);
+	}
+
+	free(log_path);
+	free(index_path);
+
+	return file;
+}
+
+static void remove_segment(Hashtable *files, ChannelLogWrite *write) {
+	LogFile *file = ht_get(files, write->dir);
+
+	if (file && file->segment == write->segment) {
+		ht_remove(files, write->dir, NULL, NULL);
+	}
+
+	char *log_path = segment_path(write->dir, write->segment, "log");
+	char *index_path = segment_path(write->dir, write->segment, "idx");
+	unlink(log_path);
+	unlink(index_path);
+	free(log_path);
+	free(index_path);
+}
+
+/**
+ * Do writes as they are queued. The log is written before the index, so an
+ * index entry never points past the end of the log.
+ */
+static void *ChannelLog_writer(void *arg) {
+	ChannelLog *log = arg;
+	Hashtable *files = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	files->value_free = (elem_free_type)LogFile_close;
+	bool running = true;
+
+	while (running) {
+		Vector *batch = queue_dequeue(log->batches);
+
+		for (size_t i = 0; i < Vector_size(batch); i++) {
+			ChannelLogWrite *write = Vector_get_at(batch, i);
+			LogFile *file = NULL;
+
+			switch (write->type) {
+			case LOG_APPEND:
+				if ((file = open_segment(files, write)) == NULL) {
+					break;
+				}
+
+				if (write_all(file->log_fd, write->data.data,
+							  write->data.len) != (ssize_t)write->data.len ||
+					write_all(file->index_fd, write->index.data,
+							  write->index.len) != (ssize_t)write->index.len) {
+					log_error("failed to write log of %s", write->dir);
+				}
+				break;
+			case LOG_REMOVE:
+				remove_segment(files, write);
+				break;
+			case LOG_STOP:
+				running = false;
+				break;
+			}
+		}
+
+		Vector_free(batch);
+	}
+
+	ht_free(files);
+	return NULL;
+}
+
+/**
+ * Open channel logs in directory dir and start the writer thread. Returns NULL
+ * if the directory cannot be used, in which case messages are not logged.
+ */
+ChannelLog *ChannelLog_open(const char *dir) {
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+		log_error("failed to create directory %s", dir);
+		return NULL;
+	}
+
+	ChannelLog *log = calloc(1, sizeof *log);
+	log->dir = strdup(dir);
+	log->channels = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	log->channels->value_free = (elem_free_type)ChannelLogState_free;
+	log->pending = Vector_alloc(16, NULL, (elem_free_type)ChannelLogWrite_free);
+	log->batches = queue_alloc();
+
+	if (start_thread(&log->writer, ChannelLog_writer, log) != 0) {
+		log_error("failed to start channel log writer");
+		queue_free(log->batches, NULL);
+		Vector_free(log->pending);
+		ht_free(log->channels);
+		free(log->dir);
+		free(log);
+		return NULL;
+	}
+
+	return log;
+}
+
+/**
+ * Write pending messages, stop the writer and free the log.
+ */
+void ChannelLog_close(ChannelLog *log) {
+	if (!log) {
+		return;
+	}
+
+	Vector_push(log->pending, ChannelLogWrite_alloc(LOG_STOP, NULL, 0));
+	ChannelLog_flush(log);
+	pthread_join(log->writer, NULL);
+
+	queue_free(log->batches, (void (*)(void *))Vector_free);
+	Vector_free(log->pending);
+	ht_free(log->channels);
+	free(log->dir);
+	free(log);
+}
+
+static void send_record(List *queue, const LogRecord *record) {
+	char *line = malloc(record->len + 3);
+	memcpy(line, record + 1, record->len);
+	memcpy(line + record->len, "\r\n", 3);
+	List_push_back(queue, line);
+}
+
+/**
+ * Send messages between after_ms and before_ms starting at offset of segment
+ * i, skipping the first skip of them. Returns number of messages sent.
+ */
+static size_t ChannelLog_send_from(ChannelLogState *state, size_t i,
+								   uint64_t offset, List *queue,
+								   uint64_t after_ms, uint64_t before_ms,
+								   size_t skip, size_t limit) {
+	size_t n_sent = 0;
+
+	for (; i < state->n_segments && n_sent < limit; i++, offset = 0) {
+		LogSegment seg;
+		LogSegment_map(state, i, &seg);
+		const LogRecord *record;
+		bool done = false;
+
+		while (n_sent < limit &&
+			   (record = LogSegment_record(&seg, offset)) != NULL) {
+			offset += record_size(record->len);
+
+			if (record->time_ms >= before_ms) {
+				done = true;
+				break;
+			}
+
+			if (record->time_ms <= after_ms) {
+				continue;
+			}
+
+			if (skip > 0) {
+				skip--;
+			} else {
+				send_record(queue, record);
+				n_sent++;
+			}
+		}
+
+		LogSegment_unmap(&seg);
+
+		if (done) {
+			break;
+		}
+	}
+
+	return n_sent;
+}
+
+/**
+ * Count messages between after_ms and before_ms in chunk k of segment, which
+ * is the part of the log from index entry k to the next one.
+ */
+static size_t LogSegment_count(const LogSegment *seg, size_t k,
+							   uint64_t after_ms, uint64_t before_ms) {
+	uint64_t offset = seg->n_index > 0 ? seg->index[k].offset : 0;
+	uint64_t end = k + 1 < seg->n_index ? seg->index[k + 1].offset : seg->size;
+	const LogRecord *record;
+	size_t count = 0;
+
+	while (offset < end && (record = LogSegment_record(seg, offset)) != NULL) {
+		count += record->time_ms > after_ms && record->time_ms < before_ms;
+		offset += record_size(record->len);
+	}
+
+	return count;
+}
+
+/**
+ * Add up to limit logged messages of channel to queue as lines, like
+ * History_send. The newest messages are found by counting the messages in
+ * chunks of the log backwards from before_ms until there are enough of them.
+ * Returns number of messages added.
+ */
+size_t ChannelLog_send(ChannelLog *log, const char *name, List *queue,
+					   uint64_t after_ms, uint64_t before_ms, bool latest,
+					   size_t limit) {
+	if (!log || limit == 0) {
+		return 0;
+	}
+
+	ChannelLogState *state = ChannelLog_get_state(log, name);
+
+	if (!latest) {
+		// Start at the last indexed record which is not after after_ms
+		size_t i = ChannelLogState_search(state, after_ms + 1);
+		i = i > 0 ? i - 1 : 0;
+
+		if (i >= state->n_segments) {
+			return 0;
+		}
+
+		LogSegment seg;
+		LogSegment_map(state, i, &seg);
+		size_t k = LogSegment_search(&seg, after_ms + 1);
+		uint64_t offset = k > 0 ? seg.index[k - 1].offset : 0;
+		LogSegment_unmap(&seg);
+
+		return ChannelLog_send_from(state, i, offset, queue, after_ms,
+									before_ms, 0, limit);
+	}
+
+	size_t i = ChannelLogState_search(state, before_ms);
+
+	if (i == 0) {
+		return 0;
+	}
+
+	// Walk back from the chunk which has the last message before before_ms
+	size_t count = 0;
+	uint64_t offset = 0;
+	bool found = false;
+	bool last = true;
+
+	while (i-- > 0) {
+		LogSegment seg;
+		LogSegment_map(state, i, &seg);
+
+		size_t k = seg.n_index > 0 ? seg.n_index - 1 : 0;
+
+		if (last) {
+			size_t n = LogSegment_search(&seg, before_ms);
+			k = n > 0 ? n - 1 : 0;
+			last = false;
+		}
+
+		for (;; k--) {
+			count += LogSegment_count(&seg, k, after_ms, before_ms);
+			offset = seg.n_index > 0 ? seg.index[k].offset : 0;
+
+			if (count >= limit ||
+				(seg.n_index > 0 && seg.index[k].time_ms <= after_ms)) {
+				found = true;
+				break;
+			}
+
+			if (k == 0) {
+				break;
+			}
+		}
+
+		LogSegment_unmap(&seg);
+
+		if (found) {
+			break;
+		}
+	}
+
+	if (!found) {
+		i = 0;
+		offset = 0;
+	}
+
+	return ChannelLog_send_from(state, i, offset, queue, after_ms, before_ms,
+								count > limit ? count - limit : 0, limit);
+}
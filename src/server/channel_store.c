@@ -0,0 +1,248 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "include/server.h"
+
+/*
+ * Binary snapshot of channels which is loaded by mapping the file instead of
+ * parsing it. The file has a fixed header, an array of fixed size records and
+ * a table of null terminated strings:
+ *
+ *   ChannelStoreHeader
+ *   ChannelRecord[n_channels]
+ *   strings
+ *
+ * Names and topics of loaded channels point into the mapping until they are
+ * changed. Each channel holds a reference to the ChannelStore and the file is
+ * unmapped when the last of them is freed. The members of loaded channels are
+ * only allocated when the first member joins. Integers are stored in host byte
+ * order; the file is not meant to be moved between machines.
+ */
+
+#define CHANNEL_STORE_MAGIC "IRCCHAN"
+#define CHANNEL_STORE_VERSION 1
+#define CHANNEL_NO_TOPIC UINT32_MAX
+
+typedef struct _ChannelStoreHeader {
+	char magic[8];			 // CHANNEL_STORE_MAGIC
+	uint32_t version;		 // CHANNEL_STORE_VERSION
+	uint32_t n_channels;	 // number of records
+	uint64_t records_offset; // offset of first record in file
+	uint64_t strings_offset; // offset of string table in file
+	uint64_t strings_size;	 // size of string table
+} ChannelStoreHeader;
+
+typedef struct _ChannelRecord {
+	uint32_t name;	// offset of name in string table
+	uint32_t topic; // offset of topic in string table or CHANNEL_NO_TOPIC
+	int64_t time_created;
+	int32_t mode;
+	uint32_t reserved;
+} ChannelRecord;
+
+/**
+ * Returns true if file starts with the magic of a channel store.
+ */
+bool is_channel_store(const char *filename) {
+	char magic[sizeof CHANNEL_STORE_MAGIC];
+	FILE *file = fopen(filename, "r");
+
+	if (!file) {
+		return false;
+	}
+
+	bool found = fread(magic, 1, sizeof magic, file) == sizeof magic &&
+				 !memcmp(magic, CHANNEL_STORE_MAGIC, sizeof magic);
+	fclose(file);
+
+	return found;
+}
+
+void ChannelStore_release(ChannelStore *store) {
+	if (store && --store->refs == 0) {
+		munmap(store->data, store->size);
+		free(store);
+	}
+}
+
+/**
+ * Returns true if str points into the mapping of store.
+ */
+bool ChannelStore_contains(ChannelStore *store, const char *str) {
+	return store && str >= (char *)store->data &&
+		   str < (char *)store->data + store->size;
+}
+
+static bool check_header(const ChannelStoreHeader *header, size_t size) {
+	if (memcmp(header->magic, CHANNEL_STORE_MAGIC, sizeof header->magic) != 0 ||
+		header->version != CHANNEL_STORE_VERSION) {
+		return false;
+	}
+
+	uint64_t records_end = header->records_offset +
+						   (uint64_t)header->n_channels * sizeof(ChannelRecord);
+
+	// Records are aligned and the string table ends with a null byte, so
+	// every string in it is terminated.
+	return header->records_offset % sizeof(uint64_t) == 0 &&
+		   records_end <= header->strings_offset &&
+		   header->strings_size > 0 &&
+		   header->strings_offset + header->strings_size == size &&
+		   ((char *)header)[size - 1] == 0;
+}
+
+/**
+ * Map channel store file and add its channels to hashtable. Returns false if
+ * the file cannot be mapped or is not a valid store of this version.
+ */
+bool ChannelStore_load(const char *filename, Hashtable *channels) {
+	int fd = open(filename, O_RDONLY | O_CLOEXEC);
+
+	if (fd == -1) {
+		log_error("Failed to open file %s", filename);
+		return false;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(ChannelStoreHeader)) {
+		log_error("Invalid channel store %s", filename);
+		close(fd);
+		return false;
+	}
+
+	size_t size = st.st_size;
+	void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		log_error("Failed to map file %s", filename);
+		return false;
+	}
+
+	const ChannelStoreHeader *header = data;
+
+	if (!check_header(header, size)) {
+		log_error("Invalid channel store %s", filename);
+		munmap(data, size);
+		return false;
+	}
+
+	const ChannelRecord *records =
+		(const ChannelRecord *)((char *)data + header->records_offset);
+	char *strings = (char *)data + header->strings_offset;
+
+	ChannelStore *store = calloc(1, sizeof *store);
+	store->data = data;
+	store->size = size;
+	store->refs = 1; // released at the end of this function
+
+	for (uint32_t i = 0; i < header->n_channels; i++) {
+		const ChannelRecord *record = &records[i];
+
+		if (record->name >= header->strings_size ||
+			(record->topic != CHANNEL_NO_TOPIC &&
+			 record->topic >= header->strings_size)) {
+			log_warn("Skipped bad record in channel store %s", filename);
+			continue;
+		}
+
+		char *name = strings + record->name;
+		Channel *channel = ht_get(channels, name);
+
+		if (channel) {
+			ht_remove(channels, name, NULL, NULL);
+		}
+
+		channel = calloc(1, sizeof *channel);
+		channel->name = name;
+		channel->topic =
+			record->topic == CHANNEL_NO_TOPIC ? NULL : strings + record->topic;
+		channel->mode = record->mode;
+		channel->time_created = record->time_created;
+		channel->store = store;
+		store->refs++;
+
+		ht_set(channels, channel->name, channel);
+	}
+
+	log_info("Loaded %u channels from channel store %s", header->n_channels,
+			 filename);
+
+	ChannelStore_release(store);
+	return true;
+}
+
+static uint32_t add_string(MsgBuf *strings, const char *str) {
+	uint32_t offset = strings->len;
+	msgbuf_add_bytes(strings, str, strlen(str) + 1);
+	return offset;
+}
+
+void ChannelStoreWriter_init(ChannelStoreWriter *writer) {
+	msgbuf_init(&writer->records);
+	msgbuf_init(&writer->strings);
+	writer->n_channels = 0;
+}
+
+/**
+ * Add record of channel to the store being written.
+ */
+void ChannelStoreWriter_add(ChannelStoreWriter *writer, Channel *channel) {
+	ChannelRecord record;
+	memset(&record, 0, sizeof record);
+	record.name = add_string(&writer->strings, channel->name);
+	record.topic = channel->topic ? add_string(&writer->strings, channel->topic)
+								  : CHANNEL_NO_TOPIC;
+	record.time_created = channel->time_created;
+	record.mode = channel->mode;
+	msgbuf_add_bytes(&writer->records, (char *)&record, sizeof record);
+	writer->n_channels++;
+}
+
+/**
+ * Add channel store with the channels added to writer to buf and free the
+ * buffers of writer.
+ */
+void ChannelStoreWriter_finish(ChannelStoreWriter *writer, MsgBuf *buf) {
+	// The table always ends with a null byte, even without channels
+	msgbuf_add_char(&writer->strings, 0);
+
+	ChannelStoreHeader header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, CHANNEL_STORE_MAGIC, sizeof header.magic);
+	header.version = CHANNEL_STORE_VERSION;
+	header.n_channels = writer->n_channels;
+	header.records_offset = sizeof header;
+	header.strings_offset = header.records_offset + writer->records.len;
+	header.strings_size = writer->strings.len;
+
+	msgbuf_add_bytes(buf, (char *)&header, sizeof header);
+	if (writer->n_channels > 0) {
+		msgbuf_add_bytes(buf, writer->records.data, writer->records.len);
+	}
+
+	msgbuf_add_bytes(buf, writer->strings.data, writer->strings.len);
+
+	msgbuf_destroy(&writer->records);
+	msgbuf_destroy(&writer->strings);
+}
+
+/**
+ * Add channel store with given channels to buf.
+ */
+void write_channel_store(MsgBuf *buf, Hashtable *channels) {
+	ChannelStoreWriter writer;
+	ChannelStoreWriter_init(&writer);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, channels);
+	Channel *channel = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&channel)) {
+		ChannelStoreWriter_add(&writer, channel);
+	}
+
+	ChannelStoreWriter_finish(&writer, buf);
+}
@@ -0,0 +1,197 @@
+#include "include/server.h"
+
+/*
+ * The config file has one line per server:
+ *
+ *   <name>,<host>,<port>,<password>[,<autoconnect>]
+ *
+ * where <autoconnect> is an optional space separated list of servers which
+ * connect to this server when they start or when the entry is added on
+ * reload. Empty lines and lines starting with '%' are ignored.
+ *
+ * The file is read once into a map of server name to ConfigEntry, so peer
+ * handshakes never read the file. It is read again on SIGHUP.
+ */
+
+void ConfigEntry_free(ConfigEntry *entry) {
+	free(entry->name);
+	free(entry->host);
+	free(entry->port);
+	free(entry->passwd);
+	Vector_free(entry->autoconnect);
+	free(entry);
+}
+
+/**
+ * Returns true if server with given name should connect to entry.
+ */
+static bool ConfigEntry_autoconnect_from(ConfigEntry *entry, const char *name) {
+	for (size_t i = 0; i < Vector_size(entry->autoconnect); i++) {
+		if (!strcmp(Vector_get_at(entry->autoconnect, i), name)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Read config file into a map of server name to ConfigEntry.
+ * Returns NULL if the file could not be read.
+ */
+Hashtable *load_config(const char *filename) {
+	FILE *file = fopen(filename, "r");
+
+	if (!file) {
+		log_error("failed to open config file %s", filename);
+		return NULL;
+	}
+
+	Hashtable *config = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	config->value_free = (elem_free_type)ConfigEntry_free;
+
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t nread = 0;
+	size_t line_no = 0;
+
+	while ((nread = getline(&line, &capacity, file)) > 0) {
+		line_no++;
+
+		if (line[nread - 1] == '\n') {
+			line[nread - 1] = 0;
+		}
+
+		// empty line or comment
+		if (line[0] == 0 || line[0] == '%') {
+			continue;
+		}
+
+		char *saveptr = NULL;
+		char *name = strtok_r(line, ",", &saveptr);
+		char *host = strtok_r(NULL, ",", &saveptr);
+		char *port = strtok_r(NULL, ",", &saveptr);
+		char *passwd = strtok_r(NULL, ",", &saveptr);
+		char *autoconnect = strtok_r(NULL, ",", &saveptr);
+
+		if (!name || !host || !port || !passwd) {
+			log_warn("%s:%zu: expected name,host,port,password", filename,
+					 line_no);
+			continue;
+		}
+
+		ConfigEntry *entry = calloc(1, sizeof *entry);
+		entry->name = strdup(name);
+		entry->host = strdup(host);
+		entry->port = strdup(port);
+		entry->passwd = strdup(passwd);
+		entry->autoconnect = Vector_alloc(1, (elem_copy_type)strdup, free);
+
+		char *tok = autoconnect ? strtok_r(autoconnect, " ", &saveptr) : NULL;
+
+		for (; tok; tok = strtok_r(NULL, " ", &saveptr)) {
+			Vector_push(entry->autoconnect, tok);
+		}
+
+		ht_set(config, entry->name, entry);
+	}
+
+	free(line);
+	fclose(file);
+
+	return config;
+}
+
+/**
+ * Apply differences between the old and current config. Links to servers
+ * which were removed are closed and servers which this server should
+ * autoconnect to are connected to if they are new. Changed passwords are
+ * used from the next handshake on. If old_config is NULL, every autoconnect
+ * entry is new.
+ */
+void Server_apply_config(Server *serv, Hashtable *old_config) {
+	ConfigEntry *self = ht_get(serv->config, serv->name);
+
+	if (self && strcmp(self->passwd, serv->passwd) != 0) {
+		log_info("password for server %s changed", serv->name);
+		free(serv->passwd);
+		serv->passwd = strdup(self->passwd);
+	}
+
+	HashtableIter itr;
+	ConfigEntry *entry = NULL;
+
+	if (old_config) {
+		ht_iter_init(&itr, old_config);
+
+		while (ht_iter_next(&itr, NULL, (void **)&entry)) {
+			if (ht_contains(serv->config, entry->name)) {
+				continue;
+			}
+
+			log_info("server %s was removed from the config", entry->name);
+			Peer *peer = ht_get(serv->name_to_peer_map, entry->name);
+
+			// Only close direct links
+			if (peer && !strcmp(peer->name, entry->name) && !peer->quit) {
+				Server_queue_peer_message(
+					serv, peer,
+					Server_create_message(serv, "ERROR :Closing Link: %s",
+										  "server removed from config"));
+				peer->quit = true;
+			}
+		}
+	}
+
+	ht_iter_init(&itr, serv->config);
+
+	while (ht_iter_next(&itr, NULL, (void **)&entry)) {
+		ConfigEntry *old_entry =
+			old_config ? ht_get(old_config, entry->name) : NULL;
+
+		if (old_entry && strcmp(old_entry->passwd, entry->passwd) != 0) {
+			log_info("password for server %s changed", entry->name);
+		}
+
+		if (!strcmp(entry->name, serv->name) ||
+			!ConfigEntry_autoconnect_from(entry, serv->name) ||
+			(old_entry && ConfigEntry_autoconnect_from(old_entry, serv->name)) ||
+			ht_contains(serv->name_to_peer_map, entry->name)) {
+			continue;
+		}
+
+		log_info("autoconnect to server %s", entry->name);
+		Server_connect_peer(serv, entry->name);
+	}
+}
+
+/**
+ * Read the config file again and apply the changes. The current config is
+ * kept if the file cannot be read. Replies built from the config and the
+ * MOTD file are rebuilt as well. Returns false if the current config is kept.
+ */
+bool Server_reload_config(Server *serv) {
+	Hashtable *config = load_config(serv->config_file);
+
+	if (!config) {
+		log_error("keeping current config");
+		return false;
+	}
+
+	if (!ht_contains(config, serv->name)) {
+		log_error("server %s not found in config file %s, keeping current config",
+				  serv->name, serv->config_file);
+		ht_free(config);
+		return false;
+	}
+
+	Hashtable *old_config = serv->config;
+	serv->config = config;
+
+	Server_apply_config(serv, old_config);
+	ht_free(old_config);
+
+	Server_reload_catalog(serv);
+	log_info("reloaded config file %s", serv->config_file);
+	return true;
+}
@@ -0,0 +1,311 @@
+#include <time.h>
+
+#include "include/server.h"
+
+/*
+ * Channel index and the conditions of LIST (ELIST).
+ *
+ * The parameter of LIST is a list of items separated by commas:
+ *   #name    the channel of this name
+ *   >n, <n   channels with more or fewer than n members
+ *   C>n, C<n channels created more or less than n minutes ago
+ *   T>n, T<n channels whose topic was set more or less than n minutes ago
+ *   mask     channels with a name matching mask, which has * or ?
+ *   !mask    channels with a name not matching mask
+ * A channel is listed if it meets all conditions. Named channels are looked
+ * up, otherwise the channels in range of one condition are read from the
+ * index and checked against the others.
+ *
+ * Member counts are of the local members, since each server of the network
+ * lists its own channels.
+ */
+
+ChannelIndex *ChannelIndex_alloc(void) {
+	ChannelIndex *index = calloc(1, sizeof *index);
+	index->by_members = SkipList_alloc();
+	index->by_created = SkipList_alloc();
+	index->by_topic = SkipList_alloc();
+	return index;
+}
+
+void ChannelIndex_free(ChannelIndex *index) {
+	SkipList_free(index->by_members);
+	SkipList_free(index->by_created);
+	SkipList_free(index->by_topic);
+	free(index);
+}
+
+void ChannelIndex_add(ChannelIndex *index, Channel *channel) {
+	channel->index = index;
+	SkipList_insert(index->by_members, ht_size(channel->members), channel);
+	SkipList_insert(index->by_created, channel->time_created, channel);
+
+	if (channel->topic_changed_at) {
+		SkipList_insert(index->by_topic, channel->topic_changed_at, channel);
+	}
+}
+
+void ChannelIndex_remove(ChannelIndex *index, Channel *channel) {
+	SkipList_remove(index->by_members, ht_size(channel->members), channel);
+	SkipList_remove(index->by_created, channel->time_created, channel);
+
+	if (channel->topic_changed_at) {
+		SkipList_remove(index->by_topic, channel->topic_changed_at, channel);
+	}
+
+	channel->index = NULL;
+}
+
+/**
+ * Move channel in the index after it had old_count members.
+ */
+void ChannelIndex_update_members(Channel *channel, size_t old_count) {
+	size_t count = ht_size(channel->members);
+
+	if (channel->index && count != old_count) {
+		SkipList_remove(channel->index->by_members, old_count, channel);
+		SkipList_insert(channel->index->by_members, count, channel);
+	}
+}
+
+/**
+ * Move channel in the index after its topic was set at old_time.
+ */
+void ChannelIndex_update_topic(Channel *channel, time_t old_time) {
+	if (!channel->index || channel->topic_changed_at == old_time) {
+		return;
+	}
+
+	if (old_time) {
+		SkipList_remove(channel->index->by_topic, old_time, channel);
+	}
+
+	if (channel->topic_changed_at) {
+		SkipList_insert(channel->index->by_topic, channel->topic_changed_at,
+						channel);
+	}
+}
+
+/**
+ * Match str against mask, where * matches any characters and ? one character,
+ * without case.
+ */
+bool match_mask(const char *mask, const char *str) {
+	const char *star = NULL;
+	const char *retry = NULL;
+
+	while (*str) {
+		if (*mask == '*') {
+			star = mask++;
+			retry = str;
+		} else if (*mask == '?' || tolower(*mask) == tolower(*str)) {
+			mask++;
+			str++;
+		} else if (star) {
+			// Let the last * match one more character
+			mask = star + 1;
+			str = ++retry;
+		} else {
+			return false;
+		}
+	}
+
+	while (*mask == '*') {
+		mask++;
+	}
+
+	return !*mask;
+}
+
+/* Range of keys including both ends, empty if min > max */
+typedef struct _Range {
+	uint64_t min;
+	uint64_t max;
+} Range;
+
+typedef struct _ChannelFilter {
+	Range members;	  // member counts
+	Range created;	  // times of creation
+	Range topic;	  // times the topic was set
+	bool has_members; // a condition on members was given
+	bool has_created;
+	bool has_topic;
+	Vector *names;	   // channel names to look up
+	Vector *masks;	   // masks the name must match
+	Vector *not_masks; // masks the name must not match
+} ChannelFilter;
+
+static bool parse_number(const char *str, uint64_t *value) {
+	char *end = NULL;
+
+	if (!isdigit(*str)) {
+		return false;
+	}
+
+	errno = 0;
+	*value = strtoull(str, &end, 10);
+	return !*end && errno == 0;
+}
+
+/**
+ * Narrow range to the keys less than (op is '<') or greater than limit.
+ */
+static void narrow_range(Range *range, char op, uint64_t limit) {
+	// Nothing is less than 0 or greater than the largest key
+	if (op == '<' ? limit == 0 : limit == UINT64_MAX) {
+		range->min = 1;
+		range->max = 0;
+	} else if (op == '<') {
+		range->max = MIN(range->max, limit - 1);
+	} else {
+		range->min = MAX(range->min, limit + 1);
+	}
+}
+
+/**
+ * Narrow range to the times more (op is '>') or less than minutes ago. Times
+ * later than now are treated as now.
+ */
+static void narrow_time_range(Range *range, char op, uint64_t minutes,
+							  time_t now) {
+	uint64_t ago = minutes > (uint64_t)now / 60 ? (uint64_t)now : minutes * 60;
+	uint64_t cutoff = now - ago;
+
+	// more than n minutes ago is a time before the cutoff
+	narrow_range(range, op == '>' ? '<' : '>', cutoff);
+}
+
+static void parse_item(ChannelFilter *filter, char *item, time_t now) {
+	uint64_t value = 0;
+
+	if ((*item == '<' || *item == '>') && parse_number(item + 1, &value)) {
+		narrow_range(&filter->members, *item, value);
+		filter->has_members = true;
+	} else if (*item == 'C' && (item[1] == '<' || item[1] == '>') &&
+			   parse_number(item + 2, &value)) {
+		narrow_time_range(&filter->created, item[1], value, now);
+		filter->has_created = true;
+	} else if (*item == 'T' && (item[1] == '<' || item[1] == '>') &&
+			   parse_number(item + 2, &value)) {
+		narrow_time_range(&filter->topic, item[1], value, now);
+		filter->has_topic = true;
+	} else if (*item == '!' && item[1]) {
+		Vector_push(filter->not_masks, item + 1);
+	} else if (strpbrk(item, "*?")) {
+		Vector_push(filter->masks, item);
+	} else if (*item == '#' && item[1]) {
+		Vector_push(filter->names, item + 1);
+	}
+}
+
+static bool in_range(Range *range, uint64_t key) {
+	return key >= range->min && key <= range->max;
+}
+
+static bool matches_masks(Vector *masks, const char *name, bool expected) {
+	for (size_t i = 0; i < Vector_size(masks); i++) {
+		if (match_mask(Vector_get_at(masks, i), name) != expected) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool matches_filter(ChannelFilter *filter, Channel *channel) {
+	if (!in_range(&filter->members, ht_size(channel->members)) ||
+		!in_range(&filter->created, channel->time_created)) {
+		return false;
+	}
+
+	// Channels without a known topic time are left out by conditions on it
+	if (filter->has_topic &&
+		(!channel->topic_changed_at ||
+		 !in_range(&filter->topic, channel->topic_changed_at))) {
+		return false;
+	}
+
+	if (Vector_size(filter->masks) == 0 &&
+		Vector_size(filter->not_masks) == 0) {
+		return true;
+	}
+
+	// Masks are matched against the name with the channel prefix
+	char *name = make_string("#%s", channel->name);
+	bool match = matches_masks(filter->masks, name, true) &&
+				 matches_masks(filter->not_masks, name, false);
+	free(name);
+
+	return match;
+}
+
+static void scan_index(SkipList *list, Range *range, ChannelFilter *filter,
+					   Vector *channels) {
+	if (range->min > range->max) {
+		return;
+	}
+
+	for (SkipListNode *node = SkipList_seek(list, range->min);
+		 node && node->key <= range->max; node = SkipList_next(node)) {
+		if (matches_filter(filter, node->elem)) {
+			Vector_push(channels, node->elem);
+		}
+	}
+}
+
+/**
+ * Find the local channels which meet the conditions of a LIST parameter.
+ * Returns a vector of the channels, which the caller frees.
+ */
+Vector *Server_find_channels(Server *serv, const char *args) {
+	Vector *channels = Vector_alloc(16, NULL, NULL);
+	Range all = {0, UINT64_MAX};
+	ChannelFilter filter = {.members = all, .created = all, .topic = all};
+	filter.names = Vector_alloc(4, NULL, NULL);
+	filter.masks = Vector_alloc(4, NULL, NULL);
+	filter.not_masks = Vector_alloc(4, NULL, NULL);
+
+	char *items = strdup(args);
+	char *saveptr = NULL;
+	time_t now = time(NULL);
+
+	for (char *item = strtok_r(items, ",", &saveptr); item != NULL;
+		 item = strtok_r(NULL, ",", &saveptr)) {
+		parse_item(&filter, item, now);
+	}
+
+	ChannelIndex *index = serv->channel_index;
+
+	// Scan the index of a condition, preferring the member count
+	if (Vector_size(filter.names) > 0) {
+		for (size_t i = 0; i < Vector_size(filter.names); i++) {
+			Channel *channel = ht_get(serv->name_to_channel_map,
+									  Vector_get_at(filter.names, i));
+
+			if (channel && matches_filter(&filter, channel)) {
+				Vector_push(channels, channel);
+			}
+		}
+	} else if (filter.has_members) {
+		scan_index(index->by_members, &filter.members, &filter, channels);
+	} else if (filter.has_topic) {
+		scan_index(index->by_topic, &filter.topic, &filter, channels);
+	} else if (filter.has_created) {
+		scan_index(index->by_created, &filter.created, &filter, channels);
+	} else if (Vector_size(filter.masks) > 0 ||
+			   Vector_size(filter.not_masks) > 0) {
+		for (Channel *channel = serv->first_channel; channel;
+			 channel = channel->next) {
+			if (matches_filter(&filter, channel)) {
+				Vector_push(channels, channel);
+			}
+		}
+	}
+
+	Vector_free(filter.names);
+	Vector_free(filter.masks);
+	Vector_free(filter.not_masks);
+	free(items);
+
+	return channels;
+}
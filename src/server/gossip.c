@@ -0,0 +1,192 @@
+#include "include/server.h"
+
+/**
+ * Network statistics
+ *
+ * Every server periodically sends a summary of its counters to its peers,
+ * which relay it to the rest of the network:
+ *
+ * `:<sender> SUMMARY <server> <seq> <users> <channels> <sketch>`
+ *
+ * The summaries of remote servers are cached along with running totals, so
+ * that global statistics can be answered in constant time. Since the same
+ * channel may exist on many servers, the number of distinct channels is
+ * estimated from the union of the HyperLogLog sketches of channel names.
+ */
+
+/**
+ * Returns the counters of this server as "<users> <channels> <sketch>".
+ */
+static char *make_local_summary(Server *serv) {
+	if (serv->channel_sketch_stale) {
+		Server_rebuild_channel_sketch(serv);
+	}
+
+	char sketch[HLL_REGISTERS + 1];
+	hll_encode(&serv->channel_sketch, sketch);
+
+	return make_string("%zu %zu %s", ht_size(serv->nick_to_user_map),
+					   ht_size(serv->name_to_channel_map), sketch);
+}
+
+static void rebuild_remote_sketch(Server *serv) {
+	hll_init(&serv->remote_channel_sketch);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->summaries);
+	Summary *summary = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&summary)) {
+		hll_merge(&serv->remote_channel_sketch, &summary->channel_sketch);
+	}
+}
+
+/**
+ * The sketch of local channels is updated when a channel is created, but has
+ * to be rebuilt when a channel is removed.
+ */
+void Server_rebuild_channel_sketch(Server *serv) {
+	hll_init(&serv->channel_sketch);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->name_to_channel_map);
+	char *name = NULL;
+
+	while (ht_iter_next(&itr, (void **)&name, NULL)) {
+		hll_add(&serv->channel_sketch, name);
+	}
+
+	serv->channel_sketch_stale = false;
+}
+
+/**
+ * Send summary of this server to all peers if the counters have changed
+ * since the last summary and the last summary is old enough.
+ */
+void Server_gossip_summary(Server *serv) {
+	uint64_t now = get_time_ms();
+
+	if (now - serv->summary_sent_at < SUMMARY_INTERVAL_MS) {
+		return;
+	}
+
+	serv->summary_sent_at = now;
+	char *summary = make_local_summary(serv);
+
+	if (serv->summary && !strcmp(serv->summary, summary)) {
+		free(summary);
+		return;
+	}
+
+	free(serv->summary);
+	serv->summary = summary;
+
+	char *message = Server_create_message(serv, "SUMMARY %s %lu %s", serv->name,
+										  ++serv->summary_seq, summary);
+	Server_broadcast_message(serv, message);
+	free(message);
+}
+
+/**
+ * Send the summaries of this server and all known servers to a new peer.
+ */
+void Server_send_summaries(Server *serv, Peer *peer) {
+	char *summary = make_local_summary(serv);
+	Server_queue_peer_message(
+		serv, peer,
+		Server_create_message(serv, "SUMMARY %s %lu %s", serv->name,
+							  ++serv->summary_seq, summary));
+	free(summary);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->summaries);
+	char *name = NULL;
+	Summary *other = NULL;
+
+	while (ht_iter_next(&itr, (void **)&name, (void **)&other)) {
+		char sketch[HLL_REGISTERS + 1];
+		hll_encode(&other->channel_sketch, sketch);
+		Server_queue_peer_message(
+			serv, peer,
+			Server_create_message(serv, "SUMMARY %s %lu %lu %lu %s", name,
+								  other->seq, other->users, other->channels,
+								  sketch));
+	}
+}
+
+/**
+ * Forget the summary of a server which has left the network.
+ */
+void Server_remove_summary(Server *serv, const char *name) {
+	Summary *summary = ht_get(serv->summaries, name);
+
+	if (!summary) {
+		return;
+	}
+
+	serv->remote_users -= summary->users;
+	ht_remove(serv->summaries, name, NULL, NULL);
+	rebuild_remote_sketch(serv);
+}
+
+unsigned long Server_count_global_users(Server *serv) {
+	return ht_size(serv->nick_to_user_map) + serv->remote_users;
+}
+
+unsigned long Server_estimate_global_channels(Server *serv) {
+	HyperLogLog sketch = serv->channel_sketch;
+	hll_merge(&sketch, &serv->remote_channel_sketch);
+	return (unsigned long)(hll_estimate(&sketch) + 0.5);
+}
+
+/**
+ * Command: SUMMARY
+ * Parameters: <server> <seq> <users> <channels> <sketch>
+ */
+void Server_handle_peer_SUMMARY(Server *serv, Peer *peer, Message *msg) {
+	assert(!strcmp(msg->command, "SUMMARY"));
+
+	if (msg->n_params < 5) {
+		return;
+	}
+
+	char *name = msg->params[0];
+
+	if (!strcmp(name, serv->name) ||
+		!ht_contains(serv->name_to_peer_map, name)) {
+		return;
+	}
+
+	unsigned long seq = strtoul(msg->params[1], NULL, 10);
+	Summary *summary = ht_get(serv->summaries, name);
+
+	if (summary && seq <= summary->seq) {
+		return;	 // already seen
+	}
+
+	Summary update;
+	update.seq = seq;
+	update.users = strtoul(msg->params[2], NULL, 10);
+	update.channels = strtoul(msg->params[3], NULL, 10);
+
+	if (!hll_decode(&update.channel_sketch, msg->params[4])) {
+		log_warn("invalid summary from server %s", name);
+		return;
+	}
+
+	if (!summary) {
+		summary = calloc(1, sizeof *summary);
+		ht_set(serv->summaries, name, summary);
+	} else {
+		serv->remote_users -= summary->users;
+	}
+
+	*summary = update;
+	serv->remote_users += summary->users;
+	rebuild_remote_sketch(serv);
+
+	serv->max_global_users =
+		MAX(serv->max_global_users, Server_count_global_users(serv));
+
+	Server_relay_message(serv, peer->name, msg->message);
+}
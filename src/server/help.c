@@ -7,6 +7,15 @@ const char help_who[] =
 	"Example: WHO emersion ; request information on user 'emersion'\n"
 	"Example: WHO #ircv3 ; list users in the '#ircv3' channel";
 
+const char help_list[] =
+	"The /LIST command lists channels with their number of members and topic.\n"
+	"Example: LIST ; list all channels\n"
+	"Example: LIST #irc,#linux ; list the channels '#irc' and '#linux'\n"
+	"Example: LIST >100,#irc* ; channels over 100 members starting with '#irc'\n"
+	"Example: LIST <5,!#test* ; small channels not starting with '#test'\n"
+	"Example: LIST C<60 ; channels created in the last hour\n"
+	"Example: LIST T>1440 ; channels whose topic was set over a day ago";
+
 const char help_privmsg[] =
 	"The /PRIVMSG command is the main way to send messages to other users.\n"
 	"PRIVMSG Angel :yes I'm receiving it ! ; Command to send a message to "
@@ -16,7 +25,8 @@ const char help_privmsg[] =
 
 const char help_usercmds[] =
 	"This IRC server supports the following IRC commands:\n"
-	"PRIVMSG, NOTICE, NICK, USER, QUIT, JOIN, PART, TOPIC, LIST, NAMES, PING";
+	"PRIVMSG, NOTICE, NICK, USER, QUIT, JOIN, PART, TOPIC, LIST, NAMES, PING, "
+	"CHATHISTORY";
 
 const struct help_t help[] = {
 	{"HELP", "** Help system **",
@@ -41,15 +51,23 @@ const struct help_t help[] = {
 	{"JOIN", "** The JOIN Command **", ""},
 	{"PART", "** The PART Command **", ""},
 	{"TOPIC", "** The TOPIC Command **", ""},
-	{"LIST", "** The LIST Command **", ""},
+	{"LIST", "** The LIST Command **", help_list},
 	{"NAMES", "** The NAMES Command **", ""},
 	{"LUSERS", "** The LUSERS Command **", ""},
 	{"PING", "** The PING Command **", ""},
+	{"CHATHISTORY", "** The CHATHISTORY Command **",
+	 "The /CHATHISTORY command sends recent messages of a channel you are "
+	 "on.\n"
+	 "CHATHISTORY LATEST #bunny * 20 ; the last 20 messages\n"
+	 "CHATHISTORY BEFORE #bunny timestamp=2023-04-27T10:00:00.000Z 20 ; the "
+	 "last 20 messages before the time\n"
+	 "CHATHISTORY AFTER #bunny timestamp=2023-04-27T10:00:00.000Z 20 ; the "
+	 "first 20 messages after the time"},
 };
 
-const struct help_t *get_help_text(const char *subject) {
-	static size_t n_help = sizeof help / sizeof *help;
+const size_t n_help = sizeof help / sizeof *help;
 
+const struct help_t *get_help_text(const char *subject) {
 	for (size_t i = 0; i < n_help; i++) {
 		if (!strcmp(help[i].subject, subject)) {
 			return help + i;
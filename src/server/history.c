@@ -0,0 +1,309 @@
+#include "include/server.h"
+
+/*
+ * Recent messages of channels are kept in a single arena which is split into
+ * blocks of HISTORY_BLOCK_SIZE bytes. A channel gets a block when its first
+ * message is added, and the block is used as a ring of entries:
+ *
+ *   HistoryEntry | message | padding to 8 bytes
+ *
+ * The message is the line which was sent to the members of the channel
+ * without the \r\n, so replaying history copies the bytes as they are. Old
+ * entries are dropped when the ring is full. An entry which does not fit
+ * before the end of the block starts at offset 0 instead, and the rest of the
+ * block is skipped.
+ *
+ * When all blocks are in use, the block of the least recently used channel is
+ * taken, so memory is bounded by the arena and cold channels lose their
+ * history first.
+ */
+
+#define HISTORY_WRAP UINT32_MAX // entry length which marks the end of a ring
+
+typedef struct _HistoryEntry {
+	uint32_t len;	   // length of message
+	uint32_t reserved;
+	uint64_t time_ms; // time message was added
+} HistoryEntry;
+
+static size_t entry_size(size_t len) {
+	return (sizeof(HistoryEntry) + len + 7) & ~(size_t)7;
+}
+
+/**
+ * Returns offset of entry at pos, which is 0 if the ring wraps at pos.
+ */
+static size_t entry_start(const HistoryBlock *block, size_t pos) {
+	if (pos + sizeof(HistoryEntry) > HISTORY_BLOCK_SIZE ||
+		((HistoryEntry *)(block->data + pos))->len == HISTORY_WRAP) {
+		return 0;
+	}
+
+	return pos;
+}
+
+History *History_alloc(size_t max_bytes) {
+	History *history = calloc(1, sizeof *history);
+	history->n_blocks = max_bytes / HISTORY_BLOCK_SIZE;
+	history->arena = malloc(history->n_blocks * HISTORY_BLOCK_SIZE);
+	history->blocks = calloc(history->n_blocks, sizeof *history->blocks);
+
+	for (size_t i = 0; i < history->n_blocks; i++) {
+		history->blocks[i].data = history->arena + i * HISTORY_BLOCK_SIZE;
+		history->blocks[i].next = history->free_list;
+		history->free_list = &history->blocks[i];
+	}
+
+	return history;
+}
+
+void History_free(History *history) {
+	if (!history) {
+		return;
+	}
+
+	free(history->blocks);
+	free(history->arena);
+	free(history);
+}
+
+static void lru_unlink(History *history, HistoryBlock *block) {
+	if (block->prev) {
+		block->prev->next = block->next;
+	} else {
+		history->lru_head = block->next;
+	}
+
+	if (block->next) {
+		block->next->prev = block->prev;
+	} else {
+		history->lru_tail = block->prev;
+	}
+
+	block->prev = block->next = NULL;
+}
+
+static void lru_push_front(History *history, HistoryBlock *block) {
+	block->prev = NULL;
+	block->next = history->lru_head;
+
+	if (history->lru_head) {
+		history->lru_head->prev = block;
+	} else {
+		history->lru_tail = block;
+	}
+
+	history->lru_head = block;
+}
+
+/**
+ * Mark history of channel as most recently used.
+ */
+static void History_touch(History *history, HistoryBlock *block) {
+	if (history->lru_head != block) {
+		lru_unlink(history, block);
+		lru_push_front(history, block);
+	}
+}
+
+/**
+ * Return the block of channel to the free list.
+ */
+void History_remove_channel(History *history, Channel *channel) {
+	HistoryBlock *block = channel->history;
+
+	if (!history || !block) {
+		return;
+	}
+
+	lru_unlink(history, block);
+	block->channel = NULL;
+	block->next = history->free_list;
+	history->free_list = block;
+	channel->history = NULL;
+}
+
+static HistoryBlock *History_get_block(History *history, Channel *channel) {
+	if (channel->history) {
+		return channel->history;
+	}
+
+	HistoryBlock *block = history->free_list;
+
+	if (block) {
+		history->free_list = block->next;
+	} else if ((block = history->lru_tail) != NULL) {
+		log_debug("dropped history of channel %s", block->channel->name);
+		lru_unlink(history, block);
+		block->channel->history = NULL;
+	} else {
+		return NULL;
+	}
+
+	block->head = block->tail = block->n_entries = 0;
+	block->channel = channel;
+	block->next = block->prev = NULL;
+	channel->history = block;
+	lru_push_front(history, block);
+
+	return block;
+}
+
+/**
+ * Remove the oldest entry of block.
+ */
+static void HistoryBlock_pop(HistoryBlock *block) {
+	block->head = entry_start(block, block->head);
+	HistoryEntry *entry = (HistoryEntry *)(block->data + block->head);
+	block->head += entry_size(entry->len);
+
+	if (--block->n_entries == 0) {
+		block->head = block->tail = 0;
+	}
+}
+
+/**
+ * Add message sent to channel at time_ms to its history. The message is
+ * expected to be a complete line; the \r\n is not stored.
+ */
+void History_add(History *history, Channel *channel, const char *message,
+				 uint64_t time_ms) {
+	if (!history) {
+		return;
+	}
+
+	size_t len = strlen(message);
+
+	if (len >= 2 && !strcmp(message + len - 2, "\r\n")) {
+		len -= 2;
+	}
+
+	size_t size = entry_size(len);
+	HistoryBlock *block = History_get_block(history, channel);
+
+	if (!block || size > HISTORY_BLOCK_SIZE) {
+		return;
+	}
+
+	History_touch(history, block);
+
+	// Find space at the tail, dropping old entries as needed
+	while (block->n_entries > 0) {
+		if (block->tail > block->head) {
+			if (HISTORY_BLOCK_SIZE - block->tail >= size) {
+				break;
+			}
+
+			if (HISTORY_BLOCK_SIZE - block->tail >= sizeof(HistoryEntry)) {
+				((HistoryEntry *)(block->data + block->tail))->len = HISTORY_WRAP;
+			}
+
+			block->tail = 0;
+		} else if (block->head - block->tail >= size) {
+			break;
+		} else {
+			HistoryBlock_pop(block);
+		}
+	}
+
+	HistoryEntry *entry = (HistoryEntry *)(block->data + block->tail);
+	entry->len = len;
+	entry->reserved = 0;
+	entry->time_ms = time_ms;
+	memcpy(entry + 1, message, len);
+
+	block->tail += size;
+	block->n_entries++;
+
+	if (block->tail == HISTORY_BLOCK_SIZE) {
+		block->tail = 0;
+	}
+}
+
+/**
+ * Returns time of the oldest message in history of channel, or UINT64_MAX if
+ * there is none.
+ */
+uint64_t History_oldest(History *history, Channel *channel) {
+	HistoryBlock *block = channel->history;
+
+	if (!history || !block || block->n_entries == 0) {
+		return UINT64_MAX;
+	}
+
+	size_t pos = entry_start(block, block->head);
+	return ((HistoryEntry *)(block->data + pos))->time_ms;
+}
+
+/**
+ * Returns number of messages in history of channel which were added after the
+ * time after_ms and before the time before_ms.
+ */
+size_t History_count(History *history, Channel *channel, uint64_t after_ms,
+					 uint64_t before_ms) {
+	HistoryBlock *block = channel->history;
+
+	if (!history || !block) {
+		return 0;
+	}
+
+	size_t n_matches = 0;
+	size_t pos = block->head;
+
+	for (size_t i = 0; i < block->n_entries; i++) {
+		pos = entry_start(block, pos);
+		HistoryEntry *entry = (HistoryEntry *)(block->data + pos);
+		n_matches += entry->time_ms > after_ms && entry->time_ms < before_ms;
+		pos += entry_size(entry->len);
+	}
+
+	return n_matches;
+}
+
+/**
+ * Add up to limit messages of channel to queue as lines. Only messages added
+ * after the time after_ms and before the time before_ms are used. If latest is
+ * true the newest of these messages are sent, otherwise the oldest.
+ * Returns number of messages added.
+ */
+size_t History_send(History *history, Channel *channel, List *queue,
+					uint64_t after_ms, uint64_t before_ms, bool latest,
+					size_t limit) {
+	HistoryBlock *block = channel->history;
+
+	if (!history || !block) {
+		return 0;
+	}
+
+	History_touch(history, block);
+
+	// Skip the oldest matching entries for latest messages
+	size_t n_matches =
+		latest ? History_count(history, channel, after_ms, before_ms) : 0;
+	size_t skip = n_matches > limit ? n_matches - limit : 0;
+	size_t n_sent = 0;
+	size_t pos = block->head;
+
+	for (size_t i = 0; i < block->n_entries && n_sent < limit; i++) {
+		pos = entry_start(block, pos);
+		HistoryEntry *entry = (HistoryEntry *)(block->data + pos);
+		pos += entry_size(entry->len);
+
+		if (entry->time_ms <= after_ms || entry->time_ms >= before_ms) {
+			continue;
+		}
+
+		if (skip > 0) {
+			skip--;
+			continue;
+		}
+
+		char *line = malloc(entry->len + 3);
+		memcpy(line, entry + 1, entry->len);
+		memcpy(line + entry->len, "\r\n", 3);
+		List_push_back(queue, line);
+		n_sent++;
+	}
+
+	return n_sent;
+}
@@ -0,0 +1,466 @@
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "include/queue.h"
+#include "include/server.h"
+
+/*
+ * Changes to channels are appended to a journal so they survive a crash. Each
+ * record is a line which sets the state of one channel:
+ *
+ *   C <name> <time_created> <mode>   channel created
+ *   T <name> :<topic>                topic changed
+ *   M <name> <mode>                  mode changed
+ *   D <name>                         channel removed
+ *
+ * The event loop only adds records to a buffer, which is handed to the writer
+ * thread once per loop iteration. The writer writes every batch that is
+ * queued and then calls fdatasync once for all of them, so the loop never
+ * waits for the disk and a slow sync commits more records at a time.
+ *
+ * After JOURNAL_SNAPSHOT_RECORDS records a snapshot of the channels is
+ * started. The event loop adds JOURNAL_SNAPSHOT_CHUNK channels of its channel
+ * list to the snapshot per iteration, so building it never stalls the loop,
+ * and the writer assembles and writes the channel store. Channels change while
+ * the snapshot is built, so the journal is then replaced by the records added
+ * since the snapshot was started instead of being emptied. Records set a state
+ * instead of changing it, so replaying them on top of a snapshot which already
+ * has some of their changes, or replaying the old journal after a crash
+ * between the two renames, gives the same channels.
+ */
+
+typedef struct _JournalBatch {
+	enum { JOURNAL_APPEND, JOURNAL_SNAPSHOT, JOURNAL_STOP } type;
+	char *data;					  // records to append or to replace journal with
+	size_t len;					  // length of data
+	ChannelStoreWriter *snapshot; // channels of snapshot
+} JournalBatch;
+
+static void snapshot_free(ChannelStoreWriter *snapshot) {
+	if (snapshot) {
+		msgbuf_destroy(&snapshot->records);
+		msgbuf_destroy(&snapshot->strings);
+		free(snapshot);
+	}
+}
+
+static void JournalBatch_free(JournalBatch *batch) {
+	if (batch) {
+		snapshot_free(batch->snapshot);
+		free(batch->data);
+		free(batch);
+	}
+}
+
+static void Journal_enqueue(Journal *journal, int type, MsgBuf *buf) {
+	JournalBatch *batch = calloc(1, sizeof *batch);
+	batch->type = type;
+
+	if (buf) {
+		batch->data = msgbuf_to_string(buf);
+		batch->len = buf->len;
+	}
+
+	queue_enqueue(journal->batches, batch);
+}
+
+/**
+ * Write the channel store of batch to the snapshot file and replace the
+ * journal with the records of batch.
+ */
+static void Journal_write_snapshot(Journal *journal, JournalBatch *batch) {
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	ChannelStoreWriter_finish(batch->snapshot, &buf);
+	free(batch->snapshot);
+	batch->snapshot = NULL;
+
+	bool ok = save_snapshot(journal->snapshot_filename, buf.data, buf.len);
+	msgbuf_destroy(&buf);
+
+	if (!ok || !save_snapshot(journal->filename, batch->data ? batch->data : "",
+							  batch->len)) {
+		return;
+	}
+
+	int fd = open(journal->filename, O_WRONLY | O_APPEND | O_CLOEXEC);
+
+	if (fd == -1) {
+		log_error("failed to reopen journal %s", journal->filename);
+		return;
+	}
+
+	close(journal->fd);
+	journal->fd = fd;
+}
+
+/**
+ * Write batches as they are queued and sync the journal after each group of
+ * batches.
+ */
+static void *Journal_writer(void *arg) {
+	Journal *journal = arg;
+	bool running = true;
+
+	while (running) {
+		JournalBatch *batch = queue_dequeue(journal->batches);
+		bool dirty = false;
+
+		for (; batch; batch = queue_try_dequeue(journal->batches)) {
+			switch (batch->type) {
+			case JOURNAL_APPEND:
+				if (write_all(journal->fd, batch->data, batch->len) !=
+					(ssize_t)batch->len) {
+					log_error("failed to write journal %s", journal->filename);
+				}
+				dirty = true;
+				break;
+			case JOURNAL_SNAPSHOT:
+				Journal_write_snapshot(journal, batch);
+				break;
+			case JOURNAL_STOP:
+				running = false;
+				break;
+			}
+
+			JournalBatch_free(batch);
+		}
+
+		if (dirty && fdatasync(journal->fd) == -1) {
+			log_error("failed to sync journal %s", journal->filename);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Drop the snapshot being built, if any.
+ */
+static void Journal_cancel_snapshot(Journal *journal) {
+	if (journal->snapshot) {
+		snapshot_free(journal->snapshot);
+		journal->snapshot = NULL;
+		journal->snapshot_next = NULL;
+		msgbuf_destroy(&journal->snapshot_records);
+	}
+}
+
+/**
+ * Cut an incomplete last record off the journal, as a crash during a write
+ * leaves it, so that records appended later start on a line of their own.
+ */
+static void cut_torn_record(int fd, const char *filename) {
+	off_t size = lseek(fd, 0, SEEK_END);
+	off_t end = size;
+	char buf[4096];
+	bool found = false;
+
+	while (end > 0 && !found) {
+		size_t n = MIN((size_t)end, sizeof buf);
+
+		if (pread(fd, buf, n, end - n) != (ssize_t)n) {
+			return;
+		}
+
+		while (n > 0 && buf[n - 1] != '\n') {
+			n--;
+			end--;
+		}
+
+		found = n > 0;
+	}
+
+	if (end < size) {
+		log_warn("cut incomplete record off journal %s", filename);
+
+		if (ftruncate(fd, end) != 0) {
+			log_error("failed to truncate journal %s", filename);
+		}
+	}
+}
+
+/**
+ * Open journal for appending and start the writer thread. Returns NULL if the
+ * journal cannot be opened, in which case changes are only saved at shutdown.
+ */
+Journal *Journal_open(const char *filename, const char *snapshot_filename) {
+	int fd = open(filename, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+	if (fd == -1) {
+		log_error("failed to open journal %s", filename);
+		return NULL;
+	}
+
+	cut_torn_record(fd, filename);
+
+	Journal *journal = calloc(1, sizeof *journal);
+	journal->fd = fd;
+	journal->filename = strdup(filename);
+	journal->snapshot_filename = strdup(snapshot_filename);
+	journal->batches = queue_alloc();
+	msgbuf_init(&journal->pending);
+
+	if (start_thread(&journal->writer, Journal_writer, journal) != 0) {
+		log_error("failed to start journal writer");
+		queue_free(journal->batches, NULL);
+		free(journal->filename);
+		free(journal->snapshot_filename);
+		close(fd);
+		free(journal);
+		return NULL;
+	}
+
+	return journal;
+}
+
+/**
+ * Write a final snapshot of channels, stop the writer and free the journal.
+ * Without channels, writes which are queued are done and a snapshot being
+ * built is dropped.
+ */
+void Journal_close(Journal *journal, Hashtable *channels) {
+	if (!journal) {
+		return;
+	}
+
+	Journal_flush(journal);
+
+	if (channels) {
+		Journal_snapshot(journal, channels);
+	} else {
+		Journal_cancel_snapshot(journal);
+	}
+
+	Journal_enqueue(journal, JOURNAL_STOP, NULL);
+	pthread_join(journal->writer, NULL);
+
+	queue_free(journal->batches, (void (*)(void *))JournalBatch_free);
+	msgbuf_destroy(&journal->pending);
+	close(journal->fd);
+	free(journal->filename);
+	free(journal->snapshot_filename);
+	free(journal);
+}
+
+/**
+ * Hand records added since the last call to the writer.
+ */
+void Journal_flush(Journal *journal) {
+	if (!journal || journal->pending.len == 0) {
+		return;
+	}
+
+	// Records added while a snapshot is built stay in the journal after it
+	if (journal->snapshot) {
+		msgbuf_add_bytes(&journal->snapshot_records, journal->pending.data,
+						 journal->pending.len);
+	}
+
+	Journal_enqueue(journal, JOURNAL_APPEND, &journal->pending);
+	msgbuf_clear(&journal->pending);
+}
+
+/**
+ * Hand snapshot to the writer, with the records added since it was started.
+ */
+static void Journal_enqueue_snapshot(Journal *journal,
+									 ChannelStoreWriter *snapshot,
+									 MsgBuf *records) {
+	JournalBatch *batch = calloc(1, sizeof *batch);
+	batch->type = JOURNAL_SNAPSHOT;
+	batch->snapshot = snapshot;
+
+	if (records) {
+		batch->data = msgbuf_to_string(records);
+		batch->len = records->len;
+	}
+
+	queue_enqueue(journal->batches, batch);
+}
+
+/**
+ * Queue a snapshot of all channels at once, which replaces the journal.
+ */
+void Journal_snapshot(Journal *journal, Hashtable *channels) {
+	if (!journal) {
+		return;
+	}
+
+	Journal_cancel_snapshot(journal);
+	Journal_flush(journal);
+
+	ChannelStoreWriter *snapshot = malloc(sizeof *snapshot);
+	ChannelStoreWriter_init(snapshot);
+	HashtableIter itr;
+	ht_iter_init(&itr, channels);
+	Channel *channel = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&channel)) {
+		ChannelStoreWriter_add(snapshot, channel);
+	}
+
+	Journal_enqueue_snapshot(journal, snapshot, NULL);
+	journal->n_records = 0;
+}
+
+/**
+ * Start a snapshot of the list of channels from first, which is built by
+ * Journal_continue_snapshot. Nothing is done if a snapshot is being built.
+ */
+void Journal_start_snapshot(Journal *journal, Channel *first) {
+	if (!journal || journal->snapshot) {
+		return;
+	}
+
+	// Records added before the snapshot only go to the old journal
+	Journal_flush(journal);
+
+	journal->snapshot = malloc(sizeof *journal->snapshot);
+	ChannelStoreWriter_init(journal->snapshot);
+	journal->snapshot_next = first;
+	msgbuf_init(&journal->snapshot_records);
+	journal->n_records = 0;
+}
+
+/**
+ * Add up to n channels to the snapshot being built and hand it to the writer
+ * once all channels are added. Returns true if the snapshot was handed over.
+ */
+bool Journal_continue_snapshot(Journal *journal, size_t n) {
+	if (!journal || !journal->snapshot) {
+		return false;
+	}
+
+	for (size_t i = 0; i < n && journal->snapshot_next; i++) {
+		ChannelStoreWriter_add(journal->snapshot, journal->snapshot_next);
+		journal->snapshot_next = journal->snapshot_next->next;
+	}
+
+	if (journal->snapshot_next) {
+		return false;
+	}
+
+	Journal_flush(journal);
+	Journal_enqueue_snapshot(journal, journal->snapshot,
+							 &journal->snapshot_records);
+	msgbuf_destroy(&journal->snapshot_records);
+	journal->snapshot = NULL;
+
+	return true;
+}
+
+/**
+ * Move the snapshot being built past channel, which is being removed from
+ * the channel list.
+ */
+void Journal_skip_channel(Journal *journal, Channel *channel) {
+	if (journal && journal->snapshot_next == channel) {
+		journal->snapshot_next = channel->next;
+	}
+}
+
+void Journal_add_channel(Journal *journal, Channel *channel) {
+	if (journal) {
+		msgbuf_add_format(&journal->pending, "C %s %ld %d\n", channel->name,
+						  (long)channel->time_created, channel->mode);
+		journal->n_records++;
+	}
+}
+
+void Journal_set_topic(Journal *journal, Channel *channel) {
+	if (journal) {
+		msgbuf_add_format(&journal->pending, "T %s :%s\n", channel->name,
+						  channel->topic ? channel->topic : "");
+		journal->n_records++;
+	}
+}
+
+void Journal_set_mode(Journal *journal, Channel *channel) {
+	if (journal) {
+		msgbuf_add_format(&journal->pending, "M %s %d\n", channel->name,
+						  channel->mode);
+		journal->n_records++;
+	}
+}
+
+void Journal_remove_channel(Journal *journal, const char *name) {
+	if (journal) {
+		msgbuf_add_format(&journal->pending, "D %s\n", name);
+		journal->n_records++;
+	}
+}
+
+/**
+ * Apply records in journal file to channels. A last line without a newline
+ * was not completely written and is ignored, and Journal_open() cuts it off.
+ * Returns the number of records applied.
+ */
+size_t Journal_replay(Hashtable *channels, const char *filename) {
+	FILE *file = fopen(filename, "r");
+
+	if (!file) {
+		return 0;
+	}
+
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t nread = 0;
+	size_t n_records = 0;
+
+	while ((nread = getline(&line, &capacity, file)) > 0) {
+		if (line[nread - 1] != '\n') {
+			log_warn("ignored incomplete record at end of journal %s",
+					 filename);
+			break;
+		}
+
+		line[nread - 1] = 0;
+
+		char *topic = strstr(line, " :");
+
+		if (topic) {
+			*topic = 0;
+			topic += 2;
+		}
+
+		char *saveptr = NULL;
+		char *type = strtok_r(line, " ", &saveptr);
+		char *name = strtok_r(NULL, " ", &saveptr);
+		char *arg1 = strtok_r(NULL, " ", &saveptr);
+		char *arg2 = strtok_r(NULL, " ", &saveptr);
+
+		if (!type || !name) {
+			continue;
+		}
+
+		Channel *channel = ht_get(channels, name);
+
+		if (!strcmp(type, "C") && arg1 && arg2) {
+			if (!channel) {
+				channel = Channel_alloc(name);
+				ht_set(channels, channel->name, channel);
+			}
+
+			channel->time_created = atol(arg1);
+			channel->mode = atoi(arg2);
+		} else if (!strcmp(type, "T") && channel) {
+			Channel_set_topic(channel, topic && *topic ? topic : NULL);
+		} else if (!strcmp(type, "M") && channel && arg1) {
+			channel->mode = atoi(arg1);
+		} else if (!strcmp(type, "D")) {
+			ht_remove(channels, name, NULL, NULL);
+		} else {
+			log_warn("skipped bad record in journal %s", filename);
+			continue;
+		}
+
+		n_records++;
+	}
+
+	free(line);
+	fclose(file);
+
+	log_info("Replayed %zu records from journal %s", n_records, filename);
+	return n_records;
+}
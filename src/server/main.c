@@ -1,6 +1,7 @@
 
 #include <signal.h>
 #include <sys/epoll.h>
+#include <sys/signalfd.h>
 
 #include "include/server.h"
 
@@ -8,27 +9,85 @@ static volatile bool g_alive = true;
 
 void sighandler(int sig);
 
+void usage(const char *program)
+{
+	fprintf(stderr, "Usage: %s [options] <name>\n", program);
+	fprintf(stderr, "  -p <ms>     time between PINGs sent to peers (default %d)\n", PEER_PING_INTERVAL_MS);
+	fprintf(stderr, "  -m <count>  PINGs missed before a peer is dropped (default %d)\n", PEER_MAX_MISSED_PINGS);
+	fprintf(stderr, "  -l <levels> log levels, e.g. \"info,server=debug\" (default trace)\n");
+	fprintf(stderr, "  -a <path>   listen for admin requests on Unix socket at path\n");
+	fprintf(stderr, "  -c <file>   capture anonymized lines from users to file for build/bench -R\n");
+}
+
 /**
  * To start IRC server on given port
  */
 int main(int argc, char *argv[])
 {
-	if (argc < 2)
+	int ping_interval_ms = PEER_PING_INTERVAL_MS;
+	int max_missed_pings = PEER_MAX_MISSED_PINGS;
+	const char *admin_path = NULL;
+	const char *capture_path = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:m:l:a:c:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p':
+			ping_interval_ms = atoi(optarg);
+			break;
+		case 'm':
+			max_missed_pings = atoi(optarg);
+			break;
+		case 'l':
+			if (!logger_set_levels(optarg))
+			{
+				usage(*argv);
+				return 1;
+			}
+			break;
+		case 'a':
+			admin_path = optarg;
+			break;
+		case 'c':
+			capture_path = optarg;
+			break;
+		default:
+			usage(*argv);
+			return 1;
+		}
+	}
+
+	if (optind >= argc || ping_interval_ms <= 0 || max_missed_pings <= 0)
 	{
-		fprintf(stderr, "Usage: %s <name>", *argv);
+		usage(*argv);
 		return 1;
 	}
-	// Create and start an IRC server on given port
-	Server *serv = Server_create(argv[1]);
 
-	// Array for events returned from epoll
-	struct epoll_event events[MAX_EVENTS] = {0};
+	// Log records are written by a separate thread from now on
+	logger_start();
+
+	// Create and start an IRC server on given port
+	Server *serv = Server_create(argv[optind]);
+	serv->peer_ping_interval_ms = ping_interval_ms;
+	serv->peer_max_missed_pings = max_missed_pings;
 
 	// Event for listener socket
 	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
 
 	CHECK(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev), "epoll_ctl");
 
+	if (admin_path && !Server_listen_admin(serv, admin_path))
+	{
+		return 1;
+	}
+
+	if (capture_path && !(serv->capture = Capture_open(capture_path)))
+	{
+		return 1;
+	}
+
 	// Setup signal handler to stop server
 	struct sigaction sa;
 	sigemptyset(&sa.sa_mask);
@@ -41,81 +100,29 @@ int main(int argc, char *argv[])
 	if (sigaction(SIGPIPE, &sa, NULL) == -1)
 		die("sigaction");
 
+	// SIGHUP is read from a signalfd in the event loop to reload the config
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGHUP);
+
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+		die("sigprocmask");
+
+	serv->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	CHECK(serv->signal_fd, "signalfd");
+
+	ev.data.fd = serv->signal_fd;
+	CHECK(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->signal_fd, &ev), "epoll_ctl");
+
 	// Run while g_alive flag is set
 	while (g_alive)
 	{
-		int num = epoll_wait(serv->epollfd, events, MAX_EVENTS, -1);
-
-		if (num == -1)
+		if (Server_poll(serv, EPOLL_TIMEOUT_MS) == -1)
 		{
 			perror("epoll_wait");
 			g_alive = false;
 			break;
 		}
-
-		for (int i = 0; i < num; i++)
-		{
-			if (events[i].data.fd == serv->fd)
-			{
-				Server_accept_all(serv);
-			}
-			else
-			{
-				int e = events[i].events;
-				int fd = events[i].data.fd;
-
-				Connection *connection = ht_get(serv->connections, &fd);
-
-				if (!connection)
-				{
-					epoll_ctl(serv->epollfd, EPOLL_CTL_DEL, fd, NULL);
-					continue;
-				}
-
-				if (e & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
-				{
-					Server_remove_connection(serv, connection);
-					continue;
-				}
-
-				if (e & EPOLLIN)
-				{
-					if (Connection_read(connection) == -1)
-					{
-						Server_remove_connection(serv, connection);
-						continue;
-					}
-
-					Server_process_request(serv, connection);
-				}
-
-				if (e & EPOLLOUT)
-				{
-					if (Connection_write(connection) == -1)
-					{
-						Server_remove_connection(serv, connection);
-						continue;
-					}
-				}
-
-				bool quit = connection->quit;
-
-				if(!quit && connection->conn_type == USER_CONNECTION) {
-					User *user = connection->data;
-					quit = user->quit;
-				} 
-				else if(!quit && connection->conn_type == PEER_CONNECTION) {
-					Peer *peer = connection->data;
-					quit = peer->quit;
-				}
-
-				if (quit && List_size(connection->outgoing_messages) == 0 && connection->res_len == 0)
-				{
-					Server_remove_connection(serv, connection);
-					continue;
-				}
-			}
-		}
 	}
 
 	Server_destroy(serv);
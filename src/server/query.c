@@ -0,0 +1,558 @@
+#include "include/replies.h"
+#include "include/server.h"
+
+/**
+ * Network-wide queries
+ *
+ * A query is fanned out along the spanning tree of peers:
+ *
+ * - `:<server> QUERY <id> <type> <ttl> [:<args>]` asks a peer to run the query
+ * on itself and on all servers behind it within ttl milliseconds.
+ * - `:<server> QREPLY <id> <key> :<row>` returns one aggregated row.
+ * - `:<server> QEND <id> <partial>` ends the results from a peer. The partial
+ * flag is set if some server behind the peer did not respond in time.
+ *
+ * Rows with the same key are merged at every hop, so each link carries at most
+ * one row per key.
+ */
+
+struct query_type_info_t {
+	const char *name;
+	void (*collect)(Server *serv, Query *query); /* add rows for this server */
+	char *(*merge)(const char *row, const char *other); /* combine two rows */
+	void (*deliver)(Server *serv, User *usr, Query *query); /* send result */
+};
+
+static void collect_servers(Server *serv, Query *query);
+static void deliver_servers(Server *serv, User *usr, Query *query);
+static void collect_list(Server *serv, Query *query);
+static char *merge_list(const char *row, const char *other);
+static void deliver_list(Server *serv, User *usr, Query *query);
+static void collect_who(Server *serv, Query *query);
+static void deliver_who(Server *serv, User *usr, Query *query);
+
+static const struct query_type_info_t query_types[] = {
+	[QUERY_SERVERS] = {"SERVERS", collect_servers, NULL, deliver_servers},
+	[QUERY_LIST] = {"LIST", collect_list, merge_list, deliver_list},
+	[QUERY_WHO] = {"WHO", collect_who, NULL, deliver_who},
+};
+
+static int query_type_from_name(const char *name) {
+	for (size_t i = 0; i < sizeof query_types / sizeof *query_types; i++) {
+		if (!strcmp(query_types[i].name, name)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static Query *Query_alloc(const char *id, int type, const char *args) {
+	Query *this = calloc(1, sizeof *this);
+	this->id = strdup(id);
+	this->type = type;
+	this->args = args ? strdup(args) : NULL;
+	this->reply_fd = -1;
+	this->pending = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	this->rows = ht_alloc(); /* Map<string, string> */
+	this->rows->value_free = free;
+	return this;
+}
+
+void Query_free(Query *this) {
+	ht_free(this->pending);
+
+	if (this->rows) {
+		ht_free(this->rows);
+	}
+
+	free(this->id);
+	free(this->args);
+	free(this->reply_peer);
+	free(this->reply_nick);
+	free(this);
+}
+
+/**
+ * Add a row to the query result. Takes ownership of the row.
+ * If a row with the same key exists, the two rows are merged.
+ */
+static void add_row(Query *query, const char *key, char *row) {
+	const struct query_type_info_t *info = query_types + query->type;
+	char *existing = ht_get(query->rows, key);
+
+	if (existing) {
+		if (!info->merge) {
+			free(row);
+			return;
+		}
+
+		char *merged = info->merge(existing, row);
+		free(row);
+		row = merged;
+	}
+
+	ht_set(query->rows, (void *)key, row);
+}
+
+/**
+ * Forward the query to every peer except the one it was received from.
+ * The peers are given less time than this server, so that their results
+ * arrive before our own deadline.
+ */
+static void fanout_query(Server *serv, Query *query, Peer *origin) {
+	long ttl =
+		(long)query->deadline - (long)get_time_ms() - QUERY_HOP_MARGIN_MS;
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->name_to_peer_map);
+	Peer *peer = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&peer)) {
+		if (!peer->registered || peer->quit ||
+			(origin && !strcmp(peer->name, origin->name)) ||
+			ht_contains(query->pending, peer->name)) {
+			continue;
+		}
+
+		if (ttl <= 0) {
+			// No time left to wait for another hop
+			query->partial = true;
+			continue;
+		}
+
+		char *message =
+			query->args
+				? Server_create_message(serv, "QUERY %s %s %ld :%s", query->id,
+										query_types[query->type].name, ttl,
+										query->args)
+				: Server_create_message(serv, "QUERY %s %s %ld", query->id,
+										query_types[query->type].name, ttl);
+		Server_queue_peer_message(serv, peer, message);
+		ht_set(query->pending, peer->name, NULL);
+	}
+}
+
+/**
+ * Find the local user who made the request, if they are still connected.
+ */
+static User *find_query_user(Server *serv, Query *query) {
+	Connection *conn = ht_get(serv->connections, &query->reply_fd);
+
+	if (!conn || conn->conn_type != USER_CONNECTION) {
+		return NULL;
+	}
+
+	User *usr = conn->data;
+
+	if (usr->quit || strcmp(usr->nick, query->reply_nick) != 0) {
+		return NULL;
+	}
+
+	return usr;
+}
+
+/**
+ * Send the aggregated rows to the requester and destroy the query.
+ */
+static void complete_query(Server *serv, Query *query) {
+	HashtableIter itr;
+	char *key = NULL;
+	char *row = NULL;
+
+	if (query->reply_peer) {
+		Peer *peer = ht_get(serv->name_to_peer_map, query->reply_peer);
+
+		if (peer && peer->registered && !peer->quit) {
+			ht_iter_init(&itr, query->rows);
+			while (ht_iter_next(&itr, (void **)&key, (void **)&row)) {
+				Server_queue_peer_message(
+					serv, peer,
+					Server_create_message(serv, "QREPLY %s %s :%s", query->id,
+										  key, row));
+			}
+
+			Server_queue_peer_message(
+				serv, peer,
+				Server_create_message(serv, "QEND %s %d", query->id,
+									  query->partial));
+		}
+	} else {
+		User *usr = find_query_user(serv, query);
+
+		if (usr) {
+			if (query->partial) {
+				List_push_back(
+					usr->msg_queue,
+					Server_create_message(
+						serv, "NOTICE %s :Partial results: some servers did "
+							  "not respond in time",
+						usr->nick));
+			}
+
+			query_types[query->type].deliver(serv, usr, query);
+		}
+	}
+
+	log_debug("query %s completed with %zu rows", query->id,
+			  ht_size(query->rows));
+	ht_remove(serv->queries, query->id, NULL, NULL);
+}
+
+/**
+ * Start a network-wide query on behalf of a local user.
+ * The result is sent to the user when all servers have responded or the
+ * deadline has passed.
+ */
+void Server_start_query(Server *serv, User *usr, int type, const char *args) {
+	char *id = make_string("%s.%lu", serv->name, ++serv->query_seq);
+
+	Query *query = Query_alloc(id, type, args);
+	query->reply_nick = strdup(usr->nick);
+	query->reply_fd = usr->fd;
+	query->deadline = get_time_ms() + QUERY_TIMEOUT_MS;
+
+	query_types[type].collect(serv, query);
+	fanout_query(serv, query, NULL);
+	ht_set(serv->queries, id, query);
+	free(id);
+
+	if (ht_size(query->pending) == 0) {
+		complete_query(serv, query);
+	}
+}
+
+/**
+ * Command: QUERY
+ * Parameters: <id> <type> <ttl> [:<args>]
+ *
+ * Run the query on this server and on the servers behind it.
+ */
+void Server_handle_peer_QUERY(Server *serv, Peer *peer, Message *msg) {
+	assert(!strcmp(msg->command, "QUERY"));
+
+	if (msg->n_params < 3) {
+		return;
+	}
+
+	char *id = msg->params[0];
+	int type = query_type_from_name(msg->params[1]);
+
+	if (type == -1 || ht_contains(serv->queries, id)) {
+		// Answer with an empty result so that the peer does not wait for us
+		log_warn("ignored query %s of type %s", id, msg->params[1]);
+		Server_queue_peer_message(
+			serv, peer, Server_create_message(serv, "QEND %s %d", id, 0));
+		return;
+	}
+
+	Query *query = Query_alloc(id, type, msg->body);
+	query->reply_peer = strdup(peer->name);
+	query->deadline = get_time_ms() + MAX(atol(msg->params[2]), 0);
+
+	query_types[type].collect(serv, query);
+	fanout_query(serv, query, peer);
+	ht_set(serv->queries, id, query);
+
+	if (ht_size(query->pending) == 0) {
+		complete_query(serv, query);
+	}
+}
+
+/**
+ * Command: QREPLY
+ * Parameters: <id> <key> :<row>
+ */
+void Server_handle_peer_QREPLY(Server *serv, Peer *peer, Message *msg) {
+	assert(!strcmp(msg->command, "QREPLY"));
+
+	if (msg->n_params < 2) {
+		return;
+	}
+
+	Query *query = ht_get(serv->queries, msg->params[0]);
+
+	if (!query || !ht_contains(query->pending, peer->name)) {
+		return;
+	}
+
+	add_row(query, msg->params[1], strdup(msg->body ? msg->body : ""));
+}
+
+/**
+ * Command: QEND
+ * Parameters: <id> <partial>
+ */
+void Server_handle_peer_QEND(Server *serv, Peer *peer, Message *msg) {
+	assert(!strcmp(msg->command, "QEND"));
+
+	if (msg->n_params < 1) {
+		return;
+	}
+
+	Query *query = ht_get(serv->queries, msg->params[0]);
+
+	if (!query || !ht_remove(query->pending, peer->name, NULL, NULL)) {
+		return;
+	}
+
+	if (msg->n_params > 1 && atoi(msg->params[1])) {
+		query->partial = true;
+	}
+
+	if (ht_size(query->pending) == 0) {
+		complete_query(serv, query);
+	}
+}
+
+/**
+ * Send partial results for all queries which have passed their deadline.
+ */
+void Server_check_queries(Server *serv) {
+	uint64_t now = get_time_ms();
+	Vector *expired = Vector_alloc(4, NULL, NULL);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->queries);
+	Query *query = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&query)) {
+		if (query->deadline <= now) {
+			Vector_push(expired, query);
+		}
+	}
+
+	for (size_t i = 0; i < Vector_size(expired); i++) {
+		query = Vector_get_at(expired, i);
+		log_warn("query %s timed out waiting for %zu peers", query->id,
+				 ht_size(query->pending));
+		query->partial = true;
+		complete_query(serv, query);
+	}
+
+	Vector_free(expired);
+}
+
+/**
+ * Stop waiting for results from a peer which has left the network.
+ */
+void Server_remove_peer_from_queries(Server *serv, Peer *peer) {
+	Vector *done = Vector_alloc(4, NULL, NULL);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->queries);
+	Query *query = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&query)) {
+		if (ht_remove(query->pending, peer->name, NULL, NULL)) {
+			query->partial = true;
+
+			if (ht_size(query->pending) == 0) {
+				Vector_push(done, query);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < Vector_size(done); i++) {
+		complete_query(serv, Vector_get_at(done, i));
+	}
+
+	Vector_free(done);
+}
+
+/**
+ * SERVERS: The names of all servers in the network.
+ */
+static void collect_servers(Server *serv, Query *query) {
+	add_row(query, serv->name, strdup(serv->name));
+}
+
+static void deliver_servers(Server *serv, User *usr, Query *query) {
+	HashtableIter itr;
+	ht_iter_init(&itr, query->rows);
+	char *name = NULL;
+
+	while (ht_iter_next(&itr, (void **)&name, NULL)) {
+		if (strcmp(name, serv->name) != 0) {
+			List_push_back(usr->msg_queue,
+						   Server_create_message(serv, "901 %s :%s", usr->nick,
+												 name));  // RPL_TEST_LIST_SERVER
+		}
+	}
+
+	List_push_back(usr->msg_queue,
+				   Server_create_message(serv, "902 %s :End of TEST_LIST_SERVER",
+										 usr->nick));
+}
+
+/**
+ * LIST: Rows are keyed by channel name and contain the number of members and
+ * the topic. Member counts of a channel are added up across servers.
+ */
+static void add_list_row(Query *query, Channel *channel) {
+	add_row(query, channel->name,
+			make_string("%zu %s", ht_size(channel->members),
+						channel->topic ? channel->topic : ""));
+}
+
+static void collect_list(Server *serv, Query *query) {
+	// The local channels of a local user's LIST are streamed by deliver_list()
+	if (!query->args && !query->reply_peer) {
+		return;
+	}
+
+	if (!query->args) {
+		HashtableIter itr;
+		ht_iter_init(&itr, serv->name_to_channel_map);
+		Channel *channel = NULL;
+
+		while (ht_iter_next(&itr, NULL, (void **)&channel)) {
+			add_list_row(query, channel);
+		}
+
+		return;
+	}
+
+	// Named channels or channels meeting the conditions of ELIST
+	Vector *channels = Server_find_channels(serv, query->args);
+
+	for (size_t i = 0; i < Vector_size(channels); i++) {
+		add_list_row(query, Vector_get_at(channels, i));
+	}
+
+	Vector_free(channels);
+}
+
+/**
+ * Split LIST row into member count and topic.
+ */
+long parse_list_row(const char *row, const char **topic) {
+	char *end = NULL;
+	long count = strtol(row, &end, 10);
+	*topic = *end == ' ' ? end + 1 : end;
+	return count;
+}
+
+static char *merge_list(const char *row, const char *other) {
+	const char *topic = NULL;
+	const char *other_topic = NULL;
+	long count = parse_list_row(row, &topic);
+	long other_count = parse_list_row(other, &other_topic);
+
+	return make_string("%ld %s", count + other_count,
+					   *topic ? topic : other_topic);
+}
+
+static void deliver_list(Server *serv, User *usr, Query *query) {
+	if (!query->args) {
+		Server_start_stream(serv, usr, STREAM_LIST, query->rows);
+		query->rows = NULL;
+		return;
+	}
+
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_LISTSTART, usr->nick));
+
+	HashtableIter itr;
+	ht_iter_init(&itr, query->rows);
+	char *name = NULL;
+	char *row = NULL;
+
+	while (ht_iter_next(&itr, (void **)&name, (void **)&row)) {
+		const char *topic = NULL;
+		long count = parse_list_row(row, &topic);
+		List_push_back(usr->msg_queue,
+					   Server_create_reply(serv, RPL_LIST, usr->nick,
+											 name, count, topic));
+	}
+
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_LISTEND, usr->nick));
+}
+
+/**
+ * WHO: Rows are keyed by nick and channel and contain the fields of
+ * RPL_WHOREPLY: <channel> <username> <host> <server> <nick> <realname>
+ */
+static void add_who_row(Server *serv, Query *query, Channel *channel,
+						User *member) {
+	char *key = make_string("%s/%s", member->nick, channel->name);
+	add_row(query, key,
+			make_string("%s %s %s %s %s %s", channel->name, member->username,
+						member->hostname, serv->hostname, member->nick,
+						member->realname));
+	free(key);
+}
+
+static void collect_who(Server *serv, Query *query) {
+	char *masks = strdup(query->args ? query->args : "");
+	char *saveptr = NULL;
+
+	for (char *mask = strtok_r(masks, ",", &saveptr); mask != NULL;
+		 mask = strtok_r(NULL, ",", &saveptr)) {
+		if (mask[0] == '#') {
+			// Return who reply for each user in channel
+			Channel *channel = ht_get(serv->name_to_channel_map, mask + 1);
+
+			if (!channel) {
+				continue;
+			}
+
+			HashtableIter itr;
+			ht_iter_init(&itr, channel->members);
+			User *member = NULL;
+			while (ht_iter_next(&itr, NULL, (void **)&member)) {
+				add_who_row(serv, query, channel, member);
+			}
+		} else {
+			User *other_user = ht_get(serv->nick_to_user_map, mask);
+
+			if (!other_user) {
+				continue;
+			}
+
+			// Return who reply for channel given user is member of
+			for (size_t i = 0; i < Vector_size(other_user->channels); i++) {
+				Channel *channel =
+					ht_get(serv->name_to_channel_map,
+						   Vector_get_at(other_user->channels, i));
+				if (channel) {
+					add_who_row(serv, query, channel, other_user);
+				}
+			}
+		}
+	}
+
+	free(masks);
+}
+
+static void deliver_who(Server *serv, User *usr, Query *query) {
+	HashtableIter itr;
+	ht_iter_init(&itr, query->rows);
+	char *row = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&row)) {
+		char *fields = strdup(row);
+		char *saveptr = NULL;
+		char *channel = strtok_r(fields, " ", &saveptr);
+		char *username = strtok_r(NULL, " ", &saveptr);
+		char *host = strtok_r(NULL, " ", &saveptr);
+		char *server = strtok_r(NULL, " ", &saveptr);
+		char *nick = strtok_r(NULL, " ", &saveptr);
+		char *realname = strtok_r(NULL, "", &saveptr);
+
+		if (nick) {
+			List_push_back(usr->msg_queue,
+						   Server_create_reply(
+							   serv, RPL_WHOREPLY, usr->nick, channel,
+							   username, host, server, nick, "H", 0,
+							   realname ? realname : ""));
+		}
+
+		free(fields);
+	}
+
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_ENDOFWHO, usr->nick,
+										 query->args ? query->args : ""));
+}
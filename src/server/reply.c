@@ -13,63 +13,29 @@ bool check_registered(Server *serv, User *usr) {
 	if (!usr->registered) {
 		List_push_back(
 			usr->msg_queue,
-			Server_create_message(serv, ERR_NOTREGISTERED_MSG, usr->nick));
+			Server_create_reply(serv, ERR_NOTREGISTERED, usr->nick));
 		return false;
 	}
 
 	return true;
 }
 
-/**
- * <client> <channel> <username> <host> <server> <nick> <flags> :<hopcount>
- * <realname>
- */
-void send_who_reply(Server *serv, User *usr, Channel *target_channel,
-					User *target_usr) {
-	List_push_back(
-		usr->msg_queue,
-		Server_create_message(serv, RPL_WHOREPLY_MSG, usr->nick,
-							  target_channel->name, target_usr->username,
-							  target_usr->hostname, serv->hostname,
-							  target_usr->nick, "H", 0, target_usr->realname));
-}
-
 void send_motd_reply(Server *serv, User *usr) {
-	char *motd = serv->motd_file ? get_motd(serv->motd_file) : NULL;
-
-	if (motd) {
-		List_push_back(usr->msg_queue, Server_create_message(serv, RPL_MOTD_MSG,
-															 usr->nick, motd));
-	} else {
-		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NOMOTD_MSG, usr->nick));
-	}
-
-	free(motd);
+	Catalog_send_motd(serv->catalog, usr);
 }
 
 void send_welcome_reply(Server *serv, User *usr) {
-	List_push_back(usr->msg_queue, Server_create_message(serv, RPL_WELCOME_MSG,
-														 usr->nick, usr->nick));
-	List_push_back(usr->msg_queue,
-				   Server_create_message(serv, RPL_YOURHOST_MSG, usr->nick,
-										 usr->hostname));
-	List_push_back(usr->msg_queue,
-				   Server_create_message(serv, RPL_CREATED_MSG, usr->nick,
-										 serv->created_at));
-	List_push_back(usr->msg_queue,
-				   Server_create_message(serv, RPL_MYINFO_MSG, usr->nick,
-										 serv->hostname, "*", "*", "*"));
+	Catalog_send(serv->catalog->welcome, usr);
 }
 
 void send_topic_reply(Server *serv, User *usr, Channel *channel) {
 	if (channel->topic) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, RPL_TOPIC_MSG, usr->nick,
+					   Server_create_reply(serv, RPL_TOPIC, usr->nick,
 											 channel->name, channel->topic));
 	} else {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, RPL_NOTOPIC_MSG, usr->nick,
+					   Server_create_reply(serv, RPL_NOTOPIC, usr->nick,
 											 channel->name));
 	}
 }
@@ -84,6 +50,8 @@ bool check_user_registration(Server *serv, User *usr) {
 
 		ht_set(serv->nick_to_user_map, usr->nick, usr);
 		ht_set(serv->nick_to_serv_name_map, usr->nick, serv->name);
+		serv->max_local_users =
+			MAX(serv->max_local_users, ht_size(serv->nick_to_user_map));
 
 		send_welcome_reply(serv, usr);
 		send_motd_reply(serv, usr);
@@ -107,11 +75,13 @@ bool check_user_registration(Server *serv, User *usr) {
  * Send RPL_NAMES as multipart message
  */
 void send_names_reply(Server *serv, User *usr, Channel *channel) {
-	char *subject = make_string(":%s " RPL_NAMREPLY_MSG, serv->name, usr->nick,
-								"=", channel->name);
-	char message[MAX_MSG_LEN + 1];
-	memset(message, 0, sizeof message);
-	strcat(message, subject);
+	MsgBuf message;
+	msgbuf_init(&message);
+	msgbuf_add_char(&message, ':');
+	msgbuf_add_string(&message, serv->name);
+	msgbuf_add_char(&message, ' ');
+	msgbuf_add_RPL_NAMREPLY(&message, usr->nick, "=", channel->name);
+	size_t subject_len = message.len;
 
 	// Get channel members
 	HashtableIter itr;
@@ -121,24 +91,26 @@ void send_names_reply(Server *serv, User *usr, Channel *channel) {
 		const char *username = member->username;
 		size_t len = strlen(username) + 1;	// Length for name and space
 
-		if (strlen(message) + len > MAX_MSG_LEN) {
+		// Leave space for \r\n
+		if (message.len + len > MAX_MSG_LEN - 2) {
 			// End current message
-			List_push_back(usr->msg_queue, make_string("%s\r\n", message));
+			msgbuf_add_crlf(&message);
+			List_push_back(usr->msg_queue, msgbuf_to_string(&message));
 
 			// Start new message with subject
-			memset(message, 0, sizeof message);
-			strcat(message, subject);
+			msgbuf_truncate(&message, subject_len);
 		}
 		// Append username and space to message
-		strcat(message, username);
-		strcat(message, " ");
+		msgbuf_add_string(&message, username);
+		msgbuf_add_char(&message, ' ');
 	}
 
-	List_push_back(usr->msg_queue, make_string("%s\r\n", message));
+	msgbuf_add_crlf(&message);
+	List_push_back(usr->msg_queue, msgbuf_to_string(&message));
 	List_push_back(usr->msg_queue,
-				   Server_create_message(serv, RPL_ENDOFNAMES_MSG, usr->nick,
+				   Server_create_reply(serv, RPL_ENDOFNAMES, usr->nick,
 										 channel->name));
-	free(subject);
+	msgbuf_destroy(&message);
 }
 
 /**
@@ -159,7 +131,7 @@ void Server_handle_NICK(Server *serv, User *usr, Message *msg) {
 
 	if (msg->n_params < 1) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NEEDMOREPARAMS_MSG,
+					   Server_create_reply(serv, ERR_NEEDMOREPARAMS,
 											 usr->nick, msg->command));
 		return;
 	}
@@ -177,7 +149,7 @@ void Server_handle_NICK(Server *serv, User *usr, Message *msg) {
 		ht_contains(serv->nick_to_serv_name_map, new_nick)) {
 		List_push_back(
 			usr->msg_queue,
-			Server_create_message(serv, ERR_NICKNAMEINUSE_MSG, msg->params[0]));
+			Server_create_reply(serv, ERR_NICKNAMEINUSE, msg->params[0]));
 		return;
 	}
 
@@ -193,6 +165,7 @@ void Server_handle_NICK(Server *serv, User *usr, Message *msg) {
 
 	usr->nick = strdup(new_nick);
 	usr->nick_changed = true;
+	User_update_prefix(usr);
 
 	log_info("user %s updated nick", usr->nick);
 
@@ -221,7 +194,7 @@ void Server_handle_USER(Server *serv, User *usr, Message *msg) {
 
 	if (msg->n_params < 3 || !msg->body) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NEEDMOREPARAMS_MSG,
+					   Server_create_reply(serv, ERR_NEEDMOREPARAMS,
 											 usr->nick, msg->command));
 		return;
 	}
@@ -229,7 +202,7 @@ void Server_handle_USER(Server *serv, User *usr, Message *msg) {
 	if (usr->registered) {
 		List_push_back(
 			usr->msg_queue,
-			Server_create_message(serv, ERR_ALREADYREGISTRED_MSG, usr->nick));
+			Server_create_reply(serv, ERR_ALREADYREGISTRED, usr->nick));
 		return;
 	}
 
@@ -241,6 +214,7 @@ void Server_handle_USER(Server *serv, User *usr, Message *msg) {
 
 	usr->username = strdup(username);
 	usr->realname = strdup(realname);
+	User_update_prefix(usr);
 
 	log_debug("user %s set username to %s and realname to %s", usr->nick,
 			  username, realname);
@@ -249,21 +223,9 @@ void Server_handle_USER(Server *serv, User *usr, Message *msg) {
 
 void Server_handle_MOTD(Server *serv, User *usr, Message *msg) {
 	assert(!strcmp(msg->command, "MOTD"));
-	List_push_back(
-		usr->msg_queue,
-		Server_create_message(serv, "375 %s :- %s Message of the day - ",
-							  usr->nick, serv->name));
-
-	char *motd = serv->motd_file ? get_motd(serv->motd_file) : NULL;
-
-	if (motd) {
-		List_push_back(usr->msg_queue, Server_create_message(serv, RPL_MOTD_MSG,
-															 usr->nick, motd));
-		free(motd);
-	} else {
-		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NOMOTD_MSG, usr->nick));
-	}
+	List_push_back(usr->msg_queue,
+				   CatalogLine_render(serv->catalog->motd_start, usr->nick));
+	Catalog_send_motd(serv->catalog, usr);
 }
 
 /**
@@ -283,37 +245,38 @@ void Server_handle_PRIVMSG(Server *serv, User *usr, Message *msg) {
 	if (msg->n_params == 0) {
 		List_push_back(
 			usr->msg_queue,
-			Server_create_message(serv, ERR_NORECIPIENT_MSG, usr->nick));
+			Server_create_reply(serv, ERR_NORECIPIENT, usr->nick));
 		return;
 	}
 
 	const char *target = msg->params[0];
 	assert(target);
 
-	char *message = User_create_message(usr, "%s", msg->message);
+	char *message = User_prefix_message(usr, msg->message);
 
 	if (target[0] == '#') {
 		Channel *channel = ht_get(serv->name_to_channel_map, target + 1);
 
 		if (!channel) {
 			List_push_back(usr->msg_queue,
-						   Server_create_message(serv, ERR_NOSUCHCHANNEL_MSG,
+						   Server_create_reply(serv, ERR_NOSUCHCHANNEL,
 												 usr->nick, target));
 			return;
 		}
 
 		if (!Channel_has_member(channel, usr)) {
 			List_push_back(usr->msg_queue,
-						   Server_create_message(serv, ERR_CANNOTSENDTOCHAN_MSG,
+						   Server_create_reply(serv, ERR_CANNOTSENDTOCHAN,
 												 usr->nick, target));
 			return;
 		}
 
 		Server_message_channel(serv, serv->name, target + 1, message);
+		Server_add_history(serv, channel, message);
 	} else {
 		if (!ht_get(serv->nick_to_serv_name_map, target)) {
 			List_push_back(usr->msg_queue,
-						   Server_create_message(serv, ERR_NOSUCHNICK_MSG,
+						   Server_create_reply(serv, ERR_NOSUCHNICK,
 												 usr->nick, target));
 			return;
 		}
@@ -352,6 +315,9 @@ void Server_handle_QUIT(Server *serv, User *usr, Message *msg) {
  * This command is used to query a list of users who match the provided mask.
  * The server will answer this command with zero, one or more RPL_WHOREPLY, and
  * end the list with RPL_ENDOFWHO.
+ *
+ * The mask is a comma separated list of channels and nicks. The query is run
+ * on every server in the network.
  */
 void Server_handle_WHO(Server *serv, User *usr, Message *msg) {
 	assert(!strcmp(msg->command, "WHO"));
@@ -359,46 +325,11 @@ void Server_handle_WHO(Server *serv, User *usr, Message *msg) {
 	if (msg->n_params == 0) {
 		List_push_back(
 			usr->msg_queue,
-			Server_create_message(serv, RPL_ENDOFWHO_MSG, usr->nick, ""));
+			Server_create_reply(serv, RPL_ENDOFWHO, usr->nick, ""));
 		return;
 	}
 
-	char *mask = msg->params[0];
-	assert(mask);
-	char *tok = strtok(mask, ",");
-
-	while (tok) {
-		if (mask[0] == '#') {
-			if (ht_contains(serv->name_to_channel_map, mask + 1)) {
-				// Return who reply for each user in channel
-				Channel *channel = ht_get(serv->name_to_channel_map, mask + 1);
-				HashtableIter itr;
-				ht_iter_init(&itr, channel->members);
-				User *member = NULL;
-				while (ht_iter_next(&itr, NULL, (void **)&member)) {
-					send_who_reply(serv, usr, channel, member);
-				}
-			}
-		} else {
-			User *other_user = ht_get(serv->nick_to_user_map, mask);
-
-			// Return who reply for channel given user is member of
-			if (other_user) {
-				for (size_t i = 0; i < Vector_size(other_user->channels); i++) {
-					Channel *channel =
-						ht_get(serv->name_to_channel_map,
-							   Vector_get_at(other_user->channels, i));
-					if (channel) {
-						send_who_reply(serv, usr, channel, other_user);
-					}
-				}
-			}
-		}
-		tok = strtok(NULL, ",");
-	}
-
-	List_push_back(usr->msg_queue, Server_create_message(serv, RPL_ENDOFWHO_MSG,
-														 usr->nick, ""));
+	Server_start_query(serv, usr, QUERY_WHO, msg->params[0]);
 }
 
 /**
@@ -418,7 +349,7 @@ void Server_handle_JOIN(Server *serv, User *usr, Message *msg) {
 
 	if (Vector_size(usr->channels) > MAX_CHANNEL_COUNT) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_TOOMANYCHANNELS_MSG,
+					   Server_create_reply(serv, ERR_TOOMANYCHANNELS,
 											 usr->nick, channel_name));
 		return;
 	}
@@ -428,7 +359,9 @@ void Server_handle_JOIN(Server *serv, User *usr, Message *msg) {
 	if (!channel) {
 		// Create channel
 		channel = Channel_alloc(channel_name);
-		ht_set(serv->name_to_channel_map, channel_name, channel);
+		Server_add_channel(serv, channel);
+		hll_add(&serv->channel_sketch, channel_name);
+		Journal_add_channel(serv->journal, channel);
 		log_info("New channel %s created by user %s", channel_name, usr->nick);
 	}
 
@@ -437,7 +370,7 @@ void Server_handle_JOIN(Server *serv, User *usr, Message *msg) {
 	User_add_channel(usr, channel->name);
 
 	// Broadcast JOIN to every client on channel
-	char *join_message = User_create_message(usr, "%s", msg->message);
+	char *join_message = User_prefix_message(usr, msg->message);
 	Server_message_channel(serv, serv->name, channel_name, join_message);
 	free(join_message);
 
@@ -450,52 +383,14 @@ void Server_handle_JOIN(Server *serv, User *usr, Message *msg) {
  * information about each channel. Both parameters to this command are optional
  * as they have different syntaxes.
  *
+ * The channels of every server in the network are listed, and the member
+ * counts of a channel are added up across servers.
  */
 void Server_handle_LIST(Server *serv, User *usr, Message *msg) {
 	assert(!strcmp(msg->command, "LIST"));
 
-	List_push_back(usr->msg_queue,
-				   Server_create_message(serv, RPL_LISTSTART_MSG, usr->nick));
-
-	if (msg->n_params == 0)	 // List all channels
-	{
-		HashtableIter itr;
-		ht_iter_init(&itr, serv->name_to_channel_map);
-		Channel *channel = NULL;
-		while (ht_iter_next(&itr, NULL, (void **)&channel)) {
-			assert(channel);
-			List_push_back(usr->msg_queue,
-						   Server_create_message(
-							   serv, RPL_LIST_MSG, usr->nick, channel->name,
-							   ht_size(channel->members), channel->topic));
-		}
-	} else	// List specified channels
-	{
-		char *targets = msg->params[0];
-		assert(targets);
-		// get channel names separated by commas
-		char *tok = strtok(targets, ",");
-		while (tok) {
-			if (tok[0] != '#') {
-				continue;
-			}
-
-			char *target = tok + 1;
-
-			if (ht_contains(serv->name_to_channel_map, target)) {
-				Channel *channel = ht_get(serv->name_to_channel_map, target);
-				List_push_back(usr->msg_queue,
-							   Server_create_message(
-								   serv, RPL_LIST_MSG, usr->nick, channel->name,
-								   ht_size(channel->members), channel->topic));
-			}
-
-			tok = strtok(NULL, ",");
-		}
-	}
-
-	List_push_back(usr->msg_queue,
-				   Server_create_message(serv, RPL_LISTEND_MSG, usr->nick));
+	Server_start_query(serv, usr, QUERY_LIST,
+					   msg->n_params > 0 ? msg->params[0] : NULL);
 }
 
 /**
@@ -510,15 +405,9 @@ void Server_handle_NAMES(Server *serv, User *usr, Message *msg) {
 		return;
 	}
 
-	// send reply for all channels on server
+	// send reply for all channels on server as the user reads it
 	if (msg->n_params == 0) {
-		HashtableIter itr;
-		ht_iter_init(&itr, serv->name_to_channel_map);
-		Channel *channel = NULL;
-		while (ht_iter_next(&itr, NULL, (void **)&channel)) {
-			send_names_reply(serv, usr, channel);
-		}
-
+		Server_start_stream(serv, usr, STREAM_NAMES, NULL);
 		return;
 	}
 
@@ -555,7 +444,7 @@ void Server_handle_TOPIC(Server *serv, User *usr, Message *msg) {
 
 	if (msg->n_params == 0) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NEEDMOREPARAMS_MSG,
+					   Server_create_reply(serv, ERR_NEEDMOREPARAMS,
 											 usr->nick, msg->command));
 		return;
 	}
@@ -569,7 +458,7 @@ void Server_handle_TOPIC(Server *serv, User *usr, Message *msg) {
 	if (*msg->params[0] != '#' ||
 		!(channel = ht_get(serv->name_to_channel_map, channel_name))) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NOSUCHCHANNEL_MSG,
+					   Server_create_reply(serv, ERR_NOSUCHCHANNEL,
 											 usr->nick, msg->params[0]));
 		return;
 	}
@@ -577,7 +466,9 @@ void Server_handle_TOPIC(Server *serv, User *usr, Message *msg) {
 	assert(channel);
 
 	if (msg->body) {
-		channel->topic = strdup(msg->body);
+		Channel_set_topic(channel, msg->body);
+		Channel_set_topic_time(channel, time(NULL));
+		Journal_set_topic(serv->journal, channel);
 		log_info("user %s set topic for channel %s", usr->nick, channel->name);
 	} else {
 		send_topic_reply(serv, usr, channel);
@@ -596,7 +487,7 @@ void Server_handle_PART(Server *serv, User *usr, Message *msg) {
 
 	if (msg->n_params == 0) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NEEDMOREPARAMS_MSG,
+					   Server_create_reply(serv, ERR_NEEDMOREPARAMS,
 											 usr->nick, msg->command));
 		return;
 	}
@@ -608,14 +499,14 @@ void Server_handle_PART(Server *serv, User *usr, Message *msg) {
 	if (*msg->params[0] != '#' ||
 		!(channel = ht_get(serv->name_to_channel_map, channel_name))) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NOSUCHCHANNEL_MSG,
+					   Server_create_reply(serv, ERR_NOSUCHCHANNEL,
 											 usr->nick, msg->params[0]));
 		return;
 	}
 
 	if (!Channel_has_member(channel, usr)) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NOTONCHANNEL_MSG,
+					   Server_create_reply(serv, ERR_NOTONCHANNEL,
 											 usr->nick, channel->name));
 		return;
 	}
@@ -638,45 +529,52 @@ void Server_handle_PART(Server *serv, User *usr, Message *msg) {
 
 	if (ht_size(channel->members) == 0) {
 		log_info("removing channel %s from server", channel->name);
-		ht_remove(serv->name_to_channel_map, channel->name, NULL, NULL);
+		Journal_remove_channel(serv->journal, channel->name);
+		History_remove_channel(serv->history, channel);
+		Server_remove_channel(serv, channel);
+		serv->channel_sketch_stale = true;
 	}
 }
 
 /**
  * Returns statistics about local and global users, as numeric replies.
- *
- * TODO: Implement this
+ * The global statistics are computed from the summaries gossiped by the other
+ * servers, so this does not depend on the size of the network.
  */
 void Server_handle_LUSERS(Server *serv, User *usr, Message *msg) {
 	assert(!strcmp(msg->command, "LUSERS"));
 
-	// List_push_back(usr->msg_queue, make_reply(":%s "
-	// RPL_LUSERCLIENT_MSG,
-	// serv->hostname,
-	// usr->nick,
-	// ht_size(serv->username_to_user_map),
-	// 0, 1));
-
-	// List_push_back(usr->msg_queue, make_reply(":%s " RPL_LUSEROP_MSG,
-	// serv->hostname,
-	// usr->nick, 0));
-
-	// List_push_back(usr->msg_queue, make_reply(":%s "
-	// RPL_LUSERUNKNOWN_MSG,
-	// serv->hostname,
-	// usr->nick, 0));
-
-	// List_push_back(usr->msg_queue, make_reply(":%s "
-	// RPL_LUSERCHANNELS_MSG,
-	// serv->hostname,
-	// usr->nick,
-	// ht_size(serv->name_to_channel_map)));
-
-	// List_push_back(usr->msg_queue, make_reply(":%s " RPL_LUSERME_MSG,
-	// serv->hostname,
-	// usr->nick,
-	// ht_size(serv->username_to_user_map),
-	// 0, 0));
+	size_t local_users = ht_size(serv->nick_to_user_map);
+	unsigned long global_users = Server_count_global_users(serv);
+	serv->max_global_users = MAX(serv->max_global_users, global_users);
+
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_LUSERCLIENT, usr->nick,
+										 (long)global_users, 0L,
+										 (long)ht_size(serv->name_to_peer_map) + 1));
+	List_push_back(usr->msg_queue, Server_create_reply(serv, RPL_LUSEROP,
+														 usr->nick, 0UL));
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_LUSERUNKNOWN, usr->nick,
+										 (unsigned long)serv->n_unknown));
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_LUSERCHANNELS, usr->nick,
+										 Server_estimate_global_channels(serv)));
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_LUSERME, usr->nick,
+										 (unsigned long)local_users, 0UL,
+										 (unsigned long)serv->n_peers));
+	List_push_back(
+		usr->msg_queue,
+		Server_create_reply(serv, RPL_LOCALUSERS, usr->nick,
+							  (unsigned long)local_users,
+							  (unsigned long)serv->max_local_users,
+							  (unsigned long)local_users,
+							  (unsigned long)serv->max_local_users));
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_NETUSERS, usr->nick,
+										 global_users, serv->max_global_users,
+										 global_users, serv->max_global_users));
 }
 
 /**
@@ -686,41 +584,17 @@ void Server_handle_LUSERS(Server *serv, User *usr, Message *msg) {
 void Server_handle_HELP(Server *serv, User *usr, Message *msg) {
 	assert(!strcmp(msg->command, "HELP"));
 
-	const struct help_t *help = NULL;
-	const char *subject = NULL;
+	const char *subject = "*";
 
-	if (msg->n_params == 0 && !msg->body) {
-		subject = "*";
-		help = get_help_text("HELP");
-	} else {
+	if (msg->n_params > 0 || msg->body) {
 		subject = msg->n_params > 0 ? msg->params[0] : msg->body;
-		help = get_help_text(subject);
 	}
 
-	if (help) {
-		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, "704 %s %s :%s", usr->nick,
-											 subject, help->title));
-		List_push_back(
-			usr->msg_queue,
-			Server_create_message(serv, "705 %s %s :", usr->nick, subject));
-
-		// Send help text as multipart messages and break long lines into
-		// multiple messages.
-		Vector *lines = text_wrap(help->body, 200);
+	// Help text is wrapped into multiple lines when the catalog is built
+	Vector *lines = ht_get(serv->catalog->help, subject);
 
-		for (size_t i = 0; i < Vector_size(lines); i++) {
-			List_push_back(
-				usr->msg_queue,
-				Server_create_message(serv, "705 %s %s :%s", usr->nick, subject,
-									  Vector_get_at(lines, i)));
-		}
-
-		Vector_free(lines);
-
-		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, "706 %s %s :End of help",
-											 usr->nick, subject));
+	if (lines) {
+		Catalog_send(lines, usr);
 		return;
 	}
 
@@ -753,11 +627,16 @@ void Server_handle_NOTICE(Server *serv, User *usr, Message *msg) {
 	}
 
 	char *target = strtok(targets, ",");
-	char *message = User_create_message(usr, "%s", msg->message);
+	char *message = User_prefix_message(usr, msg->message);
 
 	while (target) {
 		if (target[0] == '#') {
 			Server_message_channel(serv, serv->name, target + 1, message);
+			Channel *channel = ht_get(serv->name_to_channel_map, target + 1);
+
+			if (channel) {
+				Server_add_history(serv, channel, message);
+			}
 		} else {
 			Server_message_user(serv, serv->name, target, message);
 		}
@@ -770,12 +649,150 @@ void Server_handle_NOTICE(Server *serv, User *usr, Message *msg) {
 
 void Server_handle_INFO(Server *serv, User *usr, Message *msg) {
 	assert(!strcmp(msg->command, "INFO"));
-	List_push_back(
-		usr->msg_queue,
-		Server_create_message(serv, "371 %s :%s", usr->nick, serv->info));
-	List_push_back(
-		usr->msg_queue,
-		Server_create_message(serv, "374 %s :End of INFO list", usr->nick));
+	Catalog_send(serv->catalog->info, usr);
+}
+
+/**
+ * Parse a CHATHISTORY reference of the form timestamp=YYYY-MM-DDThh:mm:ss.sssZ
+ * into milliseconds since the epoch.
+ */
+static bool parse_timestamp(const char *reference, uint64_t *time_ms) {
+	const char *prefix = "timestamp=";
+
+	if (strncmp(reference, prefix, strlen(prefix)) != 0) {
+		return false;
+	}
+
+	struct tm tm;
+	memset(&tm, 0, sizeof tm);
+	const char *end =
+		strptime(reference + strlen(prefix), "%Y-%m-%dT%H:%M:%S", &tm);
+
+	if (!end) {
+		return false;
+	}
+
+	unsigned long ms = 0;
+
+	if (*end == '.') {
+		char *ms_end = NULL;
+		ms = strtoul(end + 1, &ms_end, 10);
+		end = ms_end;
+	}
+
+	if (strcmp(end, "Z") != 0 || ms > 999) {
+		return false;
+	}
+
+	*time_ms = (uint64_t)timegm(&tm) * 1000 + ms;
+	return true;
+}
+
+/**
+ * Command: CHATHISTORY
+ * Parameters: LATEST <channel> <* | timestamp=...> <limit>
+ *             BEFORE <channel> timestamp=... <limit>
+ *             AFTER <channel> timestamp=... <limit>
+ *
+ * Send up to <limit> recent messages of a channel the user is on, between
+ * BATCH lines. LATEST sends the newest messages (after the timestamp if one
+ * is given), BEFORE the newest messages before the timestamp and AFTER the
+ * oldest messages after the timestamp.
+ */
+void Server_handle_CHATHISTORY(Server *serv, User *usr, Message *msg) {
+	assert(!strcmp(msg->command, "CHATHISTORY"));
+
+	if (msg->n_params < 4) {
+		List_push_back(usr->msg_queue,
+					   Server_create_reply(serv, ERR_NEEDMOREPARAMS,
+											 usr->nick, msg->command));
+		return;
+	}
+
+	const char *subcommand = msg->params[0];
+	const char *target = msg->params[1];
+	const char *reference = msg->params[2];
+	long limit = atol(msg->params[3]);
+
+	uint64_t after_ms = 0;
+	uint64_t before_ms = UINT64_MAX;
+	uint64_t time_ms = 0;
+	bool has_time = parse_timestamp(reference, &time_ms);
+	bool latest = true;
+
+	if (!strcmp(subcommand, "LATEST") && (has_time || !strcmp(reference, "*"))) {
+		after_ms = has_time ? time_ms : 0;
+	} else if (!strcmp(subcommand, "BEFORE") && has_time) {
+		before_ms = time_ms;
+	} else if (!strcmp(subcommand, "AFTER") && has_time) {
+		after_ms = time_ms;
+		latest = false;
+	} else {
+		List_push_back(
+			usr->msg_queue,
+			Server_create_message(
+				serv, "FAIL CHATHISTORY INVALID_PARAMS %s :Invalid parameters",
+				subcommand));
+		return;
+	}
+
+	if (limit <= 0) {
+		List_push_back(
+			usr->msg_queue,
+			Server_create_message(
+				serv, "FAIL CHATHISTORY INVALID_PARAMS %s :Invalid limit",
+				msg->params[3]));
+		return;
+	}
+
+	Channel *channel = target[0] == '#'
+						   ? ht_get(serv->name_to_channel_map, target + 1)
+						   : NULL;
+
+	if (!channel || !Channel_has_member(channel, usr)) {
+		List_push_back(
+			usr->msg_queue,
+			Server_create_message(
+				serv, "FAIL CHATHISTORY INVALID_TARGET %s %s :No such channel",
+				subcommand, target));
+		return;
+	}
+
+	if (limit > HISTORY_MAX_LIMIT) {
+		limit = HISTORY_MAX_LIMIT;
+	}
+
+	unsigned long batch = serv->history->batch_seq++;
+	List_push_back(usr->msg_queue,
+				   Server_create_message(serv, "BATCH +%lu chathistory %s",
+										 batch, target));
+
+	// Messages up to the time of the oldest message in memory are read from
+	// the log, since other messages of that millisecond may have been dropped
+	// from memory already.
+	uint64_t oldest_ms = History_oldest(serv->history, channel);
+	size_t n_sent = 0;
+
+	if (after_ms < oldest_ms) {
+		uint64_t log_before_ms = oldest_ms < before_ms ? oldest_ms + 1 : before_ms;
+		size_t log_limit = limit;
+
+		if (latest) {
+			size_t n_recent = History_count(serv->history, channel, oldest_ms,
+											before_ms);
+			log_limit = n_recent < (size_t)limit ? limit - n_recent : 0;
+		}
+
+		n_sent = ChannelLog_send(serv->channel_log, channel->name,
+								 usr->msg_queue, after_ms, log_before_ms,
+								 latest, log_limit);
+		after_ms = oldest_ms;
+	}
+
+	History_send(serv->history, channel, usr->msg_queue, after_ms, before_ms,
+				 latest, limit - n_sent);
+	List_push_back(usr->msg_queue,
+				   Server_create_message(serv, "BATCH -%lu", batch));
 }
 
 /**
@@ -794,7 +811,7 @@ void Server_handle_CONNECT(Server *serv, User *usr, Message *msg) {
 
 	if (msg->n_params == 0) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NEEDMOREPARAMS_MSG,
+					   Server_create_reply(serv, ERR_NEEDMOREPARAMS,
 											 usr->nick, msg->command));
 		return;
 	}
@@ -812,47 +829,14 @@ void Server_handle_CONNECT(Server *serv, User *usr, Message *msg) {
 		return;
 	}
 
-	struct peer_info_t target_info;
-	memset(&target_info, 0, sizeof target_info);
-
-	if (!get_peer_info(serv->config_file, target_server, &target_info)) {
+	if (!ht_contains(serv->config, target_server)) {
 		List_push_back(usr->msg_queue,
-					   Server_create_message(serv, ERR_NOSUCHSERVER_MSG,
+					   Server_create_reply(serv, ERR_NOSUCHSERVER,
 											 usr->nick, target_server));
-		free(target_info.peer_host);
-		free(target_info.peer_name);
-		free(target_info.peer_passwd);
-		free(target_info.peer_port);
 		return;
 	}
 
-	Connection *conn = Connection_create_and_connect(target_info.peer_host,
-													 target_info.peer_port);
-
-	if (!conn) {
-		return;
-	}
-
-	Server_add_connection(serv, conn);
-
-	Peer *peer = Peer_alloc(PASSIVE_SERVER, conn->fd, conn->hostname);
-	peer->name = target_info.peer_name;
-
-	conn->conn_type = PEER_CONNECTION;
-	conn->data = peer;
-
-	List_push_back(conn->outgoing_messages,
-				   make_string("PASS %s * *\r\n", target_info.peer_passwd));
-	List_push_back(conn->outgoing_messages,
-				   make_string("SERVER %s\r\n", serv->name));
-
-	free(target_info.peer_passwd);
-	free(target_info.peer_host);
-	free(target_info.peer_port);
-
-	log_info("server %s initiated request with peer %s", serv->name,
-			 peer->name);
-	log_debug("active server: %s, passive server: %s", serv->name, peer->name);
+	Server_connect_peer(serv, target_server);
 }
 
 /**
@@ -866,17 +850,17 @@ void Server_handle_SERVER(Server *serv, Peer *peer, Message *msg) {
 	}
 
 	if (peer->registered) {
-		List_push_back(peer->msg_queue,
-					   Server_create_message(
-						   serv, "462 %s :You may not reregister", peer->name));
+		Server_queue_peer_message(
+			serv, peer,
+			Server_create_message(serv, "462 %s :You may not reregister", "*"));
 		return;
 	}
 
 	if (msg->n_params == 0) {
-		List_push_back(
-			peer->msg_queue,
+		Server_queue_peer_message(
+			serv, peer,
 			Server_create_message(serv, "461 %s %s :Not enough parameters",
-								  peer->name, msg->command));
+								  "*", msg->command));
 		return;
 	}
 
@@ -897,17 +881,17 @@ void Server_handle_PASS(Server *serv, Peer *peer, Message *msg) {
 	}
 
 	if (peer->registered) {
-		List_push_back(peer->msg_queue,
-					   Server_create_message(
-						   serv, "462 %s :You may not reregister", peer->name));
+		Server_queue_peer_message(
+			serv, peer,
+			Server_create_message(serv, "462 %s :You may not reregister", "*"));
 		return;
 	}
 
 	if (msg->n_params == 0) {
-		List_push_back(
-			peer->msg_queue,
+		Server_queue_peer_message(
+			serv, peer,
 			Server_create_message(serv, "461 %s %s :Not enough parameters",
-								  peer->name, msg->command));
+								  "*", msg->command));
 		return;
 	}
 
@@ -922,42 +906,46 @@ void check_peer_registration(Server *serv, Peer *peer) {
 	}
 
 	if (ht_contains(serv->name_to_peer_map, peer->name)) {
-		List_push_back(
-			peer->msg_queue,
+		Server_queue_peer_message(
+			serv, peer,
 			make_string("ERROR :ID \"%s\" already registered\r\n", peer->name));
 		peer->quit = true;
 		return;
 	}
 
 	if (strcmp(peer->passwd, serv->passwd) != 0) {
-		List_push_back(peer->msg_queue, make_string("ERROR :Bad password\r\n"));
+		Server_queue_peer_message(serv, peer,
+								  make_string("ERROR :Bad password\r\n"));
 		peer->quit = true;
 		return;
 	}
 
 	if (peer->server_type == ACTIVE_SERVER) {
-		char *other_passwd = get_server_passwd(serv->config_file, peer->name);
+		ConfigEntry *other = ht_get(serv->config, peer->name);
 
-		if (!other_passwd) {
-			List_push_back(
-				peer->msg_queue,
+		if (!other) {
+			Server_queue_peer_message(
+				serv, peer,
 				make_string("ERROR :Server not configured here\r\n"));
 			peer->quit = true;
 			return;
 		}
 
 		char *pass_message =
-			Server_create_message(serv, "PASS %s 0210 |", other_passwd);
+			Server_create_message(serv, "PASS %s 0210 |", other->passwd);
 		char *server_message = Server_create_message(
 			serv, "SERVER %s :%s %s", serv->name, serv->hostname, serv->info);
-		List_push_back(peer->msg_queue, pass_message);
-		List_push_back(peer->msg_queue, server_message);
+		Server_queue_peer_message(serv, peer, pass_message);
+		Server_queue_peer_message(serv, peer, server_message);
 		log_debug("Sent: %s%s", pass_message, server_message);
-		free(other_passwd);
 	}
 
 	peer->registered = true;
 
+	// The link and its heartbeat start once the handshake is done
+	peer->connected_at = time(NULL);
+	peer->last_seen_at = peer->ping_sent_at = get_time_ms();
+
 	// State information exchange
 
 	HashtableIter itr;
@@ -967,11 +955,12 @@ void check_peer_registration(Server *serv, Peer *peer) {
 	User *other_user = NULL;
 	while (ht_iter_next(&itr, NULL, (void **)&other_user)) {
 		if (other_user->registered && !other_user->quit) {
-			List_push_back(peer->msg_queue,
-						   Server_create_message(
-							   serv, "NICK %s 1 %s %s 1 + :%s",
-							   other_user->nick, other_user->username,
-							   other_user->hostname, other_user->realname));
+			Server_queue_peer_message(
+				serv, peer,
+				Server_create_message(serv, "NICK %s 1 %s %s 1 + :%s",
+									  other_user->nick, other_user->username,
+									  other_user->hostname,
+									  other_user->realname));
 		}
 	}
 
@@ -983,23 +972,28 @@ void check_peer_registration(Server *serv, Peer *peer) {
 	while (
 		ht_iter_next(&itr, (void **)&other_nick, (void **)&other_peer_name)) {
 		if (strcmp(other_peer_name, serv->name) != 0) {
-			List_push_back(peer->msg_queue,
-						   Server_create_message(serv, "NICK %s 1 * * 1 + :*",
-												 other_nick));
+			Server_queue_peer_message(
+				serv, peer,
+				Server_create_message(serv, "NICK %s 1 * * 1 + :*",
+									  other_nick));
 		}
 	}
 
 	// Send SERVER for servers behind this server
 	ht_iter_init(&itr, serv->name_to_peer_map);
+	char *other_server_name = NULL;
 	Peer *other_peer = NULL;
-	while (ht_iter_next(&itr, NULL, (void **)&other_peer)) {
+	while (ht_iter_next(&itr, (void **)&other_server_name,
+						(void **)&other_peer)) {
 		if (other_peer->registered && !other_peer->quit) {
-			List_push_back(
-				peer->msg_queue,
-				Server_create_message(serv, "SERVER %s", other_peer->name));
+			Server_queue_peer_message(
+				serv, peer,
+				Server_create_message(serv, "SERVER %s", other_server_name));
 		}
 	}
 
+	Server_send_summaries(serv, peer);
+
 	// TODO: UNCOMMENNT
 	// ht_iter_init(&itr, serv->name_to_channel_map);
 	// Channel *other_channel = NULL;
@@ -1015,113 +1009,86 @@ void check_peer_registration(Server *serv, Peer *peer) {
 
 	log_info("Server %s has registered", peer->name);
 	ht_set(serv->name_to_peer_map, peer->name, peer);
+	serv->n_peers++;
 }
 
-void Server_handle_TEST_LIST_SERVER(Server *serv, User *usr, Message *msg) {
-	if (ht_contains(serv->test_list_server_map, usr->nick)) {
-		log_warn("There is an existing list request in action");
-		return;
-	}
-
-	struct ListCommand *list_data = calloc(1, sizeof *list_data);
-	list_data->conn = ht_get(serv->connections, &usr->fd);
-	list_data->pending = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
-
-	Hashtable *visited = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
-	HashtableIter itr;
-	ht_iter_init(&itr, serv->name_to_peer_map);
-	Peer *peer = NULL;
-	while (ht_iter_next(&itr, NULL, (void **)&peer)) {
-		if (peer->registered && !peer->quit &&
-			!ht_contains(visited, peer->name)) {
-			List_push_back(
-				peer->msg_queue,
-				Server_create_message(serv, "TEST_LIST_SERVER %s", usr->nick));
-			List_push_back(
-				usr->msg_queue,
-				Server_create_message(serv, "901 %s :%s", usr->nick,
-									  peer->name));	 // RPL_TEST_LIST_SERVER
-			ht_set(list_data->pending, peer->name, peer);
-			ht_set(visited, peer->name, NULL);
-		}
-	}
-
-	ht_free(visited);
-
-	log_debug("Waiting for list request from %zu peers",
-			  ht_size(list_data->pending));
-
-	if (ht_size(list_data->pending) == 0) {
-		List_push_back(usr->msg_queue,
-					   Server_create_message(
-						   serv, "902 %s :End of TEST_LIST_SERVER", usr->nick));
-		ht_free(list_data->pending);
-		free(list_data);
-		log_debug("TEST_LIST_SERVER_END for target %s", usr->nick);
-		return;
-	}
+/**
+ * Command: PING
+ * Parameters: <server> :<token>
+ *
+ * Heartbeat sent by a peer. The token is returned unchanged.
+ */
+void Server_handle_peer_PING(Server *serv, Peer *peer, Message *msg) {
+	assert(!strcmp(msg->command, "PING"));
 
-	ht_set(serv->test_list_server_map, usr->nick, list_data);
+	Server_queue_peer_message(
+		serv, peer,
+		Server_create_message(serv, "PONG %s :%s", serv->name,
+							  msg->body ? msg->body : ""));
 }
 
-void Server_handle_peer_TEST_LIST_SERVER(Server *serv, Peer *peer,
-										 Message *msg) {
-	assert(!strcmp(msg->command, "TEST_LIST_SERVER"));
+/**
+ * Command: PONG
+ * Parameters: <server> :<token>
+ *
+ * Reply to our heartbeat. The token is the time the PING was sent.
+ */
+void Server_handle_peer_PONG(Server *serv, Peer *peer, Message *msg) {
+	assert(!strcmp(msg->command, "PONG"));
+	(void)serv;
 
-	if (!peer->registered || peer->quit) {
+	if (!msg->body) {
 		return;
 	}
 
-	if (msg->n_params == 0) {
-		return;
+	uint64_t sent_at = strtoull(msg->body, NULL, 10);
+
+	if (sent_at == peer->ping_sent_at) {
+		peer->rtt_ms = get_time_ms() - sent_at;
 	}
+}
 
-	char *target = msg->params[0];
+/**
+ * Command: STATS
+ * Parameters: <query>
+ *
+ * Supported queries:
+ * - l: information about the links of this server, including their traffic
+ *   and lag
+ * - m: number of messages, bytes and latency of each command
+ * - u: time since the server was started
+ */
+void Server_handle_STATS(Server *serv, User *usr, Message *msg) {
+	assert(!strcmp(msg->command, "STATS"));
 
-	if (ht_contains(serv->test_list_server_map, target)) {
-		log_warn("There is an existing list request in action");
+	if (!check_registered(serv, usr)) {
 		return;
 	}
 
-	struct ListCommand *list_data = calloc(1, sizeof *list_data);
-	list_data->conn = ht_get(serv->connections, &peer->fd);
-	list_data->pending = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
-
-	Hashtable *visited = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
-	ht_set(visited, peer->name, NULL);
+	char query = msg->n_params > 0 ? msg->params[0][0] : '*';
 
-	HashtableIter itr;
-	ht_iter_init(&itr, serv->name_to_peer_map);
-	Peer *other_peer = NULL;
-	while (ht_iter_next(&itr, NULL, (void **)&other_peer)) {
-		if (other_peer->registered && !other_peer->quit &&
-			!ht_contains(visited, other_peer->name)) {
-			List_push_back(
-				other_peer->msg_queue,
-				Server_create_message(serv, "TEST_LIST_SERVER %s", target));
-			List_push_back(peer->msg_queue,
-						   Server_create_message(
-							   serv, "901 %s :%s", target,
-							   other_peer->name));	// RPL_TEST_LIST_SERVER
-			ht_set(list_data->pending, peer->name, peer);
-			ht_set(visited, peer->name, NULL);
-		}
+	if (query == 'l') {
+		Server_send_link_stats(serv, usr);
+	} else if (query == 'm') {
+		Server_send_command_stats(serv, usr);
+	} else if (query == 'u') {
+		unsigned up = time(NULL) - serv->started_at;
+		List_push_back(usr->msg_queue,
+					   Server_create_reply(serv, RPL_STATSUPTIME, usr->nick,
+										   up / 86400, up / 3600 % 24,
+										   up / 60 % 60, up % 60));
+		Server_send_load_stats(serv, usr);
 	}
 
-	ht_free(visited);
-
-	log_debug("Waiting for list request from %zu peers",
-			  ht_size(list_data->pending));
+	List_push_back(usr->msg_queue, Server_create_reply(serv, RPL_ENDOFSTATS,
+														 usr->nick, query));
+}
 
-	if (ht_size(list_data->pending) == 0) {
-		List_push_back(peer->msg_queue,
-					   Server_create_message(
-						   serv, "902 %s :End of TEST_LIST_SERVER", target));
-		ht_free(list_data->pending);
-		free(list_data);
-		log_debug("TEST_LIST_SERVER_END for target %s", target);
-		return;
-	}
+/**
+ * Lists the names of all other servers in the network.
+ */
+void Server_handle_TEST_LIST_SERVER(Server *serv, User *usr, Message *msg) {
+	assert(!strcmp(msg->command, "TEST_LIST_SERVER"));
 
-	ht_set(serv->test_list_server_map, target, list_data);
+	Server_start_query(serv, usr, QUERY_SERVERS, NULL);
 }
@@ -1,6 +1,8 @@
 #include "include/server.h"
 
+#include <signal.h>
 #include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <sys/stat.h>
 #include <time.h>
 
@@ -12,10 +14,15 @@
  * Helper function to delimit the message before adding to queue.
  */
 void add_message(List *queue, const char *message) {
+	size_t len = strlen(message);
+
 	if (strstr(message, "\r\n")) {
 		List_push_back(queue, strdup(message));
 	} else {
-		List_push_back(queue, make_string("%s\r\n", message));
+		char *line = malloc(len + 3);
+		memcpy(line, message, len);
+		memcpy(line + len, "\r\n", 3);
+		List_push_back(queue, line);
 	}
 }
 
@@ -28,6 +35,8 @@ Peer *Peer_alloc(int type, int fd, const char *hostname) {
 	this->msg_queue = List_alloc(NULL, free);
 	this->server_type = type;
 	this->hostname = hostname;
+	this->last_seen_at = get_time_ms();
+	this->rtt_ms = -1;
 	return this;
 }
 
@@ -52,14 +61,38 @@ User *User_alloc(int fd, const char *hostname) {
 		make_string("user%05d", (rand() % (int)1e5));  // temporary nick
 	this->channels = Vector_alloc(4, (elem_copy_type)strdup, free);
 	this->msg_queue = List_alloc(NULL, free);
+	User_update_prefix(this);
 	return this;
 }
 
+/**
+ * Rebuild the cached message prefix after the nick or username has changed.
+ */
+void User_update_prefix(User *usr) {
+	free(usr->prefix);
+	usr->prefix =
+		make_reply(":%s!%s@%s ", usr->nick, usr->username, usr->hostname);
+	usr->prefix_len = strlen(usr->prefix);
+}
+
+/**
+ * Add user prefix and \r\n suffix to a message without formatting.
+ */
+char *User_prefix_message(User *usr, const char *message) {
+	size_t len = strlen(message);
+	char *line = malloc(usr->prefix_len + len + 3);
+	memcpy(line, usr->prefix, usr->prefix_len);
+	memcpy(line + usr->prefix_len, message, len);
+	memcpy(line + usr->prefix_len + len, "\r\n", 3);
+	return line;
+}
+
 /**
  * To free data for a client-server connection
  */
 void User_free(User *usr) {
 	free(usr->nick);
+	free(usr->prefix);
 	free(usr->username);
 	free(usr->realname);
 
@@ -106,11 +139,16 @@ bool User_remove_channel(User *usr, const char *channel_name) {
 }
 
 /**
- * Create and initialise the server with given name.
- * Reads server info from config file.
+ * Allocate the state of a server with given name from its entry in config,
+ * which the server takes. Channels, sockets and files are left to the caller.
+ * Returns NULL if config has no entry for the name.
  */
-Server *Server_create(const char *name) {
-	assert(name);
+static Server *Server_alloc(const char *name, Hashtable *config) {
+	ConfigEntry *self = config ? ht_get(config, name) : NULL;
+
+	if (!self) {
+		return NULL;
+	}
 
 	Server *serv = calloc(1, sizeof *serv);
 	assert(serv);
@@ -118,21 +156,22 @@ Server *Server_create(const char *name) {
 	serv->motd_file = MOTD_FILENAME;
 	serv->config_file = CONFIG_FILENAME;
 
-	struct peer_info_t serv_info;
-	memset(&serv_info, 0, sizeof serv_info);
-
-	if (!get_peer_info(CONFIG_FILENAME, name, &serv_info)) {
-		log_error("server %s not found in config file %s", name,
-				  serv->config_file);
-		exit(1);
-	}
+	serv->fd = -1;
+	serv->epollfd = -1;
+	serv->signal_fd = -1;
+	serv->admin_fd = -1;
+	serv->config = config;
 
-	serv->name = serv_info.peer_name;
-	serv->port = serv_info.peer_port;
-	serv->passwd = serv_info.peer_passwd;
-	serv->hostname = serv_info.peer_host;
+	serv->name = strdup(self->name);
+	serv->port = strdup(self->port);
+	serv->passwd = strdup(self->passwd);
+	serv->hostname = strdup(self->host);
 
 	serv->info = strdup(DEFAULT_INFO);
+	serv->peer_ping_interval_ms = PEER_PING_INTERVAL_MS;
+	serv->peer_max_missed_pings = PEER_MAX_MISSED_PINGS;
+	serv->peer_queue_high = PEER_QUEUE_HIGH_WATERMARK;
+	serv->peer_queue_low = PEER_QUEUE_LOW_WATERMARK;
 
 	serv->connections =
 		ht_alloc_type(INT_TYPE, SHALLOW_TYPE); /* Map<int, Connection *> */
@@ -142,17 +181,59 @@ Server *Server_create(const char *name) {
 		ht_alloc(STRING_TYPE, STRING_TYPE); /* Map<string, string> */
 	serv->nick_to_user_map =
 		ht_alloc_type(STRING_TYPE, SHALLOW_TYPE); /* Map<string, User*> */
-	serv->name_to_channel_map =
-		load_channels(CHANNELS_FILENAME); /* Map<string, Channel *> */
-	serv->test_list_server_map = ht_alloc_type(
-		STRING_TYPE, SHALLOW_TYPE); /* Map<string, struct ListCommand *> */
+	serv->history = History_alloc(HISTORY_MAX_BYTES);
+	serv->streams = Vector_alloc(4, NULL, NULL);
+	serv->channel_index = ChannelIndex_alloc();
+	serv->queries =
+		ht_alloc_type(STRING_TYPE, SHALLOW_TYPE); /* Map<string, Query *> */
+	serv->queries->value_free = (elem_free_type)Query_free;
+	serv->summaries =
+		ht_alloc_type(STRING_TYPE, SHALLOW_TYPE); /* Map<string, Summary *> */
+	serv->summaries->value_free = free;
+	serv->command_stats =
+		ht_alloc_type(STRING_TYPE, SHALLOW_TYPE); /* Map<string, CommandStats *> */
+	serv->command_stats->value_free = free;
 
 	time_t t = time(NULL);
 	struct tm *tm = localtime(&t);
+	serv->started_at = t;
 
 	size_t n = strftime(serv->created_at, sizeof(serv->created_at), "%c", tm);
 	assert(n > 0);
 
+	serv->catalog = Catalog_alloc(serv);
+
+	return serv;
+}
+
+/**
+ * Create and initialise the server with given name.
+ * Reads server info from config file.
+ */
+Server *Server_create(const char *name) {
+	assert(name);
+
+	Server *serv = Server_alloc(name, load_config(CONFIG_FILENAME));
+
+	if (!serv) {
+		log_error("server %s not found in config file %s", name,
+				  CONFIG_FILENAME);
+		exit(1);
+	}
+
+	// The text file is only used until the first channel store is written
+	const char *channels_file = access(CHANNELS_DB_FILENAME, F_OK) == 0
+									? CHANNELS_DB_FILENAME
+									: CHANNELS_FILENAME;
+	serv->name_to_channel_map =
+		load_channels(channels_file,
+					  JOURNAL_FILENAME); /* Map<string, Channel *> */
+	Server_link_channels(serv);
+	serv->journal = Journal_open(JOURNAL_FILENAME, CHANNELS_DB_FILENAME);
+	serv->channel_log = ChannelLog_open(CHANNEL_LOG_DIR);
+
+	Server_rebuild_channel_sketch(serv);
+
 	// Create epoll fd for listen socket and clients
 	serv->epollfd = epoll_create(1 + MAX_EVENTS);
 	CHECK(serv->epollfd, "epoll_create");
@@ -182,58 +263,154 @@ Server *Server_create(const char *name) {
 
 	log_info("Server \"%s\" is running on port %s at %s", serv->name,
 			 serv->port, serv->hostname);
+
+	Server_apply_config(serv, NULL);
+
 	return serv;
 }
 
 /**
- * Remove any open connections from server.
+ * Remove any open connections from server. The connections are collected
+ * first, since removing one frees its node of the table being iterated.
  */
 void Server_remove_all_connections(Server *serv) {
+	Vector *conns = Vector_alloc(ht_size(serv->connections) + 1, NULL, NULL);
 	HashtableIter conn_itr;
 	ht_iter_init(&conn_itr, serv->connections);
 	Connection *conn = NULL;
 
 	while (ht_iter_next(&conn_itr, NULL, (void **)&conn)) {
-		Server_remove_connection(serv, conn);
+		Vector_push(conns, conn);
+	}
+
+	for (size_t i = 0; i < Vector_size(conns); i++) {
+		Server_remove_connection(serv, Vector_get_at(conns, i));
 	}
+
+	Vector_free(conns);
 }
 
 /**
- * Destroy server and close all connections.
+ * Close all connections and free the server. Channels are saved unless the
+ * server runs on a simulated network.
  */
-void Server_destroy(Server *serv) {
+void Server_free(Server *serv) {
 	assert(serv);
 
-	save_channels(serv->name_to_channel_map, CHANNELS_FILENAME);
+	if (serv->journal) {
+		Journal_close(serv->journal, serv->name_to_channel_map);
+	} else if (!serv->net) {
+		save_channels(serv->name_to_channel_map, CHANNELS_DB_FILENAME);
+	}
+
 	Server_remove_all_connections(serv);
 
 	ht_free(serv->name_to_channel_map);
+	History_free(serv->history);
+	ChannelLog_close(serv->channel_log);
 	ht_free(serv->name_to_peer_map);
 	ht_free(serv->nick_to_user_map);
 	ht_free(serv->connections);
-	ht_free(serv->test_list_server_map);
+	ht_free(serv->queries);
+	Vector_free(serv->streams);
+	ChannelIndex_free(serv->channel_index);
+	ht_free(serv->summaries);
+	ht_free(serv->command_stats);
+	Catalog_free(serv->catalog);
+	ht_free(serv->config);
+
+	if (serv->signal_fd != -1) {
+		close(serv->signal_fd);
+	}
+
+	Server_close_admin(serv);
+	Capture_close(serv->capture);
+
+	if (serv->fd != -1) {
+		close(serv->fd);
+	}
+
+	if (serv->epollfd != -1) {
+		close(serv->epollfd);
+	}
 
-	close(serv->fd);
-	close(serv->epollfd);
 	free(serv->hostname);
 	free(serv->port);
 	free(serv->passwd);
 	free(serv->info);
+	free(serv->summary);
 	free(serv->name);
 	free(serv);
+}
+
+/**
+ * Create the server with given name on a simulated network. The server takes
+ * config, accepts connections to the node of its name and keeps its channels
+ * in memory only.
+ */
+Server *Server_create_simulated(const char *name, Hashtable *config,
+								SimNet *net) {
+	assert(name);
+	assert(net);
+
+	Server *serv = Server_alloc(name, config);
+
+	if (!serv) {
+		log_error("server %s not found in config", name);
+		ht_free(config);
+		return NULL;
+	}
+
+	serv->net = net;
+	serv->name_to_channel_map = ht_alloc(); /* Map<string, Channel *> */
+	serv->name_to_channel_map->key_copy = NULL;
+	serv->name_to_channel_map->key_free = NULL;
+	serv->name_to_channel_map->value_copy = NULL;
+	serv->name_to_channel_map->value_free = (elem_free_type)Channel_free;
+
+	Server_rebuild_channel_sketch(serv);
+	SimNet_listen(net, serv->name);
+
+	log_info("Server \"%s\" is running on a simulated network", serv->name);
+
+	Server_apply_config(serv, NULL);
+
+	return serv;
+}
+
+/**
+ * Destroy server and close all connections.
+ */
+void Server_destroy(Server *serv) {
+	Server_free(serv);
 
 	log_debug("Server stopped");
 	exit(0);
 }
 
 /**
- * There are new connections available.
+ * There are new connections available. While the server is overloaded only a
+ * few are accepted per loop iteration, and the rest wait in the backlog.
  */
 void Server_accept_all(Server *serv) {
+	int limit = serv->overloaded ? OVERLOAD_ACCEPT_BATCH : -1;
+
+	if (serv->net) {
+		Connection *conn = NULL;
+
+		while (limit-- != 0 && (conn = SimNet_accept(serv->net, serv->name))) {
+			if (!Server_add_connection(serv, conn)) {
+				Server_remove_connection(serv, conn);
+			}
+		}
+
+		return;
+	}
+
 	struct sockaddr_storage client_addr;
 	socklen_t addrlen = sizeof(client_addr);
 
-	while (1) {
+	while (limit-- != 0) {
 		int conn_sock =
 			accept(serv->fd, (struct sockaddr *)&client_addr, &addrlen);
 
@@ -247,6 +424,7 @@ void Server_accept_all(Server *serv) {
 
 		Connection *conn = Connection_alloc(
 			conn_sock, (struct sockaddr *)&client_addr, addrlen);
+		conn->capture = serv->capture;
 
 		if (!Server_add_connection(serv, conn)) {
 			Server_remove_connection(serv, conn);
@@ -254,6 +432,70 @@ void Server_accept_all(Server *serv) {
 	}
 }
 
+/**
+ * Handle events which are due at a given time, such as query deadlines.
+ * This is called after every iteration of the event loop.
+ */
+void Server_check_timeouts(Server *serv) {
+	Server_check_queries(serv);
+	Server_check_peer_heartbeats(serv);
+	Server_gossip_summary(serv);
+}
+
+/**
+ * Send PING to every registered peer once per ping interval. A peer which has
+ * not sent anything for the given number of intervals is considered dead, and
+ * its link is closed as if it had sent SQUIT. This detects half-open links that
+ * would otherwise go unnoticed.
+ */
+void Server_check_peer_heartbeats(Server *serv) {
+	uint64_t now = get_time_ms();
+	uint64_t interval = serv->peer_ping_interval_ms;
+	Vector *dead = Vector_alloc(4, NULL, NULL);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *conn = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&conn)) {
+		if (conn->conn_type != PEER_CONNECTION) {
+			continue;
+		}
+
+		Peer *peer = conn->data;
+
+		if (!peer->registered || peer->quit) {
+			continue;
+		}
+
+		if (now - peer->ping_sent_at < interval) {
+			continue;
+		}
+
+		if (now - peer->last_seen_at >= interval) {
+			peer->missed_pings++;
+		}
+
+		if (peer->missed_pings >= serv->peer_max_missed_pings) {
+			log_warn("peer %s missed %d pings", peer->name, peer->missed_pings);
+			Vector_push(dead, conn);
+			continue;
+		}
+
+		peer->ping_sent_at = now;
+		Server_queue_peer_message(
+			serv, peer,
+			Server_create_message(serv, "PING %s :%lu", serv->name,
+								  (unsigned long)now));
+	}
+
+	for (size_t i = 0; i < Vector_size(dead); i++) {
+		Server_remove_connection(serv, Vector_get_at(dead, i));
+	}
+
+	Vector_free(dead);
+}
+
 /**
  * Process request from unknown connection and promote it to either
  * user or peer connection based on the initial messages.
@@ -278,18 +520,54 @@ void Server_process_request_from_unknown(Server *serv, Connection *conn) {
 			   strncmp(message, "USER", 4) == 0) {
 		conn->conn_type = USER_CONNECTION;
 		conn->data = User_alloc(conn->fd, conn->hostname);
+		serv->n_unknown--;
 	} else if (strncmp(message, "PASS", 4) == 0 ||
 			   strncmp(message, "SERVER", 6) == 0) {
 		conn->conn_type = PEER_CONNECTION;
 		conn->data = Peer_alloc(ACTIVE_SERVER, conn->fd, conn->hostname);
+		serv->n_unknown--;
 	} else {
 		log_warn("Invalid message: %s",
-				 List_peek_front(conn->incoming_messages));
+				 (char *)List_peek_front(conn->incoming_messages));
 		List_pop_front(conn->incoming_messages);
 		return;
 	}
 }
 
+/**
+ * Returns true if message is a command which is refused while the server is
+ * overloaded, because its reply grows with the number of channels or users:
+ * LIST, NAMES without channels and WHO on a large channel.
+ */
+static bool is_expensive_command(Server *serv, Message *message) {
+	if (!strcmp(message->command, "LIST")) {
+		return true;
+	}
+
+	if (!strcmp(message->command, "NAMES")) {
+		return message->n_params == 0;
+	}
+
+	if (!strcmp(message->command, "WHO") && message->n_params > 0 &&
+		message->params[0][0] == '#') {
+		char *masks = strdup(message->params[0]);
+		char *saveptr = NULL;
+		bool large = false;
+
+		for (char *mask = strtok_r(masks, ",", &saveptr); mask && !large;
+			 mask = strtok_r(NULL, ",", &saveptr)) {
+			Channel *channel = ht_get(serv->name_to_channel_map, mask + 1);
+			large = channel && channel->members &&
+					ht_size(channel->members) > OVERLOAD_WHO_MEMBERS;
+		}
+
+		free(masks);
+		return large;
+	}
+
+	return false;
+}
+
 /**
  * Process request from user connection
  */
@@ -316,6 +594,17 @@ void Server_process_request_from_user(Server *serv, Connection *conn) {
 		if (!message->command) {
 			log_error("invalid message");
 			continue;
+		}
+
+		uint64_t start_ns = get_time_ns();
+		const char *command = message->command;
+
+		if (serv->overloaded && usr->registered &&
+			is_expensive_command(serv, message)) {
+			List_push_back(usr->msg_queue,
+						   Server_create_reply(serv, RPL_TRYAGAIN, usr->nick,
+											   message->command));
+			serv->refused_commands++;
 		} else if (!strcmp(message->command, "NICK")) {
 			Server_handle_NICK(serv, usr, message);
 		} else if (!strcmp(message->command, "USER")) {
@@ -346,8 +635,12 @@ void Server_process_request_from_user(Server *serv, Connection *conn) {
 			Server_handle_TOPIC(serv, usr, message);
 		} else if (!strcmp(message->command, "LUSERS")) {
 			Server_handle_LUSERS(serv, usr, message);
+		} else if (!strcmp(message->command, "CHATHISTORY")) {
+			Server_handle_CHATHISTORY(serv, usr, message);
 		} else if (!strcmp(message->command, "HELP")) {
 			Server_handle_HELP(serv, usr, message);
+		} else if (!strcmp(message->command, "STATS")) {
+			Server_handle_STATS(serv, usr, message);
 		} else if (!strcmp(message->command, "CONNECT")) {
 			Server_handle_CONNECT(serv, usr, message);
 		} else if (!strcmp(message->command, "TEST_LIST_SERVER")) {
@@ -356,19 +649,32 @@ void Server_process_request_from_user(Server *serv, Connection *conn) {
 			char *reply = Server_create_message(
 				serv, "451 %s :Connection not registered", usr->nick);
 			List_push_back(conn->outgoing_messages, reply);
+			command = STATS_OTHER_COMMAND;
 		} else {
 			char *reply =
 				Server_create_message(serv, "421 %s %s :Unknown command",
 									  usr->nick, message->command);
 			List_push_back(conn->outgoing_messages, reply);
+			command = STATS_OTHER_COMMAND;
 		}
 
+		Server_count_command(serv, command, strlen(message->message),
+							 get_time_ns() - start_ns, false);
 		conn->quit = usr->quit;
 	}
 
 	Vector_free(messages);
 }
 
+/**
+ * Add message sent to channel to its history in memory and to its log on disk.
+ */
+void Server_add_history(Server *serv, Channel *channel, const char *message) {
+	uint64_t time_ms = get_realtime_ms();
+	History_add(serv->history, channel, message, time_ms);
+	ChannelLog_append(serv->channel_log, channel->name, message, time_ms);
+}
+
 /**
  * This will send a message to all known members of channel on given server and
  * forward the message to its peers to reach other channel members in the
@@ -439,6 +745,7 @@ void Server_broadcast_message(Server *serv, const char *message) {
 
 		if (peer->registered && !peer->quit) {
 			add_message(peer->msg_queue, message);
+			Server_update_peer_congestion(serv, peer);
 		}
 
 		ht_set(visited, peer->name, NULL);
@@ -466,6 +773,7 @@ void Server_relay_message(Server *serv, const char *origin,
 		if (strcmp(peer->name, origin) != 0 && peer->registered &&
 			!peer->quit) {
 			add_message(peer->msg_queue, message);
+			Server_update_peer_congestion(serv, peer);
 		}
 
 		ht_set(visited, peer->name, NULL);
@@ -475,107 +783,117 @@ void Server_relay_message(Server *serv, const char *origin,
 }
 
 /**
- * Process request from peer connection
+ * Peer commands that are handled here rather than only relayed need every
+ * field of the message. Everything else is parsed lazily and forwarded with
+ * the original line.
  */
-void Server_process_request_from_peer(Server *serv, Connection *conn) {
-	assert(conn->conn_type == PEER_CONNECTION);
-
-	Peer *peer = conn->data;
-	assert(peer);
+static bool peer_needs_full_parse(const char *command) {
+	static const char *commands[] = {"PASS",  "SERVER", "PING",	  "PONG",
+									 "QUERY", "QREPLY", "QEND", "SUMMARY"};
 
-	Vector *messages = parse_message_list(conn->incoming_messages);
+	for (size_t i = 0; i < sizeof commands / sizeof *commands; i++) {
+		if (!strcmp(command, commands[i])) {
+			return true;
+		}
+	}
 
-	for (size_t i = 0; i < Vector_size(messages); i++) {
-		Message *message = Vector_get_at(messages, i);
+	return false;
+}
 
-		if (!strcmp(message->command, "ERROR")) {
-			peer->quit = true;
-			break;
-		} else if (!strcmp(message->command,
-						   "QUIT"))	 // A user behind peer has quit
-		{
-			if (message->origin) {
-				char *nick = strtok(message->origin, "!");
-				if (nick &&
-					ht_remove(serv->nick_to_serv_name_map, nick, NULL, NULL)) {
-					log_info("user %s has left", nick);
-				}
-			}
-		} else if (!strcmp(message->command, "SQUIT")) {
-			List_push_back(peer->msg_queue, Server_create_message(
-												serv, "ERROR :Closing Link: %s",
-												conn->hostname));
-			peer->quit = true;
-			break;
-		} else if (!strcmp(message->command, "TEST_LIST_SERVER")) {
-			Server_handle_peer_TEST_LIST_SERVER(serv, peer, message);
-		} else if (!strcmp(message->command, "901")) {
-			if (message->n_params > 0 && message->body) {
-				char *target = message->params[0];
-				assert(target);
-				struct ListCommand *list_data =
-					ht_get(serv->test_list_server_map, target);
-				if (list_data) {
-					log_debug("Sent TEST_LIST_SERVER reply for %s to fd %d",
-							  target, list_data->conn->fd);
-					List_push_back(list_data->conn->outgoing_messages,
-								   strdup(message->message));
-				}
-			}
-		} else if (!strcmp(message->command, "902")) {
-			if (message->n_params > 0 && message->body) {
-				char *target = message->params[0];
-				assert(target);
-				struct ListCommand *list_data =
-					ht_get(serv->test_list_server_map, target);
-				if (list_data) {
-					ht_remove(list_data->pending, peer->name, NULL, NULL);
-					if (ht_size(list_data->pending) == 0) {
-						log_debug(
-							"Sent TEST_LIST_SERVER_END reply for %s to %d",
-							target, list_data->conn->fd);
-						List_push_back(
-							list_data->conn->outgoing_messages,
-							Server_create_message(
-								serv, "902 %s :End of TEST_LIST_SERVER",
-								target));
-						ht_remove(serv->test_list_server_map, target, NULL,
-								  NULL);
-						ht_free(list_data->pending);
-						free(list_data);
-					}
-				}
-			}
-		} else if (!strcmp(message->command, "SERVER")) {
-			char *server_name = message->params[0];
-			assert(server_name);
-
-			if (peer->server_type == PASSIVE_SERVER &&
-				!strcmp(peer->name, server_name)) {
-				continue;
-			} else if (!peer->registered) {
-				Server_handle_SERVER(serv, peer, message);
-				continue;
+/**
+ * Handle message from peer. Returns false if the remaining messages of the
+ * peer should be dropped.
+ */
+static bool Server_handle_peer_message(Server *serv, Connection *conn,
+									   Peer *peer, Message *message) {
+	if (!strcmp(message->command, "ERROR")) {
+		peer->quit = true;
+		return false;
+	} else if (!strcmp(message->command,
+					   "QUIT"))	 // A user behind peer has quit
+	{
+		if (message->origin) {
+			char *nick = strtok(message->origin, "!");
+			if (nick &&
+				ht_remove(serv->nick_to_serv_name_map, nick, NULL, NULL)) {
+				log_info("user %s has left", nick);
 			}
+		}
+	} else if (!strcmp(message->command, "SQUIT")) {
+		Server_queue_peer_message(
+			serv, peer,
+			Server_create_message(serv, "ERROR :Closing Link: %s",
+								  conn->hostname));
+		peer->quit = true;
+		return false;
+	} else if (!strcmp(message->command, "PING")) {
+		Server_handle_peer_PING(serv, peer, message);
+	} else if (!strcmp(message->command, "PONG")) {
+		Server_handle_peer_PONG(serv, peer, message);
+	} else if (!strcmp(message->command, "QUERY")) {
+		Server_handle_peer_QUERY(serv, peer, message);
+	} else if (!strcmp(message->command, "QREPLY")) {
+		Server_handle_peer_QREPLY(serv, peer, message);
+	} else if (!strcmp(message->command, "QEND")) {
+		Server_handle_peer_QEND(serv, peer, message);
+	} else if (!strcmp(message->command, "SUMMARY")) {
+		Server_handle_peer_SUMMARY(serv, peer, message);
+	} else if (!strcmp(message->command, "SERVER")) {
+		char *server_name = message->params[0];
+		assert(server_name);
+
+		if (peer->server_type == PASSIVE_SERVER &&
+			!strcmp(peer->name, server_name)) {
+			return true;
+		} else if (!peer->registered) {
+			Server_handle_SERVER(serv, peer, message);
+			return true;
+		}
 
-			if (ht_contains(serv->name_to_peer_map,
-							server_name)) {	 // A new server has joined the
-											 // network behind the current peer
-				log_error("Cycle detected: Remove peer %s", server_name);
-				Peer *other_peer = ht_get(serv->name_to_peer_map, server_name);
-				Connection *other_conn =
-					ht_get(serv->connections, &other_peer->fd);
-				assert(other_conn);
-				Server_remove_connection(serv, other_conn);
-				continue;
-			}
+		if (ht_contains(serv->name_to_peer_map,
+						server_name)) {	 // A new server has joined the
+										 // network behind the current peer
+			log_error("Cycle detected: Remove peer %s", server_name);
+			Peer *other_peer = ht_get(serv->name_to_peer_map, server_name);
+			Connection *other_conn =
+				ht_get(serv->connections, &other_peer->fd);
+			assert(other_conn);
+			Server_remove_connection(serv, other_conn);
+			return true;
+		}
 
-			ht_set(serv->name_to_peer_map, server_name, peer);
-			Server_relay_message(serv, peer->name, message->message);
-		} else if (!strcmp(message->command, "PASS")) {
-			Server_handle_PASS(serv, peer, message);
-		} else if (!strcmp(message->command, "KILL")) {
-			char *nick = message->params[0];
+		ht_set(serv->name_to_peer_map, server_name, peer);
+		Server_relay_message(serv, peer->name, message->message);
+	} else if (!strcmp(message->command, "PASS")) {
+		Server_handle_PASS(serv, peer, message);
+	} else if (!strcmp(message->command, "KILL")) {
+		char *nick = message->params[0];
+		ht_remove(serv->nick_to_serv_name_map, nick, NULL, NULL);
+
+		User *other_user = ht_get(serv->nick_to_user_map, nick);
+
+		if (other_user) {
+			List_push_back(
+				other_user->msg_queue,
+				Server_create_message(
+					serv, "ERROR :nickname collision for %s", nick));
+			other_user->quit = true;
+		}
+
+		Server_relay_message(serv, peer->name, message->message);
+		log_warn("removed nick %s", nick);
+	} else if (!strcmp(message->command,
+					   "NICK"))	 // A new user was registered behind the
+								 // peer server
+	{
+		char *nick = message->params[0];
+		assert(nick);
+
+		if (ht_contains(serv->nick_to_serv_name_map, nick)) {
+			Server_queue_peer_message(
+				serv, peer,
+				Server_create_message(serv, "KILL %s :nickname collision",
+									  nick));
 			ht_remove(serv->nick_to_serv_name_map, nick, NULL, NULL);
 
 			User *other_user = ht_get(serv->nick_to_user_map, nick);
@@ -588,60 +906,71 @@ void Server_process_request_from_peer(Server *serv, Connection *conn) {
 				other_user->quit = true;
 			}
 
+			return true;
+		} else {
+			log_info("== user %s registered with server %s == ", nick,
+					 peer->name);
+			ht_set(serv->nick_to_serv_name_map, nick, peer->name);
 			Server_relay_message(serv, peer->name, message->message);
-			log_warn("removed nick %s", nick);
-		} else if (!strcmp(message->command,
-						   "NICK"))	 // A new user was registered behind the
-									 // peer server
-		{
-			char *nick = message->params[0];
-			assert(nick);
-
-			if (ht_contains(serv->nick_to_serv_name_map, nick)) {
-				List_push_back(peer->msg_queue,
-							   Server_create_message(
-								   serv, "KILL %s :nickname collision", nick));
-				ht_remove(serv->nick_to_serv_name_map, nick, NULL, NULL);
-
-				User *other_user = ht_get(serv->nick_to_user_map, nick);
-
-				if (other_user) {
-					List_push_back(
-						other_user->msg_queue,
-						Server_create_message(
-							serv, "ERROR :nickname collision for %s", nick));
-					other_user->quit = true;
-				}
-
-				continue;
-			} else {
-				log_info("== user %s registered with server %s == ", nick,
-						 peer->name);
-				ht_set(serv->nick_to_serv_name_map, nick, peer->name);
-				Server_relay_message(serv, peer->name, message->message);
-			}
-		} else if (!strcmp(message->command,
-						   "PRIVMSG"))	// To send message to a user or channel
-		{
-			assert(message->n_params > 0);
-
-			if (*message->params[0] == '#') {
-				Server_message_channel(serv, peer->name, message->params[0] + 1,
-									   message->message);
-			} else {
-				Server_message_user(serv, peer->name, message->params[0],
-									message->message);
-			}
-		} else if (!strcmp(message->command,
-						   "JOIN"))	 // TODO: Update channel map
-		{
-			Server_message_channel(serv, peer->name, message->params[0] + 1,
-								   message->message);
-		} else if (!strcmp(message->command, "PART")) {
+		}
+	} else if (!strcmp(message->command,
+					   "PRIVMSG"))	// To send message to a user or channel
+	{
+		assert(message->n_params > 0);
+
+		if (*message->params[0] == '#') {
 			Server_message_channel(serv, peer->name, message->params[0] + 1,
 								   message->message);
+			Channel *channel = ht_get(serv->name_to_channel_map,
+									  message->params[0] + 1);
+
+			if (channel) {
+				Server_add_history(serv, channel, message->message);
+			}
 		} else {
-			Server_relay_message(serv, peer->name, message->message);
+			Server_message_user(serv, peer->name, message->params[0],
+								message->message);
+		}
+	} else if (!strcmp(message->command,
+					   "JOIN"))	 // TODO: Update channel map
+	{
+		Server_message_channel(serv, peer->name, message->params[0] + 1,
+							   message->message);
+	} else if (!strcmp(message->command, "PART")) {
+		Server_message_channel(serv, peer->name, message->params[0] + 1,
+							   message->message);
+	} else {
+		Server_relay_message(serv, peer->name, message->message);
+	}
+
+	return true;
+}
+
+/**
+ * Process request from peer connection
+ */
+void Server_process_request_from_peer(Server *serv, Connection *conn) {
+	assert(conn->conn_type == PEER_CONNECTION);
+
+	Peer *peer = conn->data;
+	assert(peer);
+
+	Vector *messages = parse_message_list_lazy(conn->incoming_messages,
+											   peer_needs_full_parse);
+
+	// Any message from the peer shows that the link is alive
+	peer->last_seen_at = get_time_ms();
+	peer->missed_pings = 0;
+
+	for (size_t i = 0; i < Vector_size(messages); i++) {
+		Message *message = Vector_get_at(messages, i);
+		uint64_t start_ns = get_time_ns();
+		bool more = Server_handle_peer_message(serv, conn, peer, message);
+		Server_count_command(serv, message->command, strlen(message->message),
+							 get_time_ns() - start_ns, true);
+
+		if (!more) {
+			break;
 		}
 	}
 
@@ -671,6 +1000,10 @@ void Server_process_request(Server *serv, Connection *conn) {
 	if (!conn->quit && conn->conn_type == USER_CONNECTION) {
 		Server_process_request_from_user(serv, conn);
 	}
+
+	if (!conn->quit && conn->conn_type == ADMIN_CONNECTION) {
+		Server_process_request_from_admin(serv, conn);
+	}
 }
 
 /**
@@ -683,6 +1016,12 @@ bool Server_add_connection(Server *serv, Connection *connection) {
 	assert(connection->conn_type == UNKNOWN_CONNECTION);
 
 	ht_set(serv->connections, &connection->fd, connection);
+	serv->n_unknown++;
+
+	// Simulated connections are polled without epoll
+	if (serv->net) {
+		return true;
+	}
 
 	// Make user socket non-blocking
 	if (fcntl(connection->fd, F_SETFL,
@@ -690,9 +1029,11 @@ bool Server_add_connection(Server *serv, Connection *connection) {
 		perror("fcntl");
 		return false;
 	}
-	// Add event
+	// Add event; new connections are not read while reads are paused
 	struct epoll_event ev = {.data.fd = connection->fd,
-							 .events = EPOLLIN | EPOLLOUT};
+							 .events = serv->n_congested_peers
+										   ? EPOLLOUT
+										   : EPOLLIN | EPOLLOUT};
 
 	// Add user socket to epoll set
 	if (epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, connection->fd, &ev) != 0) {
@@ -706,6 +1047,61 @@ bool Server_add_connection(Server *serv, Connection *connection) {
 	return true;
 }
 
+/**
+ * Open a link to the server with given name in the config and send the
+ * PASS and SERVER messages to register with it.
+ */
+bool Server_connect_peer(Server *serv, const char *name) {
+	ConfigEntry *entry = ht_get(serv->config, name);
+
+	if (!entry) {
+		log_warn("server %s not found in config", name);
+		return false;
+	}
+
+	Connection *conn =
+		serv->net ? SimNet_connect(serv->net, serv->name, entry->name)
+				  : Connection_create_and_connect(entry->host, entry->port);
+
+	if (!conn) {
+		return false;
+	}
+
+	Server_add_connection(serv, conn);
+
+	Peer *peer = Peer_alloc(PASSIVE_SERVER, conn->fd, conn->hostname);
+	peer->name = strdup(entry->name);
+
+	conn->conn_type = PEER_CONNECTION;
+	conn->data = peer;
+	serv->n_unknown--;
+
+	List_push_back(conn->outgoing_messages,
+				   make_string("PASS %s * *\r\n", entry->passwd));
+	List_push_back(conn->outgoing_messages,
+				   make_string("SERVER %s\r\n", serv->name));
+
+	log_info("server %s initiated request with peer %s", serv->name,
+			 peer->name);
+	log_debug("active server: %s, passive server: %s", serv->name, peer->name);
+
+	return true;
+}
+
+/**
+ * Read pending signals from the signal fd. SIGHUP reloads the config.
+ */
+static void Server_handle_signals(Server *serv) {
+	struct signalfd_siginfo info;
+
+	while (read(serv->signal_fd, &info, sizeof info) == sizeof info) {
+		if (info.ssi_signo == SIGHUP) {
+			log_info("got SIGHUP");
+			Server_reload_config(serv);
+		}
+	}
+}
+
 struct filter_arg_t {
 	Server *serv;
 	Peer *peer;
@@ -726,6 +1122,7 @@ bool _remove_nick_for_peer(char *nick, char *name,
 bool _remove_server_for_peer(char *name, Peer *peer,
 							 struct filter_arg_t *filter_arg) {
 	if (!strcmp(peer->name, filter_arg->peer->name)) {
+		Server_remove_summary(filter_arg->serv, name);
 		Server_broadcast_message(
 			filter_arg->serv,
 			Server_create_message(filter_arg->serv, "SQUIT %s :closing link",
@@ -736,18 +1133,6 @@ bool _remove_server_for_peer(char *name, Peer *peer,
 	return false;
 }
 
-/**
- * Remove server from pending sets for TEST_LIST_SERVER command
- */
-void remove_peer_from_tls_maps(Server *serv, Peer *peer) {
-	HashtableIter itr;
-	struct ListCommand *data = NULL;
-	ht_iter_init(&itr, serv->test_list_server_map);
-	while (ht_iter_next(&itr, NULL, (void **)&data)) {
-		ht_remove(data->pending, peer->name, NULL, NULL);
-	}
-}
-
 /**
  * Remove connection from server and free all its memory.
  *
@@ -758,11 +1143,17 @@ void Server_remove_connection(Server *serv, Connection *connection) {
 	assert(connection);
 
 	ht_remove(serv->connections, &connection->fd, NULL, NULL);
-	epoll_ctl(serv->epollfd, EPOLL_CTL_DEL, connection->fd, NULL);
 
-	if (connection->conn_type == USER_CONNECTION) {
+	if (!serv->net) {
+		epoll_ctl(serv->epollfd, EPOLL_CTL_DEL, connection->fd, NULL);
+	}
+
+	if (connection->conn_type == UNKNOWN_CONNECTION) {
+		serv->n_unknown--;
+	} else if (connection->conn_type == USER_CONNECTION) {
 		User *usr = connection->data;
 		log_info("Closing connection with user %s", usr->nick);
+		Server_stop_stream(serv, usr);
 		ht_remove(serv->nick_to_user_map, usr->nick, NULL, NULL);
 		ht_remove(serv->nick_to_serv_name_map, usr->nick, NULL, NULL);
 
@@ -783,6 +1174,15 @@ void Server_remove_connection(Server *serv, Connection *connection) {
 		Peer *peer = connection->data;
 		log_info("Closing connection with peer %d", connection->fd);
 
+		if (peer->registered) {
+			serv->n_peers--;
+		}
+
+		if (peer->congested) {
+			peer->quit = true;
+			Server_update_peer_congestion(serv, peer);
+		}
+
 		// Remove all servers behind quitting server
 		if (peer->name) {
 			// Remove all users behind quitting server
@@ -792,12 +1192,315 @@ void Server_remove_connection(Server *serv, Connection *connection) {
 								 (filter_type)_remove_nick_for_peer, &arg);
 			ht_remove_all_filter(serv->name_to_peer_map,
 								 (filter_type)_remove_server_for_peer, &arg);
-			// TODO: Remove servers from test_list_server_map
-			remove_peer_from_tls_maps(serv, peer);
+			Server_remove_peer_from_queries(serv, peer);
 		}
 
 		Peer_free(peer);
+	} else if (connection->conn_type == ADMIN_CONNECTION) {
+		free(connection->data); // path of HTTP request
 	}
 
 	Connection_free(connection);
 }
+
+/**
+ * Returns the epoll events of a connection according to the flow control state.
+ * Congested peers are always read from, so that two servers flooding each
+ * other cannot stop reading at the same time and deadlock. Admin connections
+ * are always read from, so the server can be inspected while it is congested.
+ */
+uint32_t Server_connection_events(Server *serv, Connection *conn) {
+	bool reading = serv->n_congested_peers == 0 ||
+				   conn->conn_type == ADMIN_CONNECTION;
+
+	if (conn->conn_type == PEER_CONNECTION) {
+		reading = reading || ((Peer *)conn->data)->congested;
+	}
+
+	return reading ? EPOLLIN | EPOLLOUT : EPOLLOUT;
+}
+
+/**
+ * Update the epoll set with the events of a connection.
+ */
+static void update_connection_events(Server *serv, Connection *conn) {
+	if (serv->net) {
+		return;
+	}
+
+	struct epoll_event ev = {.data.fd = conn->fd,
+							 .events = Server_connection_events(serv, conn)};
+
+	if (epoll_ctl(serv->epollfd, EPOLL_CTL_MOD, conn->fd, &ev) != 0) {
+		perror("epoll_ctl");
+	}
+}
+
+/**
+ * Queue message to be sent to peer, which takes ownership of it. Every message
+ * for a peer is queued here or by the relay and broadcast functions, so that
+ * the congestion of the peer is always up to date.
+ */
+void Server_queue_peer_message(Server *serv, Peer *peer, char *message) {
+	List_push_back(peer->msg_queue, message);
+	Server_update_peer_congestion(serv, peer);
+}
+
+/**
+ * Check the size of a peer's message queue against the watermarks. Once the
+ * queue passes the high watermark the server stops reading from every other
+ * connection, since any of them may feed the peer, until the queue drains
+ * below the low watermark. A peer which is closing is no longer congested.
+ */
+void Server_update_peer_congestion(Server *serv, Peer *peer) {
+	size_t size = List_size(peer->msg_queue);
+	bool congested = peer->congested;
+
+	if (peer->quit) {
+		congested = false;
+	} else if (!peer->congested && size >= serv->peer_queue_high) {
+		congested = true;
+	} else if (peer->congested && size <= serv->peer_queue_low) {
+		congested = false;
+	}
+
+	if (congested == peer->congested) {
+		return;
+	}
+
+	peer->congested = congested;
+	size_t paused_before = serv->n_congested_peers;
+
+	if (congested) {
+		log_warn("peer %s is congested with %zu queued messages", peer->name,
+				 size);
+		serv->n_congested_peers++;
+	} else {
+		log_info("peer %s is no longer congested", peer->name);
+		serv->n_congested_peers--;
+	}
+
+	// Connections only need updating when reads are paused or resumed, or
+	// when the congestion of a peer changes while reads are paused
+	if (!paused_before && !serv->n_congested_peers) {
+		return;
+	}
+
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *conn = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&conn)) {
+		update_connection_events(serv, conn);
+	}
+}
+
+/**
+ * Handle the epoll events of a connection: read and process its messages,
+ * write its next message and close it once it quits. Returns false if the
+ * connection was removed.
+ */
+bool Server_handle_events(Server *serv, Connection *connection,
+						  uint32_t events) {
+	if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+		Server_remove_connection(serv, connection);
+		return false;
+	}
+
+	if (events & EPOLLIN) {
+		if (Connection_read(connection) == -1) {
+			Server_remove_connection(serv, connection);
+			return false;
+		}
+
+		Server_process_request(serv, connection);
+	}
+
+	if (events & EPOLLOUT) {
+		if (Connection_write(connection) == -1) {
+			Server_remove_connection(serv, connection);
+			return false;
+		}
+
+		if (connection->conn_type == PEER_CONNECTION) {
+			Server_update_peer_congestion(serv, connection->data);
+		} else if (connection->conn_type == USER_CONNECTION) {
+			Server_continue_stream(serv, connection->data);
+		}
+	}
+
+	bool quit = connection->quit;
+
+	if (!quit && connection->conn_type == USER_CONNECTION) {
+		User *user = connection->data;
+		quit = user->quit;
+	} else if (!quit && connection->conn_type == PEER_CONNECTION) {
+		Peer *peer = connection->data;
+		quit = peer->quit;
+	}
+
+	if (quit && List_size(connection->outgoing_messages) == 0 &&
+		connection->res_len == 0) {
+		Server_remove_connection(serv, connection);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Work done after every iteration of the event loop: timeouts, and writes of
+ * the journal and channel logs.
+ */
+void Server_finish_poll(Server *serv) {
+	Server_check_timeouts(serv);
+
+	if (serv->journal &&
+		serv->journal->n_records >= JOURNAL_SNAPSHOT_RECORDS) {
+		Journal_start_snapshot(serv->journal, serv->first_channel);
+	}
+
+	Journal_continue_snapshot(serv->journal, JOURNAL_SNAPSHOT_CHUNK);
+
+	Journal_flush(serv->journal);
+	ChannelLog_flush(serv->channel_log);
+}
+
+/**
+ * Wait for events on the listen socket and connections for at most
+ * timeout_ms and handle them. Returns -1 if epoll_wait failed.
+ */
+int Server_poll(Server *serv, int timeout_ms) {
+	struct epoll_event events[MAX_EVENTS];
+
+	int num = epoll_wait(serv->epollfd, events, MAX_EVENTS, timeout_ms);
+
+	if (num == -1) {
+		return -1;
+	}
+
+	uint64_t start_ns = get_time_ns();
+
+	for (int i = 0; i < num; i++) {
+		if (events[i].data.fd == serv->fd) {
+			Server_accept_all(serv);
+			continue;
+		}
+
+		if (events[i].data.fd == serv->admin_fd) {
+			Server_accept_admin(serv);
+			continue;
+		}
+
+		if (events[i].data.fd == serv->signal_fd) {
+			Server_handle_signals(serv);
+			continue;
+		}
+
+		int fd = events[i].data.fd;
+
+		Connection *connection = ht_get(serv->connections, &fd);
+
+		if (!connection) {
+			epoll_ctl(serv->epollfd, EPOLL_CTL_DEL, fd, NULL);
+			continue;
+		}
+
+		Server_handle_events(serv, connection, events[i].events);
+	}
+
+	Server_finish_poll(serv);
+
+	uint64_t busy_ns = get_time_ns() - start_ns;
+	Histogram_add(&serv->loop_latency, busy_ns);
+	Server_update_load(serv, busy_ns);
+
+	return num;
+}
+
+/**
+ * Returns true if the connection has a message to write.
+ */
+static bool has_output(Connection *conn) {
+	if (conn->res_len > 0 || List_size(conn->outgoing_messages) > 0) {
+		return true;
+	}
+
+	if (conn->conn_type == USER_CONNECTION) {
+		User *usr = conn->data;
+		return List_size(usr->msg_queue) > 0 || usr->stream;
+	}
+
+	if (conn->conn_type == PEER_CONNECTION) {
+		return List_size(((Peer *)conn->data)->msg_queue) > 0;
+	}
+
+	return false;
+}
+
+/**
+ * Handle the connections of a server on a simulated network, like an
+ * iteration of the event loop at the current virtual time. Like epoll_wait,
+ * this waits for EPOLL_TIMEOUT_MS unless something arrived for the server or
+ * the last iteration handled events. Writes to a simulated network never
+ * block, so each connection reads everything that has arrived and writes all
+ * its messages, up to SIM_POLL_ROUNDS times each.
+ */
+void Server_poll_simulated(Server *serv) {
+	assert(serv->net);
+
+	uint64_t now = get_time_ms();
+	bool busy = serv->sim_busy;
+
+	if (!SimNet_take_ready(serv->net, serv->name) && !busy &&
+		now < serv->sim_polled_at + EPOLL_TIMEOUT_MS) {
+		return;
+	}
+
+	serv->sim_polled_at = now;
+	serv->sim_busy = !busy; // messages queued by timers are written next time
+
+	Server_accept_all(serv);
+
+	// Connections may be removed while others are handled
+	size_t n = 0;
+	int *fds = malloc((ht_size(serv->connections) + 1) * sizeof *fds);
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *conn = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&conn)) {
+		fds[n++] = conn->fd;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		conn = ht_get(serv->connections, &fds[i]);
+
+		if (!conn) {
+			continue;
+		}
+
+		for (int round = 0; round < SIM_POLL_ROUNDS; round++) {
+			uint32_t events = Server_connection_events(serv, conn);
+
+			if (!SimNet_readable(conn)) {
+				events &= ~EPOLLIN;
+			}
+
+			if (!has_output(conn)) {
+				events &= ~EPOLLOUT;
+			}
+
+			serv->sim_busy = serv->sim_busy || events;
+
+			// A connection without events is still closed if it quit
+			if ((!events && round > 0) ||
+				!Server_handle_events(serv, conn, events)) {
+				break;
+			}
+		}
+	}
+
+	free(fds);
+	Server_finish_poll(serv);
+}
@@ -0,0 +1,155 @@
+#include "include/server.h"
+
+/*
+ * Counters and latency histograms of the commands handled by the server.
+ */
+
+/**
+ * Count message with command which took elapsed_ns to handle. Commands seen
+ * after STATS_MAX_COMMANDS others are counted as STATS_OTHER_COMMAND, so
+ * peers cannot grow the table without bound.
+ */
+void Server_count_command(Server *serv, const char *command, size_t bytes,
+						  uint64_t elapsed_ns, bool remote) {
+	CommandStats *stats = ht_get(serv->command_stats, command);
+
+	if (!stats) {
+		if (ht_size(serv->command_stats) >= STATS_MAX_COMMANDS) {
+			command = STATS_OTHER_COMMAND;
+			stats = ht_get(serv->command_stats, command);
+		}
+
+		if (!stats) {
+			stats = calloc(1, sizeof *stats);
+			ht_set(serv->command_stats, (char *)command, stats);
+		}
+	}
+
+	stats->count++;
+	stats->bytes += bytes;
+	stats->remote_count += remote;
+	Histogram_add(&stats->latency, elapsed_ns);
+}
+
+/**
+ * Send the count and latency of each command for STATS m. Latencies are in
+ * microseconds.
+ */
+void Server_send_command_stats(Server *serv, User *usr) {
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->command_stats);
+	char *command = NULL;
+	CommandStats *stats = NULL;
+
+	while (ht_iter_next(&itr, (void **)&command, (void **)&stats)) {
+		List_push_back(usr->msg_queue,
+					   Server_create_reply(serv, RPL_STATSCOMMANDS, usr->nick,
+										   command, (long)stats->count,
+										   (long)stats->bytes,
+										   (long)stats->remote_count));
+
+		const Histogram *latency = &stats->latency;
+		char *line = make_string(
+			"%s latency us p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f "
+			"mean %.1f",
+			command, Histogram_percentile(latency, 50) / 1000.0,
+			Histogram_percentile(latency, 90) / 1000.0,
+			Histogram_percentile(latency, 99) / 1000.0,
+			Histogram_percentile(latency, 99.9) / 1000.0,
+			latency->max / 1000.0,
+			latency->total ? latency->sum / 1000.0 / latency->total : 0.0);
+		List_push_back(usr->msg_queue, Server_create_reply(serv, RPL_STATSDEBUG,
+														   usr->nick, line));
+		free(line);
+	}
+}
+
+/**
+ * Send the traffic of each peer link for STATS l: queued messages, messages
+ * and kilobytes sent, messages and kilobytes received and seconds since the
+ * link was established.
+ */
+void Server_send_link_stats(Server *serv, User *usr) {
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->connections);
+	Connection *conn = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&conn)) {
+		if (conn->conn_type != PEER_CONNECTION) {
+			continue;
+		}
+
+		Peer *peer = conn->data;
+
+		if (!peer->registered) {
+			continue;
+		}
+
+		List_push_back(
+			usr->msg_queue,
+			Server_create_reply(
+				serv, RPL_STATSLINKINFO, usr->nick, peer->name,
+				(int)List_size(peer->msg_queue), (long)conn->messages_sent,
+				(long)(conn->bytes_sent / 1024), (long)conn->messages_received,
+				(long)(conn->bytes_received / 1024),
+				(long)(time(NULL) - peer->connected_at)));
+
+		char *lag = make_string("%s rtt %ld ms, %d missed pings", peer->name,
+								peer->rtt_ms, peer->missed_pings);
+		List_push_back(usr->msg_queue, Server_create_reply(serv, RPL_STATSDEBUG,
+														   usr->nick, lag));
+		free(lag);
+	}
+}
+
+/**
+ * Account an iteration of the event loop which spent busy_ns handling events.
+ * The server is overloaded when the moving average of iteration time, which
+ * is how long a new event may wait to be noticed, or the busy share of the
+ * last window is too high. It stays overloaded until both fall to half of
+ * their limits, so it does not flap at the edge.
+ */
+void Server_update_load(Server *serv, uint64_t busy_ns) {
+	uint64_t now = get_time_ns();
+
+	serv->loop_lag_ns = serv->loop_lag_ns - serv->loop_lag_ns / 8 + busy_ns / 8;
+	serv->load_window_busy += busy_ns;
+
+	if (serv->load_window_start == 0) {
+		serv->load_window_start = now;
+	} else if (now - serv->load_window_start >= LOAD_WINDOW_MS * 1000000ULL) {
+		serv->loop_busy_percent =
+			MIN(100, serv->load_window_busy * 100 / (now - serv->load_window_start));
+		serv->load_window_start = now;
+		serv->load_window_busy = 0;
+	}
+
+	uint64_t lag_ms = serv->loop_lag_ns / 1000000;
+
+	if (!serv->overloaded && (lag_ms >= OVERLOAD_LAG_MS ||
+							  serv->loop_busy_percent >= OVERLOAD_BUSY_PERCENT)) {
+		serv->overloaded = true;
+		serv->overloads++;
+		log_warn("Server overloaded: loop lag %lu ms, busy %u%%",
+				 (unsigned long)lag_ms, serv->loop_busy_percent);
+	} else if (serv->overloaded && lag_ms < OVERLOAD_LAG_MS / 2 &&
+			   serv->loop_busy_percent < OVERLOAD_BUSY_PERCENT / 2) {
+		serv->overloaded = false;
+		log_info("Server recovered from overload: %lu commands refused so far",
+				 serv->refused_commands);
+	}
+}
+
+/**
+ * Send the lag and busy share of the event loop for STATS u.
+ */
+void Server_send_load_stats(Server *serv, User *usr) {
+	char *line = make_string(
+		"loop lag %.3f ms, busy %u%%, %s, %lu overloads, %lu commands refused",
+		serv->loop_lag_ns / 1e6, serv->loop_busy_percent,
+		serv->overloaded ? "overloaded" : "not overloaded", serv->overloads,
+		serv->refused_commands);
+	List_push_back(usr->msg_queue,
+				   Server_create_reply(serv, RPL_STATSDEBUG, usr->nick, line));
+	free(line);
+}
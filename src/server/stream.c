@@ -0,0 +1,243 @@
+#include "include/server.h"
+
+/*
+ * Channel list of the server and the bulk replies streamed from it.
+ *
+ * Channels are kept in a list in order of creation and in the channel index
+ * besides the map by name. A stream holds a pointer to the next channel it
+ * sends, which is moved on when that channel is removed, so a stream stays
+ * valid however channels change between its chunks. Snapshots of the journal
+ * are built from the list the same way.
+ */
+
+static void link_channel(Server *serv, Channel *channel) {
+	channel->prev = serv->last_channel;
+	channel->next = NULL;
+
+	if (serv->last_channel) {
+		serv->last_channel->next = channel;
+	} else {
+		serv->first_channel = channel;
+	}
+
+	serv->last_channel = channel;
+}
+
+/**
+ * Add new channel to the map and list of channels.
+ */
+void Server_add_channel(Server *serv, Channel *channel) {
+	ht_set(serv->name_to_channel_map, channel->name, channel);
+	link_channel(serv, channel);
+	ChannelIndex_add(serv->channel_index, channel);
+}
+
+/**
+ * Remove and free channel. Streams which would send it next skip it, as does
+ * a snapshot of the journal being built.
+ */
+void Server_remove_channel(Server *serv, Channel *channel) {
+	Journal_skip_channel(serv->journal, channel);
+
+	for (size_t i = 0; i < Vector_size(serv->streams); i++) {
+		ReplyStream *stream = Vector_get_at(serv->streams, i);
+
+		if (stream->next == channel) {
+			stream->next = channel->next;
+		}
+	}
+
+	if (channel->prev) {
+		channel->prev->next = channel->next;
+	} else {
+		serv->first_channel = channel->next;
+	}
+
+	if (channel->next) {
+		channel->next->prev = channel->prev;
+	} else {
+		serv->last_channel = channel->prev;
+	}
+
+	ChannelIndex_remove(serv->channel_index, channel);
+	ht_remove(serv->name_to_channel_map, channel->name, NULL, NULL);
+}
+
+/**
+ * Build the channel list and index from the channels loaded at startup.
+ */
+void Server_link_channels(Server *serv) {
+	HashtableIter itr;
+	ht_iter_init(&itr, serv->name_to_channel_map);
+	Channel *channel = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&channel)) {
+		link_channel(serv, channel);
+		ChannelIndex_add(serv->channel_index, channel);
+	}
+}
+
+/**
+ * Free the stream which is being sent. The next stream of the user, if any,
+ * becomes the current one.
+ */
+static void end_stream(Server *serv, ReplyStream *stream) {
+	for (size_t i = 0; i < Vector_size(serv->streams); i++) {
+		if (Vector_get_at(serv->streams, i) == stream) {
+			Vector_remove(serv->streams, i, NULL);
+			break;
+		}
+	}
+
+	if (stream->rows) {
+		ht_free(stream->rows);
+	}
+
+	stream->usr->stream = stream->after;
+	free(stream);
+}
+
+static void begin_stream(Server *serv, ReplyStream *stream) {
+	stream->next = serv->first_channel;
+	Vector_push(serv->streams, stream);
+
+	if (stream->type == STREAM_LIST) {
+		List_push_back(stream->usr->msg_queue,
+					   Server_create_reply(serv, RPL_LISTSTART, stream->usr->nick));
+	}
+}
+
+static void send_stream_end(Server *serv, ReplyStream *stream) {
+	if (stream->type == STREAM_LIST) {
+		List_push_back(stream->usr->msg_queue,
+					   Server_create_reply(serv, RPL_LISTEND, stream->usr->nick));
+	}
+}
+
+/**
+ * Send RPL_LIST for a local channel, with the members and topic of the
+ * channel on other servers added in.
+ */
+static void send_list_channel(Server *serv, ReplyStream *stream,
+							  Channel *channel) {
+	long count = ht_size(channel->members);
+	const char *topic = channel->topic ? channel->topic : "";
+	char *row = NULL;
+
+	if (stream->rows &&
+		ht_remove(stream->rows, channel->name, NULL, (void **)&row)) {
+		const char *other_topic = NULL;
+		count += parse_list_row(row, &other_topic);
+
+		if (!*topic) {
+			topic = other_topic;
+		}
+	}
+
+	User *usr = stream->usr;
+	List_push_back(usr->msg_queue, Server_create_reply(serv, RPL_LIST, usr->nick,
+													   channel->name, count,
+													   topic));
+	free(row);
+}
+
+/**
+ * Start to send the reply to LIST or NAMES for all channels to usr, after any
+ * streams the user already has. Takes ownership of the LIST rows of other
+ * servers.
+ */
+void Server_start_stream(Server *serv, User *usr, int type, Hashtable *rows) {
+	ReplyStream **last = &usr->stream;
+	int waiting = 0;
+
+	for (; *last; last = &(*last)->after) {
+		waiting++;
+	}
+
+	// The first stream is being sent and does not count
+	if (waiting > STREAM_MAX_WAITING) {
+		List_push_back(usr->msg_queue,
+					   Server_create_reply(serv, RPL_TRYAGAIN, usr->nick,
+										   type == STREAM_LIST ? "LIST" : "NAMES"));
+		if (rows) {
+			ht_free(rows);
+		}
+		return;
+	}
+
+	ReplyStream *stream = calloc(1, sizeof *stream);
+	stream->type = type;
+	stream->usr = usr;
+	stream->rows = rows;
+	*last = stream;
+
+	if (stream == usr->stream) {
+		begin_stream(serv, stream);
+		Server_continue_stream(serv, usr);
+	}
+}
+
+/**
+ * Send the next chunk of the stream of usr if few of its messages are left to
+ * write. The stream is ended after the last chunk.
+ */
+void Server_continue_stream(Server *serv, User *usr) {
+	ReplyStream *stream = usr->stream;
+
+	if (!stream || List_size(usr->msg_queue) >= STREAM_LOW_WATERMARK) {
+		return;
+	}
+
+	int sent = 0;
+
+	for (; stream->next && sent < STREAM_CHUNK; sent++) {
+		Channel *channel = stream->next;
+		stream->next = channel->next;
+
+		if (stream->type == STREAM_LIST) {
+			send_list_channel(serv, stream, channel);
+		} else {
+			send_names_reply(serv, usr, channel);
+		}
+	}
+
+	// Channels which are only on other servers follow the local ones
+	if (!stream->next && stream->rows) {
+		if (!stream->rows_started) {
+			ht_iter_init(&stream->row_itr, stream->rows);
+			stream->rows_started = true;
+		}
+
+		char *name = NULL;
+		char *row = NULL;
+
+		for (; sent < STREAM_CHUNK &&
+			   ht_iter_next(&stream->row_itr, (void **)&name, (void **)&row);
+			 sent++) {
+			const char *topic = NULL;
+			long count = parse_list_row(row, &topic);
+			List_push_back(usr->msg_queue,
+						   Server_create_reply(serv, RPL_LIST, usr->nick, name,
+											   count, topic));
+		}
+	}
+
+	if (sent < STREAM_CHUNK) {
+		send_stream_end(serv, stream);
+		end_stream(serv, stream);
+
+		if (usr->stream) {
+			begin_stream(serv, usr->stream);
+			Server_continue_stream(serv, usr);
+		}
+	}
+}
+
+/**
+ * Drop the streams of a user who is leaving.
+ */
+void Server_stop_stream(Server *serv, User *usr) {
+	while (usr->stream) {
+		end_stream(serv, usr->stream);
+	}
+}
@@ -0,0 +1,647 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "include/common.h"
+#include "include/common_types.h"
+#include "include/connection.h"
+#include "include/hashtable.h"
+#include "include/list.h"
+#include "include/message.h"
+#include "include/skiplist.h"
+#include "include/sstring.h"
+#include "include/vector.h"
+
+/*
+ * Microbenchmarks of the containers, message parsing and framing used on
+ * the hot paths of the server.
+ *
+ * Each benchmark runs once to warm up and then a number of times with the
+ * same input; the median time per operation is reported with the number of
+ * heap allocations per operation. Allocations are counted by replacing
+ * malloc and friends with wrappers around the glibc allocator. Results can
+ * be written as JSON and compared with an earlier file.
+ */
+
+#define MICROBENCH_OPS 100000		 // default operations per run
+#define MICROBENCH_RUNS 5			 // default runs after the warm up
+#define MICROBENCH_STREAM_SIZE 32768 // bytes written to the pipe at a time
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static uint64_t n_allocs = 0;
+
+void *malloc(size_t size)
+{
+	__atomic_fetch_add(&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+	__atomic_fetch_add(&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	__atomic_fetch_add(&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+
+/**
+ * Time and allocations of the measured parts of a run. Setup and cleanup
+ * of a benchmark happen outside timer_start() and timer_stop().
+ */
+typedef struct Timer
+{
+	uint64_t start_ns;
+	uint64_t start_allocs;
+	uint64_t ns;
+	uint64_t allocs;
+} Timer;
+
+static void timer_start(Timer *timer)
+{
+	timer->start_allocs = __atomic_load_n(&n_allocs, __ATOMIC_RELAXED);
+	timer->start_ns = get_time_ns();
+}
+
+static void timer_stop(Timer *timer)
+{
+	timer->ns += get_time_ns() - timer->start_ns;
+	timer->allocs += __atomic_load_n(&n_allocs, __ATOMIC_RELAXED) - timer->start_allocs;
+}
+
+typedef struct Benchmark
+{
+	const char *name;
+	void (*run)(Timer *timer, size_t n);
+} Benchmark;
+
+typedef struct Result
+{
+	const char *name;
+	double ns_per_op;	  // median of the runs
+	double min_ns_per_op; // fastest run
+	double allocs_per_op;
+} Result;
+
+// Keeps the compiler from dropping the work of a benchmark
+static volatile uintptr_t sink;
+
+static const char *sample_messages[] = {
+	"PRIVMSG #general :hello everyone, how is it going today?",
+	":alice!alice@127.0.0.1 PRIVMSG #general :fine, thanks",
+	"JOIN #general,#random",
+	":server1 NICK bob 1 bob 127.0.0.1 1 + :Bob Builder",
+	"PING :server1",
+	"MODE #general +o alice",
+};
+
+#define N_SAMPLES (sizeof sample_messages / sizeof *sample_messages)
+
+static char **make_keys(size_t n)
+{
+	char **keys = calloc(n, sizeof *keys);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		keys[i] = make_string("nick%zu", i);
+	}
+
+	return keys;
+}
+
+static void free_keys(char **keys, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		free(keys[i]);
+	}
+
+	free(keys);
+}
+
+static Hashtable *make_table(char **keys, size_t n)
+{
+	Hashtable *table = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		ht_set(table, keys[i], keys[i]);
+	}
+
+	return table;
+}
+
+static void bench_ht_set(Timer *timer, size_t n)
+{
+	char **keys = make_keys(n);
+	Hashtable *table = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		ht_set(table, keys[i], keys[i]);
+	}
+
+	timer_stop(timer);
+
+	ht_free(table);
+	free_keys(keys, n);
+}
+
+static void bench_ht_get(Timer *timer, size_t n)
+{
+	char **keys = make_keys(n);
+	Hashtable *table = make_table(keys, n);
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		sink += (uintptr_t)ht_get(table, keys[(i * 7919) % n]);
+	}
+
+	timer_stop(timer);
+
+	ht_free(table);
+	free_keys(keys, n);
+}
+
+static void bench_ht_remove(Timer *timer, size_t n)
+{
+	char **keys = make_keys(n);
+	Hashtable *table = make_table(keys, n);
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		sink += ht_remove(table, keys[i], NULL, NULL);
+	}
+
+	timer_stop(timer);
+
+	ht_free(table);
+	free_keys(keys, n);
+}
+
+static void bench_skiplist_insert(Timer *timer, size_t n)
+{
+	SkipList *list = SkipList_alloc();
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		SkipList_insert(list, (i * 7919) % n, (void *)i);
+	}
+
+	timer_stop(timer);
+
+	SkipList_free(list);
+}
+
+static void bench_skiplist_seek(Timer *timer, size_t n)
+{
+	SkipList *list = SkipList_alloc();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		SkipList_insert(list, i, (void *)i);
+	}
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		sink += (uintptr_t)SkipList_seek(list, (i * 7919) % n)->elem;
+	}
+
+	timer_stop(timer);
+
+	SkipList_free(list);
+}
+
+static void bench_list_push_back(Timer *timer, size_t n)
+{
+	List *list = List_alloc(NULL, NULL);
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		List_push_back(list, (void *)(i + 1));
+	}
+
+	timer_stop(timer);
+
+	List_free(list);
+}
+
+static void bench_list_pop_front(Timer *timer, size_t n)
+{
+	List *list = List_alloc(NULL, NULL);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		List_push_back(list, (void *)(i + 1));
+	}
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		sink += (uintptr_t)List_peek_front(list);
+		List_pop_front(list);
+	}
+
+	timer_stop(timer);
+
+	List_free(list);
+}
+
+static void bench_vector_push(Timer *timer, size_t n)
+{
+	Vector *vector = Vector_alloc(4, NULL, NULL);
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		Vector_push(vector, (void *)(i + 1));
+	}
+
+	timer_stop(timer);
+
+	Vector_free(vector);
+}
+
+/*
+ * Removes from the back, so the cost of the call is measured rather than the
+ * shifting of a long vector.
+ */
+static void bench_vector_remove(Timer *timer, size_t n)
+{
+	Vector *vector = Vector_alloc(n, NULL, NULL);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		Vector_push(vector, (void *)(i + 1));
+	}
+
+	timer_start(timer);
+
+	for (size_t i = n; i > 0; i--)
+	{
+		void *elem = NULL;
+		Vector_remove(vector, i - 1, &elem);
+		sink += (uintptr_t)elem;
+	}
+
+	timer_stop(timer);
+
+	Vector_free(vector);
+}
+
+static void bench_sstring_add_string(Timer *timer, size_t n)
+{
+	sstring *str = sstring_create();
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		sstring_add_string(str, "PRIVMSG #general ");
+	}
+
+	timer_stop(timer);
+
+	sink += sstring_size(str);
+	sstring_destroy(str);
+}
+
+static void bench_parse_message(Timer *timer, size_t n)
+{
+	char buf[MAX_MSG_LEN + 1];
+
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		// parse_message() writes into the string
+		strcpy(buf, sample_messages[i % N_SAMPLES]);
+
+		Message msg;
+		message_init(&msg);
+		sink += parse_message(buf, &msg) + msg.n_params;
+		message_destroy(&msg);
+	}
+
+	timer_stop(timer);
+}
+
+static void bench_make_string(Timer *timer, size_t n)
+{
+	timer_start(timer);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		char *str = make_string(":%s!%s@%s PRIVMSG %s :%s %zu", "alice", "alice", "127.0.0.1",
+								"#general", "hello everyone", i);
+		sink += (uintptr_t)str[0];
+		free(str);
+	}
+
+	timer_stop(timer);
+}
+
+/*
+ * Frames messages from a canned byte stream in a pipe and takes them from
+ * the incoming queue, like the server does for each readable connection.
+ * An operation is one message. Writes to the pipe are not timed.
+ */
+static void bench_connection_read(Timer *timer, size_t n)
+{
+	char *stream = malloc(MICROBENCH_STREAM_SIZE);
+	size_t stream_len = 0;
+	size_t stream_messages = 0;
+
+	for (size_t i = 0;; i++)
+	{
+		const char *message = sample_messages[i % N_SAMPLES];
+		size_t len = strlen(message);
+
+		if (stream_len + len + 2 > MICROBENCH_STREAM_SIZE)
+		{
+			break;
+		}
+
+		memcpy(stream + stream_len, message, len);
+		memcpy(stream + stream_len + len, "\r\n", 2);
+		stream_len += len + 2;
+		stream_messages++;
+	}
+
+	int fds[2];
+	CHECK(pipe(fds), "pipe");
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	Connection *conn = Connection_alloc_local(fds[0], "microbench");
+	size_t framed = 0;
+
+	while (framed < n)
+	{
+		ssize_t written = write_all(fds[1], stream, stream_len);
+		assert(written == (ssize_t)stream_len);
+		size_t pending = stream_len;
+
+		timer_start(timer);
+
+		while (pending > 0)
+		{
+			ssize_t nread = Connection_read(conn);
+			assert(nread > 0);
+			pending -= nread;
+
+			while (List_size(conn->incoming_messages) > 0)
+			{
+				sink += (uintptr_t)List_peek_front(conn->incoming_messages);
+				List_pop_front(conn->incoming_messages);
+				framed++;
+			}
+		}
+
+		timer_stop(timer);
+	}
+
+	// Whole streams are framed, so the time is scaled to n messages
+	timer->ns = timer->ns * n / framed;
+	timer->allocs = timer->allocs * n / framed;
+	assert(framed % stream_messages == 0);
+
+	close(fds[1]);
+	Connection_free(conn);
+	free(stream);
+}
+
+static const Benchmark benchmarks[] = {
+	{"ht_set", bench_ht_set},
+	{"ht_get", bench_ht_get},
+	{"ht_remove", bench_ht_remove},
+	{"SkipList_insert", bench_skiplist_insert},
+	{"SkipList_seek", bench_skiplist_seek},
+	{"List_push_back", bench_list_push_back},
+	{"List_pop_front", bench_list_pop_front},
+	{"Vector_push", bench_vector_push},
+	{"Vector_remove", bench_vector_remove},
+	{"sstring_add_string", bench_sstring_add_string},
+	{"parse_message", bench_parse_message},
+	{"make_string", bench_make_string},
+	{"Connection_read", bench_connection_read},
+};
+
+#define N_BENCHMARKS (sizeof benchmarks / sizeof *benchmarks)
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static Result run_benchmark(const Benchmark *benchmark, size_t n, int runs)
+{
+	Timer timer;
+	memset(&timer, 0, sizeof timer);
+	benchmark->run(&timer, n / 10 + 1);
+
+	double *ns_per_op = calloc(runs, sizeof *ns_per_op);
+	Result result = {.name = benchmark->name};
+
+	for (int i = 0; i < runs; i++)
+	{
+		memset(&timer, 0, sizeof timer);
+		benchmark->run(&timer, n);
+		ns_per_op[i] = (double)timer.ns / n;
+		result.allocs_per_op = (double)timer.allocs / n;
+	}
+
+	qsort(ns_per_op, runs, sizeof *ns_per_op, compare_double);
+	result.ns_per_op = ns_per_op[runs / 2];
+	result.min_ns_per_op = ns_per_op[0];
+	free(ns_per_op);
+
+	return result;
+}
+
+static bool write_json(const char *filename, Result *results, size_t n_results, size_t n, int runs)
+{
+	FILE *file = fopen(filename, "w");
+
+	if (!file)
+	{
+		perror(filename);
+		return false;
+	}
+
+	// One benchmark per line, which read_baseline() relies on
+	fprintf(file, "{\n  \"ops\": %zu,\n  \"runs\": %d,\n  \"benchmarks\": [\n", n, runs);
+
+	for (size_t i = 0; i < n_results; i++)
+	{
+		fprintf(file,
+				"    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, "
+				"\"allocs_per_op\": %.2f}%s\n",
+				results[i].name, results[i].ns_per_op, results[i].min_ns_per_op, results[i].allocs_per_op,
+				i + 1 < n_results ? "," : "");
+	}
+
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+	return true;
+}
+
+/**
+ * Look up the result of benchmark with name in a file written by
+ * write_json(). Returns false if it is not there.
+ */
+static bool read_baseline(const char *filename, const char *name, Result *result)
+{
+	FILE *file = fopen(filename, "r");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	char *key = make_string("\"name\": \"%s\"", name);
+	char line[512];
+	bool found = false;
+
+	while (!found && fgets(line, sizeof line, file))
+	{
+		char *ns = strstr(line, "\"ns_per_op\": ");
+		char *allocs = strstr(line, "\"allocs_per_op\": ");
+
+		if (strstr(line, key) && ns && allocs)
+		{
+			result->ns_per_op = strtod(ns + 13, NULL);
+			result->allocs_per_op = strtod(allocs + 17, NULL);
+			found = true;
+		}
+	}
+
+	free(key);
+	fclose(file);
+	return found;
+}
+
+static void usage(const char *program)
+{
+	fprintf(stderr, "Usage: %s [options] [benchmark...]\n", program);
+	fprintf(stderr, "  -n <ops>   operations per run (default %d)\n", MICROBENCH_OPS);
+	fprintf(stderr, "  -r <runs>  runs after the warm up (default %d)\n", MICROBENCH_RUNS);
+	fprintf(stderr, "  -o <file>  write results as JSON\n");
+	fprintf(stderr, "  -b <file>  compare with results written earlier with -o\n");
+	fprintf(stderr, "Benchmarks:");
+
+	for (size_t i = 0; i < N_BENCHMARKS; i++)
+	{
+		fprintf(stderr, " %s", benchmarks[i].name);
+	}
+
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+	size_t n = MICROBENCH_OPS;
+	int runs = MICROBENCH_RUNS;
+	const char *output = NULL;
+	const char *baseline = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:o:b:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			n = atol(optarg);
+			break;
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'b':
+			baseline = optarg;
+			break;
+		default:
+			usage(*argv);
+			return 1;
+		}
+	}
+
+	if (n == 0 || runs <= 0)
+	{
+		usage(*argv);
+		return 1;
+	}
+
+	Result results[N_BENCHMARKS];
+	size_t n_results = 0;
+
+	for (size_t i = 0; i < N_BENCHMARKS; i++)
+	{
+		bool selected = optind == argc;
+
+		for (int j = optind; j < argc && !selected; j++)
+		{
+			selected = !strcmp(argv[j], benchmarks[i].name);
+		}
+
+		if (!selected)
+		{
+			continue;
+		}
+
+		Result *result = &results[n_results++];
+		*result = run_benchmark(&benchmarks[i], n, runs);
+		printf("%-20s %10.1f ns/op %8.2f allocs/op (min %.1f ns/op)", result->name, result->ns_per_op,
+			   result->allocs_per_op, result->min_ns_per_op);
+
+		Result base;
+
+		if (baseline && read_baseline(baseline, result->name, &base) && base.ns_per_op > 0)
+		{
+			printf(", %+.1f%% ns/op, %+.2f allocs/op", (result->ns_per_op / base.ns_per_op - 1) * 100,
+				   result->allocs_per_op - base.allocs_per_op);
+		}
+
+		printf("\n");
+	}
+
+	if (n_results == 0)
+	{
+		usage(*argv);
+		return 1;
+	}
+
+	if (output && !write_json(output, results, n_results, n, runs))
+	{
+		return 1;
+	}
+
+	return 0;
+}
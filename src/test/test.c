@@ -1,11 +1,21 @@
+#include <dirent.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #include "include/common.h"
 #include "include/common_types.h"
 #include "include/hashtable.h"
+#include "include/hll.h"
 #include "include/list.h"
 #include "include/message.h"
+#include "include/msgbuf.h"
 #include "include/queue.h"
+#include "include/replies.h"
+#include "include/server.h"
 #include "include/vector.h"
 
 void print_string(void *s)
@@ -339,6 +349,51 @@ void message_test()
 	Vector_free(arr);
 	Vector_free(arr2);
 	Vector_free(arr3);
+
+	Message msg;
+	message_init(&msg);
+	char *s4 = strdup(":alice!alice@localhost PRIVMSG #chan :hello world");
+	assert(parse_message_head(s4, &msg) == 0);
+	assert(msg.message == s4);
+	assert(!strcmp(msg.origin, "alice!alice@localhost"));
+	assert(!strcmp(msg.command, "PRIVMSG"));
+	assert(!strcmp(msg.params[0], "#chan"));
+	assert(msg.n_params == 1 && !msg.body);
+	message_destroy(&msg);
+
+	message_init(&msg);
+	assert(parse_message_head(strdup("QUIT :bye"), &msg) == 0);
+	assert(!msg.origin && !strcmp(msg.command, "QUIT") && msg.n_params == 0);
+	message_destroy(&msg);
+
+	message_init(&msg);
+	assert(parse_message_head(strdup(":server1"), &msg) == -1);
+	message_destroy(&msg);
+
+	// A middle param may contain ':', only " :" starts the body
+	char s5[] = "CHATHISTORY BEFORE #chan timestamp=2023-01-01T12:00:00.000Z 20";
+	message_init(&msg);
+	assert(parse_message(s5, &msg) == 0);
+	assert(!strcmp(msg.command, "CHATHISTORY") && msg.n_params == 4 && !msg.body);
+	assert(!strcmp(msg.params[2], "timestamp=2023-01-01T12:00:00.000Z"));
+	assert(!strcmp(msg.params[3], "20"));
+	message_destroy(&msg);
+
+	char s6[] = "CMD :x";
+	message_init(&msg);
+	assert(parse_message(s6, &msg) == 0);
+	assert(!msg.origin && !strcmp(msg.command, "CMD") && msg.n_params == 0);
+	assert(!strcmp(msg.body, "x"));
+	message_destroy(&msg);
+
+	char s7[] = ":alice!alice@localhost PRIVMSG #chan :hello: world :)";
+	message_init(&msg);
+	assert(parse_message(s7, &msg) == 0);
+	assert(!strcmp(msg.origin, "alice!alice@localhost"));
+	assert(!strcmp(msg.command, "PRIVMSG") && msg.n_params == 1);
+	assert(!strcmp(msg.params[0], "#chan"));
+	assert(!strcmp(msg.body, "hello: world :)"));
+	message_destroy(&msg);
 }
 
 void log_test()
@@ -419,52 +474,2894 @@ void line_wrap_test(size_t width)
 	Vector_free(lines);
 }
 
-int main(int argc, char *argv[])
+void hll_test()
 {
-	if (argc < 2)
+	HyperLogLog a, b, c;
+	hll_init(&a);
+	hll_init(&b);
+
+	assert(hll_estimate(&a) == 0);
+
+	char name[32];
+	for (int i = 0; i < 10000; i++)
 	{
-		fprintf(stderr, "Usage: %s test_case\n", *argv);
-		return 1;
+		sprintf(name, "#channel%d", i);
+		hll_add(i < 6000 ? &a : &b, name);
+		hll_add(&a, name); // duplicates must not be counted
 	}
 
-	int test_num = atoi(argv[1]);
-	char *filename;
-	size_t width;
+	double estimate = hll_estimate(&a);
+	log_info("hll_estimate() = %.0f", estimate);
+	assert(estimate > 10000 * 0.8 && estimate < 10000 * 1.2);
 
-	switch (test_num)
+	// union of overlapping sets
+	hll_merge(&b, &a);
+	estimate = hll_estimate(&b);
+	assert(estimate > 10000 * 0.8 && estimate < 10000 * 1.2);
+
+	char encoded[HLL_REGISTERS + 1];
+	hll_encode(&a, encoded);
+	assert(strlen(encoded) == HLL_REGISTERS);
+	assert(hll_decode(&c, encoded));
+	assert(!memcmp(&a, &c, sizeof a));
+	assert(!hll_decode(&c, "invalid"));
+
+	log_info("success");
+}
+
+/* Send a line and count the PRIVMSGs relayed to a fake peer socket */
+static void send_line(int fd, const char *line)
+{
+	assert(write_all(fd, (char *)line, strlen(line)) == (ssize_t)strlen(line));
+}
+
+static size_t count_relayed(int fd, char *buf, size_t *len)
+{
+	size_t count = 0;
+	ssize_t n;
+
+	while ((n = read(fd, buf + *len, MAX_MSG_LEN - *len)) > 0)
 	{
-	case 1:
-		message_test();
-		break;
-	case 2:
-		vector_test();
-		break;
-	case 3:
-		hashtable_test();
-		break;
-	case 4:
-		hashtable_iter_test();
-		break;
-	case 5:
-		queue_test();
-		break;
-	case 6:
-		filename = argv[2];
-		if (!filename)
+		*len += n;
+		buf[*len] = 0;
+
+		char *start = buf, *end;
+
+		while ((end = strstr(start, "\r\n")))
 		{
-			return 1;
+			*end = 0;
+			count += strstr(start, " PRIVMSG bob :") != NULL;
+			start = end + 2;
 		}
-		read_test(filename);
-		break;
-	case 7:
-		width = argc < 3 ? 10 : atol(argv[2]);
-		line_wrap_test(width);
-		break;
-	case 8:
-		hashtable_test2();
-		break;
-	case 9:
-		hashtable_test1();
+
+		*len = strlen(start);
+		memmove(buf, start, *len + 1);
+	}
+
+	return count;
+}
+
+/**
+ * Flood a user connection with messages for a user behind a peer whose link
+ * is never read from. The server must stop reading from the user once the
+ * peer queue passes the high watermark and resume once it drains, without
+ * dropping any messages. Run from the project root (uses config.csv).
+ */
+void flow_control_test()
+{
+	Server *serv = Server_create("server1");
+	serv->peer_queue_high = 64;
+	serv->peer_queue_low = 16;
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	// Throttled loopback link: small receive buffer and nothing is read
+	int peer_fd = socket(AF_INET, SOCK_STREAM, 0);
+	int rcvbuf = 4096;
+	assert(setsockopt(peer_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf) == 0);
+	assert(connect(peer_fd, (struct sockaddr *)&serv->servaddr, sizeof serv->servaddr) == 0);
+	send_line(peer_fd, "PASS test1 * *\r\nSERVER server2 :test\r\n"
+					   "NICK bob 1 bob localhost 1 + :Bob\r\n");
+
+	int user_fd = connect_to_host("127.0.0.1", serv->port);
+	assert(user_fd != -1);
+	send_line(user_fd, "NICK alice\r\nUSER alice * * :Alice\r\n");
+
+	for (int i = 0; i < 50; i++)
+	{
+		Server_poll(serv, 10);
+	}
+
+	Peer *peer = ht_get(serv->name_to_peer_map, "server2");
+	assert(peer && peer->registered);
+	assert(ht_get(serv->nick_to_user_map, "alice"));
+
+	char line[256];
+	char body[200];
+	memset(body, 'x', sizeof body - 1);
+	body[sizeof body - 1] = 0;
+	snprintf(line, sizeof line, "PRIVMSG bob :%s\r\n", body);
+
+	size_t sent = 0;
+
+	for (int i = 0; i < 1000 && !serv->n_congested_peers; i++)
+	{
+		for (int j = 0; j < 10; j++, sent++)
+		{
+			send_line(user_fd, line);
+		}
+
+		Server_poll(serv, 10);
+	}
+
+	assert(serv->n_congested_peers == 1 && peer->congested);
+	log_info("peer congested after %zu messages", sent);
+
+	// The user is not read from while the peer is congested
+	for (int j = 0; j < 10; j++, sent++)
+	{
+		send_line(user_fd, line);
+	}
+
+	size_t queued = List_size(peer->msg_queue);
+
+	for (int i = 0; i < 50; i++)
+	{
+		Server_poll(serv, 1);
+	}
+
+	assert(peer->congested);
+	assert(List_size(peer->msg_queue) <= queued);
+
+	// Drain the link until all messages have been relayed
+	fcntl(peer_fd, F_SETFL, fcntl(peer_fd, F_GETFL) | O_NONBLOCK);
+	char buf[MAX_MSG_LEN + 1];
+	size_t len = 0;
+	size_t relayed = 0;
+
+	for (int i = 0; i < 10000 && relayed < sent; i++)
+	{
+		relayed += count_relayed(peer_fd, buf, &len);
+		Server_poll(serv, 1);
+	}
+
+	assert(relayed == sent);
+	assert(!peer->congested && serv->n_congested_peers == 0);
+	log_info("relayed %zu messages", relayed);
+
+	close(user_fd);
+	close(peer_fd);
+}
+
+/* Connect a fake peer to serv and register it as server name */
+static int connect_peer(Server *serv, const char *name)
+{
+	char line[128];
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	assert(connect(fd, (struct sockaddr *)&serv->servaddr, sizeof serv->servaddr) == 0);
+	// Send each line at once rather than after the last one was acknowledged
+	int on = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+	snprintf(line, sizeof line, "PASS test1 * *\r\nSERVER %s :test\r\n", name);
+	send_line(fd, line);
+
+	for (int i = 0; i < 20; i++)
+	{
+		Server_poll(serv, 10);
+	}
+
+	return fd;
+}
+
+/* Read what is available on fd into buf, which holds size bytes */
+static void read_available(int fd, char *buf, size_t size)
+{
+	size_t len = 0;
+	ssize_t n;
+
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	while (len < size - 1 && (n = read(fd, buf + len, size - 1 - len)) > 0)
+	{
+		len += n;
+	}
+
+	buf[len] = 0;
+}
+
+static size_t count_substr(const char *str, const char *substr)
+{
+	size_t count = 0;
+
+	for (const char *s = str; (s = strstr(s, substr)); s += strlen(substr))
+	{
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * Link server2, with server4 behind it, and then server3 to server1. The burst
+ * to server3 must name each server once, or server3 sees a duplicate SERVER
+ * and drops the link as a cycle. Run from the project root (uses config.csv).
+ */
+void server_burst_test()
+{
+	Server *serv = Server_create("server1");
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	int fd2 = connect_peer(serv, "server2");
+	send_line(fd2, "SERVER server4 :behind server2\r\n");
+
+	for (int i = 0; i < 20; i++)
+	{
+		Server_poll(serv, 10);
+	}
+
+	Peer *peer2 = ht_get(serv->name_to_peer_map, "server2");
+	assert(peer2 && peer2->registered);
+	assert(ht_get(serv->name_to_peer_map, "server4") == peer2);
+
+	int fd3 = connect_peer(serv, "server3");
+	assert(ht_get(serv->name_to_peer_map, "server3"));
+
+	char buf[MAX_MSG_LEN * 8];
+	read_available(fd3, buf, sizeof buf);
+	assert(count_substr(buf, " SERVER server2\r\n") == 1);
+	assert(count_substr(buf, " SERVER server4\r\n") == 1);
+
+	log_info("success");
+	close(fd2);
+	close(fd3);
+}
+
+/**
+ * Re-make the link to server2 and remove all connections, as at shutdown.
+ * Removing a connection frees its node of the table of connections, so the
+ * table must not be iterated while removing. Run from the project root (uses
+ * config.csv) and under ASan to catch the use after free.
+ */
+void remove_connections_test()
+{
+	Server *serv = Server_create("server1");
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	close(connect_peer(serv, "server2"));
+
+	for (int i = 0; i < 20 && ht_contains(serv->name_to_peer_map, "server2"); i++)
+	{
+		Server_poll(serv, 10);
+	}
+
+	assert(!ht_contains(serv->name_to_peer_map, "server2"));
+
+	int peer_fd = connect_peer(serv, "server2");
+	int user_fd = connect_to_host("127.0.0.1", serv->port);
+	send_line(user_fd, "NICK alice\r\nUSER alice * * :Alice\r\n");
+
+	for (int i = 0; i < 20; i++)
+	{
+		Server_poll(serv, 10);
+	}
+
+	assert(ht_get(serv->name_to_peer_map, "server2"));
+	assert(ht_get(serv->nick_to_user_map, "alice"));
+	assert(ht_size(serv->connections) == 2);
+
+	Server_remove_all_connections(serv);
+	assert(ht_size(serv->connections) == 0);
+	assert(!ht_contains(serv->name_to_peer_map, "server2"));
+
+	log_info("success");
+	close(peer_fd);
+	close(user_fd);
+}
+
+static void poll_server(Server *serv, int rounds)
+{
+	for (int i = 0; i < rounds; i++)
+	{
+		Server_poll(serv, 10);
+	}
+}
+
+/**
+ * Poll serv and read from fd into buf until end was read. Small replies may be
+ * held back by the kernel until earlier ones are acknowledged, so a single
+ * read after polling can miss them.
+ */
+static void read_until(Server *serv, int fd, char *buf, size_t size,
+					   const char *end)
+{
+	size_t len = 0;
+	buf[0] = '\0';
+
+	for (int i = 0; i < 100 && !strstr(buf, end); i++)
+	{
+		poll_server(serv, 1);
+		usleep(10000);
+		read_available(fd, buf + len, size - len);
+		len += strlen(buf + len);
+	}
+}
+
+/* Read the lines from fd up to a QUERY and return the id of the query */
+static char *read_query_id(Server *serv, int fd)
+{
+	char buf[MAX_MSG_LEN * 8];
+	char id[64] = "";
+	read_until(serv, fd, buf, sizeof buf, " QUERY ");
+	char *query = strstr(buf, " QUERY ");
+	assert(query && sscanf(query, " QUERY %63s", id) == 1);
+	return strdup(id);
+}
+
+/**
+ * Run LIST and WHO on server1 with the fake peers server2 and server3, where
+ * server3 does not answer. Results must be delivered at the deadline or when
+ * server3 leaves, with the rows of server2 merged into those of server1. Run
+ * from the project root (uses config.csv).
+ */
+void query_test()
+{
+	Server *serv = Server_create("server1");
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	int fd2 = connect_peer(serv, "server2");
+	int fd3 = connect_peer(serv, "server3");
+	int user_fd = connect_to_host("127.0.0.1", serv->port);
+	send_line(user_fd, "NICK alice\r\nUSER alice * * :Alice\r\n"
+					   "JOIN #chan\r\nTOPIC #chan :local topic\r\n");
+	poll_server(serv, 20);
+
+	char buf[MAX_MSG_LEN * 16];
+	char line[512];
+	read_available(user_fd, buf, sizeof buf);
+	read_available(fd2, buf, sizeof buf);
+	read_available(fd3, buf, sizeof buf);
+
+	// LIST completes at the deadline with the rows which arrived
+	send_line(user_fd, "LIST #chan,#other\r\n");
+	poll_server(serv, 20);
+	char *id = read_query_id(serv, fd2);
+	char *id3 = read_query_id(serv, fd3);
+	assert(!strcmp(id, id3));
+	snprintf(line, sizeof line,
+			 "QREPLY %s chan :2 \r\n"
+			 "QREPLY %s other :1 other topic\r\n"
+			 "QEND %s 0\r\n",
+			 id, id, id);
+	send_line(fd2, line);
+	poll_server(serv, 20);
+
+	Query *query = ht_get(serv->queries, id);
+	assert(query && ht_size(query->pending) == 1 &&
+		   ht_contains(query->pending, "server3"));
+	query->deadline = get_time_ms();
+	poll_server(serv, 20);
+	assert(!ht_contains(serv->queries, id));
+
+	read_until(serv, user_fd, buf, sizeof buf, " 323 ");
+	assert(strstr(buf, "NOTICE alice :Partial results"));
+	assert(count_substr(buf, " 322 alice ") == 2);
+	assert(strstr(buf, " 322 alice chan 3 :local topic\r\n"));
+	assert(strstr(buf, " 322 alice other 1 :other topic\r\n"));
+	assert(strstr(buf, " 323 alice :End of LIST\r\n"));
+	free(id);
+	free(id3);
+
+	// A query relayed to server3 returns one merged row per channel
+	send_line(fd2, "QUERY server2.1 LIST 2000 :#chan\r\n");
+	poll_server(serv, 20);
+	id3 = read_query_id(serv, fd3);
+	assert(!strcmp(id3, "server2.1"));
+	send_line(fd3, "QREPLY server2.1 chan :4 remote topic\r\n"
+				   "QEND server2.1 0\r\n");
+	read_until(serv, fd2, buf, sizeof buf, " QEND server2.1 ");
+	assert(count_substr(buf, " QREPLY server2.1 ") == 1);
+	assert(strstr(buf, " QREPLY server2.1 chan :5 local topic\r\n"));
+	assert(strstr(buf, " QEND server2.1 0\r\n"));
+	free(id3);
+
+	// WHO completes as soon as the silent server3 leaves
+	send_line(user_fd, "WHO #chan\r\n");
+	poll_server(serv, 20);
+	id = read_query_id(serv, fd2);
+	snprintf(line, sizeof line,
+			 "QREPLY %s carol/chan :chan carol host server2 carol Carol\r\n"
+			 "QEND %s 0\r\n",
+			 id, id);
+	send_line(fd2, line);
+	poll_server(serv, 20);
+	assert(ht_contains(serv->queries, id));
+
+	close(fd3);
+	poll_server(serv, 20);
+	assert(!ht_contains(serv->name_to_peer_map, "server3"));
+	assert(!ht_contains(serv->queries, id));
+
+	read_until(serv, user_fd, buf, sizeof buf, " 315 ");
+	assert(strstr(buf, "NOTICE alice :Partial results"));
+	assert(count_substr(buf, " 352 alice ") == 2);
+	assert(strstr(buf, " 352 alice chan carol host server2 carol "));
+	assert(strstr(buf, " 315 alice #chan :End of WHO list\r\n"));
+	free(id);
+
+	log_info("success");
+	close(fd2);
+	close(user_fd);
+}
+
+/**
+ * Feed SUMMARY lines of the fake peers server2 and server3 to server1 and
+ * check the global user count of LUSERS. A summary with an old seq must be
+ * ignored, and the users of a server must leave the count with it. Run from
+ * the project root (uses config.csv).
+ */
+void summary_test()
+{
+	Server *serv = Server_create("server1");
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	int fd2 = connect_peer(serv, "server2");
+	int fd3 = connect_peer(serv, "server3");
+	int user_fd = connect_to_host("127.0.0.1", serv->port);
+	send_line(user_fd, "NICK alice\r\nUSER alice * * :Alice\r\n");
+	poll_server(serv, 20);
+
+	char buf[MAX_MSG_LEN * 16];
+	char line[MAX_MSG_LEN];
+	char sketch[HLL_REGISTERS + 1];
+	HyperLogLog hll;
+	hll_init(&hll);
+	hll_add(&hll, "chan");
+	hll_encode(&hll, sketch);
+	read_available(user_fd, buf, sizeof buf);
+
+	snprintf(line, sizeof line, "SUMMARY server2 5 10 1 %s\r\n", sketch);
+	send_line(fd2, line);
+	snprintf(line, sizeof line, "SUMMARY server3 3 7 1 %s\r\n", sketch);
+	send_line(fd3, line);
+	poll_server(serv, 20);
+	assert(Server_count_global_users(serv) == 18);
+
+	send_line(user_fd, "LUSERS\r\n");
+	read_until(serv, user_fd, buf, sizeof buf, " 251 ");
+	assert(strstr(buf, " 251 alice :There are 18 users and 0 services on 3 "
+					   "servers\r\n"));
+
+	// An old or repeated seq is ignored, a newer one replaces the counters
+	snprintf(line, sizeof line, "SUMMARY server2 4 100 1 %s\r\n", sketch);
+	send_line(fd2, line);
+	snprintf(line, sizeof line, "SUMMARY server2 5 100 1 %s\r\n", sketch);
+	send_line(fd2, line);
+	poll_server(serv, 20);
+	assert(Server_count_global_users(serv) == 18);
+
+	snprintf(line, sizeof line, "SUMMARY server2 6 20 1 %s\r\n", sketch);
+	send_line(fd2, line);
+	poll_server(serv, 20);
+	assert(Server_count_global_users(serv) == 28);
+
+	// The users of server3 leave with it
+	close(fd3);
+	poll_server(serv, 20);
+	assert(!ht_contains(serv->name_to_peer_map, "server3"));
+	assert(!ht_contains(serv->summaries, "server3"));
+
+	send_line(user_fd, "LUSERS\r\n");
+	read_until(serv, user_fd, buf, sizeof buf, " 251 ");
+	assert(strstr(buf, " 251 alice :There are 21 users and 0 services on 2 "
+					   "servers\r\n"));
+
+	log_info("success");
+	close(fd2);
+	close(user_fd);
+}
+
+/**
+ * Connect a client connection, as build/client does, to a listening socket and
+ * exchange a line each way through the socket transport.
+ */
+void client_connection_test()
+{
+	int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr = {.sin_family = AF_INET,
+							   .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+	socklen_t addrlen = sizeof addr;
+	assert(bind(listen_fd, (struct sockaddr *)&addr, sizeof addr) == 0);
+	assert(listen(listen_fd, 1) == 0);
+	assert(getsockname(listen_fd, (struct sockaddr *)&addr, &addrlen) == 0);
+
+	char port[16];
+	snprintf(port, sizeof port, "%d", ntohs(addr.sin_port));
+	Connection *client = Connection_create_and_connect("127.0.0.1", port);
+	assert(client && client->transport == &socket_transport);
+	client->conn_type = CLIENT_CONNECTION;
+	int server_fd = accept(listen_fd, NULL, NULL);
+	assert(server_fd != -1);
+
+	List_push_back(client->outgoing_messages, strdup("NICK alice\r\n"));
+	assert(Connection_write(client) == 0);
+	assert(Connection_write(client) == 12);
+
+	char buf[64];
+	assert(read(server_fd, buf, sizeof buf) == 12 && !memcmp(buf, "NICK alice\r\n", 12));
+
+	send_line(server_fd, "PING :server1\r\n");
+	assert(Connection_read(client) == 15);
+	assert(!strcmp(List_peek_front(client->incoming_messages), "PING :server1"));
+
+	// Freeing the connection closes the socket
+	Connection_free(client);
+	assert(read(server_fd, buf, sizeof buf) == 0);
+
+	log_info("success");
+	close(server_fd);
+	close(listen_fd);
+}
+
+/**
+ * Link the fake peer server2 to server1 with a short ping interval. The first
+ * PING is sent one interval after registration, a PONG gives the round trip
+ * time shown by STATS l, and the peer is dropped once it stays silent. Run
+ * from the project root (uses config.csv).
+ */
+void peer_heartbeat_test()
+{
+	Server *serv = Server_create("server1");
+	serv->peer_ping_interval_ms = 100;
+	serv->peer_max_missed_pings = 2;
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	int user_fd = connect_to_host("127.0.0.1", serv->port);
+	send_line(user_fd, "NICK alice\r\nUSER alice * * :Alice\r\n");
+	poll_server(serv, 20);
+
+	uint64_t start = get_time_ms();
+	int fd2 = connect_peer(serv, "server2");
+	Peer *peer = ht_get(serv->name_to_peer_map, "server2");
+	assert(peer && peer->registered);
+	assert(peer->ping_sent_at >= start);
+	assert(peer->connected_at >= (time_t)(start / 1000) - 1);
+
+	char buf[MAX_MSG_LEN * 16];
+	read_until(serv, fd2, buf, sizeof buf, " PING server1 :");
+	assert(get_time_ms() - start >= serv->peer_ping_interval_ms);
+
+	unsigned long token = 0;
+	assert(sscanf(strstr(buf, " PING server1 :"), " PING server1 :%lu", &token) == 1);
+	assert(token == peer->ping_sent_at && peer->rtt_ms == -1);
+
+	char line[128];
+	snprintf(line, sizeof line, "PONG server2 :%lu\r\n", token);
+	send_line(fd2, line);
+	poll_server(serv, 20);
+	assert(peer->rtt_ms >= 0 && peer->missed_pings == 0);
+
+	read_available(user_fd, buf, sizeof buf);
+	send_line(user_fd, "STATS l\r\n");
+	snprintf(line, sizeof line, " 249 alice :server2 rtt %ld ms, 0 missed pings\r\n",
+			 peer->rtt_ms);
+	read_until(serv, user_fd, buf, sizeof buf, line);
+	assert(strstr(buf, line));
+
+	// Without a reply the link is closed after the missed pings
+	uint64_t silent_since = get_time_ms();
+
+	while (ht_contains(serv->name_to_peer_map, "server2") &&
+		   get_time_ms() - silent_since < 2000)
+	{
+		poll_server(serv, 1);
+		usleep(10000);
+	}
+
+	assert(!ht_contains(serv->name_to_peer_map, "server2"));
+	assert(get_time_ms() - silent_since >=
+		   serv->peer_ping_interval_ms * (serv->peer_max_missed_pings - 1));
+
+	log_info("success");
+	close(fd2);
+	close(user_fd);
+}
+
+/**
+ * Make server1 answer a burst of queries from the fake peer server2 with
+ * QEND, which is queued straight for the peer rather than relayed. The
+ * replies must count toward the congestion of the peer. Run from the project
+ * root (uses config.csv).
+ */
+void peer_reply_congestion_test()
+{
+	Server *serv = Server_create("server1");
+	serv->peer_queue_high = 8;
+	serv->peer_queue_low = 2;
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	int fd2 = connect_peer(serv, "server2");
+	Peer *peer = ht_get(serv->name_to_peer_map, "server2");
+	assert(peer && !peer->congested);
+
+	char buf[MAX_MSG_LEN * 16];
+	read_until(serv, fd2, buf, sizeof buf, " SUMMARY ");
+	size_t len = 0;
+
+	for (int i = 0; i < 20; i++)
+	{
+		len += snprintf(buf + len, sizeof buf - len, "QUERY server2.%d BOGUS 1000\r\n", i);
+	}
+
+	send_line(fd2, buf);
+
+	// Read and handle the queries without writing any reply
+	Connection *conn = ht_get(serv->connections, &peer->fd);
+	struct pollfd pfd = {.fd = conn->fd, .events = POLLIN};
+	assert(poll(&pfd, 1, 1000) == 1);
+	assert(Server_handle_events(serv, conn, EPOLLIN));
+	assert(List_size(peer->msg_queue) >= serv->peer_queue_high);
+	assert(peer->congested && serv->n_congested_peers == 1);
+
+	// The replies drain and the peer is no longer congested
+	read_until(serv, fd2, buf, sizeof buf, " QEND server2.19 0\r\n");
+	poll_server(serv, 20);
+	assert(!peer->congested && serv->n_congested_peers == 0);
+
+	log_info("success");
+	close(fd2);
+}
+
+#define CHECK_REPLY(format, ...)                                   \
+	{                                                              \
+		char expected[MAX_MSG_LEN + 1];                            \
+		snprintf(expected, sizeof expected, format, __VA_ARGS__);  \
+		char *actual = make_reply(format, __VA_ARGS__);            \
+		if (strcmp(expected, actual))                              \
+		{                                                          \
+			log_error("expected \"%s\" got \"%s\"", expected, actual); \
+			assert(0);                                             \
+		}                                                          \
+		free(actual);                                              \
+	}
+
+/**
+ * Check make_reply() and the generated reply formatters against snprintf and
+ * compare replies/sec with make_string() for a typical numeric.
+ */
+void msgbuf_test(size_t n)
+{
+	CHECK_REPLY(":%s " RPL_WHOREPLY_MSG "\r\n", "server1", "alice", "#chan", "alice",
+				"localhost", "server1", "alice", "H", 0, "Alice");
+	CHECK_REPLY(RPL_LUSERCLIENT_MSG, "alice", -42L, 0L, 9000000000L);
+	CHECK_REPLY(RPL_STATSUPTIME, "alice", 1u, 2u, 3u, 45u);
+	CHECK_REPLY("%05d|%-4d|%4d|%c|%zu|%x|%%", 42, 7, -7, 'l', (size_t)12, 255u);
+	CHECK_REPLY("%s|%%%02X|%.*s|%5.2f|%hhu|%ld|%+d|%-3s|", "a", 0xabu, 2, "xyz", 3.14159,
+				300, -5L, 4, "b");
+
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	msgbuf_add_numeric(&buf, 1);
+	msgbuf_add_char(&buf, ' ');
+	msgbuf_add_long(&buf, -15);
+	msgbuf_add_ulong(&buf, 16);
+	msgbuf_add_crlf(&buf);
+	msgbuf_add_crlf(&buf);
+	assert(!strcmp(buf.data, "001 -1516\r\n"));
+	msgbuf_truncate(&buf, 3);
+	assert(!strcmp(buf.data, "001"));
+	msgbuf_destroy(&buf);
+
+	// Generated formatters match the templates they are generated from
+	char *reply = reply_RPL_WHOREPLY("server1", "alice", "#chan", "alice", "localhost", "server1",
+									 "alice", "H", 0, "Alice");
+	char *expected = make_string(":%s " RPL_WHOREPLY_MSG "\r\n", "server1", "alice", "#chan", "alice",
+								 "localhost", "server1", "alice", "H", 0, "Alice");
+	assert(!strcmp(reply, expected));
+	free(reply);
+	free(expected);
+
+	reply = reply_RPL_STATSUPTIME("server1", "alice", 1, 2, 3, 4);
+	assert(!strcmp(reply, ":server1 242 alice :Server Up 1 days 2:03:04\r\n"));
+	free(reply);
+
+	reply = reply_ERR_UMODEUNKNOWNFLAG2(NULL, "alice", '+', 'x');
+	assert(!strcmp(reply, "501 alice :Unknown mode \"+x\"\r\n"));
+	free(reply);
+
+	uint64_t start = get_time_ms();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		free(make_string(":%s " RPL_WHOREPLY_MSG "\r\n", "server1", "alice", "#chan", "alice",
+						 "localhost", "server1", "alice", "H", 0, "Alice"));
+	}
+
+	uint64_t mid = get_time_ms();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		free(make_reply(":%s " RPL_WHOREPLY_MSG "\r\n", "server1", "alice", "#chan", "alice",
+						"localhost", "server1", "alice", "H", 0, "Alice"));
+	}
+
+	uint64_t end = get_time_ms();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		free(reply_RPL_WHOREPLY("server1", "alice", "#chan", "alice", "localhost", "server1", "alice",
+								"H", 0, "Alice"));
+	}
+
+	uint64_t end2 = get_time_ms();
+
+	log_info("make_string: %.0f replies/sec", n * 1000.0 / (mid - start + 1));
+	log_info("make_reply: %.0f replies/sec", n * 1000.0 / (end - mid + 1));
+	log_info("reply_RPL_WHOREPLY: %.0f replies/sec", n * 1000.0 / (end2 - end + 1));
+}
+
+/**
+ * Check catalog replies against replies built for the user. Run from the
+ * project root (uses data/motd.txt).
+ */
+void catalog_test()
+{
+	Server serv;
+	memset(&serv, 0, sizeof serv);
+	serv.name = "server1";
+	serv.hostname = "localhost";
+	serv.info = "test server";
+	serv.motd_file = MOTD_FILENAME;
+	strcpy(serv.created_at, "today");
+
+	Catalog *catalog = Catalog_alloc(&serv);
+
+	char *line = CatalogLine_render(Vector_get_at(catalog->welcome, 0), "bob");
+	char *expected = reply_RPL_WELCOME("server1", "bob", "bob");
+	assert(!strcmp(line, expected));
+	free(line);
+	free(expected);
+
+	line = CatalogLine_render(Vector_get_at(catalog->welcome, 3), "alice");
+	expected = reply_RPL_MYINFO("server1", "alice", "localhost", "*", "*");
+	assert(!strcmp(line, expected));
+	free(line);
+	free(expected);
+
+	Vector *help = ht_get(catalog->help, "PRIVMSG");
+	assert(help && Vector_size(help) > 3);
+	line = CatalogLine_render(Vector_get_at(help, 0), "bob");
+	assert(!strcmp(line, ":server1 704 bob PRIVMSG :** The PRIVMSG Command **\r\n"));
+	free(line);
+
+	assert(ht_get(catalog->help, "*"));
+	assert(!ht_get(catalog->help, "UNKNOWN"));
+	assert(Vector_size(catalog->motd) > 0);
+
+	line = CatalogLine_render(Vector_get_at(catalog->motd, 0), "bob");
+	assert(!strncmp(line, ":server1 372 bob :- ", 20));
+	assert(!strcmp(line + strlen(line) - 2, "\r\n"));
+	free(line);
+
+	Catalog_free(catalog);
+}
+
+void config_test()
+{
+	char filename[] = "/tmp/irc_config_XXXXXX";
+	int fd = mkstemp(filename);
+	assert(fd != -1);
+
+	const char *contents = "% comment\n"
+						   "server1,127.0.0.1,5000,test1\n"
+						   "\n"
+						   "bad line\n"
+						   "server2,127.0.0.1,5001,test2,server1 server3\n";
+	assert(write(fd, contents, strlen(contents)) == (ssize_t)strlen(contents));
+	close(fd);
+
+	Hashtable *config = load_config(filename);
+	unlink(filename);
+
+	assert(config);
+	assert(ht_size(config) == 2);
+
+	ConfigEntry *entry = ht_get(config, "server1");
+	assert(entry);
+	assert(!strcmp(entry->host, "127.0.0.1"));
+	assert(!strcmp(entry->port, "5000"));
+	assert(!strcmp(entry->passwd, "test1"));
+	assert(Vector_size(entry->autoconnect) == 0);
+
+	entry = ht_get(config, "server2");
+	assert(entry);
+	assert(!strcmp(entry->passwd, "test2"));
+	assert(Vector_size(entry->autoconnect) == 2);
+	assert(!strcmp(Vector_get_at(entry->autoconnect, 0), "server1"));
+	assert(!strcmp(Vector_get_at(entry->autoconnect, 1), "server3"));
+
+	ht_free(config);
+
+	assert(!load_config("/tmp/irc_config_does_not_exist"));
+}
+
+static void write_file(const char *filename, const char *contents)
+{
+	FILE *file = fopen(filename, "w");
+	assert(file);
+	fputs(contents, file);
+	fclose(file);
+}
+
+static char *read_file(const char *filename)
+{
+	FILE *file = fopen(filename, "r");
+	assert(file);
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	char chunk[4096];
+	size_t n;
+
+	while ((n = fread(chunk, 1, sizeof chunk, file)) > 0)
+	{
+		msgbuf_add_bytes(&buf, chunk, n);
+	}
+
+	fclose(file);
+	msgbuf_add_char(&buf, 0);
+	return buf.data;
+}
+
+/**
+ * Add channels x0 to x<n - 1> to channels and link them in this order.
+ * Returns the first channel.
+ */
+static Channel *make_channel_list(Hashtable *channels, size_t n)
+{
+	Channel *first = NULL, *last = NULL;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		char name[32];
+		sprintf(name, "x%zu", i);
+		Channel *channel = Channel_alloc(name);
+
+		if (i % 2 == 0)
+		{
+			char *topic = make_string("topic: %zu", i);
+			Channel_set_topic(channel, topic);
+			free(topic);
+		}
+
+		channel->prev = last;
+
+		if (last)
+		{
+			last->next = channel;
+		}
+		else
+		{
+			first = channel;
+		}
+
+		last = channel;
+		ht_set(channels, channel->name, channel);
+	}
+
+	return first;
+}
+
+/**
+ * Compare the time the event loop spends on a snapshot of n channels when the
+ * channel store is written at once and when it is built in chunks.
+ */
+static void snapshot_bench(size_t n)
+{
+	const char *snapshot = "/tmp/irc_snapshot_bench.db";
+	const char *journal_file = "/tmp/irc_snapshot_bench.journal";
+	Hashtable *channels = load_channels("/dev/null", NULL);
+	Channel *first = make_channel_list(channels, n);
+
+	uint64_t start = get_time_ns();
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	write_channel_store(&buf, channels);
+	char *data = msgbuf_to_string(&buf);
+	uint64_t at_once = get_time_ns() - start;
+	free(data);
+	msgbuf_destroy(&buf);
+
+	Journal *journal = Journal_open(journal_file, snapshot);
+	assert(journal);
+	Journal_start_snapshot(journal, first);
+	uint64_t max_step = 0;
+	size_t n_steps = 0;
+	bool done = false;
+
+	while (!done)
+	{
+		start = get_time_ns();
+		done = Journal_continue_snapshot(journal, JOURNAL_SNAPSHOT_CHUNK);
+		max_step = MAX(max_step, get_time_ns() - start);
+		n_steps++;
+	}
+
+	Journal_close(journal, NULL);
+	ht_free(channels);
+
+	channels = load_channels(snapshot, NULL);
+	assert(ht_size(channels) == n);
+	ht_free(channels);
+
+	log_info("%zu channels: at once %.2f ms, %zu steps of at most %.2f ms", n,
+			 at_once / 1e6, n_steps, max_step / 1e6);
+
+	unlink(snapshot);
+	unlink(journal_file);
+}
+
+/**
+ * Replay a journal on a snapshot, compact records into snapshots and, with
+ * n, compare snapshots of n channels (see snapshot_bench).
+ */
+void journal_test(size_t n)
+{
+	char dir[] = "/tmp/irc_journal_XXXXXX";
+	assert(mkdtemp(dir));
+
+	char *snapshot = make_string("%s/channels.db", dir);
+	char *journal_file = make_string("%s/channels.journal", dir);
+
+	// Replay journal on top of snapshot; the torn last record is ignored
+	write_file(snapshot, "a 100 0 :topic a\n"
+						 "b 200 0\n");
+	write_file(journal_file, "T a :new: topic\n"
+							 "C c 300 0\n"
+							 "D b\n"
+							 "C d 400 0\n"
+							 "M d 2\n"
+							 "C e 50");
+
+	Hashtable *channels = load_channels(snapshot, journal_file);
+	assert(ht_size(channels) == 3);
+	assert(!ht_get(channels, "b"));
+	assert(!ht_get(channels, "e"));
+
+	Channel *channel = ht_get(channels, "a");
+	assert(channel && !strcmp(channel->topic, "new: topic"));
+	channel = ht_get(channels, "d");
+	assert(channel && channel->mode == 2 && channel->time_created == 400);
+	ht_free(channels);
+
+	// The torn record is cut off before records are appended after it
+	Journal *journal = Journal_open(journal_file, snapshot);
+	assert(journal);
+	channel = Channel_alloc("g");
+	channel->time_created = 500;
+	Journal_add_channel(journal, channel);
+	Channel_free(channel);
+	Journal_flush(journal);
+	Journal_close(journal, NULL);
+
+	channels = load_channels(snapshot, journal_file);
+	assert(ht_size(channels) == 4);
+	assert(!ht_get(channels, "e"));
+	channel = ht_get(channels, "g");
+	assert(channel && channel->time_created == 500);
+
+	// Records written through the journal are compacted into the snapshot
+	journal = Journal_open(journal_file, snapshot);
+	assert(journal);
+
+	channel = Channel_alloc("f");
+	channel->topic = strdup("topic f");
+	ht_set(channels, channel->name, channel);
+	Journal_add_channel(journal, channel);
+	Journal_set_topic(journal, channel);
+	Journal_remove_channel(journal, "c");
+	ht_remove(channels, "c", NULL, NULL);
+	Journal_flush(journal);
+	Journal_close(journal, channels);
+	ht_free(channels);
+
+	struct stat st;
+	assert(stat(journal_file, &st) == 0 && st.st_size == 0);
+
+	channels = load_channels(snapshot, journal_file);
+	assert(ht_size(channels) == 4);
+	assert(!ht_get(channels, "c"));
+	channel = ht_get(channels, "f");
+	assert(channel && !strcmp(channel->topic, "topic f"));
+	channel = ht_get(channels, "a");
+	assert(channel && !strcmp(channel->topic, "new: topic"));
+	ht_free(channels);
+
+	// Channels change while a snapshot is built from the channel list
+	channels = load_channels("/dev/null", NULL);
+	Channel *channel_list = make_channel_list(channels, 10);
+	journal = Journal_open(journal_file, snapshot);
+	channel = ht_get(channels, "x2");
+	channel->mode = 3;
+	Journal_set_mode(journal, channel);
+
+	Journal_start_snapshot(journal, channel_list);
+	assert(!Journal_continue_snapshot(journal, 3));
+
+	channel = ht_get(channels, "x0");
+	Channel_set_topic(channel, "changed");
+	Journal_set_topic(journal, channel);
+
+	const char *removed[] = {"x1", "x4"};
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		channel = ht_get(channels, removed[i]);
+		Journal_skip_channel(journal, channel);
+		channel->prev->next = channel->next;
+		channel->next->prev = channel->prev;
+		Journal_remove_channel(journal, channel->name);
+		ht_remove(channels, removed[i], NULL, NULL);
+	}
+
+	channel = Channel_alloc("y");
+	channel->prev = ht_get(channels, "x9");
+	channel->prev->next = channel;
+	ht_set(channels, channel->name, channel);
+	Journal_add_channel(journal, channel);
+	Journal_flush(journal);
+
+	// x3, x5 to x9 and y are left
+	assert(!Journal_continue_snapshot(journal, 3));
+	assert(!Journal_continue_snapshot(journal, 3));
+	assert(Journal_continue_snapshot(journal, 3));
+	Journal_close(journal, NULL);
+	ht_free(channels);
+
+	// The journal only keeps the records added since the snapshot started
+	channels = load_channels(snapshot, NULL);
+	assert(ht_size(channels) == 10);
+	assert(ht_get(channels, "x1") && !ht_get(channels, "x4"));
+	assert(((Channel *)ht_get(channels, "x2"))->mode == 3);
+	ht_free(channels);
+
+	channels = load_channels(snapshot, journal_file);
+	assert(ht_size(channels) == 9);
+	assert(!ht_get(channels, "x1") && !ht_get(channels, "x4") && ht_get(channels, "y"));
+	channel = ht_get(channels, "x0");
+	assert(channel && !strcmp(channel->topic, "changed"));
+	ht_free(channels);
+
+	assert(stat(journal_file, &st) == 0 && st.st_size > 0);
+	char *records = read_file(journal_file);
+	assert(!strstr(records, "M x2") && strstr(records, "D x1\n"));
+	free(records);
+
+	unlink(snapshot);
+	unlink(journal_file);
+	rmdir(dir);
+	free(snapshot);
+	free(journal_file);
+
+	if (n > 0)
+	{
+		snapshot_bench(n);
+	}
+}
+
+static Hashtable *make_channels(size_t n)
+{
+	Hashtable *channels = load_channels("/dev/null", NULL);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		char name[32];
+		sprintf(name, "channel%zu", i);
+		Channel *channel = Channel_alloc(name);
+		channel->mode = i % 4;
+
+		if (i % 2 == 0)
+		{
+			char *topic = make_string("topic: %zu", i);
+			Channel_set_topic(channel, topic);
+			free(topic);
+		}
+
+		ht_set(channels, channel->name, channel);
+	}
+
+	return channels;
+}
+
+static void write_buffer(const char *filename, MsgBuf *buf)
+{
+	assert(save_snapshot(filename, buf->data ? buf->data : "", buf->len));
+	msgbuf_clear(buf);
+}
+
+/**
+ * Compare loading n channels from a text file and from a channel store.
+ */
+static void channel_store_bench(size_t n)
+{
+	const char *text_file = "/tmp/irc_channels_bench.txt";
+	const char *store_file = "/tmp/irc_channels_bench.db";
+
+	Hashtable *channels = make_channels(n);
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	write_channels(&buf, channels);
+	write_buffer(text_file, &buf);
+	write_channel_store(&buf, channels);
+	write_buffer(store_file, &buf);
+	msgbuf_destroy(&buf);
+	ht_free(channels);
+
+	uint64_t start = get_time_ms();
+	channels = load_channels(text_file, NULL);
+	uint64_t mid = get_time_ms();
+	assert(ht_size(channels) == n);
+	ht_free(channels);
+
+	uint64_t mid2 = get_time_ms();
+	channels = load_channels(store_file, NULL);
+	uint64_t end = get_time_ms();
+	assert(ht_size(channels) == n);
+	ht_free(channels);
+
+	log_info("%zu channels: text %lu ms, channel store %lu ms", n,
+			 (unsigned long)(mid - start), (unsigned long)(end - mid2));
+
+	unlink(text_file);
+	unlink(store_file);
+}
+
+void channel_store_test(size_t n)
+{
+	const char *filename = "/tmp/irc_channels_test.db";
+
+	Hashtable *channels = make_channels(100);
+	MsgBuf buf;
+	msgbuf_init(&buf);
+	write_channel_store(&buf, channels);
+	write_buffer(filename, &buf);
+
+	Hashtable *loaded = load_channels(filename, NULL);
+	assert(ht_size(loaded) == 100);
+
+	HashtableIter itr;
+	ht_iter_init(&itr, channels);
+	Channel *channel = NULL;
+
+	while (ht_iter_next(&itr, NULL, (void **)&channel))
+	{
+		Channel *copy = ht_get(loaded, channel->name);
+		assert(copy && copy->store);
+		assert(ChannelStore_contains(copy->store, copy->name));
+		assert(copy->mode == channel->mode);
+		assert(copy->time_created == channel->time_created);
+		assert(!channel->topic == !copy->topic);
+		assert(!channel->topic || !strcmp(channel->topic, copy->topic));
+	}
+
+	// Changed topics are no longer borrowed from the store
+	channel = ht_get(loaded, "channel2");
+	Channel_set_topic(channel, "changed");
+	assert(!ChannelStore_contains(channel->store, channel->topic));
+	ht_remove(loaded, "channel3", NULL, NULL);
+	ht_free(loaded);
+	ht_free(channels);
+
+	// Store of another version is rejected
+	channels = make_channels(1);
+	write_channel_store(&buf, channels);
+	buf.data[8]++;
+	write_buffer(filename, &buf);
+	assert(is_channel_store(filename));
+	loaded = ht_alloc();
+	assert(!ChannelStore_load(filename, loaded));
+	ht_free(loaded);
+	ht_free(channels);
+	unlink(filename);
+	msgbuf_destroy(&buf);
+
+	if (n)
+	{
+		channel_store_bench(n);
+		return;
+	}
+
+	channel_store_bench(10000);
+	channel_store_bench(100000);
+	channel_store_bench(1000000);
+}
+
+static void clear_list(List *list)
+{
+	while (List_size(list) > 0)
+	{
+		List_pop_front(list);
+	}
+}
+
+void history_test()
+{
+	History *history = History_alloc(2 * HISTORY_BLOCK_SIZE);
+	Channel *a = Channel_alloc("a");
+	Channel *b = Channel_alloc("b");
+	Channel *c = Channel_alloc("c");
+	List *queue = List_alloc(NULL, free);
+
+	// Wrap the ring of a many times with messages of different lengths
+	for (int i = 0; i < 1000; i++)
+	{
+		char *message = make_string(":nick PRIVMSG #a :message %d %.*s\r\n", i,
+									i % 50, "**************************************************");
+		History_add(history, a, message, get_realtime_ms());
+		free(message);
+	}
+
+	assert(a->history && a->history->n_entries > 10);
+	assert(History_send(history, a, queue, 0, UINT64_MAX, true, 3) == 3);
+	assert(!strncmp(List_peek_front(queue), ":nick PRIVMSG #a :message 997 ", 30));
+	assert(!strcmp(List_peek_back(queue) + strlen(List_peek_back(queue)) - 2, "\r\n"));
+	clear_list(queue);
+
+	// Oldest messages are sent first for AFTER
+	size_t n = a->history->n_entries;
+	assert(History_send(history, a, queue, 0, UINT64_MAX, false, 1000) == n);
+	char *expected = make_string(":nick PRIVMSG #a :message %zu ", 1000 - n);
+	assert(!strncmp(List_peek_front(queue), expected, strlen(expected)));
+	free(expected);
+	clear_list(queue);
+
+	uint64_t now = get_realtime_ms();
+	assert(History_send(history, a, queue, now + 1000, UINT64_MAX, true, 10) == 0);
+	assert(History_send(history, a, queue, 0, 1, true, 10) == 0);
+
+	// The least recently used channel loses its block
+	History_add(history, b, ":nick PRIVMSG #b :hello\r\n", get_realtime_ms());
+	History_send(history, a, queue, 0, UINT64_MAX, true, 1);
+	clear_list(queue);
+	History_add(history, c, ":nick PRIVMSG #c :hello\r\n", get_realtime_ms());
+	assert(a->history && !b->history && c->history);
+
+	// Blocks of removed channels are reused
+	History_remove_channel(history, a);
+	assert(!a->history);
+	History_add(history, b, ":nick PRIVMSG #b :again\r\n", get_realtime_ms());
+	assert(b->history && c->history && b->history->n_entries == 1);
+	assert(History_send(history, b, queue, 0, UINT64_MAX, true, 10) == 1);
+	assert(!strcmp(List_peek_front(queue), ":nick PRIVMSG #b :again\r\n"));
+	assert(History_count(history, b, 0, UINT64_MAX) == 1);
+	assert(History_oldest(history, b) <= get_realtime_ms());
+	assert(History_oldest(history, a) == UINT64_MAX);
+
+	List_free(queue);
+	Channel_free(a);
+	Channel_free(b);
+	Channel_free(c);
+	History_free(history);
+}
+
+static void remove_dir(const char *path)
+{
+	DIR *dir = opendir(path);
+	struct dirent *entry;
+
+	while (dir && (entry = readdir(dir)) != NULL)
+	{
+		if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+		{
+			char *child = make_string("%s/%s", path, entry->d_name);
+			remove_dir(child);
+			free(child);
+		}
+	}
+
+	if (dir)
+	{
+		closedir(dir);
+		rmdir(path);
+	}
+	else
+	{
+		unlink(path);
+	}
+}
+
+/**
+ * Returns number of message in line sent by channel_log_test.
+ */
+static long log_message_number(const char *line)
+{
+	long i = -1;
+	sscanf(line, ":nick PRIVMSG #a :message %ld", &i);
+	return i;
+}
+
+/**
+ * Check that ChannelLog_send sends messages first to first + count - 1.
+ */
+static void check_log_query(ChannelLog *log, uint64_t after_ms,
+							uint64_t before_ms, bool latest, size_t limit,
+							long first, size_t count)
+{
+	List *queue = List_alloc(NULL, free);
+	assert(ChannelLog_send(log, "a", queue, after_ms, before_ms, latest, limit) == count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		char *line = List_peek_front(queue);
+		assert(log_message_number(line) == first + (long)i);
+		assert(!strcmp(line + strlen(line) - 2, "\r\n"));
+		List_pop_front(queue);
+	}
+
+	List_free(queue);
+}
+
+/**
+ * Append half a record and half an index entry to the last segment of channel
+ * in dir, as a crash during a write would leave them.
+ */
+static void append_torn_record(const char *dir, const char *channel)
+{
+	char *channel_dir = make_string("%s/%s", dir, channel);
+	DIR *d = opendir(channel_dir);
+	struct dirent *entry;
+	char last[256] = "";
+	assert(d);
+
+	while ((entry = readdir(d)) != NULL)
+	{
+		if (strstr(entry->d_name, ".log") && strcmp(entry->d_name, last) > 0)
+		{
+			snprintf(last, sizeof last, "%s", entry->d_name);
+		}
+	}
+
+	closedir(d);
+	assert(*last);
+
+	// Header of a record of 100 bytes with 10 bytes of it
+	char record[26] = {100};
+	char *path = make_string("%s/%s", channel_dir, last);
+	int fd = open(path, O_WRONLY | O_APPEND);
+	assert(fd != -1 && write(fd, record, sizeof record) == sizeof record);
+	close(fd);
+
+	strcpy(path + strlen(path) - 3, "idx");
+	fd = open(path, O_WRONLY | O_APPEND);
+	assert(fd != -1 && write(fd, record, 8) == 8);
+	close(fd);
+
+	free(path);
+	free(channel_dir);
+}
+
+/**
+ * Message i is logged at time 1000 + i, so each query has a known answer.
+ */
+void channel_log_test(size_t n)
+{
+	char dir[] = "/tmp/irc_channel_log_XXXXXX";
+	assert(mkdtemp(dir));
+
+	// Long messages to spread the log over several segments
+	char padding[201];
+	memset(padding, '*', sizeof padding - 1);
+	padding[sizeof padding - 1] = 0;
+
+	ChannelLog *log = ChannelLog_open(dir);
+	assert(log);
+	uint64_t start = get_time_ms();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		char *message = make_string(":nick PRIVMSG #a :message %zu %s\r\n", i, padding);
+		ChannelLog_append(log, "a", message, 1000 + i);
+		free(message);
+
+		if (i % 1000 == 999)
+		{
+			ChannelLog_flush(log);
+		}
+	}
+
+	ChannelLog_close(log);
+	uint64_t end = get_time_ms();
+	log_info("Logged %zu messages in %lu ms", n, end - start);
+
+	// Segments are found again when the log is opened
+	log = ChannelLog_open(dir);
+	assert(log);
+
+	check_log_query(log, 0, UINT64_MAX, true, 5, n - 5, 5);
+	check_log_query(log, 0, UINT64_MAX, false, 5, 0, 5);
+	check_log_query(log, 1000 + n / 2, UINT64_MAX, false, 3, n / 2 + 1, 3);
+	check_log_query(log, 0, 1000 + n / 2, true, 4, n / 2 - 4, 4);
+	check_log_query(log, 1000 + 10, 1000 + 15, true, 100, 11, 4);
+	check_log_query(log, 1000 + n, UINT64_MAX, true, 10, 0, 0);
+	check_log_query(log, 0, 1000, true, 10, 0, 0);
+
+	// Random ranges, which also cross segments
+	start = get_time_ms();
+	size_t n_queries = 1000;
+
+	for (size_t i = 0; i < n_queries; i++)
+	{
+		size_t lo = rand() % n;
+		size_t hi = lo + 1 + rand() % 300;
+		size_t limit = 1 + rand() % HISTORY_MAX_LIMIT;
+		size_t n_matches = (hi < n ? hi : n) - lo - 1;
+		size_t count = n_matches < limit ? n_matches : limit;
+
+		check_log_query(log, 1000 + lo, 1000 + hi, false, limit, lo + 1, count);
+		check_log_query(log, 1000 + lo, 1000 + hi, true, limit,
+						lo + 1 + n_matches - count, count);
+	}
+
+	end = get_time_ms();
+	log_info("%zu queries in %lu ms", 2 * n_queries, end - start);
+
+	// Appending continues the last segment and keeps times in order
+	ChannelLog_append(log, "a", ":nick PRIVMSG #a :message -1\r\n", 500);
+	ChannelLog_close(log);
+
+	log = ChannelLog_open(dir);
+	List *queue = List_alloc(NULL, free);
+	assert(ChannelLog_send(log, "a", queue, 1000 + n - 2, UINT64_MAX, false, 10) == 2);
+	List_free(queue);
+	check_log_query(log, 0, UINT64_MAX, true, 1, -1, 1);
+	ChannelLog_close(log);
+
+	// A crash leaves half a record and half an index entry at the end
+	append_torn_record(dir, "a");
+	log = ChannelLog_open(dir);
+
+	for (size_t i = n; i < n + 10; i++)
+	{
+		char *message = make_string(":nick PRIVMSG #a :message %zu\r\n", i);
+		ChannelLog_append(log, "a", message, 1000 + i);
+		free(message);
+	}
+
+	ChannelLog_close(log);
+	log = ChannelLog_open(dir);
+
+	// Messages before and after the tear are read in one walk
+	long expected[] = {n - 1, -1, n, n + 1, n + 2};
+	queue = List_alloc(NULL, free);
+	assert(ChannelLog_send(log, "a", queue, 1000 + n - 2, UINT64_MAX, false, 5) == 5);
+
+	for (size_t i = 0; i < 5; i++)
+	{
+		assert(log_message_number(List_peek_front(queue)) == expected[i]);
+		List_pop_front(queue);
+	}
+
+	List_free(queue);
+	check_log_query(log, 1000 + n - 1, UINT64_MAX, true, 20, n, 10);
+	ChannelLog_close(log);
+
+	// Other characters than letters, digits, '-' and '_' are escaped
+	log = ChannelLog_open(dir);
+	ChannelLog_append(log, "foo.bar", ":nick PRIVMSG #foo.bar :escaped\r\n", 2000);
+	ChannelLog_close(log);
+
+	char *escaped = make_string("%s/foo%%2Ebar", dir);
+	struct stat st;
+	assert(stat(escaped, &st) == 0 && S_ISDIR(st.st_mode));
+	free(escaped);
+
+	log = ChannelLog_open(dir);
+	queue = List_alloc(NULL, free);
+	assert(ChannelLog_send(log, "foo.bar", queue, 0, UINT64_MAX, true, 10) == 1);
+	assert(!strcmp(List_peek_front(queue), ":nick PRIVMSG #foo.bar :escaped\r\n"));
+	List_free(queue);
+	ChannelLog_close(log);
+
+	remove_dir(dir);
+}
+
+/**
+ * Returns number of lines read from the connections in fds.
+ */
+static size_t drain_lines(int *fds, size_t n_fds)
+{
+	char buf[4096];
+	size_t count = 0;
+
+	for (size_t i = 0; i < n_fds; i++)
+	{
+		ssize_t n;
+
+		while ((n = read(fds[i], buf, sizeof buf)) > 0)
+		{
+			for (ssize_t j = 0; j < n; j++)
+			{
+				count += buf[j] == '\n';
+			}
+		}
+	}
+
+	return count;
+}
+
+/**
+ * Send n_messages to the channel of the users in fds and return the number of
+ * messages delivered per second.
+ */
+static double fanout_run(Server *serv, int *fds, size_t n_users, size_t n_messages)
+{
+	const char *line = "PRIVMSG #bench :hello everyone on this channel\r\n";
+	size_t expected = n_messages * n_users;
+	size_t received = 0;
+	size_t sent = 0;
+	uint64_t start = get_time_ms();
+
+	while (received < expected)
+	{
+		for (int i = 0; i < 50 && sent < n_messages; i++, sent++)
+		{
+			send_line(fds[0], line);
+		}
+
+		Server_poll(serv, 0);
+		received += drain_lines(fds, n_users);
+	}
+
+	uint64_t elapsed = get_time_ms() - start;
+	return elapsed ? expected * 1000.0 / elapsed : 0;
+}
+
+/**
+ * Check log levels and the ring, then compare PRIVMSG fanout throughput with
+ * debug logging written synchronously, through the ring and filtered out.
+ * Build with make RELEASE=1 to compare with debug calls compiled out. Run
+ * from the project root (uses config.csv).
+ */
+void logger_test(size_t n_users)
+{
+	assert(logger_set_levels("info,test=debug,server=WARN"));
+	int test_module = logger_module(__FILE__);
+	assert(logger_level(test_module) == LOG_DEBUG);
+	assert(logger_level(logger_module("src/server/server.c")) == LOG_WARN);
+	assert(logger_level(logger_module("src/server/new_module.c")) == LOG_INFO);
+	assert(!logger_set_levels("info,server=loud"));
+	assert(!logger_set_levels("=debug"));
+	assert(logger_level(test_module) == LOG_DEBUG);
+
+	// Records go through the ring in order
+	char filename[] = "/tmp/irc_logger_XXXXXX";
+	int fd = mkstemp(filename);
+	assert(fd != -1);
+	int saved_stderr = dup(STDERR_FILENO);
+	dup2(fd, STDERR_FILENO);
+
+	logger_set_level(LOG_TRACE);
+	assert(logger_start());
+
+	for (int i = 0; i < 1000; i++)
+	{
+		log_warn("record %d", i);
+	}
+
+	logger_stop();
+	assert(logger_dropped() == 0);
+
+	FILE *file = fopen(filename, "r");
+	char *line = NULL;
+	size_t capacity = 0;
+	int n_records = 0;
+
+	while (getline(&line, &capacity, file) > 0)
+	{
+		char *record = strstr(line, "record ");
+		assert(record && atoi(record + 7) == n_records);
+		n_records++;
+	}
+
+	assert(n_records == 1000);
+	free(line);
+	fclose(file);
+
+	// Users on one channel on this server
+	Server *serv = Server_create("server1");
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = serv->fd};
+	assert(epoll_ctl(serv->epollfd, EPOLL_CTL_ADD, serv->fd, &ev) == 0);
+
+	int *fds = calloc(n_users, sizeof *fds);
+
+	for (size_t i = 0; i < n_users; i++)
+	{
+		fds[i] = connect_to_host("127.0.0.1", serv->port);
+		assert(fds[i] != -1);
+		char *registration = make_string("NICK bench%zu\r\nUSER bench%zu * * :Bench\r\nJOIN #bench\r\n", i, i);
+		send_line(fds[i], registration);
+		free(registration);
+		fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+		Server_poll(serv, 0);
+	}
+
+	Channel *channel = NULL;
+
+	for (int i = 0; i < 1000 && ht_size(channel ? channel->members : NULL) < n_users; i++)
+	{
+		Server_poll(serv, 10);
+		channel = ht_get(serv->name_to_channel_map, "bench");
+	}
+
+	assert(channel && ht_size(channel->members) == n_users);
+
+	for (int i = 0; i < 10; i++)
+	{
+		Server_poll(serv, 10);
+		drain_lines(fds, n_users);
+	}
+
+	size_t n_messages = 5000;
+	double sync_debug = fanout_run(serv, fds, n_users, n_messages);
+	logger_start();
+	double async_debug = fanout_run(serv, fds, n_users, n_messages);
+	logger_set_level(LOG_INFO);
+	double async_info = fanout_run(serv, fds, n_users, n_messages);
+	logger_stop();
+	logger_set_level(LOG_TRACE);
+
+	// Leave the channel so it is removed from the journal again
+	for (size_t i = 0; i < n_users; i++)
+	{
+		send_line(fds[i], "PART #bench\r\n");
+	}
+
+	for (int i = 0; i < 100 && ht_get(serv->name_to_channel_map, "bench"); i++)
+	{
+		Server_poll(serv, 10);
+		drain_lines(fds, n_users);
+	}
+
+	for (size_t i = 0; i < n_users; i++)
+	{
+		close(fds[i]);
+	}
+
+	free(fds);
+	dup2(saved_stderr, STDERR_FILENO);
+	close(saved_stderr);
+	close(fd);
+	unlink(filename);
+
+	char *log_dir = make_string("%s/bench", CHANNEL_LOG_DIR);
+	remove_dir(log_dir);
+	free(log_dir);
+
+	log_info("fanout of %zu messages to %zu users (messages delivered/s):", n_messages, n_users);
+	log_info("debug, synchronous: %.0f", sync_debug);
+	log_info("debug, ring:        %.0f", async_debug);
+	log_info("info, ring:         %.0f", async_info);
+	log_info("records dropped:    %lu", logger_dropped());
+
+	if (LOG_COMPILE_LEVEL > LOG_DEBUG)
+	{
+		log_info("debug calls are compiled out (LOG_COMPILE_LEVEL %d)", LOG_COMPILE_LEVEL);
+	}
+}
+
+void stats_test(size_t n)
+{
+	Histogram *histogram = calloc(1, sizeof *histogram);
+
+	// Small values are exact
+	for (uint64_t i = 1; i <= 10; i++)
+	{
+		Histogram_add(histogram, i);
+	}
+
+	assert(Histogram_percentile(histogram, 50) == 5);
+	assert(Histogram_percentile(histogram, 99.9) == 10);
+	assert(Histogram_percentile(histogram, 0) == 1);
+	memset(histogram, 0, sizeof *histogram);
+
+	// Larger values are within the error of the bucket width
+	for (uint64_t i = 1; i <= 1000000; i++)
+	{
+		Histogram_add(histogram, i * 1000);
+	}
+
+	double percentiles[] = {50, 90, 99, 99.9};
+
+	for (size_t i = 0; i < sizeof percentiles / sizeof *percentiles; i++)
+	{
+		double expected = percentiles[i] * 10000000;
+		double value = Histogram_percentile(histogram, percentiles[i]);
+		assert(value >= expected && value <= expected * (1 + 1.0 / 16));
+	}
+
+	assert(Histogram_percentile(histogram, 100) == 1000000000);
+	assert(histogram->max == 1000000000 && histogram->total == 1000000);
+
+	// Values past the last bucket are kept as the max
+	Histogram_add(histogram, UINT64_MAX);
+	assert(Histogram_percentile(histogram, 100) == UINT64_MAX);
+	free(histogram);
+
+	// Commands past the limit are merged
+	Server serv;
+	memset(&serv, 0, sizeof serv);
+	serv.command_stats = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	serv.command_stats->value_free = free;
+
+	for (int i = 0; i < STATS_MAX_COMMANDS + 10; i++)
+	{
+		char *command = make_string("CMD%d", i);
+		Server_count_command(&serv, command, 10, 100, true);
+		free(command);
+	}
+
+	CommandStats *other = ht_get(serv.command_stats, STATS_OTHER_COMMAND);
+	assert(ht_size(serv.command_stats) == STATS_MAX_COMMANDS + 1);
+	assert(other && other->count == 10 && other->bytes == 100 && other->remote_count == 10);
+
+	// Cost of counting a command
+	uint64_t start_ns = get_time_ns();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		Server_count_command(&serv, "CMD0", 64, get_time_ns() - start_ns, false);
+	}
+
+	uint64_t elapsed_ns = get_time_ns() - start_ns;
+	CommandStats *stats = ht_get(serv.command_stats, "CMD0");
+	assert(stats && stats->count == n + 1 && stats->remote_count == 1);
+	printf("counted %zu commands in %.1f ns each\n", n, (double)elapsed_ns / n);
+
+	ht_free(serv.command_stats);
+}
+
+/**
+ * Send request to admin socket at path and return the reply of the server,
+ * which is complete once it ends with end, or once the server closes the
+ * connection if end is NULL.
+ */
+static char *admin_request(Server *serv, const char *path, const char *request, const char *end)
+{
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	strcpy(addr.sun_path, path);
+	assert(connect(fd, (struct sockaddr *)&addr, sizeof addr) == 0);
+	send_line(fd, request);
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	MsgBuf reply;
+	msgbuf_init(&reply);
+	char buf[4096];
+	uint64_t deadline = get_time_ms() + 2000;
+
+	while (get_time_ms() < deadline)
+	{
+		Server_poll(serv, 10);
+		ssize_t n;
+
+		while ((n = read(fd, buf, sizeof buf)) > 0)
+		{
+			msgbuf_add_bytes(&reply, buf, n);
+		}
+
+		if (end ? reply.len >= strlen(end) && !memcmp(reply.data + reply.len - strlen(end), end, strlen(end))
+				: n == 0)
+		{
+			break;
+		}
+	}
+
+	close(fd);
+	msgbuf_add_char(&reply, 0);
+	return reply.data;
+}
+
+void admin_test()
+{
+	const char *path = "/tmp/irc_admin_test.sock";
+	Server *serv = Server_create("server1");
+	assert(Server_listen_admin(serv, path));
+
+	Server_count_command(serv, "PRIVMSG", 20, 3000, false);
+	Server_count_command(serv, "PRIVMSG", 20, 5000000, true);
+
+	char *metrics = admin_request(serv, path, "METRICS\r\n", "# EOF\n");
+	assert(strstr(metrics, "# TYPE irc_connections gauge\n"));
+	assert(strstr(metrics, "irc_connections{type=\"admin\"} 1\n"));
+	assert(strstr(metrics, "irc_commands_total{command=\"PRIVMSG\"} 2\n"));
+	assert(strstr(metrics, "irc_remote_commands_total{command=\"PRIVMSG\"} 1\n"));
+	assert(strstr(metrics, "irc_command_duration_seconds_bucket{command=\"PRIVMSG\",le=\"4.096e-06\"} 1\n"));
+	assert(strstr(metrics, "irc_command_duration_seconds_bucket{command=\"PRIVMSG\",le=\"+Inf\"} 2\n"));
+	assert(strstr(metrics, "irc_command_duration_seconds_count{command=\"PRIVMSG\"} 2\n"));
+	assert(strstr(metrics, "irc_loop_duration_seconds_count "));
+	free(metrics);
+
+	char *http = admin_request(serv, path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n", NULL);
+	assert(!strncmp(http, "HTTP/1.0 200 OK\r\n", 17));
+	assert(strstr(http, "irc_commands_total{command=\"PRIVMSG\"} 2\n"));
+	free(http);
+
+	char *dump = admin_request(serv, path, "DUMP\r\n", "OK\n");
+	assert(!strncmp(dump, "server server1 ", 15));
+	free(dump);
+
+	char *error = admin_request(serv, path, "FOO\r\n", "\n");
+	assert(!strcmp(error, "ERR unknown request\n"));
+	free(error);
+
+	error = admin_request(serv, path, "DROP server2\r\n", "\n");
+	assert(!strcmp(error, "ERR no link to server2\n"));
+	free(error);
+
+	Server_close_admin(serv);
+	assert(access(path, F_OK) == -1);
+}
+
+typedef struct SimResult
+{
+	uint64_t delivered; /* private messages received by users */
+	uint64_t segments;	/* segments sent on the simulated network */
+	uint64_t lost;		/* segments which were lost at least once */
+	uint64_t now_ms;	/* virtual time at the end */
+} SimResult;
+
+/**
+ * Config of servers sim0 to sim<n_servers - 1>, where each server connects to
+ * the server at its parent in a binary tree.
+ */
+Hashtable *sim_config(int n_servers)
+{
+	Hashtable *config = ht_alloc_type(STRING_TYPE, SHALLOW_TYPE);
+	config->value_free = (elem_free_type)ConfigEntry_free;
+
+	for (int i = 0; i < n_servers; i++)
+	{
+		ConfigEntry *entry = calloc(1, sizeof *entry);
+		entry->name = make_string("sim%d", i);
+		entry->host = strdup("sim");
+		entry->port = strdup("0");
+		entry->passwd = make_string("pw%d", i);
+		entry->autoconnect = Vector_alloc(2, (elem_copy_type)strdup, free);
+
+		for (int child = 2 * i + 1; child <= 2 * i + 2 && child < n_servers; child++)
+		{
+			char name[32];
+			snprintf(name, sizeof name, "sim%d", child);
+			Vector_push(entry->autoconnect, name);
+		}
+
+		ht_set(config, entry->name, entry);
+	}
+
+	return config;
+}
+
+/**
+ * Write the queued messages of a simulated user.
+ */
+void sim_flush(Connection *user)
+{
+	while (user->res_len > 0 || List_size(user->outgoing_messages) > 0)
+	{
+		assert(Connection_write(user) != -1);
+	}
+}
+
+/**
+ * Advance the virtual clock by ms, polling every server and the users at
+ * which something arrived after each millisecond. Private messages received
+ * by users are counted in result.
+ */
+void sim_run(SimNet *net, Server **servers, int n_servers, uint64_t ms, SimResult *result)
+{
+	for (uint64_t t = 0; t < ms; t++)
+	{
+		SimNet_advance(net, 1);
+
+		for (int i = 0; i < n_servers; i++)
+		{
+			Server_poll_simulated(servers[i]);
+		}
+
+		Connection *user = NULL;
+
+		while ((user = SimNet_next_ready(net, "users")))
+		{
+			while (SimNet_readable(user))
+			{
+				assert(Connection_read(user) != -1);
+			}
+
+			while (List_size(user->incoming_messages) > 0)
+			{
+				char *message = List_peek_front(user->incoming_messages);
+				result->delivered += strstr(message, " PRIVMSG ") != NULL;
+				List_pop_front(user->incoming_messages);
+			}
+		}
+	}
+}
+
+/**
+ * Returns true if every server knows every user.
+ */
+bool sim_registered(Server **servers, int n_servers, int n_users)
+{
+	for (int i = 0; i < n_servers; i++)
+	{
+		if (ht_size(servers[i]->nick_to_serv_name_map) < (size_t)n_users)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Run a network of servers linked as a binary tree with users spread over
+ * them on a lossy simulated network: register the users, send one private
+ * message from each user to the next, then cut off the last server until its
+ * links time out.
+ */
+SimResult sim_network(uint64_t seed, int n_servers, int n_users)
+{
+	SimResult result = {0};
+	SimNet *net = SimNet_alloc(seed);
+	SimNet_set_latency(net, 1, 20);
+	SimNet_set_loss(net, 0.01);
+
+	Server **servers = calloc(n_servers, sizeof *servers);
+	Connection **users = calloc(n_users, sizeof *users);
+
+	// Parents are created first, so children can connect when created
+	for (int i = 0; i < n_servers; i++)
+	{
+		char name[32];
+		snprintf(name, sizeof name, "sim%d", i);
+		servers[i] = Server_create_simulated(name, sim_config(n_servers), net);
+		assert(servers[i]);
+	}
+
+	sim_run(net, servers, n_servers, 2000, &result);
+
+	for (int i = 0; i < n_servers; i++)
+	{
+		assert(ht_size(servers[i]->name_to_peer_map) == (size_t)n_servers - 1);
+	}
+
+	for (int i = 0; i < n_users; i++)
+	{
+		char nick[32];
+		snprintf(nick, sizeof nick, "u%d", i);
+		users[i] = SimNet_connect(net, "users", servers[i % n_servers]->name);
+		assert(users[i]);
+		List_push_back(users[i]->outgoing_messages, make_string("NICK %s\r\n", nick));
+		List_push_back(users[i]->outgoing_messages, make_string("USER %s 0 * :%s\r\n", nick, nick));
+		sim_flush(users[i]);
+	}
+
+	for (int t = 0; t < 60000 && !sim_registered(servers, n_servers, n_users); t += 100)
+	{
+		sim_run(net, servers, n_servers, 100, &result);
+	}
+
+	assert(sim_registered(servers, n_servers, n_users));
+
+	for (int i = 0; i < n_users; i++)
+	{
+		List_push_back(users[i]->outgoing_messages, make_string("PRIVMSG u%d :hello\r\n", (i + 1) % n_users));
+		sim_flush(users[i]);
+	}
+
+	for (int t = 0; t < 10000 && result.delivered < (uint64_t)n_users; t += 100)
+	{
+		sim_run(net, servers, n_servers, 100, &result);
+	}
+
+	assert(result.delivered == (uint64_t)n_users);
+
+	// The last server is cut off until its peers miss enough pings
+	Server *leaf = servers[n_servers - 1];
+	Server *parent = servers[(n_servers - 2) / 2];
+	SimNet_partition(net, leaf->name, 1);
+
+	uint64_t timeout_ms = (uint64_t)PEER_PING_INTERVAL_MS * (PEER_MAX_MISSED_PINGS + 1);
+	sim_run(net, servers, n_servers, timeout_ms, &result);
+
+	assert(!ht_contains(parent->name_to_peer_map, leaf->name));
+	assert(ht_size(leaf->name_to_peer_map) == 0);
+	assert(ht_size(servers[0]->nick_to_serv_name_map) < (size_t)n_users);
+
+	SimNet_heal(net);
+	sim_run(net, servers, n_servers, 1000, &result);
+
+	result.segments = net->segments_sent;
+	result.lost = net->segments_lost;
+	result.now_ms = net->now_ms;
+
+	for (int i = 0; i < n_users; i++)
+	{
+		Connection_free(users[i]);
+	}
+
+	for (int i = 0; i < n_servers; i++)
+	{
+		Server_free(servers[i]);
+	}
+
+	free(users);
+	free(servers);
+	SimNet_free(net);
+
+	return result;
+}
+
+void simnet_test(int n_servers, int n_users)
+{
+	assert(n_servers >= 2);
+
+	SimNet *net = SimNet_alloc(1);
+	SimNet_set_latency(net, 10, 20);
+	SimNet_listen(net, "a");
+
+	Connection *client = SimNet_connect(net, "b", "a");
+	Connection *accepted = SimNet_accept(net, "a");
+	assert(client && accepted);
+	assert(!SimNet_accept(net, "a"));
+	assert(!SimNet_connect(net, "b", "c"));
+
+	// Segments arrive after the latency
+	assert(get_time_ms() == SIMNET_START_MS);
+	List_push_back(client->outgoing_messages, strdup("PING a\r\n"));
+	assert(Connection_write(client) == 0);
+	assert(Connection_write(client) == 8);
+	SimNet_advance(net, 9);
+	assert(!SimNet_readable(accepted));
+	SimNet_advance(net, 11);
+	assert(SimNet_readable(accepted));
+	assert(Connection_read(accepted) == 8);
+	assert(!strcmp(List_peek_front(accepted->incoming_messages), "PING a"));
+	List_pop_front(accepted->incoming_messages);
+
+	// Nothing crosses a partition until it heals
+	SimNet_partition(net, "a", 1);
+	assert(!SimNet_connect(net, "b", "a"));
+	List_push_back(client->outgoing_messages, strdup("PING b\r\n"));
+	Connection_write(client);
+	Connection_write(client);
+	SimNet_advance(net, 1000);
+	assert(!SimNet_readable(accepted));
+	SimNet_heal(net);
+	assert(Connection_read(accepted) == 8);
+	List_pop_front(accepted->incoming_messages);
+
+	// Lost segments arrive late, but in order
+	SimNet_set_loss(net, 0.5);
+	uint64_t sent_at = get_time_ms();
+
+	for (int i = 0; i < 100; i++)
+	{
+		List_push_back(client->outgoing_messages, make_string("PING %d\r\n", i));
+		Connection_write(client);
+		Connection_write(client);
+	}
+
+	assert(net->segments_lost > 0);
+
+	while (List_size(accepted->incoming_messages) < 100)
+	{
+		SimNet_advance(net, 1);
+
+		while (SimNet_readable(accepted))
+		{
+			assert(Connection_read(accepted) > 0);
+		}
+	}
+
+	assert(get_time_ms() - sent_at > 20 + SIMNET_RTO_MS);
+
+	for (int i = 0; i < 100; i++)
+	{
+		char expected[32];
+		snprintf(expected, sizeof expected, "PING %d", i);
+		assert(!strcmp(List_peek_front(accepted->incoming_messages), expected));
+		List_pop_front(accepted->incoming_messages);
+	}
+
+	// The other end reads the end of the stream after the close
+	SimNet_set_loss(net, 0);
+	Connection_free(client);
+	SimNet_advance(net, 20);
+	assert(SimNet_readable(accepted));
+	assert(Connection_read(accepted) == -1);
+	Connection_free(accepted);
+	SimNet_free(net);
+
+	// A network of servers runs the same way for the same seed
+	logger_set_level(LOG_WARN);
+	SimResult first = sim_network(7, n_servers, n_users);
+	SimResult second = sim_network(7, n_servers, n_users);
+	logger_set_level(LOG_TRACE);
+
+	log_info("%d servers, %d users: %lu messages delivered, %lu segments sent, %lu lost, %lu ms", n_servers,
+			 n_users, first.delivered, first.segments, first.lost, first.now_ms - SIMNET_START_MS);
+
+	assert(first.delivered == second.delivered);
+	assert(first.segments == second.segments);
+	assert(first.lost == second.lost);
+	assert(first.now_ms == second.now_ms);
+}
+
+/**
+ * Read the lines written to the other end of a connection in a capture.
+ */
+static Connection *capture_connection(Capture *capture, const char *lines)
+{
+	int fds[2];
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	Connection *conn = Connection_alloc_local(fds[0], "capture");
+	conn->capture = capture;
+	assert(write(fds[1], lines, strlen(lines)) == (ssize_t)strlen(lines));
+	close(fds[1]);
+	assert(Connection_read(conn) == (ssize_t)strlen(lines));
+	return conn;
+}
+
+void capture_test()
+{
+	char out[MAX_MSG_LEN + 1];
+	char nick[16], channel[16];
+
+	// Names get the same replacement within a capture, without case
+	const char *line = "NICK alice";
+	assert(Capture_anonymize(1, line, strlen(line), out, sizeof out) == 13);
+	assert(sscanf(out, "NICK %15s", nick) == 1 && nick[0] == 'a');
+
+	line = ":alice PRIVMSG Alice :hello there";
+	Capture_anonymize(1, line, strlen(line), out, sizeof out);
+	char expected[MAX_MSG_LEN + 1];
+	snprintf(expected, sizeof expected, "PRIVMSG %s :xxxxxxxxxxx", nick);
+	assert(!strcmp(out, expected));
+
+	line = "JOIN #Foo,#bar secret";
+	Capture_anonymize(1, line, strlen(line), out, sizeof out);
+	assert(sscanf(out, "JOIN %9s", channel) == 1 && !strncmp(channel, "#c", 2));
+	assert(out[14] == ',' && strncmp(out + 15, channel, 9) && out[24] == ' ');
+	assert(out[25] == 'a' && !strstr(out, "secret") && !strstr(out, "bar"));
+
+	line = "MODE #foo +ol alice 10";
+	Capture_anonymize(1, line, strlen(line), out, sizeof out);
+	snprintf(expected, sizeof expected, "MODE %s +ol %s 10", channel, nick);
+	assert(!strcmp(out, expected));
+
+	line = "USER alice 0 * :Alice A";
+	Capture_anonymize(1, line, strlen(line), out, sizeof out);
+	snprintf(expected, sizeof expected, "USER %s 0 * :xxxxxxx", nick);
+	assert(!strcmp(out, expected));
+
+	// Another salt gives other names
+	line = "NICK alice";
+	Capture_anonymize(2, line, strlen(line), out, sizeof out);
+	assert(strcmp(out + 5, nick));
+
+	// Output is cut at the size of the buffer
+	assert(Capture_anonymize(1, line, strlen(line), out, 8) == 7);
+	assert(!strncmp(out, "NICK a", 6));
+
+	// Connections of server links are not captured and take no id
+	const char *filename = "/tmp/irc_capture_test.cap";
+	Capture *capture = Capture_open(filename);
+	assert(capture);
+
+	Connection *user1 = capture_connection(capture, "NICK alice\r\nUSER alice 0 * :Alice\r\n");
+	Connection *peer = capture_connection(capture, "PASS pw\r\nSERVER s2 :info\r\n");
+	assert(!peer->capture && peer->capture_id == 0);
+	Connection *user2 = capture_connection(capture, "NICK bob\r\nPRIVMSG alice :hi\r\n");
+	assert(user1->capture_id == 1 && user2->capture_id == 2);
+
+	Connection_free(user1);
+	Connection_free(peer);
+	Connection_free(user2);
+	Capture_close(capture);
+
+	CaptureReader *reader = CaptureReader_open(filename);
+	assert(reader);
+	CaptureRecord *record = malloc(sizeof *record);
+	uint32_t ids[] = {1, 1, 2, 2, 1, 2};
+	const char *commands[] = {"NICK ", "USER ", "NICK ", "PRIVMSG ", "", ""};
+	uint64_t at_us = 0;
+
+	for (size_t i = 0; i < sizeof ids / sizeof *ids; i++)
+	{
+		assert(CaptureReader_next(reader, record));
+		assert(record->conn_id == ids[i] && record->at_us >= at_us);
+		assert(!strncmp(record->line, commands[i], strlen(commands[i])));
+		assert(record->len == strlen(record->line));
+		assert((record->len == 0) == (commands[i][0] == 0));
+		at_us = record->at_us;
+	}
+
+	assert(!CaptureReader_next(reader, record));
+	CaptureReader_close(reader);
+	free(record);
+
+	// Files of another format are rejected
+	write_file(filename, "IRCCAP00");
+	assert(!CaptureReader_open(filename));
+	unlink(filename);
+}
+
+/**
+ * Send line from a simulated user to serv and return true if a reply
+ * containing expected arrives. Other replies are discarded.
+ */
+static bool sim_request(SimNet *net, Server *serv, Connection *user, const char *line, const char *expected)
+{
+	List_push_back(user->outgoing_messages, make_string("%s\r\n", line));
+	sim_flush(user);
+	bool found = false;
+
+	for (int t = 0; t < 100; t++)
+	{
+		SimNet_advance(net, 1);
+		Server_poll_simulated(serv);
+
+		while (SimNet_readable(user))
+		{
+			assert(Connection_read(user) != -1);
+		}
+
+		while (List_size(user->incoming_messages) > 0)
+		{
+			found |= strstr(List_peek_front(user->incoming_messages), expected) != NULL;
+			List_pop_front(user->incoming_messages);
+		}
+	}
+
+	return found;
+}
+
+void overload_test()
+{
+	logger_set_level(LOG_WARN);
+	SimNet *net = SimNet_alloc(1);
+	Server *serv = Server_create_simulated("sim0", sim_config(1), net);
+	assert(serv);
+
+	Connection *user = SimNet_connect(net, "users", "sim0");
+	List_push_back(user->outgoing_messages, strdup("NICK alice\r\n"));
+	assert(sim_request(net, serv, user, "USER alice * * :Alice", " 001 alice "));
+	assert(sim_request(net, serv, user, "JOIN #a", " 366 alice "));
+
+	// A slow iteration makes the server overloaded
+	Server_update_load(serv, 1000);
+	assert(!serv->overloaded);
+	Server_update_load(serv, 8 * OVERLOAD_LAG_MS * 1000000ULL);
+	assert(serv->overloaded && serv->overloads == 1);
+
+	// Expensive commands are refused, others are answered
+	assert(sim_request(net, serv, user, "LIST", " 263 alice LIST :"));
+	assert(sim_request(net, serv, user, "NAMES", " 263 alice NAMES :"));
+	assert(sim_request(net, serv, user, "NAMES #a", " 366 alice "));
+	assert(sim_request(net, serv, user, "WHO #a", " 315 alice "));
+	assert(sim_request(net, serv, user, "PING x", "PONG"));
+	assert(sim_request(net, serv, user, "STATS u", "overloaded, 1 overloads, 2 commands refused"));
+	assert(serv->refused_commands == 2);
+
+	// Few connections are accepted per iteration
+	size_t n_connections = ht_size(serv->connections);
+	Connection *others[OVERLOAD_ACCEPT_BATCH + 2];
+
+	for (int i = 0; i < OVERLOAD_ACCEPT_BATCH + 2; i++)
+	{
+		others[i] = SimNet_connect(net, "users", "sim0");
+	}
+
+	Server_accept_all(serv);
+	assert(ht_size(serv->connections) == n_connections + OVERLOAD_ACCEPT_BATCH);
+	Server_accept_all(serv);
+	assert(ht_size(serv->connections) == n_connections + OVERLOAD_ACCEPT_BATCH + 2);
+
+	// The server recovers once the average iteration is fast again
+	for (int i = 0; i < 4; i++)
+	{
+		Server_update_load(serv, 0);
+	}
+
+	assert(serv->overloaded);
+
+	for (int i = 0; i < 4; i++)
+	{
+		Server_update_load(serv, 0);
+	}
+
+	assert(!serv->overloaded);
+	assert(sim_request(net, serv, user, "LIST", " 323 alice "));
+
+	// A window with too little idle time also makes it overloaded, even
+	// though every iteration is fast
+	SimNet_advance(net, LOAD_WINDOW_MS);
+	Server_update_load(serv, 0);
+
+	for (int i = 0; i < 100; i++)
+	{
+		Server_update_load(serv, OVERLOAD_BUSY_PERCENT * LOAD_WINDOW_MS * 100ULL);
+	}
+
+	assert(!serv->overloaded);
+	SimNet_advance(net, LOAD_WINDOW_MS);
+	Server_update_load(serv, 0);
+	assert(serv->overloaded && serv->loop_busy_percent == OVERLOAD_BUSY_PERCENT);
+	assert(serv->loop_lag_ns < OVERLOAD_LAG_MS * 1000000ULL);
+
+	for (int i = 0; i < OVERLOAD_ACCEPT_BATCH + 2; i++)
+	{
+		Connection_free(others[i]);
+	}
+
+	Connection_free(user);
+	Server_free(serv);
+	SimNet_free(net);
+	logger_set_level(LOG_TRACE);
+}
+
+/**
+ * Poll serv and read the replies of a simulated user for ms of virtual time
+ * into lines.
+ */
+static void sim_read_lines(SimNet *net, Server *serv, Connection *user, int ms, Vector *lines)
+{
+	for (int t = 0; t < ms; t++)
+	{
+		SimNet_advance(net, 1);
+		Server_poll_simulated(serv);
+
+		while (SimNet_readable(user))
+		{
+			assert(Connection_read(user) != -1);
+		}
+
+		while (List_size(user->incoming_messages) > 0)
+		{
+			Vector_push(lines, List_peek_front(user->incoming_messages));
+			List_pop_front(user->incoming_messages);
+		}
+	}
+}
+
+static size_t count_lines(Vector *lines, const char *pattern)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < Vector_size(lines); i++)
+	{
+		count += strstr(Vector_get_at(lines, i), pattern) != NULL;
+	}
+
+	return count;
+}
+
+static void clear_lines(Vector *lines)
+{
+	while (Vector_size(lines) > 0)
+	{
+		Vector_remove(lines, Vector_size(lines) - 1, NULL);
+	}
+}
+
+void stream_test(int n_channels)
+{
+	logger_set_level(LOG_WARN);
+	SimNet *net = SimNet_alloc(1);
+	SimNet_set_latency(net, 0, 0);
+	Server *serv = Server_create_simulated("sim0", sim_config(1), net);
+	Vector *lines = Vector_alloc(16, (elem_copy_type)strdup, free);
+
+	Connection *user = SimNet_connect(net, "users", "sim0");
+	List_push_back(user->outgoing_messages, strdup("NICK bob\r\n"));
+	assert(sim_request(net, serv, user, "USER bob * * :Bob", " 001 bob "));
+	assert(sim_request(net, serv, user, "JOIN #joined", " 366 bob "));
+	User *usr = ht_get(serv->nick_to_user_map, "bob");
+
+	for (int i = 0; i < n_channels; i++)
+	{
+		char name[32];
+		snprintf(name, sizeof name, "c%d", i);
+		Server_add_channel(serv, Channel_alloc(name));
+	}
+
+	// LIST sends a chunk at a time
+	List_push_back(user->outgoing_messages, strdup("LIST\r\n"));
+	sim_flush(user);
+	SimNet_advance(net, 1);
+	Server_poll_simulated(serv);
+	assert(usr->stream && Vector_size(serv->streams) == 1);
+	assert(List_size(usr->msg_queue) <= STREAM_LOW_WATERMARK + STREAM_CHUNK + 1);
+
+	// Channels may change while the stream is on the way
+	Channel *next = usr->stream->next;
+	Channel *later = next->next->next;
+	assert(next && later);
+	Server_remove_channel(serv, later);
+	Server_remove_channel(serv, next);
+	Server_add_channel(serv, Channel_alloc("new"));
+
+	uint64_t start = get_time_ns();
+	int polls = 1;
+
+	for (; usr->stream; polls++)
+	{
+		sim_read_lines(net, serv, user, 1, lines);
+		assert(List_size(usr->msg_queue) <= STREAM_LOW_WATERMARK + STREAM_CHUNK + 1);
+	}
+
+	uint64_t elapsed = get_time_ns() - start;
+	sim_read_lines(net, serv, user, 10, lines);
+
+	// Every channel is sent once, but the removed ones
+	assert(count_lines(lines, " 321 bob ") == 1 && count_lines(lines, " 323 bob ") == 1);
+	assert(count_lines(lines, " 322 bob ") == (size_t)n_channels + 1 - 2 + 1);
+	assert(count_lines(lines, " 322 bob joined 1 ") == 1);
+	assert(count_lines(lines, " 322 bob new 0 ") == 1);
+	assert(count_lines(lines, " 322 bob c0 ") == 1);
+	assert(Vector_size(serv->streams) == 0);
+	log_warn("LIST of %d channels: %.1f ms in %d polls", n_channels, elapsed / 1e6, polls);
+
+	// NAMES without channels is streamed the same way
+	clear_lines(lines);
+	List_push_back(user->outgoing_messages, strdup("NAMES\r\n"));
+	sim_flush(user);
+
+	while (Vector_size(lines) == 0 || usr->stream)
+	{
+		sim_read_lines(net, serv, user, 1, lines);
+	}
+
+	sim_read_lines(net, serv, user, 10, lines);
+	assert(count_lines(lines, " 366 bob ") == (size_t)n_channels + 1 - 2 + 1);
+	assert(count_lines(lines, " 353 bob = joined :bob") == 1);
+
+	// Another LIST waits for the one being sent
+	clear_lines(lines);
+	List_push_back(user->outgoing_messages, strdup("LIST\r\nNAMES #joined\r\nLIST\r\n"));
+	sim_flush(user);
+
+	while (count_lines(lines, " 323 bob ") < 2)
+	{
+		sim_read_lines(net, serv, user, 1, lines);
+	}
+
+	assert(count_lines(lines, " 321 bob ") == 2);
+	assert(count_lines(lines, " 322 bob ") == 2 * (size_t)n_channels);
+	assert(count_lines(lines, " 366 bob joined ") == 1);
+
+	// The second LIST starts after the end of the first
+	size_t first_end = 0;
+	size_t second_start = 0;
+
+	for (size_t i = Vector_size(lines); i-- > 0;)
+	{
+		const char *line = Vector_get_at(lines, i);
+		first_end = strstr(line, " 323 bob ") ? i : first_end;
+		second_start = strstr(line, " 321 bob ") && !second_start ? i : second_start;
+	}
+
+	assert(first_end < second_start);
+
+	// Only a few streams may wait
+	clear_lines(lines);
+	List_push_back(user->outgoing_messages, strdup("LIST\r\nLIST\r\nLIST\r\nLIST\r\nLIST\r\nLIST\r\nLIST\r\n"));
+	sim_flush(user);
+
+	while (count_lines(lines, " 323 bob ") < STREAM_MAX_WAITING + 1)
+	{
+		sim_read_lines(net, serv, user, 1, lines);
+	}
+
+	assert(count_lines(lines, " 263 bob LIST ") == 7 - (STREAM_MAX_WAITING + 1));
+	assert(!usr->stream && Vector_size(serv->streams) == 0);
+
+	// A user who leaves drops the stream
+	List_push_back(user->outgoing_messages, strdup("LIST\r\nQUIT\r\n"));
+	sim_flush(user);
+	SimNet_advance(net, 1);
+	Server_poll_simulated(serv);
+	assert(!ht_get(serv->nick_to_user_map, "bob"));
+	assert(Vector_size(serv->streams) == 0);
+
+	Vector_free(lines);
+	Connection_free(user);
+	Server_free(serv);
+	SimNet_free(net);
+	logger_set_level(LOG_TRACE);
+}
+
+void skiplist_test()
+{
+	SkipList *list = SkipList_alloc();
+	int elems[1000];
+	bool present[1000] = {0};
+
+	assert(!SkipList_seek(list, 0));
+
+	// Keys 0 to 99, each with 10 elements
+	for (int i = 0; i < 1000; i++)
+	{
+		int j = (i * 7919) % 1000;
+		elems[j] = j;
+		SkipList_insert(list, j % 100, &elems[j]);
+		present[j] = true;
+	}
+
+	assert(SkipList_size(list) == 1000);
+
+	for (int i = 0; i < 1000; i += 3)
+	{
+		assert(SkipList_remove(list, i % 100, &elems[i]));
+		assert(!SkipList_remove(list, i % 100, &elems[i]));
+		present[i] = false;
+	}
+
+	assert(!SkipList_remove(list, 5, &elems[6]));
+	assert(SkipList_size(list) == 1000 - 334);
+
+	// Nodes are ordered by key and the range [20, 30] has all elements in it
+	size_t count = 0;
+	uint64_t last_key = 20;
+
+	for (SkipListNode *node = SkipList_seek(list, 20); node && node->key <= 30; node = SkipList_next(node))
+	{
+		int j = *(int *)node->elem;
+		assert(node->key >= last_key && node->key == (uint64_t)j % 100 && present[j]);
+		last_key = node->key;
+		count++;
+	}
+
+	size_t expected = 0;
+
+	for (int j = 0; j < 1000; j++)
+	{
+		expected += present[j] && j % 100 >= 20 && j % 100 <= 30;
+	}
+
+	assert(count == expected);
+	assert(!SkipList_seek(list, 100));
+
+	SkipList_free(list);
+	log_info("success");
+}
+
+/* Number of members, minutes since creation and since the topic was set of
+ * the channels made by elist_test(), with -1 for no topic */
+#define ELIST_MEMBERS(i) ((i) % 20)
+#define ELIST_CREATED(i) ((i) % 120)
+#define ELIST_TOPIC(i) ((i) % 3 == 0 ? (i) % 50 : -1)
+
+/* The clock of the simulation is virtual */
+static uint64_t monotonic_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int elist_first_digit(int i)
+{
+	while (i >= 10)
+	{
+		i /= 10;
+	}
+
+	return i;
+}
+
+static bool elist_expected(int i, int query)
+{
+	switch (query)
+	{
+	case 0:
+		return ELIST_MEMBERS(i) > 10;
+	case 1:
+		return ELIST_MEMBERS(i) < 5;
+	case 2:
+		return ELIST_MEMBERS(i) > 5 && ELIST_MEMBERS(i) < 8;
+	case 3:
+		return ELIST_CREATED(i) < 10;
+	case 4:
+		return ELIST_CREATED(i) >= 99;
+	case 5:
+		return ELIST_TOPIC(i) >= 0 && ELIST_TOPIC(i) < 10;
+	case 6:
+		return ELIST_TOPIC(i) >= 19 && ELIST_MEMBERS(i) > 15;
+	case 7:
+		return elist_first_digit(i) == 1;
+	case 8:
+		return elist_first_digit(i) != 1 && ELIST_MEMBERS(i) < 3;
+	case 9:
+		return i == 7 || i == 8;
+	case 10:
+		return ELIST_MEMBERS(i) > 18 && i % 10 == 9;
+	default:
+		return false;
+	}
+}
+
+void elist_test(int n_channels)
+{
+	const char *queries[] = {">10", "<5", ">5,<8", "C<10", "C>99", "T<10", "T>19,>15", "#chan1*", "!#chan1*,<3",
+							 "#chan7,#chan8,#none", ">18,#CHAN*9", "<0", "C>99999999999", "x", "<3,>5"};
+	int n_queries = sizeof queries / sizeof *queries;
+
+	assert(match_mask("#chan*", "#chan12"));
+	assert(match_mask("#c?an*2", "#CHAN12"));
+	assert(match_mask("*a*a*", "#banana"));
+	assert(!match_mask("#chan?", "#chan12"));
+	assert(!match_mask("*x", "#chan"));
+	assert(match_mask("*", ""));
+
+	logger_set_level(LOG_WARN);
+	SimNet *net = SimNet_alloc(1);
+	Server *serv = Server_create_simulated("sim0", sim_config(1), net);
+	time_t now = time(NULL);
+
+	User *users = calloc(20, sizeof *users);
+
+	for (int i = 0; i < 20; i++)
+	{
+		users[i].username = make_string("member%d", i);
+	}
+
+	for (int i = 0; i < n_channels; i++)
+	{
+		char name[32];
+		snprintf(name, sizeof name, "chan%d", i);
+		Channel *channel = Channel_alloc(name);
+		channel->time_created = now - ELIST_CREATED(i) * 60 - 30;
+		Server_add_channel(serv, channel);
+
+		for (int j = 0; j < ELIST_MEMBERS(i); j++)
+		{
+			Channel_add_member(channel, &users[j]);
+		}
+
+		if (ELIST_TOPIC(i) >= 0)
+		{
+			Channel_set_topic(channel, "topic");
+			Channel_set_topic_time(channel, now - ELIST_TOPIC(i) * 60 - 30);
+		}
+	}
+
+	assert(SkipList_size(serv->channel_index->by_members) == (size_t)n_channels);
+	assert(SkipList_size(serv->channel_index->by_topic) == (size_t)(n_channels + 2) / 3);
+
+	for (int q = 0; q < n_queries; q++)
+	{
+		Vector *channels = Server_find_channels(serv, queries[q]);
+		size_t expected = 0;
+
+		for (int i = 0; i < n_channels; i++)
+		{
+			expected += elist_expected(i, q);
+		}
+
+		for (size_t k = 0; k < Vector_size(channels); k++)
+		{
+			Channel *channel = Vector_get_at(channels, k);
+			assert(elist_expected(atoi(channel->name + 4), q));
+		}
+
+		log_debug("LIST %s: %zu channels", queries[q], Vector_size(channels));
+		assert(Vector_size(channels) == expected);
+		Vector_free(channels);
+	}
+
+	// The index follows members who leave and removed channels
+	for (Channel *channel = serv->first_channel; channel; channel = channel->next)
+	{
+		for (int j = 0; j < 20; j += 2)
+		{
+			Channel_remove_member(channel, &users[j]);
+		}
+	}
+
+	Server_remove_channel(serv, ht_get(serv->name_to_channel_map, "chan19"));
+
+	for (int k = 0; k < 20; k++)
+	{
+		char query[16];
+		snprintf(query, sizeof query, ">%d", k);
+		Vector *channels = Server_find_channels(serv, query);
+		size_t expected = 0;
+
+		for (Channel *channel = serv->first_channel; channel; channel = channel->next)
+		{
+			expected += ht_size(channel->members) > (size_t)k;
+		}
+
+		assert(Vector_size(channels) == expected);
+		Vector_free(channels);
+	}
+
+	// A condition on members scans only the channels in range
+	uint64_t start = monotonic_ns();
+	Vector *channels = Server_find_channels(serv, ">8");
+	uint64_t scan_ns = monotonic_ns() - start;
+	size_t found = Vector_size(channels);
+	Vector_free(channels);
+
+	start = monotonic_ns();
+	size_t walked = 0;
+
+	for (Channel *channel = serv->first_channel; channel; channel = channel->next)
+	{
+		walked += ht_size(channel->members) > 8;
+	}
+
+	uint64_t walk_ns = monotonic_ns() - start;
+	assert(found == walked);
+	log_warn("LIST >8 of %d channels: %zu found, index %.3f ms, walk %.3f ms", n_channels, found, scan_ns / 1e6,
+			 walk_ns / 1e6);
+
+	// LIST with conditions from a user
+	Vector *lines = Vector_alloc(16, (elem_copy_type)strdup, free);
+	Connection *user = SimNet_connect(net, "users", "sim0");
+	List_push_back(user->outgoing_messages, strdup("NICK bob\r\n"));
+	assert(sim_request(net, serv, user, "USER bob * * :Bob", " 001 bob "));
+
+	List_push_back(user->outgoing_messages, strdup("LIST >8,#chan2*\r\n"));
+	sim_flush(user);
+	sim_read_lines(net, serv, user, 100, lines);
+	assert(count_lines(lines, " 321 bob ") == 1 && count_lines(lines, " 323 bob ") == 1);
+	assert(count_lines(lines, " 322 bob chan219 9 :topic") == 1);
+	assert(count_lines(lines, " 322 bob chan29 ") == 0);
+	assert(count_lines(lines, " 322 bob ") > 0);
+
+	Vector_free(lines);
+	Connection_free(user);
+	Server_free(serv);
+	SimNet_free(net);
+
+	for (int i = 0; i < 20; i++)
+	{
+		free(users[i].username);
+	}
+
+	free(users);
+	logger_set_level(LOG_TRACE);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s test_case\n", *argv);
+		return 1;
+	}
+
+	int test_num = atoi(argv[1]);
+	char *filename;
+	size_t width;
+
+	switch (test_num)
+	{
+	case 1:
+		message_test();
+		break;
+	case 2:
+		vector_test();
+		break;
+	case 3:
+		hashtable_test();
+		break;
+	case 4:
+		hashtable_iter_test();
+		break;
+	case 5:
+		queue_test();
+		break;
+	case 6:
+		filename = argv[2];
+		if (!filename)
+		{
+			return 1;
+		}
+		read_test(filename);
+		break;
+	case 7:
+		width = argc < 3 ? 10 : atol(argv[2]);
+		line_wrap_test(width);
+		break;
+	case 8:
+		hashtable_test2();
+		break;
+	case 9:
+		hashtable_test1();
+		break;
+	case 10:
+		hll_test();
+		break;
+	case 11:
+		flow_control_test();
+		break;
+	case 12:
+		msgbuf_test(argc < 3 ? 1000000 : atol(argv[2]));
+		break;
+	case 13:
+		catalog_test();
+		break;
+	case 14:
+		config_test();
+		break;
+	case 15:
+		journal_test(argc < 3 ? 0 : atol(argv[2]));
+		break;
+	case 16:
+		channel_store_test(argc < 3 ? 0 : atol(argv[2]));
+		break;
+	case 17:
+		history_test();
+		break;
+	case 18:
+		channel_log_test(argc < 3 ? 100000 : atol(argv[2]));
+		break;
+	case 19:
+		logger_test(argc < 3 ? 50 : atol(argv[2]));
+		break;
+	case 20:
+		stats_test(argc < 3 ? 1000000 : atol(argv[2]));
+		break;
+	case 21:
+		admin_test();
+		break;
+	case 22:
+		server_burst_test();
+		break;
+	case 23:
+		remove_connections_test();
+		break;
+	case 24:
+		simnet_test(argc < 3 ? 15 : atoi(argv[2]), argc < 4 ? 1000 : atoi(argv[3]));
+		break;
+	case 25:
+		capture_test();
+		break;
+	case 26:
+		overload_test();
+		break;
+	case 27:
+		stream_test(argc < 3 ? 10000 : MAX(atoi(argv[2]), 2 * SIM_POLL_ROUNDS));
+		break;
+	case 28:
+		skiplist_test();
+		break;
+	case 29:
+		elist_test(argc < 3 ? 100000 : MAX(atoi(argv[2]), 2000));
+		break;
+	case 30:
+		query_test();
+		break;
+	case 31:
+		summary_test();
+		break;
+	case 32:
+		client_connection_test();
+		break;
+	case 33:
+		peer_heartbeat_test();
+		break;
+	case 34:
+		peer_reply_congestion_test();
 		break;
 	default:
 		log_error("No such test case");
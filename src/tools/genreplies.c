@@ -0,0 +1,386 @@
+/**
+ * Generate a typed formatter for each reply template in replies.h.
+ *
+ * Usage: genreplies <replies.h> <output header> <output source>
+ *
+ * For a template such as
+ *
+ *   #define RPL_TOPIC_MSG "332 %s %s :%s"
+ *
+ * two functions are generated:
+ *
+ *   void msgbuf_add_RPL_TOPIC(MsgBuf *buf, const char *a0, const char *a1, const char *a2);
+ *   char *reply_RPL_TOPIC(const char *prefix, const char *a0, const char *a1, const char *a2);
+ *
+ * The first appends the reply to buf, the second returns an allocated line
+ * with the ":<prefix> " and "\r\n" added. Literal chunks are copied with sizes
+ * known at compile time and the output size is bounded before anything is
+ * written, so no format string is parsed at runtime. Conversions which are
+ * not supported make the generator fail, so a bad template breaks the build.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 1024
+#define MAX_ARGS 32
+
+typedef struct Conversion
+{
+	char type[32]; /* C type of the argument */
+	char conv;	   /* s, c, d, u or x */
+	bool left;
+	char pad;
+	int width;
+} Conversion;
+
+typedef struct Template
+{
+	char name[128];		  /* define name without the _MSG suffix */
+	char literal[MAX_LINE]; /* template as written in the header */
+	char *chunks[MAX_ARGS + 1];
+	Conversion args[MAX_ARGS];
+	int n_args;
+} Template;
+
+static const char *header_file;
+static int line_no;
+
+static void fail(const char *message)
+{
+	fprintf(stderr, "%s:%d: %s\n", header_file, line_no, message);
+	exit(1);
+}
+
+static const char *int_type(char conv, int longs, bool size)
+{
+	bool is_signed = conv == 'd' || conv == 'i';
+
+	if (size)
+	{
+		return is_signed ? "ssize_t" : "size_t";
+	}
+
+	switch (longs)
+	{
+	case 0:
+		return is_signed ? "int" : "unsigned";
+	case 1:
+		return is_signed ? "long" : "unsigned long";
+	default:
+		return is_signed ? "long long" : "unsigned long long";
+	}
+}
+
+/*
+ * Split template literal into chunks of literal text and conversions. The
+ * chunks keep the escape sequences of the header so they can be written back
+ * as C string literals.
+ */
+static void parse_template(Template *t)
+{
+	char chunk[MAX_LINE];
+	size_t len = 0;
+	const char *ptr = t->literal;
+
+	t->n_args = 0;
+
+	while (*ptr)
+	{
+		if (*ptr == '\\' && ptr[1])
+		{
+			chunk[len++] = *ptr++;
+			chunk[len++] = *ptr++;
+			continue;
+		}
+
+		if (*ptr != '%')
+		{
+			chunk[len++] = *ptr++;
+			continue;
+		}
+
+		ptr++;
+
+		if (*ptr == '%')
+		{
+			chunk[len++] = *ptr++;
+			continue;
+		}
+
+		if (t->n_args == MAX_ARGS)
+		{
+			fail("too many conversions");
+		}
+
+		Conversion *arg = &t->args[t->n_args];
+		memset(arg, 0, sizeof *arg);
+		arg->pad = ' ';
+
+		for (; *ptr == '-' || *ptr == '0'; ptr++)
+		{
+			if (*ptr == '-')
+			{
+				arg->left = true;
+			}
+			else
+			{
+				arg->pad = '0';
+			}
+		}
+
+		for (; isdigit((unsigned char)*ptr); ptr++)
+		{
+			arg->width = arg->width * 10 + (*ptr - '0');
+		}
+
+		int longs = 0;
+		bool size = false;
+
+		for (; *ptr == 'l' || *ptr == 'z' || *ptr == 'h'; ptr++)
+		{
+			longs += *ptr == 'l';
+			size = size || *ptr == 'z';
+		}
+
+		switch (*ptr)
+		{
+		case 's':
+		case 'c':
+			if (arg->width || arg->left || arg->pad != ' ' || longs || size)
+			{
+				fail("flags, width and length are not supported for %s and %c");
+			}
+			strcpy(arg->type, *ptr == 's' ? "const char *" : "char ");
+			arg->conv = *ptr;
+			break;
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+			sprintf(arg->type, "%s ", int_type(*ptr, longs, size));
+			arg->conv = *ptr == 'i' ? 'd' : *ptr;
+			break;
+		default:
+			fail("unsupported conversion");
+		}
+
+		ptr++;
+		chunk[len] = 0;
+		t->chunks[t->n_args++] = strdup(chunk);
+		len = 0;
+	}
+
+	chunk[len] = 0;
+	t->chunks[t->n_args] = strdup(chunk);
+}
+
+/*
+ * Parse a line of the form: #define NAME "literal"
+ * Returns false for other lines.
+ */
+static bool parse_define(const char *line, Template *t)
+{
+	char name[sizeof t->name];
+
+	if (sscanf(line, " #define %127s", name) != 1)
+	{
+		return false;
+	}
+
+	const char *start = strchr(line, '"');
+	const char *end = strrchr(line, '"');
+
+	if (!start || start == end)
+	{
+		return false;
+	}
+
+	size_t n = strlen(name);
+
+	if (n > 4 && !strcmp(name + n - 4, "_MSG"))
+	{
+		name[n - 4] = 0;
+	}
+
+	strcpy(t->name, name);
+	memcpy(t->literal, start + 1, end - start - 1);
+	t->literal[end - start - 1] = 0;
+
+	return true;
+}
+
+static void print_params(FILE *out, const Template *t)
+{
+	for (int i = 0; i < t->n_args; i++)
+	{
+		fprintf(out, ", %sa%d", t->args[i].type, i);
+	}
+}
+
+static void print_prototypes(FILE *out, const Template *t)
+{
+	fprintf(out, "\n/* \"%s\" */\n", t->literal);
+	fprintf(out, "void msgbuf_add_%s(MsgBuf *buf", t->name);
+	print_params(out, t);
+	fprintf(out, ");\n");
+	fprintf(out, "char *reply_%s(const char *prefix", t->name);
+	print_params(out, t);
+	fprintf(out, ");\n");
+}
+
+static void print_chunk(FILE *out, const char *chunk)
+{
+	if (*chunk)
+	{
+		fprintf(out, "\tp = msgbuf_put_bytes(p, \"%s\", sizeof \"%s\" - 1);\n", chunk, chunk);
+	}
+}
+
+static void print_definitions(FILE *out, const Template *t)
+{
+	fprintf(out, "\nvoid msgbuf_add_%s(MsgBuf *buf", t->name);
+	print_params(out, t);
+	fprintf(out, ")\n{\n");
+
+	for (int i = 0; i < t->n_args; i++)
+	{
+		if (t->args[i].conv == 's')
+		{
+			fprintf(out, "\ta%d = a%d ? a%d : \"(null)\";\n", i, i, i);
+			fprintf(out, "\tsize_t n%d = strlen(a%d);\n", i, i);
+		}
+	}
+
+	// Upper bound of the output size
+	fprintf(out, "\tchar *p = msgbuf_reserve(buf, 0");
+
+	for (int i = 0; i <= t->n_args; i++)
+	{
+		if (*t->chunks[i])
+		{
+			fprintf(out, " + sizeof \"%s\" - 1", t->chunks[i]);
+		}
+
+		if (i == t->n_args)
+		{
+			break;
+		}
+
+		const Conversion *arg = &t->args[i];
+
+		if (arg->conv == 's')
+		{
+			fprintf(out, " + n%d", i);
+		}
+		else if (arg->conv == 'c')
+		{
+			fprintf(out, " + 1");
+		}
+		else
+		{
+			fprintf(out, " + %d", arg->width + 21);
+		}
+	}
+
+	fprintf(out, ");\n");
+
+	for (int i = 0; i < t->n_args; i++)
+	{
+		const Conversion *arg = &t->args[i];
+		print_chunk(out, t->chunks[i]);
+
+		switch (arg->conv)
+		{
+		case 's':
+			fprintf(out, "\tp = msgbuf_put_bytes(p, a%d, n%d);\n", i, i);
+			break;
+		case 'c':
+			fprintf(out, "\t*p++ = a%d;\n", i);
+			break;
+		case 'd':
+			fprintf(out, "\tp = msgbuf_put_long(p, a%d, %d, '%c', %s);\n", i, arg->width, arg->pad,
+					arg->left ? "true" : "false");
+			break;
+		default:
+			fprintf(out, "\tp = msgbuf_put_ulong(p, a%d, %d, %d, '%c', %s);\n", i,
+					arg->conv == 'x' ? 16 : 10, arg->width, arg->pad, arg->left ? "true" : "false");
+			break;
+		}
+	}
+
+	print_chunk(out, t->chunks[t->n_args]);
+	fprintf(out, "\tmsgbuf_commit(buf, p);\n}\n");
+
+	fprintf(out, "\nchar *reply_%s(const char *prefix", t->name);
+	print_params(out, t);
+	fprintf(out, ")\n{\n\tMsgBuf *buf = reply_begin(prefix);\n");
+	fprintf(out, "\tmsgbuf_add_%s(buf", t->name);
+
+	for (int i = 0; i < t->n_args; i++)
+	{
+		fprintf(out, ", a%d", i);
+	}
+
+	fprintf(out, ");\n\treturn reply_end(buf);\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 4)
+	{
+		fprintf(stderr, "Usage: %s <replies.h> <output header> <output source>\n", *argv);
+		return 1;
+	}
+
+	header_file = argv[1];
+
+	FILE *in = fopen(argv[1], "r");
+	FILE *header = fopen(argv[2], "w");
+	FILE *source = fopen(argv[3], "w");
+
+	if (!in || !header || !source)
+	{
+		perror("fopen");
+		return 1;
+	}
+
+	const char *notice = "/* Generated by genreplies from %s. Do not edit. */\n\n";
+
+	fprintf(header, notice, argv[1]);
+	fprintf(header, "#pragma once\n\n#include \"include/msgbuf.h\"\n");
+
+	fprintf(source, notice, argv[1]);
+	fprintf(source, "#include \"gen/reply_formatters.h\"\n\n#include <string.h>\n");
+
+	char line[MAX_LINE];
+	Template t;
+
+	while (fgets(line, sizeof line, in))
+	{
+		line_no++;
+
+		if (!parse_define(line, &t))
+		{
+			continue;
+		}
+
+		parse_template(&t);
+		print_prototypes(header, &t);
+		print_definitions(source, &t);
+
+		for (int i = 0; i <= t.n_args; i++)
+		{
+			free(t.chunks[i]);
+		}
+	}
+
+	fclose(in);
+	fclose(header);
+	fclose(source);
+
+	return 0;
+}